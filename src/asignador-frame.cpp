@@ -0,0 +1,72 @@
+// Asignador lineal de memoria por frame
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include "asignador-frame.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+AsignadorFrame::AsignadorFrame( const std::size_t capacidad_inicial )
+{
+   assert( 0 < capacidad_inicial );
+   capacidad = capacidad_inicial ;
+   bloque    = new unsigned char[ capacidad ] ;
+   desbordados.reserve( 16 );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void * AsignadorFrame::reservar( const std::size_t bytes, const std::size_t alineamiento )
+{
+   assert( 0 < alineamiento && ( alineamiento & ( alineamiento-1 )) == 0 );
+
+   // alinear la dirección siguiente a la última reserva
+   const std::uintptr_t base      = reinterpret_cast<std::uintptr_t>( bloque ),
+                        direccion = ( base + usados + alineamiento-1 ) & ~std::uintptr_t( alineamiento-1 );
+   const std::size_t    inicio    = direccion - base ;
+   if ( inicio + bytes <= capacidad )
+   {
+      usados = inicio + bytes ;
+      pico   = std::max( pico, usados + bytes_desbordados );
+      return bloque + inicio ;
+   }
+
+   // no cabe: reservar en el montículo (solo ocurre hasta que el bloque crece lo suficiente)
+   unsigned char * const desbordado = new unsigned char[ bytes + alineamiento ] ;
+   desbordados.push_back( desbordado );
+   bytes_desbordados += bytes + alineamiento ;
+   pico = std::max( pico, usados + bytes_desbordados );
+   const std::uintptr_t d = reinterpret_cast<std::uintptr_t>( desbordado );
+   return desbordado + ((( d + alineamiento-1 ) & ~std::uintptr_t( alineamiento-1 )) - d );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void AsignadorFrame::reiniciar()
+{
+   if ( ! desbordados.empty() )
+   {
+      // agrandar el bloque hasta el máximo usado en un frame (con margen), ya no hay reservas vivas
+      liberarDesbordados();
+      delete [] bloque ;
+      capacidad = std::max( 2*capacidad, pico + pico/2 );
+      bloque    = new unsigned char[ capacidad ] ;
+   }
+   usados            = 0 ;
+   bytes_desbordados = 0 ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void AsignadorFrame::liberarDesbordados()
+{
+   for( unsigned char * d : desbordados )
+      delete [] d ;
+   desbordados.clear();
+}
+// ------------------------------------------------------------------------------------------------------
+
+AsignadorFrame::~AsignadorFrame()
+{
+   liberarDesbordados();
+   delete [] bloque ;
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,73 @@
+// Asignador lineal de memoria por frame
+
+#ifndef ASIGNADOR_FRAME_H
+#define ASIGNADOR_FRAME_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// --------------------------------------------------------------------------------------------
+
+// Asignador lineal ('bump allocator') para los datos temporales de un frame: cada reserva 
+// avanza un desplazamiento en un bloque de memoria propio, y al inicio del frame siguiente
+// ('reiniciar') se libera todo a la vez, sin llamadas a 'new' ni 'delete'. Si en un frame se
+// agota el bloque, las reservas que no caben se obtienen del montículo, y al reiniciar el bloque
+// se agranda hasta el máximo usado, así que tras unos frames de calentamiento ya no se reserva
+// memoria dinámica.
+//
+// Los datos reservados no se destruyen: solo se pueden reservar tablas de tipos triviales.
+//
+class AsignadorFrame
+{
+   public:
+
+   // crea el asignador con un bloque inicial de 'capacidad_inicial' bytes
+   AsignadorFrame( const std::size_t capacidad_inicial = 1 << 16 ) ;
+
+   // reserva memoria para el frame actual (válida hasta la siguiente llamada a 'reiniciar')
+   //
+   // @param bytes        (size_t) número de bytes a reservar
+   // @param alineamiento (size_t) alineamiento de la dirección devuelta (potencia de 2)
+   // @return (void *) puntero a la memoria reservada (sin inicializar)
+   //
+   void * reservar( const std::size_t bytes, const std::size_t alineamiento = alignof(std::max_align_t) );
+
+   // reserva una tabla de 'n' valores de tipo 'T' (sin inicializar)
+   template< class T > T * reservarTabla( const std::size_t n )
+   {
+      static_assert( std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value,
+                     "el asignador de frame solo admite tipos triviales" );
+      return static_cast<T *>( reservar( n*sizeof(T), alignof(T) ) );
+   }
+
+   // libera todas las reservas (se debe llamar al inicio de cada frame), y agranda el 
+   // bloque si en el frame anterior no fue suficiente
+   void reiniciar();
+
+   // bytes reservados en el frame actual, máximo de bytes reservados en un frame, y
+   // tamaño del bloque
+   inline std::size_t leerUsados()    const { return usados + bytes_desbordados ; }
+   inline std::size_t leerPico()      const { return pico ; }
+   inline std::size_t leerCapacidad() const { return capacidad ; }
+
+   // libera el bloque y las reservas desbordadas
+   ~AsignadorFrame();
+
+   AsignadorFrame( const AsignadorFrame & ) = delete ;
+   AsignadorFrame & operator = ( const AsignadorFrame & ) = delete ;
+
+   private: // ---------------------------
+
+   // libera las reservas que no cupieron en el bloque
+   void liberarDesbordados();
+
+   unsigned char *              bloque            = nullptr ;
+   std::size_t                  capacidad         = 0 , // tamaño del bloque en bytes
+                                usados            = 0 , // bytes usados del bloque en el frame actual
+                                bytes_desbordados = 0 , // bytes reservados fuera del bloque en el frame actual
+                                pico              = 0 ; // máximo de bytes reservados en un frame
+   std::vector<unsigned char *> desbordados ;           // reservas que no cupieron en el bloque
+} ;
+
+#endif
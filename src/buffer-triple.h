@@ -0,0 +1,68 @@
+// Buffer triple sin bloqueos, para pasar valores de un hilo productor a un hilo consumidor
+
+#ifndef BUFFER_TRIPLE_H
+#define BUFFER_TRIPLE_H
+
+#include <array>
+#include <atomic>
+
+// --------------------------------------------------------------------------------------------
+
+// Buffer triple: el productor escribe y publica valores completos de tipo 'T', y el consumidor
+// lee siempre el último publicado (los intermedios que no ha leído se pierden). Hay tres copias
+// del valor: la que escribe el productor, la que lee el consumidor y la última publicada, que se
+// intercambian con una sola operación atómica, así que ninguno de los dos hilos espera al otro
+// ni ve un valor a medio escribir. Solo puede haber un hilo productor y un hilo consumidor.
+//
+template< class T >
+class BufferTriple
+{
+   public:
+
+   // (productor) copia donde se escribe el próximo valor, no la ve el consumidor hasta publicarla
+   inline T & escritura() { return copias[ ind_escritura ] ; }
+
+   // (productor) publica la copia escrita (sustituye a la publicada antes, si no se ha leído) y
+   // despierta al consumidor si está esperando
+   inline void publicar()
+   {
+      ind_escritura = intercambio.exchange( ind_escritura | bit_nuevo, std::memory_order_acq_rel ) & mascara_indice ;
+      intercambio.notify_one();
+   }
+
+   // (consumidor) si hay un valor publicado que no se ha leído, pasa a leerlo
+   // @return (bool) true si ha cambiado el valor leído
+   inline bool actualizar()
+   {
+      if ( ( intercambio.load( std::memory_order_relaxed ) & bit_nuevo ) == 0 )
+         return false ;
+      ind_lectura = intercambio.exchange( ind_lectura, std::memory_order_acq_rel ) & mascara_indice ;
+      return true ;
+   }
+
+   // (consumidor) espera (bloqueado) hasta que haya un valor publicado que no se ha leído
+   inline void esperar() const
+   {
+      unsigned v = intercambio.load( std::memory_order_acquire );
+      while ( ( v & bit_nuevo ) == 0 )
+      {
+         intercambio.wait( v, std::memory_order_acquire );
+         v = intercambio.load( std::memory_order_acquire );
+      }
+   }
+
+   // (consumidor) último valor leído con 'actualizar'
+   inline const T & lectura() const { return copias[ ind_lectura ] ; }
+
+   private: // ---------------------------
+
+   static constexpr unsigned mascara_indice = 3 , // bits del índice de la copia publicada en 'intercambio'
+                             bit_nuevo      = 4 ; // bit de 'intercambio' a 1 si la publicada no se ha leído
+
+   std::array<T,3>       copias ;
+   unsigned              ind_escritura = 0 ,  // (solo la usa el productor)
+                         ind_lectura   = 1 ;  // (solo la usa el consumidor)
+   std::atomic<unsigned> intercambio { 2 } ;  // índice de la copia publicada y 'bit_nuevo'
+} ;
+
+#endif
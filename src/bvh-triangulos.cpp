@@ -0,0 +1,452 @@
+// Jerarquía de volúmenes englobantes (BVH) de los triángulos de un VAO, para selección por rayos
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <thread>
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define BVH_USAR_SSE
+#endif
+#include "bvh-triangulos.h"
+#include "paralelo.h"
+#include "pila-fija.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+// Parámetros de la construcción
+
+constexpr unsigned num_bins            = 16 ,       // 'bins' por eje para evaluar la SAH
+                   max_tris_hoja       = 16 ,       // máximo de triángulos en una hoja (salvo centroides iguales)
+                   max_profundidad     = 96 ,       // a partir de aquí, todos los nodos son hojas
+                   min_tris_paralelo   = 1u << 14 ; // mínimo de triángulos de un subárbol para construirlo en otro hilo
+constexpr float    coste_recorrido     = 1.0f ;     // coste de visitar un nodo (relativo al de un triángulo)
+
+// ------------------------------------------------------------------------------------------------------
+// Lee el índice 'i' de una tabla de índices (o devuelve 'i' si no hay tabla)
+
+static inline GLuint LeerIndiceTabla( const DescrVBOInds * dvbo_inds, const unsigned long i )
+{
+   return ( dvbo_inds != nullptr ) ? dvbo_inds->leerIndice( i ) : GLuint( i ) ;
+}
+// ------------------------------------------------------------------------------------------------------
+// Caja alineada con los ejes, usada durante la construcción
+
+struct Caja
+{
+   float min[3] = {  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max() },
+         max[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+   inline void agregar( const float * p_min, const float * p_max )
+   {
+      for( unsigned e = 0 ; e < 3 ; e++ )
+      {
+         min[e] = std::min( min[e], p_min[e] );
+         max[e] = std::max( max[e], p_max[e] );
+      }
+   }
+   inline void agregar( const Caja & c ) { agregar( c.min, c.max ); }
+
+   // mitad del área de la superficie (0 si la caja está vacía)
+   inline float area() const
+   {
+      const float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2] ;
+      return ( dx < 0.0f ) ? 0.0f : dx*dy + dy*dz + dz*dx ;
+   }
+} ;
+
+// ------------------------------------------------------------------------------------------------------
+
+BVHTriangulos::BVHTriangulos( const DescrVAO & vao )
+{
+   using namespace std ;
+   ZONA_TRAZA( "BVHTriangulos::BVHTriangulos" );
+   const auto inicio = chrono::steady_clock::now();
+
+   const DescrVBOInds * dvbo_inds = vao.leerDescrIndices();
+   const unsigned long  num_verts = ( dvbo_inds != nullptr ) ? dvbo_inds->leerCount() : vao.leerNumVertices(),
+                        num_tris  = num_verts/3 ;
+   assert( num_tris < 0xFFFFFFFFul );
+
+   // leer los vértices de los triángulos (en el orden del VAO) y calcular sus cajas
+   triangulos.resize( num_tris );
+   std::iota( triangulos.begin(), triangulos.end(), 0u );
+   leerVertices( vao );
+
+   referencias.resize( num_tris );
+   ParaleloPara( num_tris, [&]( const unsigned long t0, const unsigned long t1 )
+   {
+      for( unsigned long t = t0 ; t < t1 ; t++ )
+      {
+         Caja caja ;
+         for( unsigned j = 0 ; j < 3 ; j++ )
+            caja.agregar( glm::value_ptr( vertices[3*t+j] ), glm::value_ptr( vertices[3*t+j] ) );
+         Referencia & r = referencias[t] ;
+         r.triangulo = uint32_t( t );
+         for( unsigned e = 0 ; e < 3 ; e++ )
+         {
+            r.min[e] = caja.min[e] ;
+            r.max[e] = caja.max[e] ;
+         }
+      }
+   });
+
+   // construir la jerarquía (reordena 'referencias'), y copiar los vértices en el orden de las hojas
+   if ( num_tris > 0 )
+      nodos = construirSubarbol( 0, uint32_t( num_tris ), 0 );
+
+   vector<glm::vec3> ordenados( vertices.size() );
+   ParaleloPara( num_tris, [&]( const unsigned long k0, const unsigned long k1 )
+   {
+      for( unsigned long k = k0 ; k < k1 ; k++ )
+      {
+         triangulos[k] = referencias[k].triangulo ;
+         for( unsigned j = 0 ; j < 3 ; j++ )
+            ordenados[3*k+j] = vertices[3ul*triangulos[k]+j] ;
+      }
+   });
+   vertices.swap( ordenados );
+   vector<Referencia>().swap( referencias ); // (solo se usan al construir)
+
+   ms_construccion = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+}
+// ------------------------------------------------------------------------------------------------------
+
+void BVHTriangulos::leerVertices( const DescrVAO & vao )
+{
+   const DescrVBOAtribs * dvbo_pos  = vao.leerDescrAtrib( 0 );
+   const DescrVBOInds   * dvbo_inds = vao.leerDescrIndices();
+   assert( dvbo_pos->leerType() == GL_FLOAT );
+   assert( dvbo_pos->leerDatos() != nullptr );
+   assert( dvbo_inds == nullptr || ( dvbo_inds->leerIndices() != nullptr && ! dvbo_inds->usaReinicio() ));
+
+   const float * const posiciones = (const float *) dvbo_pos->leerDatos();
+   const unsigned      size       = dvbo_pos->leerSize();
+   assert( size == 2 || size == 3 );
+
+   vertices.resize( 3*triangulos.size() );
+   ParaleloPara( triangulos.size(), [&]( const unsigned long k0, const unsigned long k1 )
+   {
+      for( unsigned long k = k0 ; k < k1 ; k++ )
+         for( unsigned j = 0 ; j < 3 ; j++ )
+         {
+            const unsigned long v = LeerIndiceTabla( dvbo_inds, 3ul*triangulos[k] + j );
+            const float * p = posiciones + v*size ;
+            vertices[3*k+j] = glm::vec3( p[0], p[1], size == 3 ? p[2] : 0.0f );
+         }
+   });
+}
+// ------------------------------------------------------------------------------------------------------
+
+std::vector<BVHTriangulos::Nodo> BVHTriangulos::construirSubarbol( const uint32_t ini, const uint32_t fin,
+                                                                   const unsigned profundidad )
+{
+   std::vector<Nodo> v( 1 );
+   v.reserve( 2ul*( fin-ini ) ); // (un árbol binario con hojas no vacías tiene menos de 2n nodos)
+   construirNodo( v, 0, ini, fin, profundidad );
+   return v ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void BVHTriangulos::construirNodo( std::vector<Nodo> & v, const uint32_t ind, const uint32_t ini,
+                                   const uint32_t fin, const unsigned profundidad )
+{
+   assert( ini < fin );
+   const uint32_t n = fin - ini ;
+
+   // caja de los triángulos y caja de sus centros (los centros de sus cajas, multiplicados por 2)
+   Caja caja, caja_centros ;
+   for( uint32_t k = ini ; k < fin ; k++ )
+   {
+      const Referencia & r = referencias[k] ;
+      const float centro[3] = { r.min[0] + r.max[0], r.min[1] + r.max[1], r.min[2] + r.max[2] };
+      caja.agregar( r.min, r.max );
+      caja_centros.agregar( centro, centro );
+   }
+   for( unsigned e = 0 ; e < 3 ; e++ )
+   {
+      v[ind].min[e] = caja.min[e] ;
+      v[ind].max[e] = caja.max[e] ;
+   }
+
+   // clasificar los triángulos en los 'bins' de los tres ejes (en una sola pasada)
+   float escala[3] ;
+   for( unsigned e = 0 ; e < 3 ; e++ )
+   {
+      const float extension = caja_centros.max[e] - caja_centros.min[e] ;
+      escala[e] = ( extension > 0.0f ) ? float(num_bins)/extension : 0.0f ;
+   }
+   const auto bin = [&]( const Referencia & r, const unsigned e )
+   {
+      return std::min( num_bins-1, unsigned( ( r.min[e] + r.max[e] - caja_centros.min[e] )*escala[e] ));
+   };
+
+   int      mejor_eje   = -1 ;
+   unsigned mejor_bin   = 0 ;
+   float    mejor_coste = std::numeric_limits<float>::max();
+   if ( n > 2 && profundidad < max_profundidad )
+   {
+      Caja     cajas_bins[3][num_bins] ;
+      uint32_t cuentas[3][num_bins] = {} ;
+      for( uint32_t k = ini ; k < fin ; k++ )
+      {
+         const Referencia & r = referencias[k] ;
+         for( unsigned e = 0 ; e < 3 ; e++ )
+         {
+            const unsigned b = bin( r, e );
+            cuentas[e][b]++ ;
+            cajas_bins[e][b].agregar( r.min, r.max );
+         }
+      }
+
+      // buscar el mejor plano de división (SAH) entre los bordes de los 'bins' de cada eje
+      for( unsigned e = 0 ; e < 3 ; e++ )
+      {
+         if ( escala[e] == 0.0f )
+            continue ;
+
+         // áreas y cuentas a la derecha de cada borde, y evaluación de izquierda a derecha
+         float    area_der[num_bins] ;
+         uint32_t cuenta_der[num_bins] ;
+         Caja     acum ;
+         uint32_t c = 0 ;
+         for( unsigned b = num_bins-1 ; b > 0 ; b-- )
+         {
+            acum.agregar( cajas_bins[e][b] );
+            c += cuentas[e][b] ;
+            area_der[b]   = acum.area();
+            cuenta_der[b] = c ;
+         }
+         Caja     izq ;
+         uint32_t cuenta_izq = 0 ;
+         for( unsigned b = 1 ; b < num_bins ; b++ )
+         {
+            izq.agregar( cajas_bins[e][b-1] );
+            cuenta_izq += cuentas[e][b-1] ;
+            if ( cuenta_izq == 0 || cuenta_der[b] == 0 )
+               continue ;
+            const float coste = izq.area()*float(cuenta_izq) + area_der[b]*float(cuenta_der[b]) ;
+            if ( coste < mejor_coste )
+            {
+               mejor_coste = coste ;
+               mejor_eje   = int(e) ;
+               mejor_bin   = b ;
+            }
+         }
+      }
+   }
+
+   // decidir si es una hoja: no hay división, o dividir cuesta más que intersectar todos los triángulos
+   uint32_t mitad = ini ;
+   const float area = caja.area();
+   if ( mejor_eje >= 0 )
+   {
+      const bool mejor_hoja = n <= max_tris_hoja &&
+                              ( area <= 0.0f || coste_recorrido + mejor_coste/area >= float(n) );
+      if ( ! mejor_hoja )
+         mitad = uint32_t( std::partition( referencias.begin() + ini, referencias.begin() + fin,
+                   [&]( const Referencia & r ) { return bin( r, unsigned( mejor_eje ) ) < mejor_bin ; } )
+                   - referencias.begin() );
+   }
+   else if ( n > max_tris_hoja && profundidad < max_profundidad ) // centroides iguales: dividir por la mitad
+      mitad = ini + n/2 ;
+
+   if ( mitad == ini || mitad == fin )
+   {
+      v[ind].primero = ini ;
+      v[ind].cuenta  = n ;
+      return ;
+   }
+
+   // nodo interior: construir los dos hijos (en paralelo si son grandes, y hasta la profundidad en la
+   // que ya hay un subárbol por hilo; la comprobación de 32 evita desplazar más bits que los de un unsigned)
+   if ( n >= 2*min_tris_paralelo && profundidad < 32 && ( 1u << profundidad ) < NumHilosParalelo() )
+   {
+      std::vector<Nodo> sub_izq, sub_der ;
+      std::thread hilo( [&]() { sub_izq = construirSubarbol( ini, mitad, profundidad+1 ); } );
+      sub_der = construirSubarbol( mitad, fin, profundidad+1 );
+      hilo.join();
+
+      // añadir los subárboles a 'v', desplazando los índices de los hijos de sus nodos interiores
+      const uint32_t base = uint32_t( v.size() );
+      v[ind].primero = base ;
+      v[ind].cuenta  = 0 ;
+      v.resize( base + 2 );
+      for( unsigned h = 0 ; h < 2 ; h++ )
+      {
+         const std::vector<Nodo> & sub    = ( h == 0 ) ? sub_izq : sub_der ;
+         const uint32_t            despl  = uint32_t( v.size() ) - 1 ;
+         for( unsigned long k = 0 ; k < sub.size() ; k++ )
+         {
+            Nodo nodo = sub[k] ;
+            if ( nodo.cuenta == 0 )
+               nodo.primero += despl ;
+            if ( k == 0 )
+               v[base+h] = nodo ;
+            else
+               v.push_back( nodo );
+         }
+      }
+   }
+   else
+   {
+      const uint32_t base = uint32_t( v.size() );
+      v[ind].primero = base ;
+      v[ind].cuenta  = 0 ;
+      v.resize( base + 2 );
+      construirNodo( v, base,   ini,   mitad, profundidad+1 );
+      construirNodo( v, base+1, mitad, fin,   profundidad+1 );
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+
+void BVHTriangulos::reajustar( const DescrVAO & vao )
+{
+   ZONA_TRAZA( "BVHTriangulos::reajustar" );
+   const DescrVBOInds * dvbo_inds = vao.leerDescrIndices();
+   assert( ( dvbo_inds != nullptr ? dvbo_inds->leerCount() : (GLsizei) vao.leerNumVertices() )/3 == (GLsizei) triangulos.size() );
+   leerVertices( vao );
+
+   // los hijos están siempre después del padre: recorrer los nodos de atrás hacia delante
+   for( unsigned long i = nodos.size() ; i-- > 0 ; )
+   {
+      Nodo & nodo = nodos[i] ;
+      Caja   caja ;
+      if ( nodo.cuenta > 0 )
+         for( unsigned long k = 3ul*nodo.primero ; k < 3ul*( nodo.primero + nodo.cuenta ) ; k++ )
+            caja.agregar( glm::value_ptr( vertices[k] ), glm::value_ptr( vertices[k] ) );
+      else
+         for( unsigned h = 0 ; h < 2 ; h++ )
+         {
+            const Nodo & hijo = nodos[nodo.primero+h] ;
+            caja.agregar( hijo.min, hijo.max );
+         }
+      for( unsigned e = 0 ; e < 3 ; e++ )
+      {
+         nodo.min[e] = caja.min[e] ;
+         nodo.max[e] = caja.max[e] ;
+      }
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+// Rayo con los valores que se usan en cada prueba con una caja (con SSE, las tres componentes se
+// procesan a la vez, la cuarta se anula para ignorar el entero que sigue a 'min' y a 'max' en el nodo)
+
+struct RayoCajas
+{
+#ifdef BVH_USAR_SSE
+   __m128 origen, inv_dir ;
+#else
+   glm::vec3 origen, inv_dir ;
+#endif
+
+   RayoCajas( const glm::vec3 & o, const glm::vec3 & d )
+   {
+      const glm::vec3 inv = glm::vec3( 1.0f )/d ;
+#ifdef BVH_USAR_SSE
+      origen  = _mm_set_ps( 0.0f, o.z, o.y, o.x );
+      inv_dir = _mm_set_ps( 0.0f, inv.z, inv.y, inv.x );
+#else
+      origen  = o ;
+      inv_dir = inv ;
+#endif
+   }
+
+   // distancia de entrada en la caja [min,max] (la que se guarda en 'min[3]' y 'max[3]'),
+   // o infinito si no la corta en [0,t_max)
+   inline float intersectar( const float * min, const float * max, const float t_max ) const
+   {
+      float t0[4], t1[4] ;
+#ifdef BVH_USAR_SSE
+      const __m128 a = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( min ), origen ), inv_dir ),
+                   b = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( max ), origen ), inv_dir );
+      _mm_storeu_ps( t0, _mm_min_ps( a, b ) );
+      _mm_storeu_ps( t1, _mm_max_ps( a, b ) );
+#else
+      for( unsigned e = 0 ; e < 3 ; e++ )
+      {
+         const float a = ( min[e] - origen[e] )*inv_dir[e],
+                     b = ( max[e] - origen[e] )*inv_dir[e] ;
+         t0[e] = std::min( a, b );
+         t1[e] = std::max( a, b );
+      }
+#endif
+      const float entrada = std::max( std::max( t0[0], t0[1] ), std::max( t0[2], 0.0f ) ),
+                  salida  = std::min( std::min( t1[0], t1[1] ), std::min( t1[2], t_max ) );
+      return ( entrada <= salida && entrada < t_max ) ? entrada : std::numeric_limits<float>::infinity() ;
+   }
+} ;
+
+// ------------------------------------------------------------------------------------------------------
+
+ImpactoRayo BVHTriangulos::intersectar( const glm::vec3 & origen, const glm::vec3 & direccion,
+                                        const float t_max ) const
+{
+   using namespace glm ;
+   ImpactoRayo impacto ;
+   impacto.t = t_max ;
+   if ( nodos.empty() )
+      return impacto ;
+
+   const RayoCajas rayo( origen, direccion );
+   struct Pendiente { uint32_t nodo ; float entrada ; } ;
+   PilaFija<Pendiente,max_profundidad+2> pila ;
+
+   const float t_raiz = rayo.intersectar( nodos[0].min, nodos[0].max, impacto.t );
+   if ( t_raiz < impacto.t )
+      pila.push( { 0, t_raiz } );
+
+   while( pila.size() > 0 )
+   {
+      const Pendiente p = pila.pop();
+      if ( p.entrada >= impacto.t ) // ya hay una intersección más cercana que la caja
+         continue ;
+      const Nodo & nodo = nodos[p.nodo] ;
+
+      if ( nodo.cuenta > 0 ) // hoja: intersectar sus triángulos (algoritmo de Möller-Trumbore)
+      {
+         for( uint32_t k = nodo.primero ; k < nodo.primero + nodo.cuenta ; k++ )
+         {
+            const vec3 & v0 = vertices[3ul*k], & v1 = vertices[3ul*k+1], & v2 = vertices[3ul*k+2] ;
+            const vec3  e1  = v1 - v0, e2 = v2 - v0,
+                        pv  = cross( direccion, e2 );
+            const float det = dot( e1, pv );
+            if ( std::fabs( det ) < 1e-20f )
+               continue ;
+            const float inv_det = 1.0f/det ;
+            const vec3  s       = origen - v0 ;
+            const float u       = dot( s, pv )*inv_det ;
+            if ( u < 0.0f || u > 1.0f )
+               continue ;
+            const vec3  q = cross( s, e1 );
+            const float w = dot( direccion, q )*inv_det ;
+            if ( w < 0.0f || u + w > 1.0f )
+               continue ;
+            const float t = dot( e2, q )*inv_det ;
+            if ( 0.0f <= t && t < impacto.t )
+            {
+               impacto.hay           = true ;
+               impacto.t             = t ;
+               impacto.triangulo     = triangulos[k] ;
+               impacto.baricentricas = vec3( 1.0f - u - w, u, w );
+            }
+         }
+      }
+      else // nodo interior: apilar los hijos que corta el rayo, el más cercano en el tope
+      {
+         const Nodo & a  = nodos[nodo.primero], & b = nodos[nodo.primero+1] ;
+         const float  ta = rayo.intersectar( a.min, a.max, impacto.t ),
+                      tb = rayo.intersectar( b.min, b.max, impacto.t );
+         const Pendiente pa = { nodo.primero, ta }, pb = { nodo.primero+1, tb } ;
+         const Pendiente & cerca = ( ta <= tb ) ? pa : pb ,
+                         & lejos = ( ta <= tb ) ? pb : pa ;
+         if ( lejos.entrada < impacto.t )
+            pila.push( lejos );
+         if ( cerca.entrada < impacto.t )
+            pila.push( cerca );
+      }
+   }
+   return impacto ;
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,110 @@
+// Jerarquía de volúmenes englobantes (BVH) de los triángulos de un VAO, para selección por rayos
+
+#ifndef BVH_TRIANGULOS_H
+#define BVH_TRIANGULOS_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "glincludes.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+// Resultado de intersectar un rayo con los triángulos de un BVH
+
+struct ImpactoRayo
+{
+   bool          hay        = false ; // true si el rayo interseca algún triángulo
+   float         t          = std::numeric_limits<float>::infinity() ; // parámetro del punto en el rayo
+   unsigned long triangulo  = 0 ;     // número del triángulo en el VAO (el primero es el 0)
+   glm::vec3     baricentricas = { 0.0f, 0.0f, 0.0f }; // coordenadas baricéntricas del punto en el triángulo
+} ;
+
+// --------------------------------------------------------------------------------------------
+
+// BVH binario de cajas alineadas con los ejes, construido con la heurística del área de las
+// superficies (SAH, evaluada con 'bins') sobre las tablas de posiciones e índices de un VAO de
+// triángulos (modo GL_TRIANGLES). Los subárboles grandes se construyen en paralelo.
+//
+// El BVH guarda una copia de los vértices de los triángulos (en el orden de las hojas), así que
+// no depende del VAO después de construirlo, salvo para reajustarlo con las nuevas posiciones
+// (con la misma topología) sin reconstruir la jerarquía.
+//
+class BVHTriangulos
+{
+   public:
+
+   // construye el BVH de los triángulos del VAO (sus tablas deben estar en la memoria de la
+   // aplicación, las posiciones con GL_FLOAT y sin reinicios de primitiva en los índices)
+   //
+   // @param vao (const DescrVAO &) VAO con los triángulos
+   //
+   BVHTriangulos( const DescrVAO & vao );
+
+   // recalcula las cajas de los nodos con las posiciones actuales del VAO, que debe tener los
+   // mismos triángulos que al construir el BVH (para mallas dinámicas: la calidad de la
+   // jerarquía empeora si los triángulos se mueven mucho, entonces conviene reconstruirlo)
+   //
+   // @param vao (const DescrVAO &) VAO con los triángulos
+   //
+   void reajustar( const DescrVAO & vao );
+
+   // busca la intersección más cercana al origen de un rayo con los triángulos, con parámetro
+   // en el intervalo [0,t_max)
+   //
+   // @param origen    (vec3)          origen del rayo
+   // @param direccion (vec3)          dirección del rayo (no es necesario que esté normalizada)
+   // @param t_max     (float)         máximo valor del parámetro
+   // @return          (ImpactoRayo)   intersección encontrada ('hay' es false si no hay)
+   //
+   ImpactoRayo intersectar( const glm::vec3 & origen, const glm::vec3 & direccion,
+                            const float t_max = std::numeric_limits<float>::infinity() ) const ;
+
+   // número de triángulos y de nodos
+   inline unsigned long leerNumTriangulos() const { return triangulos.size(); }
+   inline unsigned long leerNumNodos() const { return nodos.size(); }
+
+   // tiempo empleado en la construcción, en milisegundos
+   inline double leerMsConstruccion() const { return ms_construccion ; }
+
+   private: // ---------------------------
+
+   // nodo del árbol (32 bytes): si 'cuenta' es 0 es un nodo interior con los hijos en las
+   // posiciones 'primero' y 'primero+1', si no es una hoja con 'cuenta' triángulos desde 'primero'
+   struct Nodo
+   {
+      float    min[3] ;
+      uint32_t primero ;
+      float    max[3] ;
+      uint32_t cuenta ;
+   } ;
+
+   // construye el subárbol de los triángulos en [ini,fin) de 'referencias', con la raíz en la
+   // posición 0 del resultado (los índices de los hijos son relativos a ese vector)
+   std::vector<Nodo> construirSubarbol( const uint32_t ini, const uint32_t fin,
+                                        const unsigned profundidad );
+
+   // escribe en 'v[ind]' el nodo de los triángulos en [ini,fin), y añade a 'v' sus descendientes
+   // (los subárboles grandes se construyen en otros hilos y después se añaden a 'v')
+   void construirNodo( std::vector<Nodo> & v, const uint32_t ind, const uint32_t ini,
+                       const uint32_t fin, const unsigned profundidad );
+
+   // lee las posiciones de los vértices de los triángulos del VAO en 'vertices' (en el orden de 'triangulos')
+   void leerVertices( const DescrVAO & vao );
+
+   // triángulo con su caja, usado durante la construcción (se reordenan al dividir los nodos)
+   struct Referencia
+   {
+      float    min[3] ;
+      uint32_t triangulo ;
+      float    max[3] ;
+   } ;
+
+   std::vector<Nodo>       nodos ;       // nodos del árbol, la raíz es el primero
+   std::vector<uint32_t>   triangulos ;  // números de los triángulos del VAO, en el orden de las hojas
+   std::vector<glm::vec3>  vertices ;    // tres vértices por triángulo, en el orden de las hojas
+   std::vector<Referencia> referencias ; // triángulos con sus cajas (solo durante la construcción)
+   double                  ms_construccion = 0.0 ;
+} ;
+
+#endif
@@ -0,0 +1,157 @@
+// Cache de vértices transformados, capturados con 'transform feedback'
+
+#include "cache-transformados.h"
+#include "errores-gl.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+// Devuelve el tipo de primitiva que produce un modo de visualización al capturarlo (las tiras y
+// abanicos se capturan como primitivas separadas), y el número de vértices por primitiva
+
+static GLenum PrimitivaCapturada( const GLenum modo, GLsizei & vertices_por_primitiva )
+{
+   switch( modo )
+   {
+      case GL_POINTS :
+         vertices_por_primitiva = 1 ;
+         return GL_POINTS ;
+      case GL_LINES : case GL_LINE_STRIP : case GL_LINE_LOOP :
+         vertices_por_primitiva = 2 ;
+         return GL_LINES ;
+      default :
+         vertices_por_primitiva = 3 ;
+         return GL_TRIANGLES ;
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool CacheTransformados::preparar( Cauce & cauce, const unsigned i, DescrVAO * vao, const GLenum modo, 
+                                   const glm::mat4 & mat_modelview )
+{
+   assert( vao != nullptr );
+   if ( entradas.size() <= i )
+      entradas.resize( i+1 );
+   Entrada & e = entradas[i] ;
+
+   const glm::mat4 transformacion = cauce.leerMatrizProyeccion() * cauce.leerMatrizVista() * mat_modelview ;
+   if ( e.valida && e.vao == vao && e.version == vao->leerVersion() && e.modo == modo && 
+        e.transformacion == transformacion && e.color == cauce.leerColor() && 
+        e.iluminacion == cauce.leerIluminacion() )
+   {
+      num_repeticiones++ ;
+      return true ;
+   }
+
+   // capturar con el programa básico y la modelview del objeto
+   e.vao            = vao ;
+   e.version        = vao->leerVersion() ;
+   e.modo           = modo ;
+   e.transformacion = transformacion ;
+   e.color          = cauce.leerColor() ;
+   e.iluminacion    = cauce.leerIluminacion() ;
+   cauce.fijarDibujarAristas( false );
+   cauce.fijarRepetirTransformados( false );
+   cauce.fijarMM( mat_modelview );
+   e.valida = capturar( e, vao, modo );
+   return e.valida ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool CacheTransformados::capturar( Entrada & e, DescrVAO * vao, const GLenum modo )
+{
+   ZONA_TRAZA( "CacheTransformados::capturar" );
+   CError();
+   GLsizei vpp ;
+   e.modo_repeticion = PrimitivaCapturada( modo, vpp );
+
+   // cota superior del número de vértices capturados (una primitiva por vértice o índice)
+   const GLsizei n = ( vao->leerDescrIndices() != nullptr ) ? vao->leerDescrIndices()->leerCount() 
+                                                            : vao->leerNumVertices() ;
+   if ( GLsizeiptr(n)*vpp > max_vertices )
+      return false ;
+   const GLsizeiptr tam = GLsizeiptr(n)*vpp*sizeof(DatosTransformado) ;
+
+   if ( consulta == 0 )
+   {
+      glGenQueries( 1, &consulta ); assert( 0 < consulta );
+   }
+   if ( e.array == 0 )
+   {
+      // VAO de repetición: posición ya transformada, color y coordenadas de textura intercalados
+      constexpr GLsizei paso = sizeof(DatosTransformado) ;
+      glGenVertexArrays( 1, &e.array ); assert( 0 < e.array );
+      glGenBuffers( 1, &e.buffer );     assert( 0 < e.buffer );
+      glBindVertexArray( e.array );
+      glBindBuffer( GL_ARRAY_BUFFER, e.buffer );
+      glVertexAttribPointer( Cauce::ind_atrib_posicion_clip, 4, GL_FLOAT, GL_FALSE, paso, 
+                             (void *) offsetof( DatosTransformado, posicion_clip ));
+      glVertexAttribPointer( Cauce::ind_atrib_colores, 3, GL_FLOAT, GL_FALSE, paso, 
+                             (void *) offsetof( DatosTransformado, color ));
+      glVertexAttribPointer( Cauce::ind_atrib_coord_text, 2, GL_FLOAT, GL_FALSE, paso, 
+                             (void *) offsetof( DatosTransformado, coord_text ));
+      glEnableVertexAttribArray( Cauce::ind_atrib_posicion_clip );
+      glEnableVertexAttribArray( Cauce::ind_atrib_colores );
+      glEnableVertexAttribArray( Cauce::ind_atrib_coord_text );
+      glBindVertexArray( 0 );
+      glBindBuffer( GL_ARRAY_BUFFER, 0 );
+   }
+   if ( e.capacidad < tam )
+   {
+      glBindBuffer( GL_TRANSFORM_FEEDBACK_BUFFER, e.buffer );
+      glBufferData( GL_TRANSFORM_FEEDBACK_BUFFER, tam, nullptr, GL_DYNAMIC_COPY );
+      glBindBuffer( GL_TRANSFORM_FEEDBACK_BUFFER, 0 );
+      e.capacidad = tam ;
+   }
+
+   // capturar sin rasterizar, y leer el número de primitivas escritas (espera a la GPU, pero solo 
+   // ocurre cuando cambia el objeto)
+   glEnable( GL_RASTERIZER_DISCARD );
+   glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 0, e.buffer );
+   glBeginQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, consulta );
+   glBeginTransformFeedback( e.modo_repeticion );
+   vao->draw( modo );
+   glEndTransformFeedback();
+   glEndQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN );
+   glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0 );
+   glDisable( GL_RASTERIZER_DISCARD );
+
+   GLuint primitivas = 0 ;
+   glGetQueryObjectuiv( consulta, GL_QUERY_RESULT, &primitivas );
+   e.num_vertices = primitivas*vpp ;
+   num_capturas++ ;
+   CError();
+   return true ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void CacheTransformados::dibujar( const unsigned i )
+{
+   assert( i < entradas.size() && entradas[i].valida );
+   CError();
+   const Entrada & e = entradas[i] ;
+   glBindVertexArray( e.array );
+   glDrawArrays( e.modo_repeticion, 0, e.num_vertices );
+   glBindVertexArray( 0 );
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
+
+void CacheTransformados::recortar( const unsigned n )
+{
+   for( unsigned i = n ; i < entradas.size() ; i++ )
+      if ( entradas[i].array != 0 )
+      {
+         glDeleteVertexArrays( 1, &entradas[i].array );
+         glDeleteBuffers( 1, &entradas[i].buffer );
+      }
+   if ( n < entradas.size() )
+      entradas.resize( n );
+}
+// ------------------------------------------------------------------------------------------------------
+
+CacheTransformados::~CacheTransformados()
+{
+   recortar( 0 );
+   if ( consulta != 0 )
+      glDeleteQueries( 1, &consulta );
+}
@@ -0,0 +1,97 @@
+// Cache de vértices transformados, capturados con 'transform feedback'
+
+#ifndef CACHE_TRANSFORMADOS_H
+#define CACHE_TRANSFORMADOS_H
+
+#include <vector>
+#include "glincludes.h"
+#include "cauce.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Guarda, para cada objeto de una secuencia de dibujo que se repite de frame en frame (p.ej. la 
+// cola de opacos), los vértices que produce el vertex shader (posición en coordenadas de 
+// recortado, color y coordenadas de textura), capturados con 'transform feedback' (OpenGL 3.3)
+// en un buffer propio. Mientras no cambian el VAO, el modo, las matrices (proyección, vista y 
+// modelview), el color actual ni la iluminación, las pasadas de dibujo repiten los vértices capturados sin 
+// volver a transformarlos. Es útil con vertex shaders costosos y con varias pasadas por frame.
+//
+// La captura no está indexada (cada primitiva tiene sus propios vértices), así que ocupa más 
+// memoria que el VAO original: los objetos con más de 'max_vertices' vértices capturados no se 
+// guardan en la cache.
+//
+class CacheTransformados
+{
+   public:
+
+   // crea una cache vacía (los objetos de OpenGL se crean al usarla)
+   CacheTransformados() = default ;
+
+   // prepara la entrada 'i' de la cache para un objeto: si la entrada no corresponde al mismo
+   // VAO, modo, matrices, color e iluminación, vuelve a capturar sus vértices con el programa básico del cauce
+   // (sin rasterizar, deja activo el programa básico)
+   //
+   // @param cauce         (Cauce &)    cauce con las matrices de vista y proyección, el color y la iluminación actuales
+   // @param i             (unsigned)   índice de la entrada (p.ej. posición en la cola)
+   // @param vao           (DescrVAO *) VAO a dibujar
+   // @param modo          (GLenum)     modo de visualización
+   // @param mat_modelview (mat4)       matriz modelview del objeto
+   // @return (bool) true si el objeto está en la cache (se puede usar 'dibujar( i )')
+   //
+   bool preparar( Cauce & cauce, const unsigned i, DescrVAO * vao, const GLenum modo, 
+                  const glm::mat4 & mat_modelview );
+
+   // dibuja los vértices capturados de la entrada 'i' (el cauce debe estar repitiendo transformados)
+   void dibujar( const unsigned i );
+
+   // libera las entradas con índice 'n' o superior (todas si 'n' es 0)
+   void recortar( const unsigned n );
+
+   // número de capturas y de repeticiones desde que se creó la cache
+   inline unsigned long numCapturas() const { return num_capturas ; }
+   inline unsigned long numRepeticiones() const { return num_repeticiones ; }
+
+   // libera los objetos de OpenGL
+   ~CacheTransformados();
+
+   // máximo número de vértices capturados por objeto
+   static constexpr GLsizei max_vertices = 1 << 22 ;
+
+   private: // ---------------------------
+
+   // vértice capturado (disposición intercalada de las salidas capturadas por el cauce)
+   struct DatosTransformado
+   {
+      glm::vec4 posicion_clip ;
+      glm::vec3 color ;
+      glm::vec2 coord_text ;
+   } ;
+
+   // entrada de la cache
+   struct Entrada
+   {
+      GLuint     array        = 0 ;       // VAO para repetir los vértices capturados
+      GLuint     buffer       = 0 ;       // buffer con los vértices capturados
+      GLsizeiptr capacidad    = 0 ;       // tamaño del buffer en bytes
+      GLsizei    num_vertices = 0 ;       // vértices capturados
+      GLenum     modo_repeticion = GL_TRIANGLES ; // modo de las primitivas capturadas
+      bool       valida       = false ;   // true si tiene vértices capturados
+      DescrVAO * vao          = nullptr ; // clave: VAO, versión (única entre VAOs), modo, matriz completa, color e iluminación
+      std::uint64_t version   = 0 ;
+      GLenum     modo         = 0 ;
+      glm::mat4  transformacion ;
+      glm::vec3  color ;
+      bool       iluminacion  = false ;
+   } ;
+
+   // captura los vértices de 'vao' en la entrada 'e', devuelve false si no caben
+   bool capturar( Entrada & e, DescrVAO * vao, const GLenum modo );
+
+   std::vector<Entrada> entradas ;
+   GLuint               consulta         = 0 ; // consulta GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN
+   unsigned long        num_capturas     = 0 ,
+                        num_repeticiones = 0 ;
+} ;
+
+#endif
@@ -0,0 +1,48 @@
+// Cámara orbital sencilla (gira alrededor de un punto), controlada con teclado y ratón
+
+#include <algorithm>
+#include <cmath>
+#include "camara-orbital.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+CamaraOrbital::CamaraOrbital( const float p_distancia )
+:  distancia( p_distancia )
+{
+   assert( 0.0f < distancia );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void CamaraOrbital::rotar( const float d_longitud, const float d_latitud )
+{
+   longitud = std::fmod( longitud + d_longitud, 360.0f );
+   latitud  = std::clamp( latitud + d_latitud, -89.0f, 89.0f );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void CamaraOrbital::acercar( const float factor )
+{
+   assert( 0.0f < factor );
+   distancia = std::clamp( distancia*factor, 0.05f, 1000.0f );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+glm::mat4 CamaraOrbital::matrizVista() const 
+{
+   using namespace glm ;
+   const float lon = radians( longitud ), lat = radians( latitud );
+   const vec3  dir = { std::cos( lat )*std::sin( lon ), std::sin( lat ), std::cos( lat )*std::cos( lon ) };
+   return lookAt( punto_atencion + distancia*dir, punto_atencion, vec3( 0.0f, 1.0f, 0.0f ) );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+glm::mat4 CamaraOrbital::matrizProyeccion( const float aspecto ) const 
+{
+   // los planos de recorte se ajustan a la distancia, para aprovechar la precisión del Z-buffer
+   return glm::perspective( glm::radians( 60.0f ), aspecto, 0.02f*distancia, 20.0f*distancia );
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,46 @@
+// Cámara orbital sencilla (gira alrededor de un punto), controlada con teclado y ratón
+
+#ifndef CAMARA_ORBITAL_H
+#define CAMARA_ORBITAL_H
+
+#include "glincludes.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Cámara que mira siempre hacia un punto de atención, desde una dirección dada por longitud
+// y latitud (en grados) y a una distancia, con proyección perspectiva
+//
+class CamaraOrbital
+{
+   public:
+
+   // crea la cámara mirando al origen
+   // @param p_distancia (float) distancia inicial al punto de atención (>0)
+   //
+   CamaraOrbital( const float p_distancia = 5.0f );
+
+   // gira la cámara alrededor del punto de atención (la latitud se limita a ±89 grados)
+   // @param d_longitud, d_latitud (float) incrementos en grados
+   //
+   void rotar( const float d_longitud, const float d_latitud );
+
+   // multiplica la distancia al punto de atención por un factor (<1 acerca, >1 aleja)
+   void acercar( const float factor );
+
+   // devuelve la matriz de vista (coordenadas de mundo a coordenadas de cámara)
+   glm::mat4 matrizVista() const ;
+
+   // devuelve la matriz de proyección perspectiva (campo de visión vertical de 60 grados)
+   // @param aspecto (float) relación ancho/alto del viewport
+   //
+   glm::mat4 matrizProyeccion( const float aspecto ) const ;
+
+   private: // ---------------------------
+
+   glm::vec3 punto_atencion = { 0.0f, 0.0f, 0.0f };
+   float     longitud  = 30.0f , // ángulo alrededor del eje Y, en grados
+             latitud   = 25.0f , // ángulo sobre el plano XZ, en grados
+             distancia = 5.0f ;  // distancia al punto de atención
+} ;
+
+#endif
@@ -0,0 +1,239 @@
+// Captura asíncrona de frames con 'pixel buffer objects' y un hilo de escritura
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <filesystem>
+#include "captura-frames.h"
+#include "imagenes.h"
+#include "errores-gl.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+CapturaFrames::CapturaFrames( const std::string & p_carpeta, const FormatoCaptura p_formato, 
+                              const unsigned num_pbos )
+:  carpeta( p_carpeta ),
+   formato( p_formato )
+{
+   using namespace std ;
+   assert( 2 <= num_pbos );
+   CError();
+
+   std::filesystem::create_directories( carpeta );
+
+   ranuras.resize( num_pbos );
+   for( Ranura & r : ranuras )
+   {
+      glGenBuffers( 1, &r.pbo );
+      assert( 0 < r.pbo );
+   }
+   CError();
+
+   hilo = std::thread( &CapturaFrames::bucleHilo, this );
+   cout << "Captura de frames iniciada en '" << carpeta << "' (" << num_pbos << " PBOs, formato " 
+        << ( formato == FormatoCaptura::ppm ? "PPM" : "raw" ) << ")." << endl ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void CapturaFrames::capturar( const int ancho, const int alto )
+{
+   assert( ! terminada );
+   assert( 0 < ancho && 0 < alto );
+   CError();
+
+   // si la ranura está ocupada (por la copia de hace 'num_pbos' frames), recogerla antes de reusarla
+   Ranura & r = ranuras[sig_ranura] ;
+   if ( r.valla != nullptr )
+      recoger( r );
+
+   // copiar el 'back buffer' al PBO (la copia es asíncrona, 'glReadPixels' vuelve enseguida)
+   // se lee en BGRA, la disposición habitual del framebuffer en memoria: el driver la copia 
+   // sin conversión (con RGB o RGBA es unas tres veces más lento), y se convierte en el hilo
+   const GLsizeiptr tam = GLsizeiptr(4)*ancho*alto ;
+   glBindBuffer( GL_PIXEL_PACK_BUFFER, r.pbo );
+   if ( r.tam != tam )
+   {
+      glBufferData( GL_PIXEL_PACK_BUFFER, tam, nullptr, GL_STREAM_READ );
+      r.tam = tam ;
+   }
+   glReadPixels( 0, 0, ancho, alto, GL_BGRA, GL_UNSIGNED_BYTE, nullptr );
+   glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+   r.valla     = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+   r.ancho     = ancho ;
+   r.alto      = alto ;
+   r.num_frame = num_frame++ ;
+   sig_ranura  = ( sig_ranura + 1 ) % ranuras.size() ;
+   CError();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void CapturaFrames::recoger( Ranura & r )
+{
+   using namespace std ;
+   assert( r.valla != nullptr );
+   CError();
+
+   // esperar a que la GPU termine la copia (normalmente ya ha terminado)
+   GLenum estado ;
+   do
+      estado = glClientWaitSync( r.valla, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000 ); // (100 ms)
+   while( estado == GL_TIMEOUT_EXPIRED );
+   assert( estado != GL_WAIT_FAILED );
+   glDeleteSync( r.valla );
+   r.valla = nullptr ;
+
+   // obtener memoria para el trabajo (si hay demasiados en espera, esperar al hilo de escritura)
+   Trabajo t ;
+   {
+      unique_lock<mutex> bloqueo( cerrojo );
+      cv_libres.wait( bloqueo, [this]{ return num_en_uso < max_trabajos ; } );
+      num_en_uso++ ;
+      if ( ! libres.empty() )
+      {
+         t.bgra = std::move( libres.back() );
+         libres.pop_back();
+      }
+   }
+   t.num_frame = r.num_frame ;
+   t.ancho     = r.ancho ;
+   t.alto      = r.alto ;
+   t.bgra.resize( r.tam );
+
+   // copiar los pixels del PBO 
+   glBindBuffer( GL_PIXEL_PACK_BUFFER, r.pbo );
+   const void * datos = glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, r.tam, GL_MAP_READ_BIT );
+   assert( datos != nullptr );
+   memcpy( t.bgra.data(), datos, r.tam );
+   glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+   glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+   CError();
+
+   {
+      lock_guard<mutex> bloqueo( cerrojo );
+      cola.push_back( std::move( t ) );
+   }
+   cv_cola.notify_one();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void CapturaFrames::bucleHilo()
+{
+   using namespace std ;
+
+   Imagen        img ;
+   FILE *        flujo = nullptr ;     // archivo del flujo 'raw' actual
+   unsigned      flujo_ancho = 0, flujo_alto = 0 ;
+   unsigned long escritos = 0 ;
+   const auto    inicio = chrono::steady_clock::now();
+
+   while( true )
+   {
+      Trabajo t ;
+      {
+         unique_lock<mutex> bloqueo( cerrojo );
+         cv_cola.wait( bloqueo, [this]{ return fin || ! cola.empty() ; } );
+         if ( cola.empty() )
+            break ;
+         t = std::move( cola.front() );
+         cola.pop_front();
+      }
+
+      // convertir de BGRA a RGB, invirtiendo el orden de las filas
+      img.redimensionar( t.ancho, t.alto );
+      for( unsigned y = 0 ; y < t.alto ; y++ )
+      {
+         const unsigned char * src = t.bgra.data()+ 4ul*t.ancho*( t.alto-1-y );
+         unsigned char       * dst = img.fila( y );
+         for( unsigned x = 0 ; x < t.ancho ; x++, src += 4, dst += 3 )
+         {
+            dst[0] = src[2] ;
+            dst[1] = src[1] ;
+            dst[2] = src[0] ;
+         }
+      }
+
+      // devolver la memoria del trabajo cuanto antes, para que no espere el hilo de visualización
+      {
+         lock_guard<mutex> bloqueo( cerrojo );
+         libres.push_back( std::move( t.bgra ) );
+         num_en_uso-- ;
+      }
+      cv_libres.notify_one();
+
+      // escribir
+      if ( formato == FormatoCaptura::ppm )
+      {
+         char nombre[32] ;
+         snprintf( nombre, sizeof(nombre), "frame-%06lu.ppm", t.num_frame );
+         EscribirPPM( carpeta + "/" + nombre, img );
+      }
+      else
+      {
+         // (un flujo nuevo cada vez que cambia el tamaño de la ventana)
+         if ( flujo == nullptr || flujo_ancho != t.ancho || flujo_alto != t.alto )
+         {
+            if ( flujo != nullptr )
+               fclose( flujo );
+            flujo_ancho = t.ancho ;
+            flujo_alto  = t.alto ;
+            const string nombre = carpeta + "/captura-" + to_string( t.ancho ) + "x" + to_string( t.alto ) 
+                                  + "-" + to_string( t.num_frame ) + ".rgb" ;
+            flujo = fopen( nombre.c_str(), "wb" );
+            if ( flujo == nullptr )
+               cout << "No se puede crear el archivo '" << nombre << "'." << endl ;
+         }
+         if ( flujo != nullptr )
+            fwrite( img.pixels.data(), 1, img.pixels.size(), flujo );
+      }
+      escritos++ ;
+   }
+
+   if ( flujo != nullptr )
+      fclose( flujo );
+
+   const double segundos = chrono::duration<double>( chrono::steady_clock::now() - inicio ).count();
+   cout << "Captura de frames terminada: " << escritos << " frames escritos en " << fixed << setprecision(2) 
+        << segundos << " s (" << ( segundos > 0.0 ? escritos/segundos : 0.0 ) << " frames/s)." 
+        << defaultfloat << endl ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void CapturaFrames::terminar()
+{
+   if ( terminada )
+      return ;
+
+   // recoger las ranuras ocupadas, de la más antigua a la más reciente
+   for( unsigned i = 0 ; i < ranuras.size() ; i++ )
+   {
+      Ranura & r = ranuras[( sig_ranura + i ) % ranuras.size()] ;
+      if ( r.valla != nullptr )
+         recoger( r );
+   }
+
+   {
+      std::lock_guard<std::mutex> bloqueo( cerrojo );
+      fin = true ;
+   }
+   cv_cola.notify_one();
+   hilo.join();
+   terminada = true ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+CapturaFrames::~CapturaFrames()
+{
+   terminar();
+   CError();
+   for( Ranura & r : ranuras )
+      glDeleteBuffers( 1, &r.pbo );
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
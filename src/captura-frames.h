@@ -0,0 +1,108 @@
+// Captura asíncrona de frames con 'pixel buffer objects' y un hilo de escritura
+
+#ifndef CAPTURA_FRAMES_H
+#define CAPTURA_FRAMES_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "glincludes.h"
+
+// --------------------------------------------------------------------------------------------
+
+// formato de los archivos de captura
+//
+enum class FormatoCaptura
+{
+   ppm,  // un archivo PPM por frame ('frame-000000.ppm', ...)
+   raw   // flujos de frames RGB sin cabecera ('captura-<ancho>x<alto>-<frame>.rgb', uno nuevo cada vez
+         // que cambia el tamaño, con el número del primer frame que contiene), 
+         // p.ej. para 'ffmpeg -f rawvideo -pix_fmt rgb24 -s <ancho>x<alto> -i ...'
+} ;
+
+// --------------------------------------------------------------------------------------------
+
+// Captura los frames visualizados sin detener el cauce: cada frame se copia (con 'glReadPixels')
+// a un PBO de un anillo, y se lee de la memoria del PBO 'num_pbos-1' frames después, cuando la
+// GPU ya ha terminado la copia. La conversión a RGB y la escritura en disco se hacen en un hilo
+// aparte, con un número limitado de frames en espera.
+//
+class CapturaFrames
+{
+   public:
+
+   // crea la captura (requiere un contexto OpenGL activo) y lanza el hilo de escritura
+   //
+   // @param carpeta  (string)         carpeta donde se escriben los archivos (se crea si no existe)
+   // @param formato  (FormatoCaptura) formato de los archivos
+   // @param num_pbos (unsigned)       número de PBOs del anillo (>=2)
+   //
+   CapturaFrames( const std::string & carpeta, const FormatoCaptura formato, const unsigned num_pbos = 3 );
+
+   // inicia la copia del framebuffer por defecto (el 'back buffer', antes de 'glfwSwapBuffers')
+   // y entrega al hilo de escritura el frame más antiguo del anillo, si lo hay
+   //
+   // @param ancho (int) ancho del framebuffer en pixels
+   // @param alto  (int) alto del framebuffer en pixels
+   //
+   void capturar( const int ancho, const int alto );
+
+   // entrega los frames pendientes del anillo, espera a que se escriban y termina el hilo
+   void terminar();
+
+   // termina (si no se ha hecho antes) y libera los PBOs
+   ~CapturaFrames();
+
+   private: // ---------------------------
+
+   // entrada del anillo de PBOs
+   struct Ranura
+   {
+      GLuint        pbo       = 0 ;       // nombre del PBO
+      GLsizeiptr    tam       = 0 ;       // tamaño actual del PBO en bytes
+      GLsync        valla     = nullptr ; // valla tras la copia, nulo si la ranura está libre
+      unsigned      ancho     = 0,        // tamaño del frame copiado
+                    alto      = 0 ;
+      unsigned long num_frame = 0 ;       // número de frame copiado
+   } ;
+
+   // frame pendiente de escribir, con los pixels BGRA tal como los da OpenGL (filas de abajo arriba)
+   struct Trabajo
+   {
+      unsigned long              num_frame = 0 ;
+      unsigned                   ancho     = 0,
+                                 alto      = 0 ;
+      std::vector<unsigned char> bgra ;
+   } ;
+
+   static constexpr unsigned max_trabajos = 4 ; // máximo número de frames en espera de escritura
+
+   const std::string    carpeta ;
+   const FormatoCaptura formato ;
+
+   std::vector<Ranura> ranuras ;          // anillo de PBOs
+   unsigned            sig_ranura = 0 ;   // siguiente ranura a usar (la más antigua)
+   unsigned long       num_frame  = 0 ;   // número de frames capturados
+   bool                terminada  = false ;
+
+   // estado compartido con el hilo de escritura (protegido por 'cerrojo')
+   std::thread                             hilo ;
+   std::mutex                              cerrojo ;
+   std::condition_variable                 cv_cola ;    // hay trabajos, o hay que terminar
+   std::condition_variable                 cv_libres ;  // hay memoria libre para un trabajo
+   std::deque<Trabajo>                     cola ;       // trabajos pendientes, en orden
+   std::vector<std::vector<unsigned char>> libres ;     // memoria de trabajos ya escritos (se reutiliza)
+   unsigned                                num_en_uso = 0 ; // trabajos en la cola o en escritura
+   bool                                    fin        = false ;
+
+   // espera a la valla de una ranura ocupada, copia sus pixels y los pone en la cola
+   void recoger( Ranura & r );
+
+   // función que ejecuta el hilo de escritura
+   void bucleHilo();
+} ;
+
+#endif
@@ -0,0 +1,212 @@
+// Carga asíncrona de texturas: decodificación en hilos auxiliares y subida con PBOs por porciones
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include "cargador-texturas.h"
+#include "imagenes.h"
+#include "paralelo.h"
+#include "errores-gl.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+CargadorTexturas::CargadorTexturas( const unsigned num_hilos, const unsigned num_pbos, const GLsizeiptr p_tam_pbo )
+:  tam_pbo( p_tam_pbo )
+{
+   assert( 2 <= num_pbos );
+   assert( 4 <= tam_pbo );
+   CError();
+
+   ranuras.resize( num_pbos );
+   for( Ranura & r : ranuras )
+   {
+      glGenBuffers( 1, &r.pbo ); assert( 0 < r.pbo );
+      glBindBuffer( GL_PIXEL_UNPACK_BUFFER, r.pbo );
+      glBufferData( GL_PIXEL_UNPACK_BUFFER, tam_pbo, nullptr, GL_STREAM_DRAW );
+   }
+   glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+   CError();
+
+   const unsigned n = ( num_hilos > 0 ) ? num_hilos : NumHilosParalelo() ;
+   for( unsigned i = 0 ; i < n ; i++ )
+      hilos.emplace_back( &CargadorTexturas::decodificar, this );
+}
+// ------------------------------------------------------------------------------------------------------
+
+Textura * CargadorTexturas::cargar( const std::string & archivo )
+{
+   texturas.push_back( std::make_unique<Textura>( archivo ) );
+   Textura * textura = texturas.back().get() ;
+   {
+      std::lock_guard<std::mutex> bloqueo( cerrojo );
+      peticiones.emplace_back( textura, archivo );
+      num_pendientes++ ;
+   }
+   cond_peticiones.notify_one();
+   return textura ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+unsigned CargadorTexturas::numPendientes()
+{
+   std::lock_guard<std::mutex> bloqueo( cerrojo );
+   return num_pendientes ;
+}
+// ------------------------------------------------------------------------------------------------------
+// Hilo de decodificación: lee el archivo y lo convierte a RGBA con las filas invertidas. Espera si 
+// ya hay demasiadas texturas decodificadas sin subir.
+
+void CargadorTexturas::decodificar()
+{
+   using namespace std ;
+   NombrarHiloTraza( "cargador de texturas" );
+   while( true )
+   {
+      pair<Textura *,string> peticion ;
+      {
+         unique_lock<mutex> bloqueo( cerrojo );
+         cond_peticiones.wait( bloqueo, [this]() { return terminar || ! peticiones.empty() ; } );
+         if ( terminar )
+            return ;
+         peticion = std::move( peticiones.front() );
+         peticiones.pop_front();
+      }
+
+      unique_ptr<Decodificada> dec = make_unique<Decodificada>();
+      dec->textura = peticion.first ;
+
+      {
+         ZONA_TRAZA( "CargadorTexturas::decodificar" ); // (sin la espera a que haya sitio)
+         Imagen imagen ;
+         if ( ! LeerPPM( peticion.second, imagen ) || imagen.ancho == 0 || imagen.alto == 0 )
+            dec->error = true ;
+         else
+         {
+            dec->ancho = imagen.ancho ;
+            dec->alto  = imagen.alto ;
+            dec->rgba.resize( 4ul*imagen.ancho*imagen.alto );
+            for( unsigned y = 0 ; y < imagen.alto ; y++ )
+            {
+               const unsigned char * org = imagen.fila( imagen.alto-1-y );
+               unsigned char *       dst = dec->rgba.data() + 4ul*imagen.ancho*y ;
+               for( unsigned x = 0 ; x < imagen.ancho ; x++ )
+               {
+                  dst[4*x+0] = org[3*x+0] ;  dst[4*x+1] = org[3*x+1] ;
+                  dst[4*x+2] = org[3*x+2] ;  dst[4*x+3] = 255 ;
+               }
+            }
+         }
+      }
+
+      unique_lock<mutex> bloqueo( cerrojo );
+      cond_decodificadas.wait( bloqueo, [this]() { return terminar || decodificadas.size() < max_decodificadas ; } );
+      if ( terminar )
+         return ;
+      decodificadas.push_back( std::move( dec ) );
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool CargadorTexturas::procesarSubidas( const double presupuesto_ms )
+{
+   using namespace std ;
+   ZONA_TRAZA( "CargadorTexturas::procesarSubidas" );
+   const auto inicio = chrono::steady_clock::now();
+   bool       alguna_lista = false ;
+   CError();
+
+   while( true )
+   {
+      // tomar la siguiente textura decodificada, si no hay ninguna en curso
+      if ( actual == nullptr )
+      {
+         {
+            lock_guard<mutex> bloqueo( cerrojo );
+            if ( decodificadas.empty() )
+               break ;
+            actual = std::move( decodificadas.front() );
+            decodificadas.pop_front();
+         }
+         cond_decodificadas.notify_one();
+
+         if ( actual->error )
+         {
+            cout << "Error: no se ha podido leer la textura '" << actual->textura->leerNombre() << "'." << endl ;
+            actual = nullptr ;
+            lock_guard<mutex> bloqueo( cerrojo );
+            num_pendientes-- ;
+            continue ;
+         }
+         assert( 4*GLsizeiptr(actual->ancho) <= tam_pbo ); // una fila debe caber en un PBO
+         actual->textura->crear( actual->ancho, actual->alto );
+         filas_subidas = 0 ;
+      }
+
+      // esperar (sin bloquear) a que la GPU haya terminado de leer el siguiente PBO del anillo
+      Ranura & r = ranuras[sig_ranura] ;
+      if ( r.valla != nullptr )
+      {
+         if ( glClientWaitSync( r.valla, 0, 0 ) == GL_TIMEOUT_EXPIRED )
+            break ;
+         glDeleteSync( r.valla );
+         r.valla = nullptr ;
+      }
+
+      // copiar una banda de filas al PBO y, desde él, a la textura
+      const GLsizeiptr bytes_fila = 4*GLsizeiptr(actual->ancho) ;
+      const unsigned   filas      = std::min( GLsizeiptr(actual->alto - filas_subidas), tam_pbo/bytes_fila );
+      const GLsizeiptr bytes      = filas*bytes_fila ;
+
+      glBindBuffer( GL_PIXEL_UNPACK_BUFFER, r.pbo );
+      void * destino = glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, bytes, 
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+      assert( destino != nullptr );
+      std::memcpy( destino, actual->rgba.data() + filas_subidas*bytes_fila, bytes );
+      glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+
+      glBindTexture( GL_TEXTURE_2D, actual->textura->leerId() );
+      glTexSubImage2D( GL_TEXTURE_2D, 0, 0, filas_subidas, actual->ancho, filas, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+      glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+      r.valla    = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+      sig_ranura = ( sig_ranura + 1 ) % ranuras.size() ;
+
+      // si la textura está completa, generar los mipmaps
+      filas_subidas += filas ;
+      if ( filas_subidas == actual->alto )
+      {
+         actual->textura->terminar();
+         actual       = nullptr ;
+         alguna_lista = true ;
+         lock_guard<mutex> bloqueo( cerrojo );
+         num_pendientes-- ;
+      }
+
+      if ( chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count() >= presupuesto_ms )
+         break ;
+   }
+   CError();
+   return alguna_lista ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+CargadorTexturas::~CargadorTexturas()
+{
+   {
+      std::lock_guard<std::mutex> bloqueo( cerrojo );
+      terminar = true ;
+   }
+   cond_peticiones.notify_all();
+   cond_decodificadas.notify_all();
+   for( std::thread & h : hilos )
+      h.join();
+
+   for( Ranura & r : ranuras )
+   {
+      if ( r.valla != nullptr )
+         glDeleteSync( r.valla );
+      glDeleteBuffers( 1, &r.pbo );
+   }
+   texturas.clear(); // (libera los objetos textura mientras el contexto sigue activo)
+}
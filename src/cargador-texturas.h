@@ -0,0 +1,105 @@
+// Carga asíncrona de texturas: decodificación en hilos auxiliares y subida con PBOs por porciones
+
+#ifndef CARGADOR_TEXTURAS_H
+#define CARGADOR_TEXTURAS_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "glincludes.h"
+#include "textura.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Carga texturas desde archivos PPM sin detener la visualización: los archivos se leen y se 
+// convierten a RGBA en hilos auxiliares, y el hilo de OpenGL, en cada frame, sube a las texturas
+// bandas de filas a través de un anillo de PBOs ('GL_PIXEL_UNPACK_BUFFER' + 'glTexSubImage2D'),
+// hasta agotar un presupuesto de tiempo. Al completar una textura se generan sus mipmaps en la 
+// GPU. Un PBO no se vuelve a escribir hasta que su valla indica que la GPU ha terminado de leerlo.
+//
+class CargadorTexturas
+{
+   public:
+
+   // crea el cargador (requiere un contexto OpenGL activo) y lanza los hilos de decodificación
+   //
+   // @param num_hilos (unsigned)   número de hilos de decodificación (0 -> 'NumHilosParalelo()')
+   // @param num_pbos  (unsigned)   número de PBOs del anillo (>=2)
+   // @param tam_pbo   (GLsizeiptr) tamaño de cada PBO en bytes (máximo tamaño de una banda)
+   //
+   CargadorTexturas( const unsigned num_hilos = 0, const unsigned num_pbos = 4, 
+                     const GLsizeiptr tam_pbo = 1 << 20 );
+
+   // pide la carga de una textura desde un archivo PPM, y vuelve sin esperar
+   //
+   // @param archivo (string) nombre del archivo PPM
+   // @return (Textura *) textura (sin lista hasta que se termine de subir), propiedad del cargador
+   //
+   Textura * cargar( const std::string & archivo );
+
+   // sube bandas de las texturas decodificadas hasta agotar el presupuesto de tiempo (al menos
+   // una banda por llamada, si hay alguna y hay un PBO libre). Se debe llamar una vez por frame.
+   //
+   // @param presupuesto_ms (double) tiempo máximo aproximado a emplear, en milisegundos
+   // @return (bool) true si alguna textura ha quedado lista en esta llamada
+   //
+   bool procesarSubidas( const double presupuesto_ms );
+
+   // número de texturas pedidas que todavía no están listas (ni han fallado)
+   unsigned numPendientes() ;
+
+   // devuelve todas las texturas creadas por el cargador, en el orden de las peticiones
+   inline const std::vector<std::unique_ptr<Textura>> & leerTexturas() const { return texturas ; }
+
+   // termina los hilos, libera los PBOs y las texturas
+   ~CargadorTexturas();
+
+   private: // ---------------------------
+
+   // textura decodificada, con pixels RGBA (filas de abajo arriba, como las espera OpenGL)
+   struct Decodificada
+   {
+      Textura *                  textura = nullptr ;
+      bool                       error   = false ;
+      unsigned                   ancho   = 0 ,
+                                 alto    = 0 ;
+      std::vector<unsigned char> rgba ;
+   } ;
+
+   // entrada del anillo de PBOs
+   struct Ranura
+   {
+      GLuint pbo   = 0 ;
+      GLsync valla = nullptr ; // valla tras la última 'glTexSubImage2D' desde este PBO
+   } ;
+
+   // máximo número de texturas decodificadas en espera de subida (limita la memoria usada)
+   static constexpr unsigned max_decodificadas = 8 ;
+
+   // función que ejecuta cada hilo de decodificación
+   void decodificar();
+
+   std::vector<std::unique_ptr<Textura>> texturas ; // todas las texturas pedidas
+   std::vector<Ranura>                   ranuras ;  // anillo de PBOs
+   GLsizeiptr                            tam_pbo ;
+   unsigned                              sig_ranura = 0 ;
+
+   std::unique_ptr<Decodificada> actual ;       // textura que se está subiendo (nulo si ninguna)
+   unsigned                      filas_subidas = 0 ; // filas de 'actual' ya subidas
+
+   // estado compartido con los hilos (protegido por 'cerrojo')
+   std::mutex                                cerrojo ;
+   std::condition_variable                   cond_peticiones ;   // hay peticiones o hay que terminar
+   std::condition_variable                   cond_decodificadas ; // hay sitio en 'decodificadas'
+   std::deque<std::pair<Textura *,std::string>> peticiones ;     // archivos por decodificar
+   std::deque<std::unique_ptr<Decodificada>> decodificadas ;     // texturas por subir
+   unsigned                                  num_pendientes = 0 ;
+   bool                                      terminar = false ;
+   std::vector<std::thread>                  hilos ;
+} ;
+
+#endif
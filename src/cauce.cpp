@@ -4,12 +4,19 @@
 #include <iomanip>
 
 #include "cauce.h"
+#include "errores-gl.h"
+#include "traza.h"
 
 // ---------------------------------------------------------------------------------------------
 
 GLchar   Cauce::log_buffer[ Cauce::log_long_max ] ; //  buffer para log 
 GLsizei  Cauce::log_long ;                           // longitud actual del buffer (en chars)
 
+GLuint     Cauce::ubo_frame         = 0 ; // UBO con el bloque por frame
+GLuint     Cauce::ubo_objeto        = 0 ; // UBO con el anillo de bloques por objeto
+GLsizeiptr Cauce::tam_bloque_objeto = 0 ; // tamaño de cada entrada del anillo
+GLuint     Cauce::sig_bloque_objeto = 0 ; // siguiente entrada libre del anillo
+
 // ---------------------------------------------------------------------------------------------
 // Basic pipeline shaders sources
 
@@ -17,32 +24,73 @@ const char * const fuente_vertex_shader = R"glsl(
    #version 330 core
 
    // Parámetros uniform (variables de entrada iguales para todos los vértices en cada primitiva)
+   // (las matrices están en bloques 'std140', guardados en UBOs compartidos por todos los programas)
 
-   uniform mat4 u_mat_modelview;  // variable uniform: matriz de transformación de posiciones
-   uniform mat4 u_mat_proyeccion; // variable uniform: matriz de proyección
-   uniform bool u_usar_color_plano; // 1 --> usar color plano, 0 -> usar color interpolado
+   layout( std140 ) uniform BloqueFrame   // datos por frame (punto de enlace 0)
+   {
+      mat4 u_mat_proyeccion; // matriz de proyección
+      mat4 u_mat_vista;      // matriz de vista (coordenadas de mundo a coordenadas de cámara)
+      vec4 u_tam_viewport;   // tamaño del viewport en pixels (en .x e .y)
+   };
+   layout( std140 ) uniform BloqueObjeto  // datos por objeto (punto de enlace 1)
+   {
+      mat4 u_mat_modelview;  // matriz de transformación de posiciones
+   };
 
    // Atributos de vértice (variables de entrada distintas para cada vértice)
    // (las posiciones de posición siempre deben estar en la 'location' 0)
 
    layout( location = 0 ) in vec3 atrib_posicion ; // atributo 0: posición del vértice
    layout( location = 1 ) in vec3 atrib_color ;    // atributo 1: color RGB del vértice
+   layout( location = 2 ) in vec2 atrib_coord_text ; // atributo 2: coordenadas de textura
+   layout( location = 3 ) in vec3 atrib_normal ;   // atributo 3: normal del vértice
+   layout( location = 7 ) in vec4 atrib_posicion_clip ; // posición ya transformada (al repetir transformados)
+
+   uniform bool u_repetir_transformados ; // true --> la posición viene ya transformada (cache de 'transform feedback')
+   uniform bool u_iluminacion ;           // true --> el color se multiplica por la luz que recibe el vértice
+
+   // fuente de luz direccional en coordenadas de cámara (desde arriba a la derecha del observador)
+   const vec3  dir_luz       = vec3( 0.37, 0.56, 0.74 ); // (normalizada)
+   const float luz_ambiental = 0.25 ,
+               luz_difusa    = 0.75 ;
 
    // output variables, going to the geometry shader
 
    out      vec3 var_color_interpolado ; // color RGB del vértice (el mismo que proporciona la aplic.)
    flat out vec3 var_color_plano  ; // color RGB del 'provoking vertex'
+   out      vec2 var_coord_text ;   // coordenadas de textura del vértice
+
+   // la posición debe ser idéntica en el programa básico y en el programa con aristas
+   // (la pasada previa de profundidad y la pasada de color pueden usar programas distintos)
+   invariant gl_Position ;
 
    // función principal que se ejecuta una vez por vértice
    void main()
    {
-      // copiamos color recibido en el color de salida, tal cual
-      var_color_interpolado = atrib_color ;
-      var_color_plano       = atrib_color ;
-
       // calcular las posiciones del vértice en posiciones de mundo y escribimos 'gl_Position'
-      // (se calcula multiplicando las cordenadas por la matrices 'modelview' y 'projection')
-      gl_Position = u_mat_proyeccion * u_mat_modelview * vec4( atrib_posicion, 1);
+      // (se calcula multiplicando las cordenadas por la matrices 'modelview', 'vista' y 'projection'),
+      // salvo si se repiten vértices capturados con 'transform feedback' (ya están transformados,
+      // y su color ya está iluminado)
+      vec3 color = atrib_color ;
+      if ( u_repetir_transformados )
+         gl_Position = atrib_posicion_clip ;
+      else
+      {
+         gl_Position = u_mat_proyeccion * u_mat_vista * u_mat_modelview * vec4( atrib_posicion, 1);
+
+         // iluminación (la normal se transforma con la modelview y la vista, se supone que no
+         // tienen escalados no uniformes), por las dos caras
+         if ( u_iluminacion )
+         {
+            vec3 normal = normalize( mat3( u_mat_vista * u_mat_modelview ) * atrib_normal );
+            color *= luz_ambiental + luz_difusa*abs( dot( normal, dir_luz ) );
+         }
+      }
+
+      // copiamos el color (iluminado o no) en el color de salida
+      var_color_interpolado = color ;
+      var_color_plano       = color ;
+      var_coord_text        = atrib_coord_text ;
    }
 )glsl";
 
@@ -52,16 +100,111 @@ const char * const fuente_fragment_shader = R"glsl(
     #version 330 core
 
    uniform bool u_usar_color_plano;     // false -> usar color interpolado, true --> usar color plano, 
+   uniform bool u_visualizar_overdraw;  // true --> cada fragmento aporta un incremento fijo (para mezcla aditiva)
+   uniform bool      u_usar_textura ;   // true --> el color se multiplica por el de la textura
+   uniform sampler2D u_textura ;        // textura (unidad 0)
    in      vec3 var_color_interpolado ; // color interpolado en el pixel.
    flat in vec3 var_color_plano ;       // color (plano) producido por el 'provoking vertex'
+   in      vec2 var_coord_text ;        // coordenadas de textura interpoladas
    layout( location = 0 ) out vec4 out_color_fragmento ; // variable de salida (color del pixel)
    
    void main()
    {
+      if ( u_visualizar_overdraw )
+      {
+         out_color_fragmento = vec4( 0.25, 0.10, 0.04, 1.0 ); // incremento por cada capa sombreada
+         return ;
+      }
       if ( u_usar_color_plano )
          out_color_fragmento = vec4( var_color_plano, 1.0 ) ; // el color del pixel es el color interpolado
       else 
          out_color_fragmento = vec4( var_color_interpolado, 1.0 ); // el color plano (de un único vértice)
+      if ( u_usar_textura )
+         out_color_fragmento *= texture( u_textura, var_coord_text );
+   }
+)glsl";
+
+// ------------------------------------------------------------------------------------------------------
+// Geometry shader del programa con aristas: calcula, para cada vértice del triángulo, su distancia 
+// en pixels a la arista opuesta. Interpolada sin corrección de perspectiva, da en cada fragmento
+// su distancia a cada una de las tres aristas.
+
+const char * const fuente_geometry_shader_aristas = R"glsl(
+   #version 330 core
+
+   layout( std140 ) uniform BloqueFrame   // datos por frame (punto de enlace 0)
+   {
+      mat4 u_mat_proyeccion; // matriz de proyección
+      mat4 u_mat_vista;      // matriz de vista (coordenadas de mundo a coordenadas de cámara)
+      vec4 u_tam_viewport;   // tamaño del viewport en pixels (en .x e .y)
+   };
+
+   layout( triangles ) in ;
+   layout( triangle_strip, max_vertices = 3 ) out ;
+
+   in      vec3 var_color_interpolado[] ; // colores producidos por el vertex shader
+   flat in vec3 var_color_plano[] ;
+   in      vec2 var_coord_text[] ;        // coordenadas de textura producidas por el vertex shader
+
+   out      vec3 var_color_interpolado_g ; // mismos colores y coordenadas, hacia el fragment shader
+   flat out vec3 var_color_plano_g ;
+   out      vec2 var_coord_text_g ;
+   noperspective out vec3 var_dist_aristas ; // distancia en pixels a cada arista
+
+   invariant gl_Position ;
+
+   void main()
+   {
+      // posiciones de los vértices en pixels
+      vec2 p[3] ;
+      for( int i = 0 ; i < 3 ; i++ )
+         p[i] = 0.5*u_tam_viewport.xy * gl_in[i].gl_Position.xy / gl_in[i].gl_Position.w ;
+
+      // altura de cada vértice sobre la arista opuesta (doble del área entre la longitud de la arista)
+      float doble_area = abs( (p[1].x-p[0].x)*(p[2].y-p[0].y) - (p[1].y-p[0].y)*(p[2].x-p[0].x) );
+      vec3  alturas    = doble_area / vec3( length( p[2]-p[1] ), length( p[2]-p[0] ), length( p[1]-p[0] ) );
+
+      for( int i = 0 ; i < 3 ; i++ )
+      {
+         gl_Position             = gl_in[i].gl_Position ;
+         var_color_interpolado_g = var_color_interpolado[i] ;
+         var_color_plano_g       = var_color_plano[i] ;
+         var_coord_text_g        = var_coord_text[i] ;
+         var_dist_aristas        = vec3( 0.0 );
+         var_dist_aristas[i]     = alturas[i] ;
+         EmitVertex();
+      }
+      EndPrimitive();
+   }
+)glsl";
+
+// ------------------------------------------------------------------------------------------------------
+// Fragment shader del programa con aristas: mezcla el color del relleno con el de las aristas
+// según la distancia del fragmento a la arista más cercana (con un pixel de suavizado).
+
+const char * const fuente_fragment_shader_aristas = R"glsl(
+   #version 330 core
+
+   uniform bool  u_usar_color_plano;     // false -> usar color interpolado, true --> usar color plano
+   uniform vec3  u_color_aristas;        // color de las aristas
+   uniform float u_ancho_aristas;        // ancho de las aristas en pixels
+   uniform bool      u_usar_textura ;     // true --> el color del relleno se multiplica por el de la textura
+   uniform sampler2D u_textura ;          // textura (unidad 0)
+   in      vec3 var_color_interpolado_g ; // color interpolado en el pixel.
+   flat in vec3 var_color_plano_g ;       // color (plano) producido por el 'provoking vertex'
+   in      vec2 var_coord_text_g ;        // coordenadas de textura interpoladas
+   noperspective in vec3 var_dist_aristas ; // distancia en pixels a cada arista
+   layout( location = 0 ) out vec4 out_color_fragmento ; // variable de salida (color del pixel)
+
+   void main()
+   {
+      vec3  color_relleno = u_usar_color_plano ? var_color_plano_g : var_color_interpolado_g ;
+      if ( u_usar_textura )
+         color_relleno *= texture( u_textura, var_coord_text_g ).rgb ;
+      float dist          = min( var_dist_aristas.x, min( var_dist_aristas.y, var_dist_aristas.z ));
+      float medio_ancho   = 0.5*u_ancho_aristas ;
+      float f_relleno     = smoothstep( medio_ancho - 0.5, medio_ancho + 0.5, dist );
+      out_color_fragmento = vec4( mix( u_color_aristas, color_relleno, f_relleno ), 1.0 );
    }
 )glsl";
 
@@ -70,9 +213,13 @@ const char * const fuente_fragment_shader = R"glsl(
 Cauce::Cauce()
 {
    using namespace std ;
+   ZONA_TRAZA( "Cauce::Cauce" );
 
+   crearUBOs();
    crearObjetoPrograma();
    inicializarUniforms();
+   enlazarBloquesUniforms( id_prog );
+   enlazarBloquesUniforms( id_prog_aristas );
    imprimeInfoUniforms();
 
    cout << "Cauce creado sin errores." << endl ;
@@ -82,9 +229,88 @@ Cauce::Cauce()
 
 void Cauce::inicializarUniforms()
 {
-   loc_mat_modelview  = leerLocation( "u_mat_modelview" );      
-   loc_mat_proyeccion = leerLocation( "u_mat_proyeccion" );     
-   loc_usar_color_plano = leerLocation( "u_usar_color_plano" );     
+   loc_usar_color_plano = leerLocation( id_prog, "u_usar_color_plano" );     
+   loc_visualizar_overdraw = leerLocation( id_prog, "u_visualizar_overdraw" );
+
+   loc_usar_color_plano_aristas = leerLocation( id_prog_aristas, "u_usar_color_plano" );
+   loc_color_aristas            = leerLocation( id_prog_aristas, "u_color_aristas" );
+   loc_ancho_aristas            = leerLocation( id_prog_aristas, "u_ancho_aristas" );
+
+   loc_usar_textura             = leerLocation( id_prog, "u_usar_textura" );
+   loc_usar_textura_aristas     = leerLocation( id_prog_aristas, "u_usar_textura" );
+   loc_repetir_tf               = leerLocation( id_prog, "u_repetir_transformados" );
+   loc_repetir_tf_aristas       = leerLocation( id_prog_aristas, "u_repetir_transformados" );
+   loc_iluminacion              = leerLocation( id_prog, "u_iluminacion" );
+   loc_iluminacion_aristas      = leerLocation( id_prog_aristas, "u_iluminacion" );
+
+   // dar valores iniciales a los uniforms del programa con aristas (deja activado el básico),
+   // los 'sampler' de los dos programas usan la unidad de textura 0
+   glUseProgram( id_prog_aristas );
+   glUniform3fv( loc_color_aristas, 1, glm::value_ptr( color_aristas ) );
+   glUniform1f( loc_ancho_aristas, ancho_aristas );
+   glUniform1i( leerLocation( id_prog_aristas, "u_textura" ), 0 );
+   glUseProgram( id_prog );
+   glUniform1i( leerLocation( id_prog, "u_textura" ), 0 );
+
+   // valores por defecto de las coordenadas de textura y de la normal (para VAOs sin esas tablas)
+   glVertexAttrib2f( ind_atrib_coord_text, 0.0, 0.0 );
+   glVertexAttrib3f( ind_atrib_normales, 0.0, 0.0, 1.0 );
+}
+// ---------------------------------------------------------------------------------------------
+// Crea los UBOs compartidos: el de datos por frame y el anillo de bloques por objeto. Cada 
+// entrada del anillo ocupa un múltiplo de GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, para poder 
+// enlazarla con 'glBindBufferRange'.
+
+void Cauce::crearUBOs()
+{
+   if ( ubo_frame != 0 ) // los UBOs ya se han creado (para otro cauce)
+      return ;
+   CError();
+
+   GLint alineamiento = 0 ;
+   glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alineamiento ); assert( 0 < alineamiento );
+   tam_bloque_objeto = ((sizeof(glm::mat4) + alineamiento - 1)/alineamiento)*alineamiento ;
+
+   DatosFrame datos_iniciales ;
+   glGenBuffers( 1, &ubo_frame ); assert( 0 < ubo_frame );
+   glBindBuffer( GL_UNIFORM_BUFFER, ubo_frame );
+   glBufferData( GL_UNIFORM_BUFFER, sizeof(DatosFrame), &datos_iniciales, GL_DYNAMIC_DRAW );
+   glBindBufferBase( GL_UNIFORM_BUFFER, punto_enlace_frame, ubo_frame );
+
+   glGenBuffers( 1, &ubo_objeto ); assert( 0 < ubo_objeto );
+   glBindBuffer( GL_UNIFORM_BUFFER, ubo_objeto );
+   glBufferData( GL_UNIFORM_BUFFER, num_bloques_objeto*tam_bloque_objeto, nullptr, GL_STREAM_DRAW );
+   glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+   sig_bloque_objeto = 0 ;
+
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+// Asocia cada bloque de uniforms del programa a su punto de enlace fijo (solo se hace una vez, 
+// al enlazar el programa; después cambiar de programa no requiere reenviar los datos)
+
+void Cauce::enlazarBloquesUniforms( GLuint prog )
+{
+   using namespace std ;
+   assert( 0 < prog );
+   CError();
+
+   const GLuint ind_bloque_frame  = glGetUniformBlockIndex( prog, "BloqueFrame" ),
+                ind_bloque_objeto = glGetUniformBlockIndex( prog, "BloqueObjeto" );
+
+   if ( ind_bloque_frame != GL_INVALID_INDEX )
+      glUniformBlockBinding( prog, ind_bloque_frame, punto_enlace_frame );
+   else 
+      cout << "Warning: uniform block 'BloqueFrame' is not declared or not used." << endl ;
+
+   if ( ind_bloque_objeto != GL_INVALID_INDEX )
+      glUniformBlockBinding( prog, ind_bloque_objeto, punto_enlace_objeto );
+   else 
+      cout << "Warning: uniform block 'BloqueObjeto' is not declared or not used." << endl ;
+
+   // dejar la modelview actual (la identidad) en el punto de enlace de objetos
+   actualizarBloqueObjeto();
+   CError();
 }
 // ---------------------------------------------------------------------------------------------
 
@@ -92,7 +318,7 @@ void Cauce::imprimeInfoUniforms()
 {
    using namespace std ;
    assert( 0 < id_prog );
-   assert( glGetError() == GL_NO_ERROR );
+   CError();
 
    GLint n_uniforms;
    glGetProgramiv( id_prog, GL_ACTIVE_UNIFORMS, &n_uniforms );
@@ -105,26 +331,35 @@ void Cauce::imprimeInfoUniforms()
       glGetActiveUniform( id_prog, (GLuint)i, log_long_max, &log_long, &n_entradas, &tipo, log_buffer);
       cout << "   Uniform " << i << ": " << log_buffer << " (" << NombreTipoGL(tipo) << " x" << n_entradas << ")." << endl ;
    }
-   assert( glGetError() == GL_NO_ERROR );
+   CError();
 }
 
 // ---------------------------------------------------------------------------------------------
 
 GLuint Cauce::compilarAdjuntarShader
 (  
+   GLuint       prog,                // objeto programa al que se adjunta el shader
    GLenum       shader_type,         // uno de GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER
    const char * shader_description,  // texto descriptivo por si hay error ('vertex shader', 'fragment shader', etc...)
    const char * shader_source        // código fuente del shader
 )
 {  using namespace std ;
+   ZONA_TRAZA( "Cauce::compilarAdjuntarShader" );
+#ifdef GL_COMPUTE_SHADER
+   assert( shader_type == GL_VERTEX_SHADER || 
+           shader_type == GL_GEOMETRY_SHADER || 
+           shader_type == GL_FRAGMENT_SHADER ||
+           shader_type == GL_COMPUTE_SHADER ) ;
+#else
    assert( shader_type == GL_VERTEX_SHADER || 
            shader_type == GL_GEOMETRY_SHADER || 
            shader_type == GL_FRAGMENT_SHADER ) ;
+#endif
 
    assert( shader_source != nullptr );
-   assert( id_prog > 0 );
+   assert( prog > 0 );
 
-   assert( glGetError() == GL_NO_ERROR );
+   CError();
 
    const GLuint shader_id     = glCreateShader( shader_type );
    GLint        source_length = strlen( shader_source );
@@ -148,20 +383,20 @@ GLuint Cauce::compilarAdjuntarShader
       exit(1);
    }
 
-   glAttachShader( id_prog, shader_id );
-   assert( glGetError() == GL_NO_ERROR );
+   glAttachShader( prog, shader_id );
+   CError();
    return shader_id ;
 }
 // ---------------------------------------------------------------------------------------------
 // Gets uniform location + warns if it is not active.
 
-GLint Cauce::leerLocation( const char * name )
+GLint Cauce::leerLocation( GLuint prog, const char * name )
 {
    using namespace std ;
    assert( name != nullptr );
-   assert( id_prog > 0 );
+   assert( prog > 0 );
 
-   const GLint location = glGetUniformLocation( id_prog, name ); 
+   const GLint location = glGetUniformLocation( prog, name ); 
 
    if ( location == -1 )
       cout << "Warning: uniform '" << name << "' is not declared or not used." << endl ;
@@ -172,42 +407,65 @@ GLint Cauce::leerLocation( const char * name )
 
 void Cauce::crearObjetoPrograma( )
 {
+   ZONA_TRAZA( "Cauce::crearObjetoPrograma" );
    // check preconditions
    using namespace std ;
    assert( fuente_vertex_shader != nullptr );
    assert( fuente_fragment_shader != nullptr );
    assert( id_prog == 0 );
-   assert( glGetError() == GL_NO_ERROR );
+   CError();
    
    // crear el programa, compilar los shaders
    id_prog = glCreateProgram() ;  assert( id_prog > 0 );
-   id_frag_shader = compilarAdjuntarShader( GL_VERTEX_SHADER,   "vertex shader",   fuente_vertex_shader );
-   id_vert_shader = compilarAdjuntarShader( GL_FRAGMENT_SHADER, "fragment shader", fuente_fragment_shader );
-   
+   id_frag_shader = compilarAdjuntarShader( id_prog, GL_VERTEX_SHADER,   "vertex shader",   fuente_vertex_shader );
+   id_vert_shader = compilarAdjuntarShader( id_prog, GL_FRAGMENT_SHADER, "fragment shader", fuente_fragment_shader );
 
+   // salidas del vertex shader que se capturan con 'transform feedback' (ver 'CacheTransformados'),
+   // intercaladas en el orden de 'DatosTransformado'
+   const GLchar * const salidas_capturadas[3] = { "gl_Position", "var_color_interpolado", "var_coord_text" };
+   glTransformFeedbackVaryings( id_prog, 3, salidas_capturadas, GL_INTERLEAVED_ATTRIBS );
+   
    // enlazar el programa y ver si ha habido errores
+   enlazarPrograma( id_prog, "objeto programa" );
+
+   // crear el programa con aristas superpuestas (mismo vertex shader, más un geometry shader)
+   id_prog_aristas = glCreateProgram() ;  assert( id_prog_aristas > 0 );
+   id_vert_shader_aristas = compilarAdjuntarShader( id_prog_aristas, GL_VERTEX_SHADER,   "vertex shader",   fuente_vertex_shader );
+   id_geom_shader_aristas = compilarAdjuntarShader( id_prog_aristas, GL_GEOMETRY_SHADER, "geometry shader (aristas)", fuente_geometry_shader_aristas );
+   id_frag_shader_aristas = compilarAdjuntarShader( id_prog_aristas, GL_FRAGMENT_SHADER, "fragment shader (aristas)", fuente_fragment_shader_aristas );
+   enlazarPrograma( id_prog_aristas, "objeto programa con aristas" );
+   
+   // activar (usar) el programa
+   glUseProgram( id_prog );
+   CError();
+   cout << "El objeto programa se ha creado sin problemas." << endl ; 
+}
+// ---------------------------------------------------------------------------------------------
+
+void Cauce::enlazarPrograma( GLuint prog, const char * descripcion )
+{
+   using namespace std ;
+   ZONA_TRAZA( "Cauce::enlazarPrograma" );
+   assert( prog > 0 );
+   assert( descripcion != nullptr );
+
    GLint estado_prog ;
-   glLinkProgram( id_prog ) ;   
-   assert( glGetError() == GL_NO_ERROR );
+   glLinkProgram( prog ) ;   
+   CError();
 
-   glGetProgramInfoLog( id_prog, log_long_max, &log_long, log_buffer );
+   glGetProgramInfoLog( prog, log_long_max, &log_long, log_buffer );
    if ( log_long > 0 )
    {
-      cout << "Log de enlazado del objeto programa:" << endl ;
+      cout << "Log de enlazado del " << descripcion << ":" << endl ;
       cout << log_buffer << endl ;
    }
    
-   glGetProgramiv( id_prog, GL_LINK_STATUS, &estado_prog );
+   glGetProgramiv( prog, GL_LINK_STATUS, &estado_prog );
    if ( estado_prog != GL_TRUE )
    {  
-      cout << "Errores al enlazar el objeto programa. Aborto." << endl ;
+      cout << "Errores al enlazar el " << descripcion << ". Aborto." << endl ;
       exit(1);
    }
-   
-   // activar (usar) el programa
-   glUseProgram( id_prog );
-   assert( glGetError() == GL_NO_ERROR );
-   cout << "El objeto programa se ha creado sin problemas." << endl ; 
 }
 
 // ---------------------------------------------------------------------------------------------
@@ -217,9 +475,9 @@ void Cauce::crearObjetoPrograma( )
 void Cauce::activar()
 {
    assert( id_prog > 0 );
-   assert( glGetError() == GL_NO_ERROR );
-   glUseProgram( id_prog );
-   assert( glGetError() == GL_NO_ERROR );
+   CError();
+   glUseProgram( dibujar_aristas ? id_prog_aristas : id_prog );
+   CError();
 }
 
 // ---------------------------------------------------------------------------------------------
@@ -233,16 +491,14 @@ void Cauce::fijarColor( const glm::vec3 & nuevo_color )
 
 void Cauce::pushColor()
 {
-   pila_colores.push_back( color );
+   pila_colores.push( color );
 }
 // -----------------------------------------------------------------------------
 
 void Cauce::popColor()
 {
    using namespace glm ;
-   assert( pila_colores.size() > 0 );
-   const vec3 c = pila_colores[ pila_colores.size()-1] ;
-   pila_colores.pop_back();
+   const vec3 c = pila_colores.pop();
    fijarColor( c );
 }
 
@@ -251,53 +507,186 @@ void Cauce::popColor()
 void Cauce::fijarUsarColorPlano( const bool nuevo_usar_color_plano )
 {
    assert( loc_usar_color_plano != -1 ); 
-   assert( glGetError() == GL_NO_ERROR );
-   glUniform1i( loc_usar_color_plano, nuevo_usar_color_plano );
-   assert( glGetError() == GL_NO_ERROR );
+   CError();
+   usar_color_plano = nuevo_usar_color_plano ;
+   glUniform1i( dibujar_aristas ? loc_usar_color_plano_aristas : loc_usar_color_plano, nuevo_usar_color_plano );
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+
+void Cauce::fijarVisualizarOverdraw( const bool nuevo_visualizar_overdraw )
+{
+   assert( loc_visualizar_overdraw != -1 ); 
+   assert( ! dibujar_aristas ); // solo está en el programa básico
+   CError();
+   glUniform1i( loc_visualizar_overdraw, nuevo_visualizar_overdraw );
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+
+// Los uniforms que no están en bloques son propios de cada programa: al cambiar de programa
+// se reenvían los valores actuales de 'usar color plano', 'usar textura', 'repetir transformados'
+// e 'iluminación'
+// (las matrices están en los UBOs compartidos).
+
+void Cauce::fijarDibujarAristas( const bool nuevo_dibujar_aristas )
+{
+   if ( nuevo_dibujar_aristas == dibujar_aristas )
+      return ;
+   CError();
+   dibujar_aristas = nuevo_dibujar_aristas ;
+   glUseProgram( dibujar_aristas ? id_prog_aristas : id_prog );
+   glUniform1i( dibujar_aristas ? loc_usar_color_plano_aristas : loc_usar_color_plano, usar_color_plano );
+   glUniform1i( dibujar_aristas ? loc_usar_textura_aristas : loc_usar_textura, usarTextura() );
+   glUniform1i( dibujar_aristas ? loc_repetir_tf_aristas : loc_repetir_tf, repetir_transformados );
+   glUniform1i( dibujar_aristas ? loc_iluminacion_aristas : loc_iluminacion, iluminacion );
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+
+void Cauce::fijarRepetirTransformados( const bool nuevo_repetir_transformados )
+{
+   CError();
+   repetir_transformados = nuevo_repetir_transformados ;
+   glUniform1i( dibujar_aristas ? loc_repetir_tf_aristas : loc_repetir_tf, repetir_transformados );
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+
+void Cauce::fijarIluminacion( const bool nueva_iluminacion )
+{
+   CError();
+   iluminacion = nueva_iluminacion ;
+   glUniform1i( dibujar_aristas ? loc_iluminacion_aristas : loc_iluminacion, iluminacion );
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+// Una textura que todavía no está lista se trata como si no hubiera textura.
+
+void Cauce::fijarTextura( Textura * nueva_textura )
+{
+   CError();
+   const bool habia_textura = usarTextura();
+   textura = nueva_textura ;
+   if ( usarTextura() )
+   {
+      glActiveTexture( GL_TEXTURE0 );
+      glBindTexture( GL_TEXTURE_2D, textura->leerId() );
+   }
+   else if ( habia_textura ) // no dejar la textura enlazada (algunos drivers la muestrean igualmente)
+   {
+      glActiveTexture( GL_TEXTURE0 );
+      glBindTexture( GL_TEXTURE_2D, 0 );
+   }
+   glUniform1i( dibujar_aristas ? loc_usar_textura_aristas : loc_usar_textura, usarTextura() );
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+
+void Cauce::fijarColorAnchoAristas( const glm::vec3 & nuevo_color_aristas, const float nuevo_ancho_aristas )
+{
+   assert( 0.0f < nuevo_ancho_aristas );
+   CError();
+   color_aristas = nuevo_color_aristas ;
+   ancho_aristas = nuevo_ancho_aristas ;
+
+   glUseProgram( id_prog_aristas );
+   glUniform3fv( loc_color_aristas, 1, glm::value_ptr( color_aristas ) );
+   glUniform1f( loc_ancho_aristas, ancho_aristas );
+   if ( ! dibujar_aristas )
+      glUseProgram( id_prog );
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+
+void Cauce::fijarViewport( const int ancho, const int alto )
+{
+   glViewport( 0, 0, ancho, alto );
+   datos_frame.tam_viewport = { float(ancho), float(alto), 0.0, 0.0 };
+   actualizarBloqueFrame();
 }
 // ---------------------------------------------------------------------------------------------
 
 void Cauce::fijarMatrizProyeccion( const glm::mat4 & new_projection_mat )
 {
-   assert( loc_mat_proyeccion != -1 ); 
-   assert( glGetError() == GL_NO_ERROR );
-   mat_proyeccion = new_projection_mat ;
-   glUniformMatrix4fv( loc_mat_proyeccion, 1, GL_FALSE, glm::value_ptr(mat_proyeccion) );
-   assert( glGetError() == GL_NO_ERROR );
+   datos_frame.mat_proyeccion = new_projection_mat ;
+   actualizarBloqueFrame();
+}
+// ---------------------------------------------------------------------------------------------
+
+void Cauce::fijarMatrizVista( const glm::mat4 & new_view_mat )
+{
+   datos_frame.mat_vista = new_view_mat ;
+   actualizarBloqueFrame();
+}
+// ---------------------------------------------------------------------------------------------
+
+void Cauce::actualizarBloqueFrame()
+{
+   assert( ubo_frame != 0 );
+   CError();
+   glBindBuffer( GL_UNIFORM_BUFFER, ubo_frame );
+   glBufferSubData( GL_UNIFORM_BUFFER, 0, sizeof(DatosFrame), &datos_frame );
+   glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+// Cada cambio de la modelview usa una entrada nueva del anillo, así no se sobreescriben datos 
+// que la GPU puede estar usando todavía para dibujos previos. Al dar la vuelta al anillo, 
+// se pide un nuevo almacenamiento para el buffer ('orphaning'), sin esperar a la GPU.
+
+void Cauce::actualizarBloqueObjeto()
+{
+   assert( ubo_objeto != 0 );
+   CError();
+
+   glBindBuffer( GL_UNIFORM_BUFFER, ubo_objeto );
+   if ( sig_bloque_objeto == num_bloques_objeto )
+   {
+      glBufferData( GL_UNIFORM_BUFFER, num_bloques_objeto*tam_bloque_objeto, nullptr, GL_STREAM_DRAW );
+      sig_bloque_objeto = 0 ;
+   }
+   const GLintptr desplazamiento = sig_bloque_objeto*tam_bloque_objeto ;
+   glBufferSubData( GL_UNIFORM_BUFFER, desplazamiento, sizeof(glm::mat4), glm::value_ptr(mat_modelview) );
+   glBindBufferRange( GL_UNIFORM_BUFFER, punto_enlace_objeto, ubo_objeto, desplazamiento, sizeof(glm::mat4) );
+   glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+   sig_bloque_objeto++ ;
+
+   CError();
 }
 // ---------------------------------------------------------------------------------------------
 
 void Cauce::resetMM()
 {
-   assert( loc_mat_modelview != -1 );  
-   assert( glGetError() == GL_NO_ERROR );
    mat_modelview = glm::mat4( 1.0f );
-   pila_mat_modelview.clear();
-   glUniformMatrix4fv( loc_mat_modelview, 1, GL_FALSE, glm::value_ptr(mat_modelview) );
-   assert( glGetError() == GL_NO_ERROR );
+   pila_mat_modelview.vaciar();
+   actualizarBloqueObjeto();
 }
 // ---------------------------------------------------------------------------------------------
 
 void Cauce::pushMM()
 {
-   pila_mat_modelview.push_back( mat_modelview );
+   pila_mat_modelview.push( mat_modelview );
 }
 // ---------------------------------------------------------------------------------------------
 
 void Cauce::compMM( const glm::mat4 & mat )
 {
-   assert( loc_mat_modelview >= 0 );
    mat_modelview = mat_modelview * mat ;
-   glUniformMatrix4fv( loc_mat_modelview, 1, GL_FALSE, glm::value_ptr(mat_modelview) );
+   actualizarBloqueObjeto();
 }
 // ---------------------------------------------------------------------------------------------
 
 void Cauce::popMM()
 {
-   assert( loc_mat_modelview >= 0 );
-   assert( pila_mat_modelview.size() > 0 );
-   mat_modelview = pila_mat_modelview[ pila_mat_modelview.size()-1 ] ;
-   pila_mat_modelview.pop_back();
-   glUniformMatrix4fv( loc_mat_modelview, 1, GL_FALSE, glm::value_ptr(mat_modelview) );
+   mat_modelview = pila_mat_modelview.pop();
+   actualizarBloqueObjeto();
+}
+// --------------------------------------------------------------------------------------------
+
+void Cauce::fijarMM( const glm::mat4 & mat )
+{
+   mat_modelview = mat ;
+   actualizarBloqueObjeto();
 }
 // --------------------------------------------------------------------------------------------
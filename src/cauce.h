@@ -5,6 +5,8 @@
 
 #include <vector>
 #include "glincludes.h"
+#include "textura.h"
+#include "pila-fija.h"
 
 
 // ****************************************************************************************
@@ -18,25 +20,43 @@ class Cauce
    // crea un objeto cauce vacío
    Cauce() ;
 
-   // compila un shader y lo adjunta al objeto programa 'id_prog' (que debe ser >0)
+   // compila un shader y lo adjunta a un objeto programa
    //
-   // @param shader_type        (GLenum) one of: GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER
+   // @param prog               (GLuint) program object name (must be >0)
+   // @param shader_type        (GLenum) one of: GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER 
+   //                                   (or GL_COMPUTE_SHADER, with OpenGL 4.3)
    // @param shader_description (const char *) text description for error log ('vertex shader', 'fragment shader', etc...)
    // @param shader_source      (const char *) source string
    //
-   GLuint compilarAdjuntarShader(  GLenum shader_type, const char * shader_description, const char * shader_source );
+   GLuint compilarAdjuntarShader(  GLuint prog, GLenum shader_type, const char * shader_description, const char * shader_source );
+
+   // enlaza un objeto programa con sus shaders ya adjuntos, aborta si hay errores
+   //
+   // @param prog        (GLuint) program object name (must be >0)
+   // @param descripcion (const char *) text description for the log
+   //
+   void enlazarPrograma( GLuint prog, const char * descripcion );
                                        
    // lee la 'location' de un uniform, da una advertencia si no está activo
+   // @param prog (GLuint) - program object name
    // @param name (conat char *) - uniform name in the shaders sources
    //
-   GLint leerLocation( const char * name );
+   GLint leerLocation( GLuint prog, const char * name );
 
-   // crea, compila y usa el objeto programa
+   // crea, compila y usa el objeto programa (y crea el programa con aristas)
    void crearObjetoPrograma( );
 
    // lee las 'locations' de los parámetros uniforms y los inicializa 
    void inicializarUniforms();
 
+   // asocia los bloques de uniforms de un programa a sus puntos de enlace fijos
+   // @param prog (GLuint) - program object name
+   //
+   void enlazarBloquesUniforms( GLuint prog );
+
+   // crea los UBOs compartidos por todos los objetos programa (solo la primera vez)
+   static void crearUBOs();
+
    // imprime los nombres y tipos de los uniform del programa (para debug)
    void imprimeInfoUniforms();
 
@@ -53,6 +73,68 @@ class Cauce
    //
    void fijarUsarColorPlano( const bool nuevo_usar_color_plano );
 
+   // devuelve el valor actual de 'usar_color_plano'
+   inline bool leerUsarColorPlano() const { return usar_color_plano ; }
+
+   // activa o desactiva el modo de visualización de 'overdraw' (cada fragmento 
+   // sombreado suma una cantidad fija de color, para usar con mezcla aditiva)
+   // @param nuevo_visualizar_overdraw (bool) - nuevo valor del booleano
+   //
+   void fijarVisualizarOverdraw( const bool nuevo_visualizar_overdraw );
+
+   // fija la textura con la que se multiplica el color de los fragmentos (en la unidad 0)
+   // @param nueva_textura (Textura *) - textura a usar, o nulo para no usar textura (si no 
+   //                                    está lista se visualiza como si fuera nula)
+   //
+   void fijarTextura( Textura * nueva_textura );
+
+   // devuelve la textura actual (puede ser nula)
+   inline Textura * leerTextura() const { return textura ; }
+
+   // activa o desactiva la repetición de vértices ya transformados: el vertex shader toma la 
+   // posición en coordenadas de recortado del atributo 'ind_atrib_posicion_clip', en lugar de 
+   // transformar la del atributo de posiciones (ver 'CacheTransformados')
+   // @param nuevo_repetir_transformados (bool) - nuevo valor del booleano
+   //
+   void fijarRepetirTransformados( const bool nuevo_repetir_transformados );
+
+   // activa o desactiva la iluminación: el color de cada vértice se multiplica por la luz que
+   // recibe (ambiental más difusa de una fuente direccional fija en coordenadas de cámara, por
+   // las dos caras), calculada en el vertex shader con el atributo de normales (el valor por 
+   // defecto, para VAOs sin normales, es (0,0,1)). Al repetir transformados, el color capturado 
+   // ya está iluminado.
+   // @param nueva_iluminacion (bool) - nuevo valor del booleano
+   //
+   void fijarIluminacion( const bool nueva_iluminacion );
+
+   // devuelve true si la iluminación está activada
+   inline bool leerIluminacion() const { return iluminacion ; }
+
+   // devuelve el color actual (valor por defecto del atributo de color)
+   inline const glm::vec3 & leerColor() const { return color ; }
+
+   // activa o desactiva el dibujo de aristas superpuestas al relleno en una única pasada 
+   // (cambia al programa con 'geometry shader', que calcula en cada fragmento su distancia
+   // en pixels a las aristas del triángulo). Solo se puede usar con primitivas de tipo triángulo.
+   // @param nuevo_dibujar_aristas (bool) - nuevo valor del booleano
+   //
+   void fijarDibujarAristas( const bool nuevo_dibujar_aristas );
+
+   // devuelve true si está activado el dibujo de aristas superpuestas 
+   inline bool leerDibujarAristas() const { return dibujar_aristas ; }
+
+   // fija el color y el ancho (en pixels) de las aristas superpuestas
+   // @param nuevo_color_aristas (vec3)  - color de las aristas
+   // @param nuevo_ancho_aristas (float) - ancho de las aristas en pixels (>0)
+   //
+   void fijarColorAnchoAristas( const glm::vec3 & nuevo_color_aristas, const float nuevo_ancho_aristas );
+
+   // fija el viewport (toda la ventana) y su tamaño en los datos por frame
+   // @param ancho (int) - ancho en pixels
+   // @param alto  (int) - alto en pixels
+   //
+   void fijarViewport( const int ancho, const int alto );
+
    // inserta una copia del color actual en el tope de la pila de colores
    void pushColor();
 
@@ -73,18 +155,55 @@ class Cauce
    // removes the current matrix on top of the modelview matrix stack (cannot be empty)
    void popMM();
 
+   // sets the current modelview matrix (without modifying the stack)
+   // @param mat (mat4) -- new modelview matrix
+   //
+   void fijarMM( const glm::mat4 & mat );
+
+   // returns the current modelview matrix
+   inline const glm::mat4 & leerMM() const { return mat_modelview ; }
+
+   // returns the current projection matrix
+   inline const glm::mat4 & leerMatrizProyeccion() const { return datos_frame.mat_proyeccion ; }
+
    // sets the projection matrix
    void fijarMatrizProyeccion( const glm::mat4 & new_projection_mat );
 
+   // sets the view matrix (world to camera coordinates, applied after the modelview matrix)
+   void fijarMatrizVista( const glm::mat4 & new_view_mat );
+
+   // returns the current view matrix
+   inline const glm::mat4 & leerMatrizVista() const { return datos_frame.mat_vista ; }
+
    // índice del atributo de posiciones (debe ser 0)
    static constexpr GLuint ind_atrib_posiciones = 0 ; 
 
    // índice del atributo 'color de vértice' 
    static constexpr GLuint ind_atrib_colores = 1 ;
 
-   // número total de atributos que gestiona este cauce (0->positions, 1->colors)
-   static constexpr GLuint num_atribs = 2 ;
-   
+   // índice del atributo 'coordenadas de textura' (vec2)
+   static constexpr GLuint ind_atrib_coord_text = 2 ;
+
+   // índice del atributo 'normal del vértice' (vec3), usado al iluminar
+   static constexpr GLuint ind_atrib_normales = 3 ;
+
+   // número total de atributos que gestiona este cauce (0->positions, 1->colors, 2->texture coords., 3->normals)
+   static constexpr GLuint num_atribs = 4 ;
+
+   // índice del atributo con posiciones ya transformadas (vec4), solo al repetir transformados 
+   // (está fuera del rango de atributos de los VAOs)
+   static constexpr GLuint ind_atrib_posicion_clip = 7 ;
+
+   // puntos de enlace (binding points) fijos de los bloques de uniforms, iguales en todos los programas
+   static constexpr GLuint punto_enlace_frame  = 0 ; // bloque 'BloqueFrame' (datos por frame: proyección, vista)
+   static constexpr GLuint punto_enlace_objeto = 1 ; // bloque 'BloqueObjeto' (datos por objeto: modelview)
+
+   // número de entradas del anillo de bloques por objeto en el UBO de objetos
+   static constexpr GLuint num_bloques_objeto = 1024 ;
+
+   // capacidad de las pilas de colores y de matrices modelview (máxima profundidad de anidamiento)
+   static constexpr unsigned max_pila = 64 ;
+
    protected: // ---------------------------
    
    // nombres de objeto programa y objetos shaders
@@ -92,26 +211,75 @@ class Cauce
           id_frag_shader = 0 , // nombre o identificador del objeto shader (fragment shader)
           id_vert_shader = 0 ; // nombre o identificador del objeto shader (vertex shader)
 
+   // nombres del objeto programa con aristas superpuestas y de sus shaders propios
+   GLuint id_prog_aristas        = 0 , // objeto programa (vertex + geometry + fragment shader)
+          id_vert_shader_aristas = 0 , // objeto shader (vertex shader, mismo fuente que el básico)
+          id_geom_shader_aristas = 0 , // objeto shader (geometry shader)
+          id_frag_shader_aristas = 0 ; // objeto shader (fragment shader)
+
    // variables estáticas con información del log errores
    static constexpr GLsizei  log_long_max = 1024*16 ;     //  longitud máxima en chars del buffer para log 
    static           GLchar   log_buffer[ log_long_max ] ; //  buffer para log 
    static           GLsizei  log_long ;                   // longitud actual del buffer
 
-   // pila de colores 
-   std::vector<glm::vec3> pila_colores ;  
+   // pila de colores (de capacidad fija, apilar no reserva memoria)
+   PilaFija<glm::vec3,max_pila> pila_colores ;  
+
+   // contenido del bloque 'BloqueFrame' (con la disposición 'std140' del shader)
+   struct DatosFrame
+   {
+      glm::mat4 mat_proyeccion = glm::mat4(1.0) ; // current projection matrix (initially equal to the identity matrix)
+      glm::mat4 mat_vista      = glm::mat4(1.0) ; // current view matrix (initially equal to the identity matrix)
+      glm::vec4 tam_viewport   = { 512.0, 512.0, 0.0, 0.0 } ; // viewport size in pixels (in .x and .y)
+   } ;
+
+   // UBOs compartidos por todos los objetos programa (se crean al crear el primer cauce)
+   static GLuint     ubo_frame ;          // UBO con el bloque por frame ('BloqueFrame')
+   static GLuint     ubo_objeto ;         // UBO con un anillo de bloques por objeto ('BloqueObjeto')
+   static GLsizeiptr tam_bloque_objeto ;  // tamaño de cada entrada del anillo (múltiplo del alineamiento)
+   static GLuint     sig_bloque_objeto ;  // índice de la siguiente entrada libre del anillo
+
+   // escribe la modelview actual en la siguiente entrada del anillo de bloques por objeto,
+   // y enlaza esa entrada (con 'glBindBufferRange') en el punto de enlace de objetos
+   void actualizarBloqueObjeto();
+
+   // escribe los datos por frame en el UBO de frame
+   void actualizarBloqueFrame();
 
    // variables con valores actuales de los uniforms y locations asociados
 
    glm::vec3 color                = { 0.0, 0.0, 0.0 }; // color actual
+   bool      usar_color_plano     = false ;            // valor actual del uniform 'use flat color'
    GLint     loc_usar_color_plano = -1 ;               // location for the uniform 'use flat color'
-   
+   GLint     loc_visualizar_overdraw = -1 ;            // location for the uniform 'overdraw visualization'
+
+   bool      dibujar_aristas              = false ;    // true si está activo el programa con aristas
+   glm::vec3 color_aristas                = { 0.0, 0.0, 0.0 }; // color de las aristas superpuestas
+   float     ancho_aristas                = 2.0 ;      // ancho en pixels de las aristas superpuestas (la mitad queda dentro del triángulo)
+   GLint     loc_usar_color_plano_aristas = -1 ;       // location for 'use flat color' (program with edges)
+   GLint     loc_color_aristas            = -1 ;       // location for the uniform 'edges color'
+   GLint     loc_ancho_aristas            = -1 ;       // location for the uniform 'edges width'
+
+   Textura * textura                  = nullptr ;  // textura actual (nulo si no hay)
+   GLint     loc_usar_textura         = -1 ;       // location for the uniform 'use texture'
+   GLint     loc_usar_textura_aristas = -1 ;       // location for 'use texture' (program with edges)
+
+   // true si hay textura actual y está lista
+   inline bool usarTextura() const { return textura != nullptr && textura->lista() ; }
+
+   bool      repetir_transformados  = false ;    // valor actual del uniform 'repeat transformed vertices'
+   GLint     loc_repetir_tf         = -1 ;       // location for 'repeat transformed vertices'
+   GLint     loc_repetir_tf_aristas = -1 ;       // location for 'repeat transformed vertices' (program with edges)
+
+   bool      iluminacion            = false ;    // valor actual del uniform 'lighting'
+   GLint     loc_iluminacion        = -1 ;       // location for 'lighting'
+   GLint     loc_iluminacion_aristas = -1 ;      // location for 'lighting' (program with edges)
+
    glm::mat4              mat_modelview      = glm::mat4(1.0);  // current modelview matrix (initially equal to the identity matrix)
-   std::vector<glm::mat4> pila_mat_modelview ;                 // stack for saved modelview matrices
-   GLint                  loc_mat_modelview  = -1 ;             // uniform location for the modelview matrix
-   
-   glm::mat4 mat_proyeccion     = glm::mat4(1.0);  // current projection matrix (initially equal to the identity matrix)
-   GLint     loc_mat_proyeccion = -1 ;             // uniform location for projection matrix
+   PilaFija<glm::mat4,max_pila> pila_mat_modelview ;           // stack for saved modelview matrices (fixed capacity)
    
+   DatosFrame datos_frame ; // current per-frame data (projection and view matrices)
+
    
 };
 
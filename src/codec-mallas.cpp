@@ -0,0 +1,727 @@
+// Códec de mallas comprimidas: índices con deltas y atributos cuantizados, decodificación en paralelo
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "codec-mallas.h"
+#include "paralelo.h"
+#include "traza.h"
+
+// decodificación vectorizada: SSSE3 en x86 (comprobado en tiempo de ejecución, los ejecutables se
+// compilan sin '-mssse3'), NEON en ARM de 64 bits, y en otro caso, escalar
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 )
+#include <tmmintrin.h>
+#define CODEC_USAR_SSSE3
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define CODEC_FUNCION_SSSE3
+#else
+#define CODEC_FUNCION_SSSE3 __attribute__(( target( "ssse3" ) ))
+#endif
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#include <arm_neon.h>
+#define CODEC_USAR_NEON
+#endif
+
+// ------------------------------------------------------------------------------------------------------
+
+constexpr char     magia_codec[4]  = { 'M', 'C', 'M', '1' } ;
+constexpr uint32_t version_codec   = 1 ;
+constexpr uint32_t tam_bloque      = 1u << 14 ; // valores por bloque de un flujo (se decodifican en paralelo)
+constexpr uint32_t tam_tramo       = 256 ;      // valores que se decodifican de una vez (en la pila)
+constexpr unsigned relleno_bloque  = 16 ;       // bytes a cero tras cada bloque (lecturas de 16 bytes)
+constexpr unsigned max_bits_cuantiz = 24 ;      // (un 'float' tiene 24 bits de mantisa)
+constexpr uint32_t max_paso        = 8 ;        // máxima distancia entre un valor y el que lo predice
+constexpr uint32_t pasos_candidatos[] = { 1, 3, 6 } ; // distancias que prueba el codificador (6: pares de triángulos)
+
+// ------------------------------------------------------------------------------------------------------
+// Tablas para decodificar 4 valores con un byte de control: máscara de la permutación de bytes
+// que lleva los bytes de cada valor a su entero de 32 bits (0x80 = byte a cero), y número de
+// bytes que ocupan los 4 valores
+
+struct TablasVByte
+{
+   alignas(16) uint8_t mascara[256][16] ;
+   uint8_t             longitud[256] ;
+
+   TablasVByte()
+   {
+      for( unsigned c = 0 ; c < 256 ; c++ )
+      {
+         unsigned pos = 0 ;
+         for( unsigned j = 0 ; j < 4 ; j++ )
+         {
+            const unsigned l = ( ( c >> 2*j ) & 3 ) + 1 ;
+            for( unsigned b = 0 ; b < 4 ; b++ )
+               mascara[c][4*j+b] = ( b < l ) ? uint8_t( pos + b ) : uint8_t( 0x80 );
+            pos += l ;
+         }
+         longitud[c] = uint8_t( pos );
+      }
+   }
+} ;
+
+static const TablasVByte tablas_vbyte ;
+
+// ------------------------------------------------------------------------------------------------------
+// conversión entre enteros con signo (las diferencias) y sin signo con el signo en el bit 0
+
+static inline uint32_t Zigzag( const uint32_t d )
+{
+   return ( d << 1 ) ^ uint32_t( int32_t( d ) >> 31 );
+}
+static inline uint32_t DesZigzag( const uint32_t z )
+{
+   return ( z >> 1 ) ^ ( 0u - ( z & 1u ) );
+}
+
+// ******************************************************************************************************
+// Codificación
+// ------------------------------------------------------------------------------------------------------
+// añade los bytes de un valor (o de una tabla de tamaño fijo) al final de un vector
+
+template< class T >
+static void Escribir( std::vector<unsigned char> & salida, const T & valor )
+{
+   const size_t tam = salida.size();
+   salida.resize( tam + sizeof( T ) );
+   std::memcpy( salida.data() + tam, &valor, sizeof( T ) );
+}
+// ------------------------------------------------------------------------------------------------------
+// número de bytes que ocupa un valor con delta+zigzag
+
+static inline uint32_t LongitudValor( const uint32_t z )
+{
+   return ( z < ( 1u << 8 ) ) ? 1 : ( z < ( 1u << 16 ) ) ? 2 : ( z < ( 1u << 24 ) ) ? 3 : 4 ;
+}
+// ------------------------------------------------------------------------------------------------------
+// elige la distancia con la que se calculan los deltas de un flujo, la de los candidatos con la
+// que ocupan menos bytes: 1 en general, o p.ej. 6 en las tablas de índices de mallas formadas por
+// cuadriláteros (pares de triángulos), donde cada índice es cercano al del par anterior
+
+static uint32_t ElegirPaso( const std::vector<uint32_t> & valores )
+{
+   uint32_t      mejor_paso  = 1 ;
+   unsigned long mejor_bytes = ~0ul ;
+   for( const uint32_t paso : pasos_candidatos )
+   {
+      unsigned long bytes = 0 ;
+      for( size_t i = 0 ; i < valores.size() ; i++ )
+         bytes += LongitudValor( Zigzag( valores[i] - ( i >= paso ? valores[i-paso] : 0u ) ) );
+      if ( bytes < mejor_bytes )
+      {
+         mejor_bytes = bytes ;
+         mejor_paso  = paso ;
+      }
+   }
+   return mejor_paso ;
+}
+// ------------------------------------------------------------------------------------------------------
+// codifica un bloque de 'n' valores (delta respecto al valor 'paso' posiciones antes, zigzag y
+// Stream VByte): los bytes de control, los de los valores y el relleno
+
+static void CodificarBloque( const uint32_t * valores, const uint32_t n, const uint32_t paso,
+                             std::vector<unsigned char> & salida )
+{
+   const size_t inicio      = salida.size(),
+                num_control = ( n + 3 )/4 ;
+   salida.resize( inicio + num_control + 4ul*n + relleno_bloque, 0 ); // (tamaño máximo)
+   unsigned char * const control = salida.data() + inicio ;
+   unsigned char *       datos   = control + num_control ;
+
+   for( uint32_t i = 0 ; i < n ; i++ )
+   {
+      const uint32_t z = Zigzag( valores[i] - ( i >= paso ? valores[i-paso] : 0u ) ),
+                     l = LongitudValor( z );
+      control[i/4] |= uint8_t( ( l-1 ) << 2*( i%4 ) );
+      for( uint32_t b = 0 ; b < l ; b++ )
+         *datos++ = uint8_t( z >> 8*b );
+   }
+   salida.resize( size_t( datos - salida.data() ) + relleno_bloque ); // (el relleno ya está a cero)
+}
+// ------------------------------------------------------------------------------------------------------
+// codifica un flujo de valores: número de valores, distancia de los deltas, tabla con el
+// desplazamiento de cada bloque (desde el inicio de los bloques) y los bloques
+
+static void CodificarFlujo( const std::vector<uint32_t> & valores, std::vector<unsigned char> & salida )
+{
+   const uint32_t num_valores = uint32_t( valores.size() ),
+                  num_bloques = ( num_valores + tam_bloque - 1 )/tam_bloque ,
+                  paso        = ElegirPaso( valores );
+   std::vector<unsigned char> bloques ;
+   std::vector<uint64_t>      desplazamientos( num_bloques );
+   for( uint32_t b = 0 ; b < num_bloques ; b++ )
+   {
+      desplazamientos[b] = bloques.size() ;
+      const uint32_t v0 = b*tam_bloque ;
+      CodificarBloque( valores.data() + v0, std::min( tam_bloque, num_valores - v0 ), paso, bloques );
+   }
+   Escribir( salida, num_valores );
+   Escribir( salida, paso );
+   Escribir( salida, uint64_t( bloques.size() ) );
+   for( const uint64_t d : desplazamientos )
+      Escribir( salida, d );
+   salida.insert( salida.end(), bloques.begin(), bloques.end() );
+}
+// ------------------------------------------------------------------------------------------------------
+
+std::vector<unsigned char> CodificarMalla( const DescrVAO & vao, const OpcionesCodecMalla & opciones )
+{
+   using namespace std ;
+   ZONA_TRAZA( "CodificarMalla" );
+   assert( opciones.bits_posiciones <= max_bits_cuantiz && opciones.bits_atributos <= max_bits_cuantiz );
+   const auto inicio = chrono::steady_clock::now();
+
+   const uint32_t        num_vertices = uint32_t( vao.leerNumVertices() );
+   const DescrVBOInds *  dvbo_inds    = vao.leerDescrIndices();
+   vector<const DescrVBOAtribs *> tablas ;
+   for( unsigned i = 0 ; i < vao.leerNumAtribs() ; i++ )
+      if ( vao.tieneAtrib( i ) )
+      {
+         assert( vao.leerDescrAtrib( i )->leerType() == GL_FLOAT );
+         assert( vao.leerDescrAtrib( i )->leerDatos() != nullptr );
+         tablas.push_back( vao.leerDescrAtrib( i ) );
+      }
+
+   // cabecera
+   vector<unsigned char> salida ;
+   size_t bytes_originales = 0 ;
+   Escribir( salida, magia_codec );
+   Escribir( salida, version_codec );
+   Escribir( salida, num_vertices );
+   Escribir( salida, uint32_t( tablas.size() ) );
+   Escribir( salida, uint32_t( dvbo_inds != nullptr ? dvbo_inds->leerType() : 0 ) );
+   Escribir( salida, uint32_t( dvbo_inds != nullptr ? dvbo_inds->leerCount() : 0 ) );
+   Escribir( salida, uint32_t( dvbo_inds != nullptr && dvbo_inds->usaReinicio() ? 1 : 0 ) );
+   Escribir( salida, uint32_t( dvbo_inds != nullptr ? dvbo_inds->leerIndiceReinicio() : 0 ) );
+
+   // tablas de atributos: cuantización de cada componente, y sus flujos
+   vector<uint32_t> valores( num_vertices );
+   for( const DescrVBOAtribs * tabla : tablas )
+   {
+      const unsigned  size = unsigned( tabla->leerSize() ),
+                      bits = ( tabla->leerIndex() == 0 ) ? opciones.bits_posiciones : opciones.bits_atributos ;
+      const float *   v    = (const float *) tabla->leerDatos();
+      float minimo[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, escala[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+      if ( bits > 0 )
+         for( unsigned c = 0 ; c < size ; c++ )
+         {
+            float maximo = v[c] ;
+            minimo[c] = v[c] ;
+            for( uint32_t i = 1 ; i < num_vertices ; i++ )
+            {
+               minimo[c] = std::min( minimo[c], v[size*i+c] );
+               maximo    = std::max( maximo,    v[size*i+c] );
+            }
+            escala[c] = ( maximo - minimo[c] )/float( ( 1u << bits ) - 1 );
+         }
+      Escribir( salida, uint32_t( tabla->leerIndex() ) );
+      Escribir( salida, uint32_t( size ) );
+      Escribir( salida, uint32_t( bits ) );
+      for( unsigned c = 0 ; c < 4 ; c++ )
+         Escribir( salida, minimo[c] );
+      for( unsigned c = 0 ; c < 4 ; c++ )
+         Escribir( salida, escala[c] );
+
+      for( unsigned c = 0 ; c < size ; c++ )
+      {
+         const uint32_t max_q = ( bits > 0 ) ? ( 1u << bits ) - 1 : 0 ;
+         for( uint32_t i = 0 ; i < num_vertices ; i++ )
+            if ( bits == 0 )
+               std::memcpy( &valores[i], v + size*i + c, sizeof( float ) );
+            else if ( escala[c] > 0.0f )
+               valores[i] = std::min( max_q, uint32_t( std::lround( ( v[size*i+c] - minimo[c] )/escala[c] ) ) );
+            else
+               valores[i] = 0 ;
+         CodificarFlujo( valores, salida );
+      }
+      bytes_originales += tabla->leerTamano() ;
+   }
+
+   // flujo de índices
+   if ( dvbo_inds != nullptr )
+   {
+      const uint32_t num_indices = uint32_t( dvbo_inds->leerCount() );
+      const void *   indices     = dvbo_inds->leerIndices();
+      valores.resize( num_indices );
+      for( uint32_t i = 0 ; i < num_indices ; i++ )
+         switch( dvbo_inds->leerType() )
+         {
+            case GL_UNSIGNED_BYTE  : valores[i] = ((const GLubyte  *) indices)[i] ; break ;
+            case GL_UNSIGNED_SHORT : valores[i] = ((const GLushort *) indices)[i] ; break ;
+            default                : valores[i] = ((const GLuint   *) indices)[i] ; break ;
+         }
+      CodificarFlujo( valores, salida );
+      bytes_originales += dvbo_inds->leerTamano() ;
+   }
+
+   const double ms = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+   cout << "Malla codificada: " << num_vertices << " vértices, " << fixed << setprecision(1)
+        << double( bytes_originales )/1024.0 << " KiB -> " << double( salida.size() )/1024.0 << " KiB (razón "
+        << setprecision(2) << double( bytes_originales )/double( salida.size() ) << ", "
+        << setprecision(1) << ms << " ms)." << defaultfloat << endl ;
+   return salida ;
+}
+
+// ******************************************************************************************************
+// Decodificación
+// ------------------------------------------------------------------------------------------------------
+// estado de la decodificación de un bloque: siguientes bytes de control y de valores, y último
+// valor decodificado (con deltas respecto al valor anterior, los valores son la suma de prefijos
+// de los deltas, que se hace en el mismo registro; con otra distancia, se obtienen los deltas)
+
+struct Decodificador
+{
+   const uint8_t * control = nullptr ;
+   const uint8_t * datos   = nullptr ;
+   uint32_t        previo  = 0 ;
+   bool            sumar_prefijos = true ;
+} ;
+
+// ------------------------------------------------------------------------------------------------------
+// decodifica los 'n' (<=4) valores de un byte de control, uno a uno
+
+static inline void DecodificarGrupoEscalar( Decodificador & d, const uint32_t n, uint32_t * salida )
+{
+   const uint8_t c = *d.control++ ;
+   for( uint32_t j = 0 ; j < n ; j++ )
+   {
+      const uint32_t l = ( ( c >> 2*j ) & 3u ) + 1 ;
+      uint32_t z = 0 ;
+      for( uint32_t b = 0 ; b < l ; b++ )
+         z |= uint32_t( d.datos[b] ) << 8*b ;
+      d.datos  += l ;
+      if ( d.sumar_prefijos )
+      {
+         d.previo += DesZigzag( z );
+         salida[j] = d.previo ;
+      }
+      else
+         salida[j] = DesZigzag( z );
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+// decodifica 'num_grupos' grupos completos de 4 valores (versiones SSSE3, NEON y escalar)
+
+#if defined( CODEC_USAR_SSSE3 )
+
+CODEC_FUNCION_SSSE3
+static void DecodificarGruposSSSE3( Decodificador & d, const uint32_t num_grupos, uint32_t * salida )
+{
+   const __m128i uno    = _mm_set1_epi32( 1 ),
+                 cero   = _mm_setzero_si128();
+   __m128i       previo = _mm_set1_epi32( int( d.previo ) );
+   for( uint32_t g = 0 ; g < num_grupos ; g++ )
+   {
+      const uint8_t c = d.control[g] ;
+      const __m128i z = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) d.datos ),
+                                          _mm_load_si128( (const __m128i *) tablas_vbyte.mascara[c] ) );
+      d.datos += tablas_vbyte.longitud[c] ;
+
+      // deshacer el 'zigzag' y sumar los prefijos (más el último valor del grupo anterior)
+      __m128i v = _mm_xor_si128( _mm_srli_epi32( z, 1 ), _mm_sub_epi32( cero, _mm_and_si128( z, uno ) ) );
+      if ( d.sumar_prefijos )
+      {
+         v = _mm_add_epi32( v, _mm_slli_si128( v, 4 ) );
+         v = _mm_add_epi32( v, _mm_slli_si128( v, 8 ) );
+         v = _mm_add_epi32( v, previo );
+         previo = _mm_shuffle_epi32( v, 0xFF );
+      }
+      _mm_storeu_si128( (__m128i *) ( salida + 4*g ), v );
+   }
+   d.control += num_grupos ;
+   d.previo   = uint32_t( _mm_cvtsi128_si32( previo ) );
+}
+
+// comprueba si la CPU tiene SSSE3
+static bool CpuTieneSSSE3()
+{
+#if defined( _MSC_VER )
+   int info[4] ;
+   __cpuid( info, 1 );
+   return ( info[2] & ( 1 << 9 ) ) != 0 ;
+#else
+   __builtin_cpu_init(); // (se llama al inicializar variables globales)
+   return __builtin_cpu_supports( "ssse3" );
+#endif
+}
+static const bool usar_ssse3 = CpuTieneSSSE3();
+
+#elif defined( CODEC_USAR_NEON )
+
+static void DecodificarGruposNEON( Decodificador & d, const uint32_t num_grupos, uint32_t * salida )
+{
+   const uint32x4_t uno    = vdupq_n_u32( 1 ),
+                    cero   = vdupq_n_u32( 0 );
+   uint32x4_t       previo = vdupq_n_u32( d.previo );
+   for( uint32_t g = 0 ; g < num_grupos ; g++ )
+   {
+      const uint8_t    c = d.control[g] ;
+      const uint32x4_t z = vreinterpretq_u32_u8( vqtbl1q_u8( vld1q_u8( d.datos ), vld1q_u8( tablas_vbyte.mascara[c] ) ) );
+      d.datos += tablas_vbyte.longitud[c] ;
+
+      // deshacer el 'zigzag' y sumar los prefijos (más el último valor del grupo anterior)
+      uint32x4_t v = veorq_u32( vshrq_n_u32( z, 1 ), vsubq_u32( cero, vandq_u32( z, uno ) ) );
+      if ( d.sumar_prefijos )
+      {
+         v = vaddq_u32( v, vextq_u32( cero, v, 3 ) );
+         v = vaddq_u32( v, vextq_u32( cero, v, 2 ) );
+         v = vaddq_u32( v, previo );
+         previo = vdupq_laneq_u32( v, 3 );
+      }
+      vst1q_u32( salida + 4*g, v );
+   }
+   d.control += num_grupos ;
+   d.previo   = vgetq_lane_u32( previo, 0 );
+}
+
+#endif
+
+static void DecodificarGrupos( Decodificador & d, const uint32_t num_grupos, uint32_t * salida )
+{
+#if defined( CODEC_USAR_SSSE3 )
+   if ( usar_ssse3 )
+   {
+      DecodificarGruposSSSE3( d, num_grupos, salida );
+      return ;
+   }
+#elif defined( CODEC_USAR_NEON )
+   DecodificarGruposNEON( d, num_grupos, salida );
+   return ;
+#endif
+   for( uint32_t g = 0 ; g < num_grupos ; g++ )
+      DecodificarGrupoEscalar( d, 4, salida + 4*g );
+}
+// ------------------------------------------------------------------------------------------------------
+// decodifica un bloque de 'n' valores con deltas a distancia 'paso', por tramos en la pila:
+// 'escribir( i, valores, m )' recibe los 'm' valores decodificados a partir del 'i' del bloque
+
+template< class Funcion >
+static void DecodificarBloque( const uint8_t * bloque, const uint32_t n, const uint32_t paso,
+                               const Funcion & escribir )
+{
+   assert( 1 <= paso && paso <= max_paso );
+   Decodificador d ;
+   d.control        = bloque ;
+   d.datos          = bloque + ( n + 3 )/4 ;
+   d.sumar_prefijos = ( paso == 1 );
+
+   // (con distancia mayor que 1, antes del tramo están los 'paso' últimos valores del anterior)
+   uint32_t   buffer[max_paso + tam_tramo] = {} ;
+   uint32_t * tramo = buffer + max_paso ;
+   for( uint32_t i = 0 ; i < n ; i += tam_tramo )
+   {
+      const uint32_t m = std::min( tam_tramo, n - i ),
+                     g = m/4 ;
+      DecodificarGrupos( d, g, tramo );
+      if ( m > 4*g )
+         DecodificarGrupoEscalar( d, m - 4*g, tramo + 4*g );
+      if ( paso > 1 )
+      {
+         for( uint32_t q = 0 ; q < m ; q++ )
+            tramo[q] += tramo[ int( q ) - int( paso ) ] ;
+         std::memmove( tramo - paso, tramo + m - paso, paso*sizeof( uint32_t ) );
+      }
+      escribir( i, tramo, m );
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+// lectura de la malla codificada, comprobando que no se sale de los datos
+
+struct LectorCodec
+{
+   const unsigned char * p ;
+   const unsigned char * fin ;
+   bool                  error = false ;
+
+   template< class T >
+   T leer()
+   {
+      T valor {} ;
+      if ( error || size_t( fin - p ) < sizeof( T ) )
+         error = true ;
+      else
+      {
+         std::memcpy( &valor, p, sizeof( T ) );
+         p += sizeof( T );
+      }
+      return valor ;
+   }
+} ;
+
+// flujo de una malla codificada (en los datos, no se copia)
+struct FlujoCodec
+{
+   uint32_t              num_valores     = 0 ,
+                         paso            = 1 ; // distancia de los deltas
+   const unsigned char * desplazamientos = nullptr ; // tabla de 'num_bloques' uint64
+   const unsigned char * bloques         = nullptr ;
+   uint64_t              bytes_bloques   = 0 ;
+
+   inline uint32_t numBloques() const { return ( num_valores + tam_bloque - 1 )/tam_bloque ; }
+
+   // devuelve el bloque 'b' (de 'n' valores), o nulo si no cabe en los datos de los bloques (se
+   // suman las longitudes de sus bytes de control)
+   const uint8_t * bloque( const uint32_t b, const uint32_t n ) const
+   {
+      uint64_t d ;
+      std::memcpy( &d, desplazamientos + 8ul*b, sizeof( d ) );
+      const uint64_t num_control = ( n + 3 )/4 ;
+      if ( d > bytes_bloques || bytes_bloques - d < num_control + relleno_bloque )
+         return nullptr ;
+      const uint8_t * control = bloques + d ;
+      uint64_t        bytes   = num_control + relleno_bloque ;
+      for( uint32_t g = 0 ; g < n/4 ; g++ )
+         bytes += tablas_vbyte.longitud[ control[g] ] ;
+      for( uint32_t j = 0 ; j < n % 4 ; j++ )
+         bytes += ( ( control[n/4] >> 2*j ) & 3u ) + 1 ;
+      return ( bytes_bloques - d < bytes ) ? nullptr : control ;
+   }
+} ;
+
+// lee la tabla de bloques de un flujo de 'num_valores' valores y salta sus bloques
+static FlujoCodec LeerFlujo( LectorCodec & lector, const uint32_t num_valores_esperado )
+{
+   FlujoCodec f ;
+   f.num_valores = lector.leer<uint32_t>();
+   f.paso        = lector.leer<uint32_t>();
+   const uint64_t bytes_bloques = lector.leer<uint64_t>();
+   const uint32_t num_bloques   = f.numBloques();
+   if ( lector.error || f.num_valores != num_valores_esperado || f.paso < 1 || f.paso > max_paso ||
+        size_t( lector.fin - lector.p ) < 8ul*num_bloques + bytes_bloques )
+   {
+      lector.error = true ;
+      return f ;
+   }
+   f.desplazamientos = lector.p ;
+   f.bloques         = lector.p + 8ul*num_bloques ;
+   f.bytes_bloques   = bytes_bloques ;
+   lector.p          = f.bloques + bytes_bloques ;
+   return f ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * DecodificarMalla( const unsigned char * datos, const size_t num_bytes, const unsigned num_atribs )
+{
+   using namespace std ;
+   ZONA_TRAZA( "DecodificarMalla" );
+   const auto inicio = chrono::steady_clock::now();
+
+   // cabecera
+   LectorCodec lector { datos, datos + num_bytes };
+   char magia[4] ;
+   for( char & m : magia )
+      m = lector.leer<char>();
+   const uint32_t version      = lector.leer<uint32_t>(),
+                  num_vertices = lector.leer<uint32_t>(),
+                  num_tablas   = lector.leer<uint32_t>(),
+                  tipo_indices = lector.leer<uint32_t>(),
+                  num_indices  = lector.leer<uint32_t>(),
+                  usar_reinicio = lector.leer<uint32_t>(),
+                  ind_reinicio = lector.leer<uint32_t>();
+   // (el mayor índice de vértice y el de reinicio deben caber en el tipo de los índices)
+   const uint32_t max_indice   = ( tipo_indices == GL_UNSIGNED_BYTE )  ? 0xFFu :
+                                 ( tipo_indices == GL_UNSIGNED_SHORT ) ? 0xFFFFu : 0xFFFFFFFFu ;
+   if ( lector.error || std::memcmp( magia, magia_codec, 4 ) != 0 || version != version_codec ||
+        num_vertices == 0 || num_tablas == 0 || num_tablas > num_atribs ||
+        ( tipo_indices != 0 && tipo_indices != GL_UNSIGNED_BYTE && tipo_indices != GL_UNSIGNED_SHORT &&
+          tipo_indices != GL_UNSIGNED_INT ) || ( tipo_indices != 0 && num_indices == 0 ) ||
+        ( tipo_indices != 0 && ( num_vertices-1 > max_indice || ( usar_reinicio != 0 && ind_reinicio > max_indice ))) )
+   {
+      cout << "Malla codificada no válida (cabecera)." << endl ;
+      return nullptr ;
+   }
+
+   // tablas de atributos (se crean los descriptores con memoria propia) y sus flujos
+   struct TablaCodec
+   {
+      DescrVBOAtribs * dvbo = nullptr ;
+      unsigned         size = 0 ,
+                       bits = 0 ;
+      float            minimo[4], escala[4] ;
+      FlujoCodec       flujos[4] ;
+   } ;
+   vector<TablaCodec> tablas( num_tablas );
+   vector<bool>       indice_usado( num_atribs, false );
+   for( TablaCodec & t : tablas )
+   {
+      const uint32_t index = lector.leer<uint32_t>();
+      t.size = lector.leer<uint32_t>();
+      t.bits = lector.leer<uint32_t>();
+      for( float & m : t.minimo )
+         m = lector.leer<float>();
+      for( float & e : t.escala )
+         e = lector.leer<float>();
+      if ( lector.error || index >= num_atribs || indice_usado[index] || ( index == 0 ) != ( &t == &tablas[0] ) ||
+           t.size < 1 || t.size > 4 || t.bits > max_bits_cuantiz )
+         break ;
+      indice_usado[index] = true ;
+      for( unsigned c = 0 ; c < t.size ; c++ )
+         t.flujos[c] = LeerFlujo( lector, num_vertices );
+      if ( lector.error )
+         break ;
+      t.dvbo = new DescrVBOAtribs( index, GL_FLOAT, t.size, num_vertices );
+   }
+   FlujoCodec flujo_indices ;
+   DescrVBOInds * dvbo_inds = nullptr ;
+   if ( ! lector.error && tablas.back().dvbo != nullptr && tipo_indices != 0 )
+   {
+      flujo_indices = LeerFlujo( lector, num_indices );
+      if ( ! lector.error )
+         dvbo_inds = new DescrVBOInds( tipo_indices, GLsizei( num_indices ) );
+   }
+   if ( lector.error || tablas.back().dvbo == nullptr )
+   {
+      for( TablaCodec & t : tablas )
+         delete t.dvbo ;
+      cout << "Malla codificada no válida (flujos)." << endl ;
+      return nullptr ;
+   }
+
+   // lista de tareas (un bloque de un flujo cada una), y decodificarlas en paralelo
+   struct Tarea
+   {
+      const TablaCodec * tabla ;      // tabla de atributos (nulo para el flujo de índices)
+      unsigned           componente ;
+      uint32_t           bloque ;
+   } ;
+   vector<Tarea> tareas ;
+   for( const TablaCodec & t : tablas )
+      for( unsigned c = 0 ; c < t.size ; c++ )
+         for( uint32_t b = 0 ; b < t.flujos[c].numBloques() ; b++ )
+            tareas.push_back( { &t, c, b } );
+   if ( dvbo_inds != nullptr )
+      for( uint32_t b = 0 ; b < flujo_indices.numBloques() ; b++ )
+         tareas.push_back( { nullptr, 0, b } );
+
+   void * const      indices = ( dvbo_inds != nullptr ) ? dvbo_inds->leerPunteroIndices() : nullptr ;
+   std::atomic<bool> bloque_no_valido { false } ;
+   ParaleloPara( tareas.size(), [&]( const unsigned long t0, const unsigned long t1 )
+   {
+      for( unsigned long i = t0 ; i < t1 ; i++ )
+      {
+         const Tarea &      tarea  = tareas[i] ;
+         const FlujoCodec & flujo  = ( tarea.tabla != nullptr ) ? tarea.tabla->flujos[tarea.componente] : flujo_indices ;
+         const uint32_t     primer = tarea.bloque*tam_bloque ,
+                            n      = std::min( tam_bloque, flujo.num_valores - primer );
+         const uint8_t *    bloque = flujo.bloque( tarea.bloque, n );
+         if ( bloque == nullptr )
+         {
+            bloque_no_valido = true ;
+            continue ;
+         }
+
+         if ( tarea.tabla == nullptr ) // índices, con el tipo de la tabla
+            DecodificarBloque( bloque, n, flujo.paso, [&]( const uint32_t j, const uint32_t * v, const uint32_t m )
+            {
+               const uint32_t k = primer + j ;
+               uint32_t maximo = 0 ; // (los índices deben ser de vértices, o de reinicio)
+               for( uint32_t q = 0 ; q < m ; q++ )
+                  maximo = std::max( maximo, v[q] );
+               if ( maximo >= num_vertices )
+                  for( uint32_t q = 0 ; q < m ; q++ )
+                     if ( v[q] >= num_vertices && ! ( usar_reinicio != 0 && v[q] == ind_reinicio ) )
+                        bloque_no_valido = true ;
+               if ( tipo_indices == GL_UNSIGNED_INT )
+                  std::memcpy( (GLuint *) indices + k, v, 4ul*m );
+               else if ( tipo_indices == GL_UNSIGNED_SHORT )
+                  for( uint32_t q = 0 ; q < m ; q++ )
+                     ((GLushort *) indices)[k+q] = GLushort( v[q] );
+               else
+                  for( uint32_t q = 0 ; q < m ; q++ )
+                     ((GLubyte *) indices)[k+q] = GLubyte( v[q] );
+            });
+         else // una componente de una tabla de atributos (cuantizada o no), intercalada con las demás
+         {
+            const TablaCodec & t      = *tarea.tabla ;
+            const unsigned     c      = tarea.componente ;
+            float * const      salida = (float *) t.dvbo->leerPunteroDatos() + c ;
+            DecodificarBloque( bloque, n, flujo.paso, [&]( const uint32_t j, const uint32_t * v, const uint32_t m )
+            {
+               float * s = salida + size_t( t.size )*( primer + j );
+               if ( t.bits == 0 )
+                  for( uint32_t q = 0 ; q < m ; q++ )
+                     std::memcpy( s + t.size*q, v + q, sizeof( float ) );
+               else
+                  for( uint32_t q = 0 ; q < m ; q++ )
+                     s[t.size*q] = t.minimo[c] + float( v[q] )*t.escala[c] ;
+            });
+         }
+      }
+   }, 1 );
+   if ( bloque_no_valido )
+   {
+      for( TablaCodec & t : tablas )
+         delete t.dvbo ;
+      delete dvbo_inds ;
+      cout << "Malla codificada no válida (bloques)." << endl ;
+      return nullptr ;
+   }
+
+   // crear el VAO con las tablas decodificadas
+   DescrVAO * vao = new DescrVAO( num_atribs, tablas[0].dvbo );
+   for( unsigned i = 1 ; i < num_tablas ; i++ )
+      vao->agregar( tablas[i].dvbo );
+   if ( dvbo_inds != nullptr )
+   {
+      if ( usar_reinicio != 0 )
+         dvbo_inds->fijarIndiceReinicio( ind_reinicio );
+      vao->agregar( dvbo_inds );
+   }
+
+   const double ms       = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+   size_t       decodif  = ( dvbo_inds != nullptr ) ? dvbo_inds->leerTamano() : 0 ;
+   for( const TablaCodec & t : tablas )
+      decodif += t.dvbo->leerTamano() ;
+   cout << "Malla decodificada: " << num_vertices << " vértices, " << num_indices << " índices, " << fixed
+        << setprecision(1) << double( num_bytes )/1024.0 << " KiB -> " << double( decodif )/1024.0 << " KiB ("
+        << ms << " ms, " << setprecision(2) << double( decodif )/( ms*1e6 ) << " GB/s, "
+        << std::min<size_t>( NumHilosParalelo(), tareas.size() ) << " hilos"
+#if defined( CODEC_USAR_SSSE3 )
+        << ( usar_ssse3 ? ", SSSE3" : "" )
+#elif defined( CODEC_USAR_NEON )
+        << ", NEON"
+#endif
+        << ")." << defaultfloat << endl ;
+   return vao ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool GuardarMallaComprimida( const std::string & nombre, const DescrVAO & vao, const OpcionesCodecMalla & opciones )
+{
+   const std::vector<unsigned char> datos = CodificarMalla( vao, opciones );
+   std::ofstream archivo( nombre, std::ios::binary );
+   archivo.write( (const char *) datos.data(), std::streamsize( datos.size() ) );
+   if ( ! archivo )
+   {
+      std::cout << "No se ha podido escribir la malla comprimida '" << nombre << "'." << std::endl ;
+      return false ;
+   }
+   return true ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * LeerMallaComprimida( const std::string & nombre, const unsigned num_atribs )
+{
+   ZONA_TRAZA( "LeerMallaComprimida" );
+   std::ifstream archivo( nombre, std::ios::binary | std::ios::ate );
+   if ( ! archivo )
+      return nullptr ;
+   const std::streamsize tam = archivo.tellg();
+   std::vector<unsigned char> datos( size_t( std::max<std::streamsize>( 0, tam ) ) );
+   archivo.seekg( 0 );
+   if ( ! archivo.read( (char *) datos.data(), tam ) )
+   {
+      std::cout << "No se ha podido leer la malla comprimida '" << nombre << "'." << std::endl ;
+      return nullptr ;
+   }
+   return DecodificarMalla( datos.data(), datos.size(), num_atribs );
+}
+// ------------------------------------------------------------------------------------------------------
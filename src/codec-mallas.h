@@ -0,0 +1,82 @@
+// Códec de mallas comprimidas: índices con deltas y atributos cuantizados, decodificación en paralelo
+
+#ifndef CODEC_MALLAS_H
+#define CODEC_MALLAS_H
+
+#include <string>
+#include <vector>
+#include "glincludes.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+// Formato (todos los enteros en 'little endian'): una cabecera con el número de vértices, el
+// tipo y número de índices, y la cuantización de cada tabla de atributos, seguida de flujos de
+// enteros de 32 bits, uno por cada componente de cada tabla de atributos y otro para los índices.
+//
+//   - índices: cada uno se guarda como la diferencia (delta) con el que está una distancia fija
+//     antes, con el signo en el bit menos significativo ('zigzag'), así los valores pequeños de
+//     cualquier signo ocupan pocos bits. El codificador elige la distancia de cada flujo: 1 en
+//     general, o 6 en mallas de cuadriláteros (cada índice es cercano al del par de triángulos
+//     anterior, aunque dentro del par hay saltos del tamaño de una fila de vértices).
+//   - atributos (GL_FLOAT): cada componente se cuantiza a un número de bits entre su mínimo y su
+//     máximo en la tabla, y se guarda igual que los índices (normalmente, delta+zigzag respecto a
+//     la del vértice anterior). Con 0 bits no se cuantiza (se guardan los bits del 'float', sin
+//     pérdidas).
+//
+// Los enteros de cada flujo se codifican con 'Stream VByte': un byte de control por cada 4 valores
+// (2 bits con la longitud de cada uno, de 1 a 4 bytes) y los bytes de los valores en otra tabla.
+// Al decodificar, un grupo de 4 valores se extrae con una sola instrucción de permutación de
+// bytes (SSSE3 'pshufb' o NEON 'tbl', con una tabla de 256 máscaras indexada por el byte de
+// control), y el 'zigzag' y la suma de prefijos de los deltas se hacen en el mismo registro (con
+// distancias mayores que 1, los valores se suman después a los anteriores, por tramos). Cada
+// flujo se divide en bloques independientes (los deltas empiezan de cero en cada bloque), así que
+// todos los bloques de todos los flujos se decodifican en paralelo, directamente en la memoria
+// de los descriptores de VBOs del VAO resultante.
+
+// Opciones de la codificación de una malla
+//
+struct OpcionesCodecMalla
+{
+   unsigned bits_posiciones = 16 ; // bits por componente de las posiciones (1..24, 0 = sin pérdidas)
+   unsigned bits_atributos  = 12 ; // bits por componente de los demás atributos (1..24, 0 = sin pérdidas)
+} ;
+
+// --------------------------------------------------------------------------------------------
+// Codifica un VAO (con sus tablas en la memoria de la aplicación, atributos GL_FLOAT) en memoria,
+// e informa en 'cout' de la razón de compresión
+//
+// @param vao      (const DescrVAO &)           VAO a codificar
+// @param opciones (const OpcionesCodecMalla &) bits de cuantización
+// @return (vector<unsigned char>) malla codificada
+//
+std::vector<unsigned char> CodificarMalla( const DescrVAO & vao, const OpcionesCodecMalla & opciones = {} );
+
+// Decodifica una malla codificada con 'CodificarMalla' en un VAO nuevo (sin crear en la GPU), e
+// informa en 'cout' del tiempo y la velocidad de decodificación
+//
+// @param datos      (const unsigned char *) malla codificada
+// @param num_bytes  (size_t)                número de bytes de 'datos'
+// @param num_atribs (unsigned)              número de atributos del VAO (p.ej. 'Cauce::num_atribs')
+// @return (DescrVAO *) VAO decodificado (nulo si los datos no son válidos)
+//
+DescrVAO * DecodificarMalla( const unsigned char * datos, const size_t num_bytes, const unsigned num_atribs );
+
+// Codifica un VAO y lo escribe en un archivo
+//
+// @param nombre   (string)                     nombre del archivo
+// @param vao      (const DescrVAO &)           VAO a codificar
+// @param opciones (const OpcionesCodecMalla &) bits de cuantización
+// @return (bool) true si se ha escrito sin errores
+//
+bool GuardarMallaComprimida( const std::string & nombre, const DescrVAO & vao,
+                             const OpcionesCodecMalla & opciones = {} );
+
+// Lee un archivo escrito con 'GuardarMallaComprimida' y lo decodifica en un VAO nuevo
+//
+// @param nombre     (string)   nombre del archivo
+// @param num_atribs (unsigned) número de atributos del VAO
+// @return (DescrVAO *) VAO decodificado (nulo si no se ha podido leer o no es válido)
+//
+DescrVAO * LeerMallaComprimida( const std::string & nombre, const unsigned num_atribs );
+
+#endif
@@ -0,0 +1,194 @@
+// Cola de objetos opacos con test de profundidad, ordenación y pasada previa de profundidad
+
+#include <algorithm>
+#include <limits>
+#include "cola-opacos.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+ColaOpacos::ColaOpacos()
+{
+   CError();
+   glGenQueries( 1, &consulta ); assert( 0 < consulta );
+   CError();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ColaOpacos::vaciar()
+{
+   entradas.clear();
+   orden.clear();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ColaOpacos::agregar( Cauce & cauce, DescrVAO * vao, const GLenum modo, const glm::vec3 & centro,
+                          const bool aristas )
+{
+   assert( vao != nullptr );
+
+   // calcular la profundidad del centro en coordenadas normalizadas de dispositivo (NDC),
+   // (menor profundidad --> más cerca del observador, igual que en el Z-buffer)
+   const glm::vec4 centro_clip = cauce.leerMatrizProyeccion() * cauce.leerMatrizVista() * cauce.leerMM() 
+                                 * glm::vec4( centro, 1.0f );
+   const float     profundidad = ( centro_clip.w > 0.0f ) ? centro_clip.z / centro_clip.w
+                                                         : std::numeric_limits<float>::max() ;
+
+   entradas.push_back( { vao, modo, cauce.leerMM(), profundidad, cauce.leerUsarColorPlano(), 
+                        cauce.leerTextura(), cauce.leerIluminacion(), aristas, false } );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+// true para los modos que producen triángulos (los únicos que admite el programa con aristas)
+
+static bool EsModoTriangulos( const GLenum modo )
+{
+   return modo == GL_TRIANGLES || modo == GL_TRIANGLE_STRIP || modo == GL_TRIANGLE_FAN ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ColaOpacos::dibujarRellenos( Cauce & cauce, const bool con_aristas )
+{
+   Textura * const textura_previa     = cauce.leerTextura();
+   const bool      iluminacion_previa = cauce.leerIluminacion();
+   for( const unsigned i : orden )
+   {
+      const Entrada & e = entradas[i] ;
+      cauce.fijarDibujarAristas( con_aristas && e.aristas && EsModoTriangulos( e.modo ) );
+      cauce.fijarMM( e.mat_modelview );
+      cauce.fijarUsarColorPlano( e.usar_color_plano );
+      cauce.fijarTextura( e.textura );
+      cauce.fijarIluminacion( e.iluminacion );
+      if ( e.en_cache )
+      {
+         cauce.fijarRepetirTransformados( true );
+         cache.dibujar( i );
+         cauce.fijarRepetirTransformados( false );
+      }
+      else
+         e.vao->draw( e.modo );
+   }
+   cauce.fijarDibujarAristas( false );
+   cauce.fijarTextura( textura_previa );
+   cauce.fijarIluminacion( iluminacion_previa );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ColaOpacos::visualizar( Cauce & cauce )
+{
+   using namespace std ;
+   ZONA_TRAZA( "ColaOpacos::visualizar" );
+   CError();
+
+   const glm::mat4 mat_modelview_previa = cauce.leerMM();
+
+   // calcular el orden de visualización: el de inserción, o de delante hacia atrás
+   // (así los objetos más cercanos llenan antes el Z-buffer y se descartan más fragmentos)
+   orden.resize( entradas.size() );
+   for( unsigned i = 0 ; i < orden.size() ; i++ )
+      orden[i] = i ;
+   // (se desempata por orden de inserción, como 'stable_sort', pero sin reservar memoria temporal)
+   if ( ordenar )
+      std::sort( orden.begin(), orden.end(), [this]( const unsigned a, const unsigned b )
+                 {  return entradas[a].profundidad < entradas[b].profundidad ||
+                           ( entradas[a].profundidad == entradas[b].profundidad && a < b ) ; } );
+
+   // preparar la cache de transformados (se capturan solo las entradas que han cambiado)
+   if ( usar_cache_transformados )
+   {
+      const bool iluminacion_previa = cauce.leerIluminacion();
+      for( unsigned i = 0 ; i < entradas.size() ; i++ )
+      {
+         cauce.fijarIluminacion( entradas[i].iluminacion );
+         entradas[i].en_cache = cache.preparar( cauce, i, entradas[i].vao, entradas[i].modo, 
+                                                entradas[i].mat_modelview );
+      }
+      cauce.fijarIluminacion( iluminacion_previa );
+      cache.recortar( entradas.size() );
+   }
+   else
+      cache.recortar( 0 );
+
+   glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+
+   // en modo 'overdraw', contar los fragmentos que se producirían sin test de profundidad
+   GLuint fragmentos_totales = 0 ;
+   if ( visualizar_overdraw )
+   {
+      glDisable( GL_DEPTH_TEST );
+      glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+      glBeginQuery( GL_SAMPLES_PASSED, consulta );
+      dibujarRellenos( cauce, false );
+      glEndQuery( GL_SAMPLES_PASSED );
+      glGetQueryObjectuiv( consulta, GL_QUERY_RESULT, &fragmentos_totales ); // (espera a la GPU)
+      glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+   }
+
+   // habilitar EPO por Z-buffer (las aristas se dibujan en la misma pasada que el relleno,
+   // así que no hace falta desplazar los rellenos hacia atrás)
+   glEnable( GL_DEPTH_TEST );
+   glDepthFunc( GL_LESS );
+   glDepthMask( GL_TRUE );
+
+   // pasada previa: escribir solo el Z-buffer, la pasada de color solo sombrea los fragmentos visibles
+   if ( prepasada_profundidad )
+   {
+      glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+      dibujarRellenos( cauce, false );
+      glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+      glDepthMask( GL_FALSE );
+      glDepthFunc( GL_LEQUAL );
+   }
+
+   // pasada de color, con las aristas superpuestas (en modo 'overdraw' cada fragmento sombreado 
+   // suma un incremento fijo, y no se dibujan aristas)
+   if ( visualizar_overdraw )
+   {
+      glEnable( GL_BLEND );
+      glBlendFunc( GL_ONE, GL_ONE );
+      cauce.fijarVisualizarOverdraw( true );
+      glBeginQuery( GL_SAMPLES_PASSED, consulta );
+   }
+
+   dibujarRellenos( cauce, ! visualizar_overdraw );
+
+   if ( visualizar_overdraw )
+   {
+      GLuint fragmentos_sombreados = 0 ;
+      glEndQuery( GL_SAMPLES_PASSED );
+      glGetQueryObjectuiv( consulta, GL_QUERY_RESULT, &fragmentos_sombreados ); // (espera a la GPU)
+      cauce.fijarVisualizarOverdraw( false );
+      glDisable( GL_BLEND );
+
+      const GLuint ahorrados = fragmentos_totales - std::min( fragmentos_totales, fragmentos_sombreados );
+      cout << "Overdraw: fragmentos sombreados " << fragmentos_sombreados << " de " << fragmentos_totales
+           << " (ahorrados " << ahorrados << ", "
+           << fixed << setprecision(1) << ( fragmentos_totales > 0 ? 100.0*ahorrados/fragmentos_totales : 0.0 )
+           << "%)." << defaultfloat << endl ;
+   }
+
+   // restaurar el estado
+   glDepthMask( GL_TRUE );
+   glDepthFunc( GL_LESS );
+   cauce.fijarMM( mat_modelview_previa );
+   CError();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+ColaOpacos::~ColaOpacos()
+{
+   if ( consulta != 0 )
+   {
+      CError();
+      glDeleteQueries( 1, &consulta );
+      CError();
+      consulta = 0 ;
+   }
+}
+// ------------------------------------------------------------------------------------------------------
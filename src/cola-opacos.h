@@ -0,0 +1,87 @@
+#ifndef COLA_OPACOS_H
+#define COLA_OPACOS_H
+
+#include <vector>
+#include "glincludes.h"
+#include "cauce.h"
+#include "vaos-vbos.h"
+#include "cache-transformados.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Cola de objetos opacos de un frame: guarda los VAOs a dibujar junto con la matriz modelview
+// que tenía el cauce al añadirlos, y los visualiza con test de profundidad, opcionalmente
+// ordenados de delante hacia atrás y con una pasada previa que solo escribe el Z-buffer.
+// Opcionalmente, los vértices transformados de cada objeto se guardan en una cache
+// ('transform feedback') y se repiten en todas las pasadas, y en los frames siguientes
+// mientras el objeto y la cámara no cambien.
+//
+class ColaOpacos
+{
+   public:
+
+   // crea una cola vacía (requiere un contexto OpenGL activo, crea el objeto consulta)
+   ColaOpacos() ;
+
+   // vacía la cola (se debe llamar al inicio de cada frame)
+   void vaciar() ;
+
+   // Añade un objeto opaco a la cola, con la matriz modelview, el valor de 'usar color plano',
+   // la textura y la iluminación que tiene actualmente el cauce.
+   //
+   // @param cauce   (Cauce &)     cauce del que se leen la modelview, la vista y la proyección actuales
+   // @param vao     (DescrVAO *)  VAO a dibujar (no nulo)
+   // @param modo    (GLenum)      modo de visualización (GL_TRIANGLES, ...)
+   // @param centro  (vec3)        centro del objeto en coordenadas de objeto (para ordenar)
+   // @param aristas (bool)        si es 'true', se dibujan las aristas superpuestas al relleno
+   //                              (en la misma pasada, solo para modos de triángulos)
+   //
+   void agregar( Cauce & cauce, DescrVAO * vao, const GLenum modo, const glm::vec3 & centro,
+                 const bool aristas );
+
+   // Visualiza todos los objetos de la cola, con test de profundidad. Deja la modelview del
+   // cauce como estaba antes de la llamada.
+   //
+   // @param cauce (Cauce &) cauce usado para visualizar
+   //
+   void visualizar( Cauce & cauce ) ;
+
+   // libera el objeto consulta
+   ~ColaOpacos() ;
+
+   // opciones de visualización (se pueden cambiar entre frames)
+
+   bool prepasada_profundidad = false ; // hacer pasada previa que solo escribe el Z-buffer
+   bool ordenar               = true ;  // ordenar de delante hacia atrás antes de dibujar
+   bool visualizar_overdraw   = false ; // visualizar las capas sombreadas e informar de fragmentos ahorrados
+   bool usar_cache_transformados = false ; // repetir vértices transformados capturados (ver 'CacheTransformados')
+
+   private: // ---------------------------
+
+   // entrada de la cola: un VAO con su estado de visualización
+   struct Entrada
+   {
+      DescrVAO * vao ;              // VAO a dibujar
+      GLenum     modo ;             // modo de visualización
+      glm::mat4  mat_modelview ;    // matriz modelview con la que se dibuja
+      float      profundidad ;      // profundidad del centro en coordenadas normalizadas de dispositivo
+      bool       usar_color_plano ; // valor de 'usar color plano' para el relleno
+      Textura *  textura ;          // textura para el relleno (puede ser nula)
+      bool       iluminacion ;      // valor de 'iluminación' para el relleno
+      bool       aristas ;          // dibujar aristas superpuestas al relleno
+      bool       en_cache ;         // true si sus vértices transformados están en la cache
+   } ;
+
+   std::vector<Entrada>  entradas ; // entradas en el orden de inserción
+   std::vector<unsigned> orden ;    // índices de 'entradas' en el orden de visualización
+
+   GLuint consulta = 0 ; // objeto consulta para contar fragmentos (GL_SAMPLES_PASSED)
+
+   CacheTransformados cache ; // vértices transformados de cada entrada (índice de inserción)
+
+   // dibuja el relleno de todas las entradas, en el orden de 'orden', opcionalmente con las
+   // aristas superpuestas (en las entradas que las tienen)
+   void dibujarRellenos( Cauce & cauce, const bool con_aristas ) ;
+} ;
+
+#endif
@@ -0,0 +1,63 @@
+// Contador de reservas de memoria dinámica (sustituye los operadores 'new' y 'delete' globales)
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "contador-asignaciones.h"
+
+// ------------------------------------------------------------------------------------------------------
+// Contadores globales (el orden de los incrementos entre hilos no importa)
+
+static std::atomic<unsigned long long> num_asignaciones { 0 },
+                                       bytes_asignados  { 0 };
+
+// ------------------------------------------------------------------------------------------------------
+
+ContadoresAsignaciones LeerContadoresAsignaciones()
+{
+   return { num_asignaciones.load( std::memory_order_relaxed ), bytes_asignados.load( std::memory_order_relaxed ) };
+}
+// ------------------------------------------------------------------------------------------------------
+// Cuenta una reserva y la hace con 'malloc' (devuelve nulo si no hay memoria)
+
+static void * ReservarContando( const std::size_t bytes ) noexcept
+{
+   num_asignaciones.fetch_add( 1, std::memory_order_relaxed );
+   bytes_asignados.fetch_add( bytes, std::memory_order_relaxed );
+   return std::malloc( bytes > 0 ? bytes : 1 );
+}
+// ------------------------------------------------------------------------------------------------------
+// Operadores globales sustituidos (las versiones con alineamiento extendido no se sustituyen:
+// usan las de la librería estándar, y no se cuentan)
+
+void * operator new( std::size_t bytes )
+{
+   void * p = ReservarContando( bytes );
+   if ( p == nullptr )
+      throw std::bad_alloc();
+   return p ;
+}
+
+void * operator new[]( std::size_t bytes )
+{
+   return operator new( bytes );
+}
+
+void * operator new( std::size_t bytes, const std::nothrow_t & ) noexcept
+{
+   return ReservarContando( bytes );
+}
+
+void * operator new[]( std::size_t bytes, const std::nothrow_t & ) noexcept
+{
+   return ReservarContando( bytes );
+}
+
+void operator delete( void * p ) noexcept                                  { std::free( p ); }
+void operator delete[]( void * p ) noexcept                                { std::free( p ); }
+void operator delete( void * p, std::size_t ) noexcept                     { std::free( p ); }
+void operator delete[]( void * p, std::size_t ) noexcept                   { std::free( p ); }
+void operator delete( void * p, const std::nothrow_t & ) noexcept          { std::free( p ); }
+void operator delete[]( void * p, const std::nothrow_t & ) noexcept        { std::free( p ); }
+
+// ------------------------------------------------------------------------------------------------------
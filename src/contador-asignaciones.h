@@ -0,0 +1,29 @@
+// Contador de reservas de memoria dinámica (sustituye los operadores 'new' y 'delete' globales)
+
+#ifndef CONTADOR_ASIGNACIONES_H
+#define CONTADOR_ASIGNACIONES_H
+
+// --------------------------------------------------------------------------------------------
+
+// Número de reservas y de bytes reservados con 'new' (en todos los hilos) desde el inicio del 
+// programa. Los operadores 'new' y 'delete' globales se sustituyen en 'contador-asignaciones.cpp'
+// por unos que cuentan cada reserva (con contadores atómicos) y después usan 'malloc' y 'free'.
+// Las reservas que hacen las librerías de C (p.ej. el driver de OpenGL) con 'malloc' no se cuentan.
+//
+struct ContadoresAsignaciones
+{
+   unsigned long long num_asignaciones = 0 , // número de llamadas a 'new'
+                      bytes            = 0 ; // bytes reservados en total
+
+   // diferencia entre dos lecturas de los contadores (reservas entre ambas)
+   inline ContadoresAsignaciones operator - ( const ContadoresAsignaciones & anterior ) const
+   {
+      return { num_asignaciones - anterior.num_asignaciones, bytes - anterior.bytes };
+   }
+} ;
+
+// Devuelve los valores actuales de los contadores
+//
+ContadoresAsignaciones LeerContadoresAsignaciones();
+
+#endif
@@ -0,0 +1,95 @@
+// Comprobación de errores de OpenGL, con nivel configurable en tiempo de compilación
+
+#include <cstdlib>
+#include "errores-gl.h"
+
+PuntoComprobacionGL punto_comprobacion_gl ;
+bool                salida_depuracion_gl = false ;
+
+// ------------------------------------------------------------------------------------------------------
+// devuelve el nombre de un código de error de OpenGL
+
+static const char * NombreErrorGL( const GLenum codigo )
+{
+   switch( codigo )
+   {
+      case GL_INVALID_ENUM                  : return "GL_INVALID_ENUM" ;
+      case GL_INVALID_VALUE                 : return "GL_INVALID_VALUE" ;
+      case GL_INVALID_OPERATION             : return "GL_INVALID_OPERATION" ;
+      case GL_INVALID_FRAMEBUFFER_OPERATION : return "GL_INVALID_FRAMEBUFFER_OPERATION" ;
+      case GL_OUT_OF_MEMORY                 : return "GL_OUT_OF_MEMORY" ;
+      default                               : return "(desconocido)" ;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ComprobarErrorGL( const char * archivo, const int linea, const char * funcion )
+{
+   using namespace std ;
+   const GLenum codigo = glGetError() ;
+   if ( codigo == GL_NO_ERROR )
+      return ;
+
+   cerr << "Error de OpenGL: " << NombreErrorGL( codigo ) << " (0x" << hex << codigo << dec << ")" << endl
+        << "   detectado en " << archivo << ":" << linea << " (función '" << funcion << "')" << endl ;
+   abort();
+}
+
+// ------------------------------------------------------------------------------------------------------
+// Función invocada por el driver para cada mensaje de la salida de depuración (es síncrona,
+// así que se ejecuta dentro de la llamada a OpenGL que lo produce). El punto registrado es 
+// el de la última comprobación anterior a esa llamada.
+
+#if NIVEL_COMPROBACION_GL == 1 && ! defined(__APPLE__)
+
+static void GLAPIENTRY MensajeDepuracionGL( GLenum fuente, GLenum tipo, GLuint id, GLenum gravedad,
+                                            GLsizei longitud, const GLchar * mensaje, const void * datos )
+{
+   using namespace std ;
+   const PuntoComprobacionGL & p = punto_comprobacion_gl ;
+
+   if ( tipo != GL_DEBUG_TYPE_ERROR )
+   {
+      cout << "Mensaje de OpenGL (id " << id << "): " << mensaje << endl ;
+      return ;
+   }
+   cerr << "Error de OpenGL (id " << id << "): " << mensaje << endl
+        << "   producido después de " << p.archivo << ":" << p.linea << " (función '" << p.funcion << "')" << endl ;
+   abort();
+}
+
+#endif
+
+// ------------------------------------------------------------------------------------------------------
+
+void InicializarComprobacionGL()
+{
+   using namespace std ;
+   ComprobarErrorGL( __FILE__, __LINE__, __func__ );
+
+#if NIVEL_COMPROBACION_GL == 0
+   cout << "Comprobación de errores de OpenGL desactivada." << endl ;
+#elif NIVEL_COMPROBACION_GL == 1 && ! defined(__APPLE__)
+   GLint flags_contexto = 0 ;
+   glGetIntegerv( GL_CONTEXT_FLAGS, &flags_contexto );
+
+   const bool hay_khr_debug = GLEW_VERSION_4_3 || GLEW_KHR_debug ;
+   if ( hay_khr_debug && ( flags_contexto & GL_CONTEXT_FLAG_DEBUG_BIT ) != 0 )
+   {
+      glEnable( GL_DEBUG_OUTPUT );
+      glEnable( GL_DEBUG_OUTPUT_SYNCHRONOUS );
+      glDebugMessageCallback( MensajeDepuracionGL, nullptr );
+      // descartar las notificaciones (informativas), que pueden ser muy frecuentes
+      glDebugMessageControl( GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE );
+      ComprobarErrorGL( __FILE__, __LINE__, __func__ );
+      salida_depuracion_gl = true ;
+      cout << "Comprobación de errores de OpenGL con salida de depuración (GL_KHR_debug)." << endl ;
+   }
+   else
+      cout << "Salida de depuración de OpenGL no disponible, comprobación de errores con 'glGetError'." << endl ;
+#else
+   cout << "Comprobación de errores de OpenGL con 'glGetError'." << endl ;
+#endif
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,78 @@
+// Comprobación de errores de OpenGL, con nivel configurable en tiempo de compilación
+
+#ifndef ERRORES_GL_H
+#define ERRORES_GL_H
+
+#include <cassert>
+#include "glincludes.h"
+
+// --------------------------------------------------------------------------------------------
+// Nivel de comprobación de errores de OpenGL (se puede fijar con -DNIVEL_COMPROBACION_GL=n):
+//
+//   0 : sin comprobación, 'CError()' no hace nada (ejecutable 'release')
+//   1 : salida de depuración de OpenGL (GL_KHR_debug): el driver invoca una función cuando se 
+//       produce un error, y 'CError()' solo registra el punto del código (archivo, línea, función)
+//       sin llamar a OpenGL. Si el contexto no tiene salida de depuración (p.ej. en macOS), se
+//       usa el nivel 2.
+//   2 : comprobación síncrona, 'CError()' llama a 'glGetError' (fuerza un viaje al driver)
+//
+// Por defecto se usa el nivel 1 (ejecutable 'debug').
+
+#ifndef NIVEL_COMPROBACION_GL
+#define NIVEL_COMPROBACION_GL 1
+#endif
+
+// --------------------------------------------------------------------------------------------
+
+// punto del código fuente donde se ha hecho la última comprobación
+//
+struct PuntoComprobacionGL
+{
+   const char * archivo = "(ninguno)" ;
+   int          linea   = 0 ;
+   const char * funcion = "(ninguna)" ;
+} ;
+
+// último punto de comprobación registrado (solo se usa en el nivel 1)
+extern PuntoComprobacionGL punto_comprobacion_gl ;
+
+// true si está activa la salida de depuración (solo puede serlo en el nivel 1)
+extern bool salida_depuracion_gl ;
+
+// Comprueba (con 'glGetError') que no hay errores pendientes de OpenGL. Si los hay, 
+// informa del error y del punto del código, y aborta.
+//
+// @param archivo (const char *) nombre del archivo fuente
+// @param linea   (int)          número de línea 
+// @param funcion (const char *) nombre de la función
+//
+void ComprobarErrorGL( const char * archivo, const int linea, const char * funcion );
+
+// Registra el punto del código para los mensajes de la salida de depuración. Si la
+// salida de depuración no está activa, hace la comprobación síncrona.
+//
+inline void RegistrarPuntoGL( const char * archivo, const int linea, const char * funcion )
+{
+   if ( salida_depuracion_gl )
+      punto_comprobacion_gl = { archivo, linea, funcion };
+   else 
+      ComprobarErrorGL( archivo, linea, funcion );
+}
+
+// Prepara la comprobación de errores según el nivel: en el nivel 1 activa la salida de 
+// depuración si el contexto la admite (se debe llamar tras crear el contexto e inicializar GLEW)
+//
+void InicializarComprobacionGL();
+
+// --------------------------------------------------------------------------------------------
+// macro de comprobación, para usar en todo el código tras las llamadas a OpenGL
+
+#if NIVEL_COMPROBACION_GL == 0
+   #define CError()  ((void)0)
+#elif NIVEL_COMPROBACION_GL == 1
+   #define CError()  RegistrarPuntoGL( __FILE__, __LINE__, __func__ )
+#else
+   #define CError()  ComprobarErrorGL( __FILE__, __LINE__, __func__ )
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+// Framebuffer object para visualizar fuera de la ventana (offscreen)
+
+#include <cassert>
+#include <cstring>
+#include "fbo-offscreen.h"
+#include "errores-gl.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+FramebufferOffscreen::FramebufferOffscreen( const unsigned p_ancho, const unsigned p_alto )
+:  ancho( p_ancho ),
+   alto( p_alto )
+{
+   using namespace std ;
+   assert( 0 < ancho && 0 < alto );
+   CError();
+
+   glGenRenderbuffers( 1, &rb_color );
+   glBindRenderbuffer( GL_RENDERBUFFER, rb_color );
+   glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, ancho, alto );
+
+   glGenRenderbuffers( 1, &rb_profundidad );
+   glBindRenderbuffer( GL_RENDERBUFFER, rb_profundidad );
+   glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, ancho, alto );
+   glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+   glGenFramebuffers( 1, &fbo );
+   glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+   glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rb_color );
+   glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb_profundidad );
+
+   const GLenum estado = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+   glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+   CError();
+
+   if ( estado != GL_FRAMEBUFFER_COMPLETE )
+   {
+      cout << "No se puede crear el framebuffer offscreen (estado 0x" << hex << estado << dec << "). Aborto." << endl ;
+      exit(1);
+   }
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void FramebufferOffscreen::activar()
+{
+   glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+   CError();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void FramebufferOffscreen::desactivar()
+{
+   glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+   CError();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void FramebufferOffscreen::copiarEnVentana( const unsigned ancho_zona, const unsigned alto_zona,
+                                            const int ancho_ventana, const int alto_ventana )
+{
+   assert( 0 < ancho_zona && ancho_zona <= ancho && 0 < alto_zona && alto_zona <= alto );
+   CError();
+   const bool mismo_tamano = ( int(ancho_zona) == ancho_ventana && int(alto_zona) == alto_ventana );
+   glBindFramebuffer( GL_READ_FRAMEBUFFER, fbo );
+   glBindFramebuffer( GL_DRAW_FRAMEBUFFER, 0 );
+   glBlitFramebuffer( 0, 0, ancho_zona, alto_zona, 0, 0, ancho_ventana, alto_ventana,
+                      GL_COLOR_BUFFER_BIT, mismo_tamano ? GL_NEAREST : GL_LINEAR );
+   glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+   CError();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void FramebufferOffscreen::leerImagen( Imagen & img )
+{
+   CError();
+   GLint fbo_lectura_previo = 0 ;
+   glGetIntegerv( GL_READ_FRAMEBUFFER_BINDING, &fbo_lectura_previo );
+   glBindFramebuffer( GL_READ_FRAMEBUFFER, fbo );
+
+   // leer en RGB (filas sin relleno), de abajo hacia arriba, e invertir el orden de las filas
+   Imagen invertida ;
+   invertida.redimensionar( ancho, alto );
+   glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+   glReadPixels( 0, 0, ancho, alto, GL_RGB, GL_UNSIGNED_BYTE, invertida.pixels.data() );
+   glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+   glBindFramebuffer( GL_READ_FRAMEBUFFER, fbo_lectura_previo );
+   CError();
+
+   img.redimensionar( ancho, alto );
+   for( unsigned y = 0 ; y < alto ; y++ )
+      memcpy( img.fila( y ), invertida.fila( alto-1-y ), 3ul*ancho );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+FramebufferOffscreen::~FramebufferOffscreen()
+{
+   CError();
+   glDeleteFramebuffers( 1, &fbo );
+   glDeleteRenderbuffers( 1, &rb_color );
+   glDeleteRenderbuffers( 1, &rb_profundidad );
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
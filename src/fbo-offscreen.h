@@ -0,0 +1,61 @@
+// Framebuffer object para visualizar fuera de la ventana (offscreen)
+
+#ifndef FBO_OFFSCREEN_H
+#define FBO_OFFSCREEN_H
+
+#include "glincludes.h"
+#include "imagenes.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Framebuffer con un 'renderbuffer' de color (RGBA, 8 bits por canal) y otro de profundidad
+// (24 bits), del tamaño indicado al crearlo.
+//
+class FramebufferOffscreen
+{
+   public:
+
+   // crea el framebuffer (requiere un contexto OpenGL activo), aborta si no está completo
+   //
+   // @param p_ancho (unsigned) ancho en pixels (>0)
+   // @param p_alto  (unsigned) alto en pixels (>0)
+   //
+   FramebufferOffscreen( const unsigned p_ancho, const unsigned p_alto );
+
+   // hace que las siguientes visualizaciones se hagan en este framebuffer
+   void activar();
+
+   // vuelve a visualizar en el framebuffer por defecto (la ventana)
+   void desactivar();
+
+   // copia la zona inferior izquierda de los pixels de color, de 'ancho_zona' x 'alto_zona', en
+   // todo el framebuffer por defecto (la ventana), ampliándola o reduciéndola con filtro bilineal
+   // si el tamaño es distinto, y deja activo el framebuffer por defecto
+   //
+   // @param ancho_zona, alto_zona       (unsigned) tamaño de la zona a copiar, en pixels
+   // @param ancho_ventana, alto_ventana (int)      tamaño del framebuffer por defecto, en pixels
+   //
+   void copiarEnVentana( const unsigned ancho_zona, const unsigned alto_zona,
+                         const int ancho_ventana, const int alto_ventana );
+
+   // lee los pixels de color (espera a que termine la visualización) 
+   // @param img (Imagen) imagen RGB donde se leen (se redimensiona)
+   //
+   void leerImagen( Imagen & img );
+
+   inline unsigned leerAncho() const { return ancho ; }
+   inline unsigned leerAlto()  const { return alto ; }
+
+   // libera el framebuffer y los renderbuffers
+   ~FramebufferOffscreen();
+
+   private: // ---------------------------
+
+   unsigned ancho = 0,
+            alto  = 0 ;
+   GLuint   fbo           = 0 , // nombre del framebuffer object
+            rb_color      = 0 , // nombre del renderbuffer de color
+            rb_profundidad = 0 ; // nombre del renderbuffer de profundidad
+} ;
+
+#endif
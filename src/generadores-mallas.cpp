@@ -0,0 +1,301 @@
+// Generadores procedurales de mallas indexadas (en paralelo), para escenas de prueba
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <glm/gtc/constants.hpp> // 'pi'
+#include "generadores-mallas.h"
+#include "cauce.h"
+#include "paralelo.h"
+
+using namespace glm ;
+
+// ------------------------------------------------------------------------------------------------------
+// Tablas de una malla en construcción: los descriptores de VBO y punteros a su memoria
+
+struct TablasMalla
+{
+   DescrVBOAtribs * dvbo_pos   = nullptr ;
+   DescrVBOAtribs * dvbo_col   = nullptr ;
+   DescrVBOInds   * dvbo_tris  = nullptr ;
+   vec3           * posiciones = nullptr ;
+   vec3           * colores    = nullptr ;
+   uvec3          * triangulos = nullptr ;
+
+   TablasMalla( const unsigned long num_verts, const unsigned long num_tris ) ;
+
+   // crea el VAO con las tablas, e informa del tamaño de la malla y del tiempo desde 'inicio'
+   DescrVAO * crearVAO( const std::string & nombre, 
+                        const std::chrono::steady_clock::time_point & inicio ) ;
+
+   unsigned long num_verts, num_tris ;
+} ;
+
+// ------------------------------------------------------------------------------------------------------
+
+TablasMalla::TablasMalla( const unsigned long p_num_verts, const unsigned long p_num_tris )
+:  num_verts( p_num_verts ),
+   num_tris( p_num_tris )
+{
+   dvbo_pos   = new DescrVBOAtribs( Cauce::ind_atrib_posiciones, GL_FLOAT, 3, num_verts );
+   dvbo_col   = new DescrVBOAtribs( Cauce::ind_atrib_colores,    GL_FLOAT, 3, num_verts );
+   dvbo_tris  = new DescrVBOInds( GL_UNSIGNED_INT, 3*num_tris );
+   posiciones = (vec3 *)  dvbo_pos->leerPunteroDatos();
+   colores    = (vec3 *)  dvbo_col->leerPunteroDatos();
+   triangulos = (uvec3 *) dvbo_tris->leerPunteroIndices();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * TablasMalla::crearVAO( const std::string & nombre, 
+                                  const std::chrono::steady_clock::time_point & inicio )
+{
+   using namespace std ;
+
+   DescrVAO * vao = new DescrVAO( Cauce::num_atribs, dvbo_pos );
+   vao->agregar( dvbo_col );
+   vao->agregar( dvbo_tris );
+
+   const double ms = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+   cout << "Malla generada: " << nombre << ", " << num_verts << " vértices, " << num_tris 
+        << " triángulos (" << fixed << setprecision(1) << ms << " ms, " << NumHilosParalelo() 
+        << " hilos)." << defaultfloat << endl ;
+   return vao ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+// Genera una superficie paramétrica sobre una rejilla de (nu+1)*(nv+1) vértices: la función
+// 'vertice( i, j, pos, col )' escribe la posición y el color del vértice en la columna 'i' 
+// (0..nu) y la fila 'j' (0..nv). Cada celda produce dos triángulos.
+
+template< class FuncionVertice >
+DescrVAO * GenerarParametrica( const std::string & nombre, const unsigned nu, const unsigned nv, 
+                               const FuncionVertice & vertice )
+{
+   assert( 0 < nu && 0 < nv );
+   const auto          inicio    = std::chrono::steady_clock::now();
+   const unsigned long num_verts = (unsigned long)( nu+1 )*( nv+1 ),
+                       num_tris  = 2ul*nu*nv ;
+   TablasMalla         t( num_verts, num_tris );
+
+   // vértices, por filas
+   ParaleloPara( nv+1, [&]( const unsigned long j0, const unsigned long j1 )
+   {
+      for( unsigned long j = j0 ; j < j1 ; j++ )
+         for( unsigned i = 0 ; i <= nu ; i++ )
+         {
+            const unsigned long k = j*( nu+1 ) + i ;
+            vertice( i, unsigned(j), t.posiciones[k], t.colores[k] );
+         }
+   }, 64 );
+
+   // triángulos, por filas de celdas
+   ParaleloPara( nv, [&]( const unsigned long j0, const unsigned long j1 )
+   {
+      for( unsigned long j = j0 ; j < j1 ; j++ )
+         for( unsigned i = 0 ; i < nu ; i++ )
+         {
+            const unsigned v00 = j*( nu+1 ) + i,  v10 = v00 + 1,
+                           v01 = v00 + nu + 1,    v11 = v01 + 1 ;
+            const unsigned long c = 2ul*( j*nu + i );
+            t.triangulos[c]   = { v00, v10, v11 };
+            t.triangulos[c+1] = { v00, v11, v01 };
+         }
+   }, 64 );
+
+   return t.crearVAO( nombre, inicio );
+}
+
+// ------------------------------------------------------------------------------------------------------
+// color a partir de una dirección (componentes entre -1 y 1)
+
+inline vec3 ColorDireccion( const vec3 & d )
+{
+   return 0.5f*d + vec3( 0.5f );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * GenerarRejilla( const unsigned nx, const unsigned nz )
+{
+   return GenerarParametrica( "rejilla", nx, nz, [=]( const unsigned i, const unsigned j, vec3 & pos, vec3 & col )
+   {
+      const float u = float(i)/nx, v = float(j)/nz ;
+      pos = { 2.0f*u - 1.0f, 0.0f, 1.0f - 2.0f*v };
+      col = { u, 0.5f, v };
+   });
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * GenerarEsferaUV( const unsigned n_meridianos, const unsigned n_paralelos )
+{
+   return GenerarParametrica( "esfera UV", n_meridianos, n_paralelos, 
+      [=]( const unsigned i, const unsigned j, vec3 & pos, vec3 & col )
+   {
+      const float longitud = 2.0f*pi<float>()*i/n_meridianos,
+                  latitud  = pi<float>()*( float(j)/n_paralelos - 0.5f );
+      pos = { std::cos( latitud )*std::sin( longitud ), std::sin( latitud ), std::cos( latitud )*std::cos( longitud ) };
+      col = ColorDireccion( pos );
+   });
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * GenerarToro( const unsigned n_mayor, const unsigned n_menor, const float r_mayor, 
+                        const float r_menor )
+{
+   return GenerarParametrica( "toro", n_mayor, n_menor, 
+      [=]( const unsigned i, const unsigned j, vec3 & pos, vec3 & col )
+   {
+      const float a = 2.0f*pi<float>()*i/n_mayor,
+                  b = 2.0f*pi<float>()*j/n_menor ;
+      const vec3  dir_radial = { std::sin( a ), 0.0f, std::cos( a ) },
+                  normal     = std::cos( b )*dir_radial + vec3( 0.0f, std::sin( b ), 0.0f );
+      pos = r_mayor*dir_radial + r_menor*normal ;
+      col = ColorDireccion( normal );
+   });
+}
+
+// ------------------------------------------------------------------------------------------------------
+// el cilindro es una única superficie paramétrica: la primera fila de celdas es la tapa inferior
+// (radio de 0 a 1), después 'n_alturas' filas en el lateral, y la última fila es la tapa superior
+
+DescrVAO * GenerarCilindro( const unsigned n_lados, const unsigned n_alturas )
+{
+   assert( 0 < n_alturas );
+   return GenerarParametrica( "cilindro", n_lados, n_alturas+2, 
+      [=]( const unsigned i, const unsigned j, vec3 & pos, vec3 & col )
+   {
+      const float    a     = 2.0f*pi<float>()*i/n_lados ;
+      const unsigned k     = std::clamp( j, 1u, n_alturas+1 ) - 1 ; // fila en el lateral (0..n_alturas)
+      const float    y     = 2.0f*float(k)/n_alturas - 1.0f,
+                     radio = ( j == 0 || j == n_alturas+2 ) ? 0.0f : 1.0f ;
+      pos = { radio*std::sin( a ), y, radio*std::cos( a ) };
+      col = ColorDireccion( { radio*std::sin( a ), y, radio*std::cos( a ) } );
+   });
+}
+
+// ------------------------------------------------------------------------------------------------------
+// ruido de valor en 2D: valores pseudo-aleatorios en los puntos de coordenadas enteras, 
+// interpolados con una función suave
+
+inline float ValorRed( const int x, const int z, const unsigned semilla )
+{
+   unsigned h = unsigned(x)*0x8da6b343u ^ unsigned(z)*0xd8163841u ^ semilla*0xcb1ab31fu ;
+   h ^= h >> 13 ;  h *= 0x5bd1e995u ;  h ^= h >> 15 ;
+   return float( h & 0xFFFFFFu )/float( 0xFFFFFFu ); // en [0,1]
+}
+
+inline float RuidoValor( const float x, const float z, const unsigned semilla )
+{
+   const float    fx = std::floor( x ), fz = std::floor( z );
+   const int      ix = int( fx ), iz = int( fz );
+   const float    tx = x - fx, tz = z - fz,
+                  sx = tx*tx*( 3.0f - 2.0f*tx ),
+                  sz = tz*tz*( 3.0f - 2.0f*tz );
+   const float    v00 = ValorRed( ix, iz, semilla ),   v10 = ValorRed( ix+1, iz, semilla ),
+                  v01 = ValorRed( ix, iz+1, semilla ), v11 = ValorRed( ix+1, iz+1, semilla );
+   return mix( mix( v00, v10, sx ), mix( v01, v11, sx ), sz );
+}
+
+// suma de octavas de ruido de valor, resultado en [0,1]
+inline float RuidoFractal( float x, float z, const unsigned semilla )
+{
+   constexpr unsigned num_octavas = 6 ;
+   float suma = 0.0f, amplitud = 0.5f, total = 0.0f ;
+   for( unsigned o = 0 ; o < num_octavas ; o++ )
+   {
+      suma  += amplitud*RuidoValor( x, z, semilla+o );
+      total += amplitud ;
+      x *= 2.0f ;  z *= 2.0f ;  amplitud *= 0.5f ;
+   }
+   return suma/total ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * GenerarTerreno( const unsigned nx, const unsigned nz, const float amplitud, 
+                           const unsigned semilla )
+{
+   return GenerarParametrica( "terreno", nx, nz, 
+      [=]( const unsigned i, const unsigned j, vec3 & pos, vec3 & col )
+   {
+      const float x = 2.0f*float(i)/nx - 1.0f,
+                  z = 1.0f - 2.0f*float(j)/nz,
+                  h = RuidoFractal( 2.0f*( x + 1.0f ), 2.0f*( z + 1.0f ), semilla ); 
+      pos = { x, amplitud*( 2.0f*h - 1.0f ), z };
+
+      // colores: verde en las zonas bajas, marrón en las medias y blanco en las altas
+      const vec3 verde = { 0.2f, 0.55f, 0.15f }, marron = { 0.45f, 0.35f, 0.2f }, blanco = { 0.95f, 0.95f, 0.95f };
+      col = h < 0.55f ? mix( verde, marron, std::clamp( ( h - 0.3f )/0.25f, 0.0f, 1.0f ))
+                      : mix( marron, blanco, std::clamp( ( h - 0.55f )/0.15f, 0.0f, 1.0f ));
+   });
+}
+
+// ------------------------------------------------------------------------------------------------------
+// Icoesfera: cada una de las 20 caras del icosaedro se subdivide en una red triangular con 'n' 
+// segmentos por arista, con (n+1)(n+2)/2 vértices y n*n triángulos por cara. Las caras se
+// generan en paralelo, cada una en su zona de las tablas.
+
+DescrVAO * GenerarIcoesfera( const unsigned n )
+{
+   assert( 0 < n );
+   const auto inicio = std::chrono::steady_clock::now();
+
+   // vértices y caras del icosaedro (caras orientadas hacia fuera)
+   const float t = ( 1.0f + std::sqrt( 5.0f ) )/2.0f ;
+   const vec3  ico_verts[12] =
+   {
+      {-1, t, 0}, {1, t, 0}, {-1,-t, 0}, {1,-t, 0}, {0,-1, t}, {0, 1, t}, 
+      {0,-1,-t},  {0, 1,-t}, { t, 0,-1}, {t, 0, 1}, {-t, 0,-1}, {-t, 0, 1}
+   };
+   const uvec3 ico_caras[20] =
+   {
+      {0,11,5}, {0,5,1}, {0,1,7}, {0,7,10}, {0,10,11}, {1,5,9}, {5,11,4}, {11,10,2}, {10,7,6}, {7,1,8},
+      {3,9,4}, {3,4,2}, {3,2,6}, {3,6,8}, {3,8,9}, {4,9,5}, {2,4,11}, {6,2,10}, {8,6,7}, {9,8,1}
+   };
+
+   const unsigned long verts_cara = (unsigned long)( n+1 )*( n+2 )/2,
+                       tris_cara  = (unsigned long) n*n ;
+   TablasMalla         tm( 20*verts_cara, 20*tris_cara );
+
+   ParaleloPara( 20, [&]( const unsigned long c0, const unsigned long c1 )
+   {
+      for( unsigned long c = c0 ; c < c1 ; c++ )
+      {
+         const vec3     a = ico_verts[ico_caras[c][0]], b = ico_verts[ico_caras[c][1]], 
+                        d = ico_verts[ico_caras[c][2]] ;
+         const unsigned base_v = c*verts_cara ;
+         vec3         * pos    = tm.posiciones + base_v ;
+         vec3         * col    = tm.colores + base_v ;
+         uvec3        * tri    = tm.triangulos + c*tris_cara ;
+
+         // vértice (i,j) de la cara, con i+j <= n: a + i*(b-a)/n + j*(d-a)/n, en la fila 'j'
+         const auto indice = [n,base_v]( const unsigned i, const unsigned j )
+         {  return base_v + j*( n+1 ) - j*( j-1 )/2 + i ; };
+
+         unsigned k = 0 ;
+         for( unsigned j = 0 ; j <= n ; j++ )
+            for( unsigned i = 0 ; i+j <= n ; i++, k++ )
+            {
+               pos[k] = normalize( a + ( float(i)*( b-a ) + float(j)*( d-a ) )/float(n) );
+               col[k] = ColorDireccion( pos[k] );
+            }
+
+         k = 0 ;
+         for( unsigned j = 0 ; j < n ; j++ )
+            for( unsigned i = 0 ; i+j < n ; i++ )
+            {
+               tri[k++] = { indice( i, j ), indice( i+1, j ), indice( i, j+1 ) };
+               if ( i+j+1 < n )
+                  tri[k++] = { indice( i+1, j ), indice( i+1, j+1 ), indice( i, j+1 ) };
+            }
+         assert( k == tris_cara );
+      }
+   }, 1 );
+
+   return tm.crearVAO( "icoesfera", inicio );
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,49 @@
+// Generadores procedurales de mallas indexadas (en paralelo), para escenas de prueba
+
+#ifndef GENERADORES_MALLAS_H
+#define GENERADORES_MALLAS_H
+
+#include "glincludes.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+// Todos los generadores crean un VAO indexado para GL_TRIANGLES, con posiciones (atributo 
+// 'Cauce::ind_atrib_posiciones') y colores (atributo 'Cauce::ind_atrib_colores'). Las tablas se 
+// escriben directamente en la memoria de los descriptores de VBO, repartiendo el trabajo entre 
+// varios hilos, e informan en 'cout' del tamaño de la malla y del tiempo empleado.
+// Las mallas están centradas en el origen y caben en el cubo [-1,1]^3.
+//
+// Las superficies paramétricas (rejilla, esfera UV, toro, cilindro, terreno) repiten los vértices
+// de las costuras y los polos, y la icoesfera repite los de las aristas entre caras (ver 'SoldarVertices').
+
+// Rejilla plana en el plano Y=0 ([-1,1] en X y Z), con 'nx' por 'nz' celdas (2 triángulos por celda)
+//
+DescrVAO * GenerarRejilla( const unsigned nx, const unsigned nz );
+
+// Esfera de radio 1 con 'n_meridianos' divisiones en longitud y 'n_paralelos' en latitud
+//
+DescrVAO * GenerarEsferaUV( const unsigned n_meridianos, const unsigned n_paralelos );
+
+// Esfera de radio 1 obtenida al subdividir cada cara de un icosaedro en 'n*n' triángulos
+// (cada arista en 'n' segmentos), proyectando los vértices en la esfera. 
+//
+DescrVAO * GenerarIcoesfera( const unsigned n );
+
+// Toro en el plano Y=0, con radio mayor 'r_mayor' y radio menor 'r_menor' (r_mayor+r_menor <= 1),
+// con 'n_mayor' divisiones alrededor del eje Y y 'n_menor' alrededor del tubo
+//
+DescrVAO * GenerarToro( const unsigned n_mayor, const unsigned n_menor, const float r_mayor = 0.7f, 
+                        const float r_menor = 0.3f );
+
+// Cilindro de radio 1 y eje Y (Y entre -1 y 1), con tapas, con 'n_lados' divisiones alrededor
+// del eje y 'n_alturas' divisiones a lo largo del eje
+//
+DescrVAO * GenerarCilindro( const unsigned n_lados, const unsigned n_alturas );
+
+// Terreno: rejilla de 'nx' por 'nz' celdas desplazada en Y con ruido fractal (suma de octavas de
+// ruido de valor), con la altura máxima 'amplitud', y colores según la altura
+//
+DescrVAO * GenerarTerreno( const unsigned nx, const unsigned nz, const float amplitud = 0.35f,
+                           const unsigned semilla = 0 );
+
+#endif
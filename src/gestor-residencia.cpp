@@ -0,0 +1,97 @@
+// Gestor de residencia: presupuesto de memoria de la GPU para los VAOs, con expulsión LRU
+
+#include <algorithm>
+#include <cassert>
+#include "gestor-residencia.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+GestorResidencia::GestorResidencia( const GLsizeiptr p_presupuesto )
+:  presupuesto( p_presupuesto )
+{
+   assert( 0 < presupuesto );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void GestorResidencia::insertarPrimero( DescrVAO & vao )
+{
+   assert( vao.gestor == nullptr );
+   vao.gestor        = this ;
+   vao.lru_anterior  = nullptr ;
+   vao.lru_siguiente = primero ;
+   if ( primero != nullptr )
+      primero->lru_anterior = &vao ;
+   else
+      ultimo = &vao ;
+   primero = &vao ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void GestorResidencia::desenlazar( DescrVAO & vao )
+{
+   assert( vao.gestor == this );
+   if ( vao.lru_anterior != nullptr )
+      vao.lru_anterior->lru_siguiente = vao.lru_siguiente ;
+   else
+      primero = vao.lru_siguiente ;
+   if ( vao.lru_siguiente != nullptr )
+      vao.lru_siguiente->lru_anterior = vao.lru_anterior ;
+   else
+      ultimo = vao.lru_anterior ;
+   vao.gestor        = nullptr ;
+   vao.lru_anterior  = nullptr ;
+   vao.lru_siguiente = nullptr ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void GestorResidencia::olvidar( DescrVAO & vao )
+{
+   desenlazar( vao );
+   residentes -= vao.leerTamano() ;
+   assert( 0 <= residentes );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void GestorResidencia::usar( DescrVAO & vao )
+{
+   // acierto: pasar a ser el más reciente
+   if ( vao.gestor == this )
+   {
+      assert( vao.creado() );
+      num_aciertos++ ;
+      if ( primero != &vao )
+      {
+         desenlazar( vao );
+         insertarPrimero( vao );
+      }
+      return ;
+   }
+   assert( vao.gestor == nullptr ); // (solo puede haber un gestor)
+
+   // un VAO creado en la GPU antes de usar el gestor se registra sin contar la subida
+   const GLsizeiptr tamano = vao.leerTamano() ;
+   if ( vao.creado() )
+      num_aciertos++ ;
+   else
+   {
+      // fallo: expulsar los VAOs usados hace más tiempo hasta que quepa (se creará a continuación)
+      num_fallos++ ;
+      bytes_subidos += tamano ;
+      while ( ultimo != nullptr && residentes + tamano > presupuesto )
+      {
+         ultimo->liberarGPU(); // (llama a 'olvidar')
+         num_expulsiones++ ;
+      }
+   }
+   residentes += tamano ;
+   max_residentes = std::max( max_residentes, residentes );
+   insertarPrimero( vao );
+}
+// ------------------------------------------------------------------------------------------------------
+
+GestorResidencia::~GestorResidencia()
+{
+   while ( primero != nullptr )
+      olvidar( *primero );
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+// Gestor de residencia: presupuesto de memoria de la GPU para los VAOs, con expulsión LRU
+
+#ifndef GESTOR_RESIDENCIA_H
+#define GESTOR_RESIDENCIA_H
+
+#include "glincludes.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Controla los bytes que ocupan en la GPU los VBOs de los VAOs registrados, para que no superen
+// un presupuesto. Los VAOs se registran al dibujarlos o prepararlos (ver 'FijarGestorResidencia')
+// y se mantienen en una lista ordenada por su último uso. Cuando hay que crear en la GPU un VAO
+// que no cabe en el presupuesto, se liberan los VAOs residentes usados hace más tiempo (LRU): sus
+// VBOs se eliminan de la GPU, pero los descriptores conservan los datos en la memoria de la
+// aplicación, y el siguiente 'draw' los vuelve a crear de forma transparente.
+//
+// La lista está enlazada con punteros en los propios VAOs, así que registrar un uso o una
+// expulsión no reserva memoria dinámica. El presupuesto es estricto: si los VAOs que se dibujan
+// en un frame no caben, cada uno expulsa a los anteriores y todos los dibujos son fallos (se ve
+// en las estadísticas). Un VAO que solo no cabe en el presupuesto se crea igualmente, tras
+// expulsar a todos los demás. Solo se puede usar desde el hilo que tiene el contexto OpenGL.
+//
+class GestorResidencia
+{
+   public:
+
+   // crea un gestor vacío
+   // @param p_presupuesto (GLsizeiptr) máximo número de bytes de los VAOs residentes (>0)
+   //
+   GestorResidencia( const GLsizeiptr p_presupuesto );
+
+   // registra un uso de un VAO justo antes de dibujarlo o prepararlo: si está creado en la GPU
+   // pasa a ser el más reciente (acierto), si no (fallo), expulsa VAOs hasta que quepa, para que
+   // a continuación se cree (lo llama 'DescrVAO')
+   //
+   // @param vao (DescrVAO &) VAO que se va a usar
+   //
+   void usar( DescrVAO & vao );
+
+   // quita un VAO de la lista de residentes (lo llaman 'DescrVAO::liberarGPU' y el destructor de 'DescrVAO')
+   // @param vao (DescrVAO &) VAO registrado en este gestor
+   //
+   void olvidar( DescrVAO & vao );
+
+   // presupuesto, bytes residentes ahora y máximo de bytes residentes
+   inline GLsizeiptr leerPresupuesto()      const { return presupuesto ; }
+   inline GLsizeiptr leerResidentes()       const { return residentes ; }
+   inline GLsizeiptr leerMaximoResidentes() const { return max_residentes ; }
+
+   // usos con el VAO residente (aciertos) y sin él (fallos, cada uno crea el VAO en la GPU), VAOs
+   // expulsados, y bytes enviados a la GPU al crear VAOs (las subidas son los fallos)
+   inline unsigned long numAciertos()    const { return num_aciertos ; }
+   inline unsigned long numFallos()      const { return num_fallos ; }
+   inline unsigned long numExpulsiones() const { return num_expulsiones ; }
+   inline unsigned long bytesSubidos()   const { return bytes_subidos ; }
+
+   // quita del gestor los VAOs residentes (no los libera de la GPU)
+   ~GestorResidencia();
+
+   private: // ---------------------------
+
+   // inserta un VAO al principio de la lista de residentes (el más reciente), y lo quita de la
+   // lista (sin cambiar los bytes residentes)
+   void insertarPrimero( DescrVAO & vao );
+   void desenlazar( DescrVAO & vao );
+
+   const GLsizeiptr presupuesto ;
+   GLsizeiptr       residentes      = 0 ,
+                    max_residentes  = 0 ;
+   DescrVAO *       primero         = nullptr , // VAO residente usado más recientemente
+            *       ultimo          = nullptr ; // VAO residente usado hace más tiempo
+   unsigned long    num_aciertos    = 0 ,
+                    num_fallos      = 0 ,
+                    num_expulsiones = 0 ,
+                    bytes_subidos   = 0 ;
+} ;
+
+#endif
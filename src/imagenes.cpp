@@ -0,0 +1,83 @@
+// Imágenes RGB en memoria y lectura/escritura en formato PPM
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include "imagenes.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+void Imagen::redimensionar( const unsigned nuevo_ancho, const unsigned nuevo_alto )
+{
+   ancho = nuevo_ancho ;
+   alto  = nuevo_alto ;
+   pixels.resize( 3ul*ancho*alto );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+bool EscribirPPM( const std::string & nombre, const Imagen & img )
+{
+   using namespace std ;
+   assert( img.pixels.size() == 3ul*img.ancho*img.alto );
+
+   FILE * f = fopen( nombre.c_str(), "wb" );
+   if ( f == nullptr )
+   {
+      cout << "No se puede crear el archivo '" << nombre << "'." << endl ;
+      return false ;
+   }
+   fprintf( f, "P6\n%u %u\n255\n", img.ancho, img.alto );
+   const size_t escritos = fwrite( img.pixels.data(), 1, img.pixels.size(), f );
+   const bool   ok       = ( escritos == img.pixels.size() ) && ( fclose( f ) == 0 );
+   if ( ! ok )
+      cout << "Error al escribir el archivo '" << nombre << "'." << endl ;
+   return ok ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+bool LeerPPM( const std::string & nombre, Imagen & img )
+{
+   using namespace std ;
+
+   FILE * f = fopen( nombre.c_str(), "rb" );
+   if ( f == nullptr )
+      return false ;
+
+   unsigned ancho = 0, alto = 0, maximo = 0 ;
+   bool ok = fscanf( f, "P6 %u %u %u", &ancho, &alto, &maximo ) == 3 && maximo == 255 
+             && fgetc( f ) != EOF ; // (un único espacio en blanco tras la cabecera)
+   if ( ok )
+   {
+      img.redimensionar( ancho, alto );
+      ok = fread( img.pixels.data(), 1, img.pixels.size(), f ) == img.pixels.size() ;
+   }
+   fclose( f );
+   if ( ! ok )
+      cout << "El archivo '" << nombre << "' no es un PPM binario válido." << endl ;
+   return ok ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+ComparacionImagenes CompararImagenes( const Imagen & a, const Imagen & b, const unsigned tolerancia )
+{
+   assert( a.ancho == b.ancho && a.alto == b.alto );
+   ComparacionImagenes res ;
+
+   for( size_t i = 0 ; i < a.pixels.size() ; i += 3 )
+   {
+      unsigned dif_pixel = 0 ;
+      for( unsigned c = 0 ; c < 3 ; c++ )
+      {
+         const int d = int( a.pixels[i+c] ) - int( b.pixels[i+c] );
+         dif_pixel = std::max( dif_pixel, unsigned( d < 0 ? -d : d ) );
+      }
+      res.max_diferencia = std::max( res.max_diferencia, dif_pixel );
+      if ( dif_pixel > tolerancia )
+         res.num_distintos++ ;
+   }
+   return res ;
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,61 @@
+// Imágenes RGB en memoria y lectura/escritura en formato PPM
+
+#ifndef IMAGENES_H
+#define IMAGENES_H
+
+#include <vector>
+#include <string>
+
+// --------------------------------------------------------------------------------------------
+
+// Imagen RGB con 8 bits por canal, filas de arriba hacia abajo, sin relleno entre filas
+//
+struct Imagen
+{
+   unsigned                   ancho  = 0 ; // número de columnas (pixels)
+   unsigned                   alto   = 0 ; // número de filas (pixels)
+   std::vector<unsigned char> pixels ;     // 3*ancho*alto bytes (R,G,B)
+
+   // cambia el tamaño (sin inicializar el contenido si no crece la tabla)
+   void redimensionar( const unsigned nuevo_ancho, const unsigned nuevo_alto );
+
+   // devuelve un puntero al primer byte de la fila 'y' (0 es la fila superior)
+   inline unsigned char * fila( const unsigned y ) { return pixels.data() + 3ul*ancho*y ; }
+   inline const unsigned char * fila( const unsigned y ) const { return pixels.data() + 3ul*ancho*y ; }
+} ;
+
+// --------------------------------------------------------------------------------------------
+
+// Escribe una imagen en un archivo en formato PPM binario ('P6')
+//
+// @param nombre (string) nombre del archivo
+// @param img    (Imagen) imagen a escribir
+// @return (bool) true si se ha escrito sin errores
+//
+bool EscribirPPM( const std::string & nombre, const Imagen & img );
+
+// Lee una imagen de un archivo en formato PPM binario ('P6', con 255 como valor máximo)
+//
+// @param nombre (string) nombre del archivo
+// @param img    (Imagen) imagen leída (se redimensiona)
+// @return (bool) true si se ha leído sin errores
+//
+bool LeerPPM( const std::string & nombre, Imagen & img );
+
+// Resultado de comparar dos imágenes del mismo tamaño
+//
+struct ComparacionImagenes
+{
+   unsigned long num_distintos = 0 ; // pixels con algún canal que difiere más que la tolerancia
+   unsigned      max_diferencia = 0 ; // máxima diferencia en un canal (0..255)
+} ;
+
+// Compara dos imágenes pixel a pixel (deben tener el mismo tamaño)
+//
+// @param a, b        (Imagen)   imágenes a comparar
+// @param tolerancia  (unsigned) máxima diferencia admitida en cada canal
+// @return (ComparacionImagenes)  número de pixels distintos y máxima diferencia
+//
+ComparacionImagenes CompararImagenes( const Imagen & a, const Imagen & b, const unsigned tolerancia );
+
+#endif
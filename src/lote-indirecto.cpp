@@ -0,0 +1,340 @@
+// Lote de objetos con recortado en la GPU (compute shader) y dibujo indirecto múltiple
+
+#include <cmath>
+#include "lote-indirecto.h"
+#include "errores-gl.h"
+#include "traza.h"
+
+// ---------------------------------------------------------------------------------------------
+// Compute shader de recortado: un hilo por objeto, escribe la orden de dibujo del objeto
+
+const char * const fuente_compute_shader_recorte = R"glsl(
+   #version 430 core
+
+   layout( local_size_x = 64 ) in ;
+
+   struct Malla  { uint num_indices, primer_indice ; int vertice_base ; uint relleno ; vec4 esfera ; } ;
+   struct Objeto { mat4 modelo ; vec4 color ; uvec4 malla ; } ;
+   struct Orden  { uint count, instance_count, first_index ; int base_vertex ; uint base_instance ; } ;
+
+   layout( std430, binding = 0 ) readonly  buffer BufferObjetos { Objeto objetos[] ; } ;
+   layout( std430, binding = 1 ) readonly  buffer BufferMallas  { Malla  mallas[] ;  } ;
+   layout( std430, binding = 2 ) writeonly buffer BufferOrdenes { Orden  ordenes[] ; } ;
+
+   uniform uint u_num_objetos ;
+   uniform vec4 u_planos[6] ; // planos del view-frustum en coordenadas de mundo (normales hacia dentro)
+
+   void main()
+   {
+      uint i = gl_GlobalInvocationID.x ;
+      if ( i >= u_num_objetos )
+         return ;
+
+      Objeto o = objetos[i] ;
+      Malla  m = mallas[ o.malla.x ] ;
+
+      // esfera englobante en coordenadas de mundo (el radio se escala con la mayor escala)
+      vec3  centro = ( o.modelo * vec4( m.esfera.xyz, 1.0 ) ).xyz ;
+      float escala = max( length( o.modelo[0].xyz ), max( length( o.modelo[1].xyz ), length( o.modelo[2].xyz )));
+      float radio  = m.esfera.w * escala ;
+
+      bool visible = true ;
+      for( int p = 0 ; p < 6 ; p++ )
+         visible = visible && ( dot( u_planos[p].xyz, centro ) + u_planos[p].w >= -radio );
+
+      ordenes[i] = Orden( m.num_indices, visible ? 1u : 0u, m.primer_indice, m.vertice_base, i );
+   }
+)glsl";
+
+// ---------------------------------------------------------------------------------------------
+// Vertex shader del dibujo: lee la matriz y el color del objeto en el SSBO, con el índice de objeto
+// que llega como atributo por instancia (su valor es el 'base_instance' de la orden de dibujo)
+
+const char * const fuente_vertex_shader_lote = R"glsl(
+   #version 430 core
+
+   layout( std140 ) uniform BloqueFrame
+   {
+      mat4 u_mat_proyeccion;
+      mat4 u_mat_vista;
+      vec4 u_tam_viewport;
+   };
+
+   struct Objeto { mat4 modelo ; vec4 color ; uvec4 malla ; } ;
+   layout( std430, binding = 0 ) readonly buffer BufferObjetos { Objeto objetos[] ; } ;
+
+   layout( location = 0 ) in vec3 atrib_posicion ;
+   layout( location = 1 ) in vec3 atrib_color ;
+   layout( location = 8 ) in uint atrib_objeto ;
+
+   out vec3 var_color ;
+
+   void main()
+   {
+      var_color   = atrib_color * objetos[ atrib_objeto ].color.rgb ;
+      gl_Position = u_mat_proyeccion * u_mat_vista * objetos[ atrib_objeto ].modelo * vec4( atrib_posicion, 1.0 );
+   }
+)glsl";
+
+// ---------------------------------------------------------------------------------------------
+
+const char * const fuente_fragment_shader_lote = R"glsl(
+   #version 430 core
+
+   in vec3 var_color ;
+   layout( location = 0 ) out vec4 out_color_fragmento ;
+
+   void main()
+   {
+      out_color_fragmento = vec4( var_color, 1.0 );
+   }
+)glsl";
+
+// ---------------------------------------------------------------------------------------------
+
+bool LoteIndirecto::soportado()
+{
+#ifndef __APPLE__
+   return GLEW_VERSION_4_3 ||
+          ( GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object && GLEW_ARB_multi_draw_indirect );
+#else
+   return false ;
+#endif
+}
+// ---------------------------------------------------------------------------------------------
+
+LoteIndirecto::LoteIndirecto()
+{
+   assert( soportado() );
+}
+// ---------------------------------------------------------------------------------------------
+// Las tablas de la malla se pasan a vec3 e índices GLuint, los índices se guardan relativos al
+// primer vértice de la malla ('vertice_base' en la orden de dibujo)
+
+unsigned LoteIndirecto::agregarMalla( const DescrVAO & malla )
+{
+   using namespace glm ;
+
+   const DescrVBOAtribs * dvbo_pos = malla.leerDescrAtrib( Cauce::ind_atrib_posiciones ),
+                        * dvbo_col = malla.tieneAtrib( Cauce::ind_atrib_colores )
+                                     ? malla.leerDescrAtrib( Cauce::ind_atrib_colores ) : nullptr ;
+   assert( dvbo_pos->leerType() == GL_FLOAT && 2 <= dvbo_pos->leerSize() && dvbo_pos->leerSize() <= 3 );
+   assert( dvbo_col == nullptr || ( dvbo_col->leerType() == GL_FLOAT && dvbo_col->leerSize() == 3 ));
+
+   const unsigned long n      = malla.leerNumVertices(),
+                       primer = posiciones.size() ;
+   const GLint         tam    = dvbo_pos->leerSize() ;
+   const float *       pos    = (const float *) dvbo_pos->leerDatos() ;
+
+   // vértices y caja englobante
+   vec3 minimo = vec3( +INFINITY ), maximo = vec3( -INFINITY );
+   for( unsigned long v = 0 ; v < n ; v++ )
+   {
+      const vec3 p = { pos[tam*v], pos[tam*v+1], tam == 3 ? pos[tam*v+2] : 0.0f };
+      posiciones.push_back( p );
+      colores.push_back( dvbo_col != nullptr ? ((const vec3 *) dvbo_col->leerDatos())[v] : vec3( 1.0f ));
+      minimo = min( minimo, p );
+      maximo = max( maximo, p );
+   }
+
+   // esfera englobante: centro de la caja y distancia al vértice más lejano
+   const vec3 centro = 0.5f*( minimo + maximo );
+   float      radio  = 0.0f ;
+   for( unsigned long v = primer ; v < posiciones.size() ; v++ )
+      radio = std::max( radio, length( posiciones[v] - centro ));
+
+   // índices (o la secuencia 0..n-1 si no es indexada)
+   const DescrVBOInds * dvbo_ind      = malla.leerDescrIndices();
+   const unsigned long  primer_indice = indices.size() ;
+   if ( dvbo_ind == nullptr )
+      for( unsigned long v = 0 ; v < n ; v++ )
+         indices.push_back( v );
+   else
+   {
+      assert( ! dvbo_ind->usaReinicio() );
+      for( GLsizei i = 0 ; i < dvbo_ind->leerCount() ; i++ )
+         switch( dvbo_ind->leerType() )
+         {
+            case GL_UNSIGNED_BYTE  : indices.push_back( ((const GLubyte  *) dvbo_ind->leerIndices())[i] ); break ;
+            case GL_UNSIGNED_SHORT : indices.push_back( ((const GLushort *) dvbo_ind->leerIndices())[i] ); break ;
+            default                : indices.push_back( ((const GLuint   *) dvbo_ind->leerIndices())[i] ); break ;
+         }
+   }
+
+   mallas.push_back( { GLuint( indices.size() - primer_indice ), GLuint( primer_indice ), GLint( primer ), 0,
+                       vec4( centro, radio ) } );
+   modificado = true ;
+   return mallas.size()-1 ;
+}
+// ---------------------------------------------------------------------------------------------
+
+void LoteIndirecto::agregarObjeto( const unsigned malla, const glm::mat4 & modelo, const glm::vec3 & color )
+{
+   assert( malla < mallas.size() );
+   objetos.push_back( { modelo, glm::vec4( color, 1.0f ), glm::uvec4( malla, 0, 0, 0 ) } );
+   modificado = true ;
+}
+// ---------------------------------------------------------------------------------------------
+
+void LoteIndirecto::crearProgramas( Cauce & cauce )
+{
+#ifndef __APPLE__
+   CError();
+   prog_recorte = glCreateProgram(); assert( 0 < prog_recorte );
+   cauce.compilarAdjuntarShader( prog_recorte, GL_COMPUTE_SHADER, "compute shader (recortado)", fuente_compute_shader_recorte );
+   cauce.enlazarPrograma( prog_recorte, "programa de recortado en la GPU" );
+   loc_planos      = cauce.leerLocation( prog_recorte, "u_planos" );
+   loc_num_objetos = cauce.leerLocation( prog_recorte, "u_num_objetos" );
+
+   prog_dibujo = glCreateProgram(); assert( 0 < prog_dibujo );
+   cauce.compilarAdjuntarShader( prog_dibujo, GL_VERTEX_SHADER,   "vertex shader (lote)",   fuente_vertex_shader_lote );
+   cauce.compilarAdjuntarShader( prog_dibujo, GL_FRAGMENT_SHADER, "fragment shader (lote)", fuente_fragment_shader_lote );
+   cauce.enlazarPrograma( prog_dibujo, "programa de dibujo del lote" );
+   glUniformBlockBinding( prog_dibujo, glGetUniformBlockIndex( prog_dibujo, "BloqueFrame" ), Cauce::punto_enlace_frame );
+   CError();
+#endif
+}
+// ---------------------------------------------------------------------------------------------
+
+void LoteIndirecto::subirDatos()
+{
+#ifndef __APPLE__
+   CError();
+   assert( ! posiciones.empty() && ! objetos.empty() );
+
+   if ( vao == 0 )
+   {
+      glGenVertexArrays( 1, &vao );
+      GLuint buffers[7] ;
+      glGenBuffers( 7, buffers );
+      vbo_pos = buffers[0] ; vbo_col = buffers[1] ; vbo_objeto = buffers[2] ; vbo_ind = buffers[3] ;
+      ssbo_mallas = buffers[4] ; ssbo_objetos = buffers[5] ; buf_ordenes = buffers[6] ;
+   }
+
+   std::vector<GLuint> num_objeto( objetos.size() );
+   for( unsigned i = 0 ; i < num_objeto.size() ; i++ )
+      num_objeto[i] = i ;
+
+   glBindVertexArray( vao );
+   glBindBuffer( GL_ARRAY_BUFFER, vbo_pos );
+   glBufferData( GL_ARRAY_BUFFER, posiciones.size()*sizeof(glm::vec3), posiciones.data(), GL_STATIC_DRAW );
+   glVertexAttribPointer( Cauce::ind_atrib_posiciones, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
+   glEnableVertexAttribArray( Cauce::ind_atrib_posiciones );
+
+   glBindBuffer( GL_ARRAY_BUFFER, vbo_col );
+   glBufferData( GL_ARRAY_BUFFER, colores.size()*sizeof(glm::vec3), colores.data(), GL_STATIC_DRAW );
+   glVertexAttribPointer( Cauce::ind_atrib_colores, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
+   glEnableVertexAttribArray( Cauce::ind_atrib_colores );
+
+   // el índice de objeto avanza una vez por instancia, empezando en 'base_instance'
+   glBindBuffer( GL_ARRAY_BUFFER, vbo_objeto );
+   glBufferData( GL_ARRAY_BUFFER, num_objeto.size()*sizeof(GLuint), num_objeto.data(), GL_STATIC_DRAW );
+   glVertexAttribIPointer( ind_atrib_objeto, 1, GL_UNSIGNED_INT, 0, nullptr );
+   glVertexAttribDivisor( ind_atrib_objeto, 1 );
+   glEnableVertexAttribArray( ind_atrib_objeto );
+   glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+   glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, vbo_ind );
+   glBufferData( GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(GLuint), indices.data(), GL_STATIC_DRAW );
+   glBindVertexArray( 0 );
+
+   glBindBuffer( GL_SHADER_STORAGE_BUFFER, ssbo_mallas );
+   glBufferData( GL_SHADER_STORAGE_BUFFER, mallas.size()*sizeof(Malla), mallas.data(), GL_STATIC_DRAW );
+   glBindBuffer( GL_SHADER_STORAGE_BUFFER, ssbo_objetos );
+   glBufferData( GL_SHADER_STORAGE_BUFFER, objetos.size()*sizeof(Objeto), objetos.data(), GL_STATIC_DRAW );
+   glBindBuffer( GL_SHADER_STORAGE_BUFFER, buf_ordenes );
+   glBufferData( GL_SHADER_STORAGE_BUFFER, objetos.size()*5*sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW );
+   glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 );
+
+   modificado = false ;
+   CError();
+
+   using namespace std ;
+   cout << "Lote indirecto: " << objetos.size() << " objetos, " << mallas.size() << " mallas, "
+        << posiciones.size() << " vértices, " << indices.size()/3 << " triángulos en las mallas." << endl ;
+#endif
+}
+// ---------------------------------------------------------------------------------------------
+
+void LoteIndirecto::preparar( Cauce & cauce )
+{
+#ifndef __APPLE__
+   ZONA_TRAZA( "LoteIndirecto::preparar" );
+   if ( objetos.empty() )
+      return ;
+   if ( prog_recorte == 0 )
+      crearProgramas( cauce );
+   if ( modificado )
+      subirDatos();
+#endif
+}
+// ---------------------------------------------------------------------------------------------
+
+void LoteIndirecto::visualizar( Cauce & cauce )
+{
+#ifndef __APPLE__
+   ZONA_TRAZA( "LoteIndirecto::visualizar" );
+   using namespace glm ;
+   if ( objetos.empty() )
+      return ;
+   CError();
+
+   preparar( cauce );
+
+   // planos del view-frustum en coordenadas de mundo (a partir de las filas de 'proyección*vista'),
+   // normalizados para que la distancia con signo se pueda comparar con el radio
+   const mat4 m = cauce.leerMatrizProyeccion() * cauce.leerMatrizVista() ;
+   vec4 planos[6] ;
+   for( int i = 0 ; i < 3 ; i++ )
+   {
+      planos[2*i]   = row( m, 3 ) + row( m, i );
+      planos[2*i+1] = row( m, 3 ) - row( m, i );
+   }
+   for( vec4 & p : planos )
+      p /= length( vec3( p.x, p.y, p.z ) );
+
+   // recortado: escribe las órdenes de dibujo
+   glUseProgram( prog_recorte );
+   glUniform4fv( loc_planos, 6, value_ptr( planos[0] ) );
+   glUniform1ui( loc_num_objetos, objetos.size() );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, ssbo_objetos );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, ssbo_mallas );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, buf_ordenes );
+   glDispatchCompute( ( objetos.size() + 63 )/64, 1, 1 );
+
+   // las órdenes se leen como 'draw indirect buffer' después de que el compute shader las escriba
+   glMemoryBarrier( GL_COMMAND_BARRIER_BIT );
+
+   // dibujo de todos los objetos con una sola llamada
+   glEnable( GL_DEPTH_TEST );
+   glDepthFunc( GL_LESS );
+   glDepthMask( GL_TRUE );
+   glUseProgram( prog_dibujo );
+   glBindVertexArray( vao );
+   glBindBuffer( GL_DRAW_INDIRECT_BUFFER, buf_ordenes );
+   glMultiDrawElementsIndirect( GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, objetos.size(), 0 );
+   glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+   glBindVertexArray( 0 );
+
+   cauce.activar();
+   CError();
+#endif
+}
+// ---------------------------------------------------------------------------------------------
+
+LoteIndirecto::~LoteIndirecto()
+{
+#ifndef __APPLE__
+   if ( vao != 0 )
+   {
+      const GLuint buffers[7] = { vbo_pos, vbo_col, vbo_objeto, vbo_ind, ssbo_mallas, ssbo_objetos, buf_ordenes };
+      glDeleteBuffers( 7, buffers );
+      glDeleteVertexArrays( 1, &vao );
+   }
+   if ( prog_recorte != 0 )
+   {
+      glDeleteProgram( prog_recorte );
+      glDeleteProgram( prog_dibujo );
+   }
+#endif
+}
@@ -0,0 +1,121 @@
+// Lote de objetos con recortado en la GPU (compute shader) y dibujo indirecto múltiple
+
+#ifndef LOTE_INDIRECTO_H
+#define LOTE_INDIRECTO_H
+
+#include <vector>
+#include "glincludes.h"
+#include "cauce.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Lote de muchos objetos estáticos (p.ej. 100.000 o más), cada uno con una malla de un conjunto
+// de mallas, una matriz de modelado y un color. Todas las mallas se guardan en un único VAO, y
+// los datos por objeto (matriz, esfera englobante y malla) en un SSBO. En cada frame un compute
+// shader comprueba la esfera de cada objeto con los planos del view-frustum y escribe, para cada
+// objeto, una orden 'DrawElementsIndirectCommand' (con 0 instancias si no es visible), y después
+// todo el lote se dibuja con una única llamada a 'glMultiDrawElementsIndirect'. Así el coste en
+// la CPU por frame no depende del número de objetos.
+//
+// Requiere OpenGL 4.3 (o las extensiones de compute shaders, SSBOs y 'multi draw indirect'),
+// no está disponible en macOS.
+//
+class LoteIndirecto
+{
+   public:
+
+   // devuelve true si el contexto actual permite usar esta clase
+   static bool soportado() ;
+
+   // crea un lote vacío (requiere 'soportado()')
+   LoteIndirecto() ;
+
+   // añade una malla al conjunto de mallas del lote (copia sus tablas, el VAO no se modifica)
+   //
+   // @param malla (const DescrVAO &) malla de triángulos ('GL_TRIANGLES'), con posiciones float
+   //              (2 o 3 valores) y opcionalmente colores float (3 valores), indexada o no
+   // @return (unsigned) índice de la malla en el lote
+   //
+   unsigned agregarMalla( const DescrVAO & malla );
+
+   // añade un objeto al lote
+   //
+   // @param malla  (unsigned)  índice de la malla (devuelto por 'agregarMalla')
+   // @param modelo (mat4)      matriz de modelado (coordenadas de objeto a coordenadas de mundo)
+   // @param color  (vec3)      color por el que se multiplican los colores de la malla
+   //
+   void agregarObjeto( const unsigned malla, const glm::mat4 & modelo, const glm::vec3 & color );
+
+   // número de objetos del lote
+   inline unsigned numObjetos() const { return objetos.size() ; }
+
+   // compila los programas y sube los datos a la GPU si hace falta (lo hace 'visualizar' si no
+   // se ha llamado antes, este método permite hacerlo antes del primer frame)
+   //
+   // @param cauce (Cauce &) cauce con el que se compilan los shaders
+   //
+   void preparar( Cauce & cauce );
+
+   // recorta y dibuja todos los objetos con las matrices de vista y proyección actuales del
+   // cauce (la modelview del cauce no se usa), con test de profundidad. Deja activado el
+   // programa del cauce. La primera vez (o tras añadir mallas u objetos) sube los datos a la GPU.
+   //
+   // @param cauce (Cauce &) cauce del que se leen las matrices y con el que se compilan los shaders
+   //
+   void visualizar( Cauce & cauce );
+
+   // libera los objetos de OpenGL
+   ~LoteIndirecto() ;
+
+   // índice del atributo con el número de objeto (por instancia), fuera del rango del cauce
+   static constexpr GLuint ind_atrib_objeto = 8 ;
+
+   private: // ---------------------------
+
+   // datos de una malla del lote, tal como los lee el compute shader (disposición 'std430')
+   struct Malla
+   {
+      GLuint    num_indices ;   // número de índices de la malla
+      GLuint    primer_indice ; // posición del primer índice en la tabla de índices del lote
+      GLint     vertice_base ;  // valor sumado a los índices (primer vértice de la malla)
+      GLuint    relleno ;
+      glm::vec4 esfera ;        // esfera englobante en coords. de objeto (centro en xyz, radio en w)
+   } ;
+
+   // datos de un objeto del lote (disposición 'std430')
+   struct Objeto
+   {
+      glm::mat4  modelo ;  // matriz de modelado
+      glm::vec4  color ;   // color (rgb)
+      glm::uvec4 malla ;   // índice de la malla (en x)
+   } ;
+
+   // sube todas las tablas a la GPU (crea los buffers la primera vez)
+   void subirDatos();
+
+   // compila y enlaza los programas (usando el cauce para compilar)
+   void crearProgramas( Cauce & cauce );
+
+   std::vector<glm::vec3> posiciones ;  // tablas de vértices de todas las mallas
+   std::vector<glm::vec3> colores ;
+   std::vector<GLuint>    indices ;     // tablas de índices de todas las mallas
+   std::vector<Malla>     mallas ;
+   std::vector<Objeto>    objetos ;
+   bool                   modificado = true ; // true si hay que volver a subir los datos
+
+   GLuint prog_recorte = 0 ,    // programa con el compute shader de recortado
+          prog_dibujo  = 0 ;    // programa para dibujar los objetos
+   GLint  loc_planos       = -1 , // locations de los uniforms del compute shader
+          loc_num_objetos  = -1 ;
+   GLuint vao          = 0 ,
+          vbo_pos      = 0 ,
+          vbo_col      = 0 ,
+          vbo_objeto   = 0 ,    // índices de objeto 0,1,2,... (atributo por instancia)
+          vbo_ind      = 0 ,
+          ssbo_mallas  = 0 ,
+          ssbo_objetos = 0 ,
+          buf_ordenes  = 0 ;    // órdenes de dibujo (SSBO para el compute shader y 'draw indirect buffer')
+} ;
+
+#endif
@@ -3,18 +3,83 @@
 
 
 // includes de la librería estándard de C++
+#include <algorithm> // 'std::max'
+#include <atomic>    // 'std::atomic' (scenes rejected by the render thread)
 #include <cassert>   // 'assert' (enforce preconditions)
+#include <chrono>    // 'steady_clock' (benchmark)
 #include <cstring>   // 'strlen' (to compile shaders)
+#include <cmath>     // 'ceil', 'sqrt'
+#include <cstdlib>   // 'atoi', 'atof'
+#include <filesystem> // 'directory_iterator' (to find the textures)
 #include <iostream>  // 'cout' and such
 #include <iomanip>   // set precision and such
+#include <thread>    // 'std::thread' (render thread)
 #include <vector>    // 'std::vector' types
+#ifdef __GLIBC__
+#include <malloc.h>  // 'mallopt' (memory thresholds, see 'PrepararRecursos')
+#endif
 
 // incluir cabeceras de OpenGL y GLM
 #include "glincludes.h"
 
 // incluir cabeceras auxiliares para shaders, vaos y vbos.
 #include "cauce.h"      // clase 'Cauce'
-#include "vaos-vbos.h"  // clases 'DescrVAO', 'DescrVBOAtribs' y 'DescrVBOInds' 
+#include "vaos-vbos.h"  // clases 'DescrVAO', 'DescrVBOAtribs' y 'DescrVBOInds'
+#include "cola-opacos.h" // clase 'ColaOpacos'
+#include "errores-gl.h"  // macro 'CError' (comprobación de errores de OpenGL)
+#include "captura-frames.h" // clase 'CapturaFrames'
+#include "regresion.h"  // función 'EjecutarRegresion'
+#include "generadores-mallas.h" // funciones 'Generar...' (mallas procedurales)
+#include "camara-orbital.h"     // clase 'CamaraOrbital'
+#include "soldar-vertices.h"    // función 'SoldarVertices'
+#include "normales-vertices.h"  // función 'CalcularNormales'
+#include "gestor-residencia.h"  // clase 'GestorResidencia'
+#include "codec-mallas.h"       // funciones 'GuardarMallaComprimida' y 'LeerMallaComprimida'
+#include "cargador-texturas.h"  // clases 'Textura' y 'CargadorTexturas'
+#include "lote-indirecto.h"     // clase 'LoteIndirecto'
+#include "asignador-frame.h"    // clase 'AsignadorFrame'
+#include "contador-asignaciones.h" // función 'LeerContadoresAsignaciones'
+#include "traza.h"              // macro 'ZONA_TRAZA' y funciones de la traza
+#include "precarga-recursos.h"  // clase 'PrecargaRecursos'
+#include "bvh-triangulos.h"     // clase 'BVHTriangulos'
+#include "buffer-triple.h"      // clase 'BufferTriple'
+#include "resolucion-dinamica.h" // clase 'ResolucionDinamica'
+#include "octree-puntos.h"      // funciones 'GenerarNubeSintetica' y 'ConstruirOctreePuntos'
+#include "nube-puntos.h"        // clase 'NubePuntos'
+#include "serie-temporal.h"     // clase 'SerieTemporal'
+#include "tiras-triangulos.h"   // función 'CrearVAOTiras'
+#include "paralelo.h"           // función 'ParaleloPara'
+
+// ---------------------------------------------------------------------------------------------
+// Estado de la entrada y de la ventana que el hilo de eventos pasa al hilo de visualización
+// (los gestores de eventos modifican su copia y la publican, el hilo de visualización aplica
+// la última publicada a las variables globales que usa al dibujar)
+
+struct EstadoEntrada
+{
+    int           ancho = 512, alto = 512 ;  // tamaño del framebuffer, en pixels
+    bool          terminar        = false ;  // true cuando hay que terminar el programa
+    bool          escena_mallas   = false ,
+                  escena_texturas = false ,
+                  escena_lote     = false ,
+                  escena_nube     = false ,
+                  escena_serie    = false ,
+                  soldar_mallas   = false ,
+                  tiras_mallas    = false ,
+                  iluminar_mallas = true ;
+    unsigned      nivel_mallas    = 4 ;
+    CamaraOrbital camara ;
+    bool          prepasada_profundidad    = false , // opciones de la cola de opacos
+                  ordenar                  = true ,
+                  visualizar_overdraw      = false ,
+                  usar_cache_transformados = false ;
+    double        serie_centro = 0.5 ,       // vista de la serie temporal: centro y ancho del rango visible
+                  serie_ancho  = 1.0 ;       // (en fracciones de la serie)
+    unsigned long num_cambios_captura = 0 ;  // veces que se ha pedido iniciar o terminar la captura (tecla 'C')
+    unsigned long num_selecciones     = 0 ;  // veces que se ha pedido seleccionar una malla (clic)
+    double        seleccion_x = 0.0, seleccion_y = 0.0 ; // punto de la última selección pedida
+    int           seleccion_ancho = 0, seleccion_alto = 0 ; // tamaño de la ventana en la última selección
+} ;
 
 // ---------------------------------------------------------------------------------------------
 // Constantes y variables globales
@@ -24,8 +89,8 @@
 //     ind_atrib_colors    = 1,      // índice del atributo de vértice con su color RGB
 //     num_atribs           = 2 ;     // número de atributos que gestionan los shaders
 bool
-    redibujar_ventana   = true ,   // puesto a true por los gestores de eventos cuando cambia el modelo y hay que regenerar la vista
-    terminar_programa   = false ;  // puesto a true en los gestores de eventos cuando hay que terminar el programa
+    redibujar_ventana   = true ,   // puesto a true al aplicar un estado nuevo de la entrada, cuando hay que regenerar la vista
+    terminar_programa   = false ;  // puesto a true al aplicar un estado de la entrada que pide terminar el programa
 GLFWwindow *
     ventana_glfw        = nullptr; // puntero a la ventana GLFW
 int
@@ -35,174 +100,843 @@ DescrVAO
     * vao_ind          = nullptr , // identificador de VAO (vertex array object) para secuencia indexada
     * vao_no_ind       = nullptr , // identificador de VAO para secuencia de vértices no indexada
     * vao_glm          = nullptr ; // identificador de VAO para secuencia de vértices guardada en vectors de vec3
-Cauce 
+Cauce
     * cauce            = nullptr ; // puntero al objeto de la clase 'Cauce' en uso.
+ColaOpacos
+    * cola_opacos      = nullptr ; // cola de objetos opacos del frame actual
+CapturaFrames
+    * captura          = nullptr ; // captura de frames en curso (nulo si no se está capturando)
+FormatoCaptura
+    formato_captura    = FormatoCaptura::ppm ; // formato de los archivos de captura (opción '--captura-raw')
+bool
+    capturar_al_inicio = false ;   // empezar a capturar desde el primer frame (opción '--capturar')
+bool
+    permitir_dsa       = true ;    // crear VBOs y VAOs con DSA si el contexto lo soporta (opción '--sin-dsa')
+OpcionesRegresion
+    opciones_regresion ;           // opciones de la prueba de regresión (carpeta vacía si no se hace)
+bool
+    escena_mallas      = false ;   // true para visualizar las mallas procedurales en lugar de los triángulos (tecla 'M')
+unsigned
+    nivel_mallas       = 4 ;       // nivel de resolución de las mallas procedurales (teclas '+' y '-')
+bool
+    soldar_mallas      = false ;   // true para soldar los vértices repetidos de las mallas procedurales (tecla 'W')
+bool
+    tiras_mallas       = false ;   // true para dibujar las mallas procedurales como tiras de triángulos (tecla 'R')
+bool
+    iluminar_mallas    = true ;    // true para iluminar las mallas procedurales, con sus normales (tecla 'L')
+std::vector<DescrVAO *>
+    mallas             ;           // mallas procedurales del nivel actual (vacío si no se han creado)
+std::vector<BVHTriangulos *>
+    bvh_mallas         ;           // BVHs de las mallas procedurales, para seleccionarlas con el ratón (vacío si no se han creado)
+CamaraOrbital
+    camara_mallas( 9.0f ) ;        // cámara usada para visualizar las mallas procedurales
+bool
+    escena_texturas    = false ;   // true para visualizar las texturas cargadas (tecla 'T')
+CargadorTexturas
+    * cargador_texturas = nullptr ; // cargador asíncrono de texturas
+std::string
+    carpeta_texturas   ;           // carpeta con archivos PPM a cargar al inicio (opción '--texturas')
+constexpr double
+    presupuesto_texturas_ms = 2.0 ; // tiempo máximo por frame para subir texturas a la GPU
+DescrVAO
+    * vao_cuadro       = nullptr ; // cuadrado [-1,1]^2 con coordenadas de textura
+Textura
+    * textura_ajedrez  = nullptr ; // textura usada si no se ha cargado ninguna
+bool
+    escena_lote        = false ;   // true para visualizar el lote de objetos recortado en la GPU (tecla 'I')
+LoteIndirecto
+    * lote             = nullptr ; // lote de objetos con recortado en la GPU (nulo si no se ha creado)
+AsignadorFrame
+    asignador_frame    ;           // memoria temporal del frame actual (se reinicia al inicio de cada frame)
+unsigned
+    frames_benchmark   = 0 ;       // número de frames a medir en el benchmark (opción '--benchmark', 0 si no se hace)
+constexpr unsigned
+    frames_calentamiento_benchmark = 10 ; // frames iniciales del benchmark que no se miden
+std::string
+    archivo_traza      ;           // archivo donde escribir la traza al terminar (opción '--traza', vacío si no se graba)
+PrecargaRecursos
+    precarga           ;           // VAOs que se crean y se usan para calentar el driver antes de visualizarlos
+bool
+    precargar          = true ;    // preparar los recursos antes del primer frame (opción '--sin-precarga')
+std::chrono::steady_clock::time_point
+    instante_inicio    ;           // instante de inicio del programa (para el tiempo hasta el primer frame)
+unsigned long
+    num_frames         = 0 ;       // frames visualizados en la ventana
+double
+    peor_frame_ms      = 0.0 ;     // máximo tiempo de un frame (en la CPU, hasta presentarlo)
+unsigned long
+    peor_frame         = 0 ;       // número del frame que más ha tardado
+ResolucionDinamica
+    * resolucion_dinamica = nullptr ; // escalado de la resolución de los frames (nulo si no se usa)
+double
+    objetivo_frame_ms  = 0.0 ;     // tiempo objetivo de la GPU por frame (opción '--resolucion-dinamica', 0 si no se usa)
+float
+    escala_resolucion_min = 0.5f , // límites de la escala de la resolución dinámica (opción '--escala-resolucion')
+    escala_resolucion_max = 1.0f ;
+GestorResidencia
+    * gestor_residencia = nullptr ; // presupuesto de memoria de la GPU para los VAOs (nulo si no se usa)
+std::string
+    carpeta_mallas     ;           // carpeta con las mallas procedurales comprimidas (opción '--cache-mallas', vacío si no se usa)
+double
+    memoria_gpu_mib    = 0.0 ;     // presupuesto de memoria de la GPU para los VAOs, en MiB (opción '--memoria-gpu', 0 si no se usa)
+bool
+    escena_nube        = false ;   // true para visualizar la nube de puntos (tecla 'N')
+NubePuntos
+    * nube             = nullptr ; // nube de puntos fuera de memoria (nulo si no se ha abierto)
+std::string
+    carpeta_nube       ;           // carpeta con el octree de la nube de puntos (opción '--nube', vacío si no hay)
+double
+    presupuesto_puntos = 3.0 ;     // máximo de puntos de la nube dibujados por frame, en millones (opción '--presupuesto-puntos')
+std::string
+    archivo_generar_nube ,         // archivo de puntos a generar y terminar (opción '--generar-nube', vacío si no se genera)
+    archivo_construir_nube ,       // archivo de puntos del que construir un octree y terminar (opción '--construir-nube')
+    carpeta_construir_nube ;       // carpeta donde escribir el octree construido
+unsigned long
+    puntos_generar_nube = 0 ;      // número de puntos de la nube a generar
+bool
+    escena_serie       = false ;   // true para visualizar la serie temporal (tecla 'S')
+SerieTemporal
+    * serie            = nullptr ; // serie temporal con su pirámide de mínimos y máximos (nulo si no se ha creado)
+double
+    muestras_serie     = 16.0 ,    // número de muestras de la serie temporal, en millones (opción '--muestras-serie')
+    serie_centro       = 0.5 ,     // centro y ancho del rango visible de la serie temporal (en fracciones de la serie,
+    serie_ancho        = 1.0 ;     // teclas de cursor izquierda y derecha, y de página arriba y abajo)
+EstadoEntrada
+    entrada            ;           // estado de la entrada en el hilo de eventos (lo modifican los gestores de eventos)
+EstadoEntrada
+    entrada_aplicada   ;           // último estado de la entrada aplicado en el hilo de visualización
+BufferTriple<EstadoEntrada>
+    buffer_entrada     ;           // estados de la entrada publicados por el hilo de eventos
+std::atomic<unsigned>
+    escenas_rechazadas { 0 } ;     // escenas que el hilo de visualización no puede visualizar (bits 'rechazada_...'),
+                                   // el hilo de eventos las quita de 'entrada' al publicarla
+constexpr unsigned
+    rechazada_lote     = 1u ,      // bits de las escenas del lote de objetos y de la nube de puntos en 'escenas_rechazadas'
+    rechazada_nube     = 2u ;
 
 
+// ---------------------------------------------------------------------------------------------
+// crea el VAO del triángulo no indexado (si no está creado)
+
+void CrearTriangulo_NoInd()
+{
+    if ( vao_no_ind != nullptr )
+        return ;
+
+    // número de vértices que se van a dibujar
+    constexpr unsigned num_verts = 3 ;
+
+    // tablas de posiciones y colores de vértices (posiciones en 2D, con Z=0)
+    const GLfloat
+        posiciones[ num_verts*2 ] = {  -0.8, -0.8,      +0.8, -0.8,     0.0, 0.8      },
+        colores   [ num_verts*3 ] = {  1.0, 0.0, 0.0,   0.0, 1.0, 0.0,  0.0, 0.0, 1.0 };
+
+    // Crear VAO con posiciones, colores e indices
+    vao_no_ind = new DescrVAO( cauce->num_atribs, new DescrVBOAtribs( cauce->ind_atrib_posiciones, GL_FLOAT, 2, num_verts, posiciones ));
+    vao_no_ind->agregar( new DescrVBOAtribs( cauce->ind_atrib_colores, GL_FLOAT, 3, num_verts, colores ));
+}
 // ---------------------------------------------------------------------------------------------
 // función que se encarga de visualizar un triángulo relleno en modo diferido,
 // no indexado, usando la clase 'DescrVAO' (declarada en 'vaos-vbos.h')
-// el triángulo se dibuja en primer lugar relleno con colores, y luego las aristas en negro
+// el triángulo se añade a la cola de opacos, que lo dibuja relleno con colores y con las aristas en negro
+// superpuestas en la misma pasada (con el geometry shader de aristas del cauce)
 
 
 void DibujarTriangulo_NoInd( )
 {
-    assert( glGetError() == GL_NO_ERROR );
-
-    // la primera vez, crear e inicializar el VAO
-    if ( vao_no_ind == nullptr )
-    {
-        // número de vértices que se van a dibujar
-        constexpr unsigned num_verts = 3 ;
+    CError();
 
-        // tablas de posiciones y colores de vértices (posiciones en 2D, con Z=0)
-        const GLfloat
-            posiciones[ num_verts*2 ] = {  -0.8, -0.8,      +0.8, -0.8,     0.0, 0.8      },
-            colores   [ num_verts*3 ] = {  1.0, 0.0, 0.0,   0.0, 1.0, 0.0,  0.0, 0.0, 1.0 };
-
-        // Crear VAO con posiciones, colores e indices
-        vao_no_ind = new DescrVAO( cauce->num_atribs, new DescrVBOAtribs( cauce->ind_atrib_posiciones, GL_FLOAT, 2, num_verts, posiciones ));
-        vao_no_ind->agregar( new DescrVBOAtribs( cauce->ind_atrib_colores, GL_FLOAT, 3, num_verts, colores ));    
-    }
+    CrearTriangulo_NoInd(); // (solo la primera vez, si no se ha hecho en la precarga)
     
-    assert( glGetError() == GL_NO_ERROR );
+    CError();
 
-    // duibujar relleno usando los colores del VAO
-    glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+    // añadir a la cola: relleno usando los colores del VAO, y aristas en color negro
     cauce->fijarUsarColorPlano( false );
-    vao_no_ind->habilitarAtrib( cauce->ind_atrib_colores, true );
-    vao_no_ind->draw( GL_TRIANGLES );
+    cola_opacos->agregar( *cauce, vao_no_ind, GL_TRIANGLES, { 0.0, -0.27, 0.0 }, true );
 
-    assert( glGetError() == GL_NO_ERROR );
+    CError();
+}
 
-    // dibujar las líneas usando color negro
-    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-    cauce->fijarUsarColorPlano( true );
-    cauce->fijarColor( { 0.0, 0.0, 0.0 });
-    vao_no_ind->habilitarAtrib( cauce->ind_atrib_colores, false );
-    vao_no_ind->draw( GL_TRIANGLES );
+// ---------------------------------------------------------------------------------------------
+// crea el VAO del triángulo indexado (si no está creado)
 
-    assert( glGetError() == GL_NO_ERROR );
+void CrearTriangulo_Ind()
+{
+    if ( vao_ind != nullptr )
+        return ;
+
+    // número de vértices e índices que se van a dibujar
+    constexpr unsigned num_verts = 3, num_inds  = 3 ;
+
+    // tablas de posiciones y colores de vértices (posiciones en 2D, con Z=0)
+    const GLfloat
+        posiciones[ num_verts*2 ] = {  -0.4, -0.4,      +0.4, -0.4,     0.0, +0.4      },
+        colores   [ num_verts*3 ] = {  1.0, 0.0, 0.0,   0.0, 1.0, 0.0,  0.0, 0.0, 1.0 } ;
+    const GLuint
+        indices   [ num_inds    ] = { 0, 1, 2 };
+
+    vao_ind = new DescrVAO( cauce->num_atribs, new DescrVBOAtribs( cauce->ind_atrib_posiciones, GL_FLOAT, 2, num_verts, posiciones) );
+    vao_ind->agregar( new DescrVBOAtribs( cauce->ind_atrib_colores, GL_FLOAT, 3, num_verts, colores) ) ;
+    vao_ind->agregar( new DescrVBOInds( GL_UNSIGNED_INT, num_inds, indices ));
 }
-
 // ---------------------------------------------------------------------------------------------
 // función que se encarga de visualizar un triángulo  en modo diferido,
 // indexado, usando la clase  'DescrVAO' (declarada en vaos-vbos.h)
-// el triángulo se dibuja en primer lugar relleno con colores, y luego las aristas en negro
+// el triángulo se añade a la cola de opacos, que lo dibuja relleno con colores y con las aristas en negro
+// superpuestas en la misma pasada (con el geometry shader de aristas del cauce)
 
 void DibujarTriangulo_Ind( )
 {
-    assert( glGetError() == GL_NO_ERROR );
-
-    if ( vao_ind == nullptr )
-    {
-         // número de vértices e índices que se van a dibujar
-        constexpr unsigned num_verts = 3, num_inds  = 3 ;
-
-        // tablas de posiciones y colores de vértices (posiciones en 2D, con Z=0)
-        const GLfloat
-            posiciones[ num_verts*2 ] = {  -0.4, -0.4,      +0.4, -0.4,     0.0, +0.4      },
-            colores   [ num_verts*3 ] = {  1.0, 0.0, 0.0,   0.0, 1.0, 0.0,  0.0, 0.0, 1.0 } ;
-        const GLuint
-            indices   [ num_inds    ] = { 0, 1, 2 };
+    CError();
 
-        vao_ind = new DescrVAO( cauce->num_atribs, new DescrVBOAtribs( cauce->ind_atrib_posiciones, GL_FLOAT, 2, num_verts, posiciones) );
-        vao_ind->agregar( new DescrVBOAtribs( cauce->ind_atrib_colores, GL_FLOAT, 3, num_verts, colores) ) ;
-        vao_ind->agregar( new DescrVBOInds( GL_UNSIGNED_INT, num_inds, indices ));
-    }
+    CrearTriangulo_Ind(); // (solo la primera vez, si no se ha hecho en la precarga)
    
-    assert( glGetError() == GL_NO_ERROR );
-    
-    glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-    cauce->fijarUsarColorPlano( false );
-    vao_ind->habilitarAtrib( cauce->ind_atrib_colores, true );
-    vao_ind->draw( GL_TRIANGLES );
+    CError();
 
-    assert( glGetError() == GL_NO_ERROR );
-   
-    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-    cauce->fijarColor( { 0.0, 0.0, 0.0 });
-    vao_ind->habilitarAtrib( cauce->ind_atrib_colores, false );
-    vao_ind->draw( GL_TRIANGLES );
+    cauce->fijarUsarColorPlano( false );
+    cola_opacos->agregar( *cauce, vao_ind, GL_TRIANGLES, { 0.0, -0.13, 0.0 }, true );
 
-    assert( glGetError() == GL_NO_ERROR );
+    CError();
 }
 
+// ---------------------------------------------------------------------------------------------
+// crea el VAO del triángulo guardado en vectores de GLM (si no está creado)
+
+void CrearTriangulo_glm()
+{
+    using namespace std ;
+    using namespace glm ;
+    if ( vao_glm != nullptr )
+        return ;
+
+    // tablas de posiciones y colores de vértices (posiciones en 2D, con Z=0)
+    const vector<vec2>   posiciones = {  {-0.4, -0.4},     {+0.42, -0.47},   {0.1, +0.37}    };
+    const vector<vec3>   colores    = {  {1.0, 1.0, 0.0},  {0.0, 1.0, 1.0},  {1.0, 0.0, 1.0} };
+    const vector<uvec3>  indices    = {  { 0, 1, 2 }};   // (un único triángulo)      
+
+    vao_glm = new DescrVAO( cauce->num_atribs, new DescrVBOAtribs( cauce->ind_atrib_posiciones, posiciones ));
+    vao_glm->agregar( new DescrVBOAtribs( cauce->ind_atrib_colores, colores )) ;
+    vao_glm->agregar( new DescrVBOInds( indices ) );
+
+    CError();
+}
 // ---------------------------------------------------------------------------------------------
 // función que se encarga de visualizar un triángulo relleno en modo diferido,
 // usando vectores con entradas de tipos GLM (vec2, vec3, uvec3)
-// el triángulo se dibuja en primer lugar relleno con colores, y luego las aristas en negro
+// el triángulo se añade a la cola de opacos, que lo dibuja relleno con colores y con las aristas en negro
+// superpuestas en la misma pasada (con el geometry shader de aristas del cauce)
 
 void DibujarTriangulo_glm( )
 {    
+    CError();
+
+    CrearTriangulo_glm(); // (solo la primera vez, si no se ha hecho en la precarga)
+   
+    CError();
+
+    cauce->fijarUsarColorPlano( false );
+    cola_opacos->agregar( *cauce, vao_glm, GL_TRIANGLES, { 0.04, -0.17, 0.0 }, true );
+
+    CError();
+}
+
+// ---------------------------------------------------------------------------------------------
+// modo con el que se dibujan las mallas procedurales (triángulos sueltos o tiras)
+
+GLenum ModoMallas()
+{
+    return tiras_mallas ? GL_TRIANGLE_STRIP : GL_TRIANGLES ;
+}
+// ---------------------------------------------------------------------------------------------
+// crea los VAOs de las mallas procedurales en la GPU ahora, y no al dibujarlos en la cola de opacos
+// (antes, con 'tiras_mallas', sustituye cada malla por sus tiras de triángulos separadas con el
+// índice de reinicio)
+
+void PrecargarMallas()
+{
+    if ( tiras_mallas )
+        for( DescrVAO * & malla : mallas )
+        {
+            DescrVAO * tiras = CrearVAOTiras( *malla );
+            delete malla ;
+            malla = tiras ;
+        }
+    if ( ! precargar )
+        return ;
+    for( DescrVAO * malla : mallas )
+        precarga.registrar( malla, ModoMallas() );
+    precarga.precargar( *cauce );
+}
+// ---------------------------------------------------------------------------------------------
+// crea las mallas procedurales del nivel de resolución actual (si no están creadas), con 
+// 'n = 8*2^nivel' divisiones: en el nivel 7 hay en total unos 12 millones de triángulos. Con 
+// '--cache-mallas', las lee comprimidas de la carpeta si ya están, o las guarda tras crearlas.
+
+void CrearMallas()
+{
     using namespace std ;
+    if ( ! mallas.empty() )
+        return ;
+    ZONA_TRAZA( "CrearMallas" );
+
+    const unsigned n = 8u << nivel_mallas ;
+    constexpr unsigned num_mallas = 6 ;
+
+    // leer las mallas comprimidas de este nivel (y soldadura), si están todas en la carpeta
+    const auto nombre_archivo = [&]( const unsigned i )
+    {
+        return carpeta_mallas + "/malla-n" + to_string( nivel_mallas ) + ( soldar_mallas ? "-soldada-" : "-" ) 
+               + to_string( i ) + ".mcm" ;
+    };
+    if ( ! carpeta_mallas.empty() )
+    {
+        for( unsigned i = 0 ; i < num_mallas ; i++ )
+        {
+            DescrVAO * malla = LeerMallaComprimida( nombre_archivo( i ), cauce->num_atribs );
+            if ( malla == nullptr )
+                break ;
+            mallas.push_back( malla );
+        }
+        if ( mallas.size() == num_mallas )
+        {
+            cout << "Mallas procedurales leídas de '" << carpeta_mallas << "' (nivel " << nivel_mallas << ")" << endl ;
+            PrecargarMallas();
+            return ;
+        }
+        for( DescrVAO * malla : mallas )
+            delete malla ;
+        mallas.clear();
+    }
+
+    cout << "Creando mallas procedurales (nivel " << nivel_mallas << ", n = " << n << ")" << endl ;
+
+    mallas.push_back( GenerarRejilla( n, n ) );
+    mallas.push_back( GenerarEsferaUV( n, n/2 ) );
+    mallas.push_back( GenerarIcoesfera( std::max( 1u, n/3 ) ) );
+    mallas.push_back( GenerarToro( n, n/2 ) );
+    mallas.push_back( GenerarCilindro( n, n/2 ) );
+    mallas.push_back( GenerarTerreno( n, n ) );
+
+    if ( soldar_mallas )
+        for( DescrVAO * & malla : mallas )
+        {
+            DescrVAO * soldada = SoldarVertices( *malla, 1e-5f );
+            delete malla ;
+            malla = soldada ;
+        }
+
+    // calcular las normales (tras soldar, así los vértices de las costuras soldadas tienen la
+    // normal de los triángulos de los dos lados)
+    for( DescrVAO * malla : mallas )
+        malla->agregar( CalcularNormales( *malla ) );
+    assert( mallas.size() == num_mallas );
+
+    // guardarlas comprimidas para la próxima vez
+    if ( ! carpeta_mallas.empty() )
+        for( unsigned i = 0 ; i < num_mallas ; i++ )
+            GuardarMallaComprimida( nombre_archivo( i ), *mallas[i] );
+
+    PrecargarMallas();
+}
+// ---------------------------------------------------------------------------------------------
+// elimina las mallas procedurales (se vuelven a crear al visualizarlas)
+
+void EliminarMallas()
+{
+    for( DescrVAO * malla : mallas )
+    {
+        precarga.quitar( malla );
+        delete malla ;
+    }
+    mallas.clear();
+    for( BVHTriangulos * bvh : bvh_mallas )
+        delete bvh ;
+    bvh_mallas.clear();
+}
+// ---------------------------------------------------------------------------------------------
+// matriz de modelado de la malla procedural número 'i' (en una cuadrícula de 3x2)
+
+glm::mat4 MatrizModeloMalla( const unsigned i )
+{
+    using namespace glm ;
+    return translate( vec3{ 2.5f*( float(i % 3) - 1.0f ), 0.0f, 2.5f*( float(i / 3) - 0.5f ) } );
+}
+// ---------------------------------------------------------------------------------------------
+// añade a la cola de opacos las mallas procedurales (en una cuadrícula de 3x2), y fija las
+// matrices de la cámara orbital
+
+void DibujarMallas( const int ancho, const int alto )
+{
     using namespace glm ;
+    CrearMallas();
 
-    assert( glGetError() == GL_NO_ERROR );
+    cauce->fijarMatrizProyeccion( camara_mallas.matrizProyeccion( float(ancho)/float(alto) ) );
+    cauce->fijarMatrizVista( camara_mallas.matrizVista() );
+    cauce->fijarUsarColorPlano( false );
+    cauce->fijarIluminacion( iluminar_mallas ); // (la cola de opacos lo registra en cada entrada)
 
-    if ( vao_glm == nullptr )
+    for( unsigned i = 0 ; i < mallas.size() ; i++ )
     {
+        cauce->pushMM();
+            cauce->compMM( MatrizModeloMalla( i ) );
+            cola_opacos->agregar( *cauce, mallas[i], ModoMallas(), { 0.0, 0.0, 0.0 }, false );
+        cauce->popMM();
+    }
+    cauce->fijarIluminacion( false );
+}
+// ---------------------------------------------------------------------------------------------
+// selecciona la malla procedural visible en el punto (x,y) de la ventana (en coordenadas de GLFW,
+// con el origen arriba a la izquierda) con un rayo desde la cámara, e informa en 'cout' de la 
+// malla, el triángulo y las coordenadas baricéntricas del punto (la primera vez crea los BVHs)
+// Además, pinta de rojo los vértices de la malla cercanos al punto: solo se envían a la GPU los
+// rangos modificados de la tabla de colores (las posiciones no cambian, el BVH sigue siendo válido)
 
-        // tablas de posiciones y colores de vértices (posiciones en 2D, con Z=0)
-        const vector<vec2>   posiciones = {  {-0.4, -0.4},     {+0.42, -0.47},   {0.1, +0.37}    };
-        const vector<vec3>   colores    = {  {1.0, 1.0, 0.0},  {0.0, 1.0, 1.0},  {1.0, 0.0, 1.0} };
-        const vector<uvec3>  indices    = {  { 0, 1, 2 }};   // (un único triángulo)      
+void SeleccionarMalla( const double x, const double y, const int ancho, const int alto )
+{
+    using namespace std ;
+    using namespace glm ;
+    if ( mallas.empty() || ancho <= 0 || alto <= 0 )
+        return ;
+    if ( tiras_mallas )
+    {
+        cout << "No se pueden seleccionar las mallas dibujadas como tiras (tecla 'R' para volver a triángulos)." << endl ;
+        return ;
+    }
+    ZONA_TRAZA( "SeleccionarMalla" );
+
+    if ( bvh_mallas.empty() )
+        for( unsigned i = 0 ; i < mallas.size() ; i++ )
+        {
+            bvh_mallas.push_back( new BVHTriangulos( *mallas[i] ) );
+            cout << "BVH de la malla " << i << ": " << bvh_mallas[i]->leerNumTriangulos() << " triángulos, " 
+                 << bvh_mallas[i]->leerNumNodos() << " nodos (" << fixed << setprecision(1) 
+                 << bvh_mallas[i]->leerMsConstruccion() << " ms)." << defaultfloat << endl ;
+        }
+    const auto inicio = chrono::steady_clock::now();
+
+    // rayo en coordenadas de mundo, desde el plano de recorte delantero (t=0) hasta el trasero (t=1)
+    const mat4  inv_vp = inverse( camara_mallas.matrizProyeccion( float(ancho)/float(alto) ) * camara_mallas.matrizVista() );
+    const float xn     = 2.0f*float(x)/float(ancho) - 1.0f ,
+                yn     = 1.0f - 2.0f*float(y)/float(alto) ;
+    const vec4  p0     = inv_vp * vec4( xn, yn, -1.0f, 1.0f ),
+                p1     = inv_vp * vec4( xn, yn, +1.0f, 1.0f );
+    const vec4  origen = p0/p0.w ,
+                direccion = p1/p1.w - origen ;
+
+    // intersectar con cada malla en sus coordenadas de objeto (el parámetro 't' es el mismo)
+    ImpactoRayo mejor ;
+    unsigned    malla = 0 ;
+    mejor.t = 1.0f ;
+    for( unsigned i = 0 ; i < bvh_mallas.size() ; i++ )
+    {
+        const mat4 inv_modelo = inverse( MatrizModeloMalla( i ) );
+        const vec4 o = inv_modelo * origen ,
+                   d = inv_modelo * direccion ;
+        const ImpactoRayo impacto = bvh_mallas[i]->intersectar( vec3( o.x, o.y, o.z ), vec3( d.x, d.y, d.z ), mejor.t );
+        if ( impacto.hay )
+        {
+            mejor = impacto ;
+            malla = i ;
+        }
+    }
+    const double us = chrono::duration<double,micro>( chrono::steady_clock::now() - inicio ).count();
 
-        vao_glm = new DescrVAO( cauce->num_atribs, new DescrVBOAtribs( cauce->ind_atrib_posiciones, posiciones ));
-        vao_glm->agregar( new DescrVBOAtribs( cauce->ind_atrib_colores, colores )) ;
-        vao_glm->agregar( new DescrVBOInds( indices ) );
+    if ( mejor.hay )
+    {
+        cout << "Selección: malla " << malla << ", triángulo " << mejor.triangulo << ", coordenadas baricéntricas (" 
+             << fixed << setprecision(3) << mejor.baricentricas.x << ", " << mejor.baricentricas.y << ", " 
+             << mejor.baricentricas.z << ") (" << setprecision(1) << us << " µs)." << defaultfloat << endl ;
+
+        // punto de impacto en coordenadas de objeto
+        DescrVAO &             vao        = *mallas[malla] ;
+        const DescrVBOInds *   dvbo_inds  = vao.leerDescrIndices() ;
+        const float *          posiciones = (const float *) vao.leerDescrAtrib( Cauce::ind_atrib_posiciones )->leerDatos() ;
+        vec3 punto = { 0.0f, 0.0f, 0.0f };
+        for( unsigned k = 0 ; k < 3 ; k++ )
+        {
+            const unsigned long v = dvbo_inds->leerIndice( 3*mejor.triangulo + k );
+            punto += mejor.baricentricas[k] * vec3( posiciones[3*v], posiciones[3*v+1], posiciones[3*v+2] );
+        }
 
-        assert( glGetError() == GL_NO_ERROR );
+        // pintar los vértices cercanos (cada uno registra un rango modificado de la tabla de colores)
+        constexpr float radio_pintar = 0.15f ;
+        unsigned long num_pintados = 0 ;
+        for( unsigned long v = 0 ; v < (unsigned long) vao.leerNumVertices() ; v++ )
+        {
+            const vec3 p = vec3( posiciones[3*v], posiciones[3*v+1], posiciones[3*v+2] );
+            if ( dot( p - punto, p - punto ) <= radio_pintar*radio_pintar )
+            {
+                float * color = (float *) vao.modificarAtrib( Cauce::ind_atrib_colores, v, 1 );
+                color[0] = 1.0f ;  color[1] = 0.1f ;  color[2] = 0.1f ;
+                num_pintados++ ;
+            }
+        }
+        cout << "Vértices pintados: " << num_pintados << " de " << vao.leerNumVertices() << "." << endl ;
     }
-   
-    assert( glGetError() == GL_NO_ERROR );
-    
-    glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+    else
+        cout << "Selección: ninguna malla (" << fixed << setprecision(1) << us << " µs)." << defaultfloat << endl ;
+}
+
+// ---------------------------------------------------------------------------------------------
+// pide al cargador de texturas todos los archivos PPM de 'carpeta_texturas' (en orden alfabético)
+
+void CargarTexturas()
+{
+    using namespace std ;
+    namespace fs = std::filesystem ;
+    if ( carpeta_texturas.empty() )
+        return ;
+
+    vector<string> archivos ;
+    error_code     error ;
+    for( const fs::directory_entry & entrada : fs::directory_iterator( carpeta_texturas, error ) )
+        if ( entrada.is_regular_file() && entrada.path().extension() == ".ppm" )
+            archivos.push_back( entrada.path().string() );
+    sort( archivos.begin(), archivos.end() );
+
+    cout << "Cargando " << archivos.size() << " texturas de '" << carpeta_texturas << "'." << endl ;
+    for( const string & archivo : archivos )
+        cargador_texturas->cargar( archivo );
+}
+// ---------------------------------------------------------------------------------------------
+// crea el VAO del cuadrado [-1,1]^2 con coordenadas de textura (si no está creado)
+
+void CrearCuadro()
+{
+    using namespace std ;
+    using namespace glm ;
+    if ( vao_cuadro != nullptr )
+        return ;
+
+    const vector<vec3>  posiciones = { {-1.0, -1.0, 0.0}, {+1.0, -1.0, 0.0}, {+1.0, +1.0, 0.0}, {-1.0, +1.0, 0.0} };
+    const vector<vec3>  colores    = { {1.0, 1.0, 1.0},   {1.0, 1.0, 1.0},   {1.0, 1.0, 1.0},   {1.0, 1.0, 1.0}   };
+    const vector<vec2>  coords     = { {0.0, 0.0},        {1.0, 0.0},        {1.0, 1.0},        {0.0, 1.0}        };
+    const vector<uvec3> indices    = { {0, 1, 2}, {0, 2, 3} };
+
+    vao_cuadro = new DescrVAO( cauce->num_atribs, new DescrVBOAtribs( cauce->ind_atrib_posiciones, posiciones ));
+    vao_cuadro->agregar( new DescrVBOAtribs( cauce->ind_atrib_colores, colores ));
+    vao_cuadro->agregar( new DescrVBOAtribs( cauce->ind_atrib_coord_text, coords ));
+    vao_cuadro->agregar( new DescrVBOInds( indices ));
+}
+// ---------------------------------------------------------------------------------------------
+// crea la textura de ajedrez que se usa si no se carga ninguna (si no está creada)
+
+void CrearTexturaAjedrez()
+{
+    if ( textura_ajedrez != nullptr )
+        return ;
+
+    Imagen ajedrez ;
+    ajedrez.redimensionar( 64, 64 );
+    for( unsigned y = 0 ; y < ajedrez.alto ; y++ )
+        for( unsigned x = 0 ; x < ajedrez.ancho ; x++ )
+        {
+            const unsigned char v = (( x/8 + y/8 ) % 2 == 0) ? 255 : 64 ;
+            unsigned char * p = ajedrez.fila( y ) + 3*x ;
+            p[0] = v ;  p[1] = v ;  p[2] = (x < 32) ? 255 : v ;
+        }
+    textura_ajedrez = new Textura( "ajedrez", ajedrez );
+}
+// ---------------------------------------------------------------------------------------------
+// añade a la cola de opacos un cuadrado por cada textura del cargador (en una cuadrícula), o 
+// uno solo con una textura de ajedrez si no se ha cargado ninguna. Las texturas que todavía
+// no están listas no se dibujan (aparecen en cuanto el cargador termina de subirlas).
+
+void DibujarTexturas()
+{
+    using namespace std ;
+    using namespace glm ;
+
+    CrearCuadro(); // (solo la primera vez, si no se ha hecho en la precarga)
+
+    // lista de texturas a dibujar (en la memoria del frame, para no reservar memoria en cada frame)
+    const auto &     cargadas     = cargador_texturas->leerTexturas();
+    Textura ** const texturas     = asignador_frame.reservarTabla<Textura *>( std::max<size_t>( 1, cargadas.size() ));
+    unsigned         num_texturas = 0 ;
+    for( const unique_ptr<Textura> & t : cargadas )
+        texturas[ num_texturas++ ] = t.get() ;
+    if ( num_texturas == 0 )
+    {
+        CrearTexturaAjedrez();
+        texturas[ num_texturas++ ] = textura_ajedrez ;
+    }
+
+    // cuadrícula de 'n' por 'n' celdas que ocupa [-0.9,0.9]^2
+    const unsigned n     = unsigned( std::ceil( std::sqrt( float( num_texturas ))));
+    const float    celda = 1.8f/float(n) ;
+
     cauce->fijarUsarColorPlano( false );
-    vao_glm->habilitarAtrib( cauce->ind_atrib_colores, true );
-    vao_glm->draw( GL_TRIANGLES );
+    for( unsigned i = 0 ; i < num_texturas ; i++ )
+    {
+        if ( ! texturas[i]->lista() )
+            continue ;
+        const float x = -0.9f + celda*( float(i % n) + 0.5f ),
+                    y = +0.9f - celda*( float(i / n) + 0.5f );
+        cauce->fijarTextura( texturas[i] );
+        cauce->pushMM();
+            cauce->compMM( translate( vec3{ x, y, 0.0f } ));
+            cauce->compMM( scale( vec3{ 0.45f*celda, 0.45f*celda, 1.0f } ));
+            cola_opacos->agregar( *cauce, vao_cuadro, GL_TRIANGLES, { 0.0, 0.0, 0.0 }, false );
+        cauce->popMM();
+    }
+    cauce->fijarTextura( nullptr );
+}
 
-    assert( glGetError() == GL_NO_ERROR );
-   
-    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-    cauce->fijarColor( { 0.0, 0.0, 0.0 });
-    vao_glm->habilitarAtrib( cauce->ind_atrib_colores, false );
-    vao_glm->draw( GL_TRIANGLES );
+// ---------------------------------------------------------------------------------------------
+// crea el lote de objetos recortados en la GPU: una rejilla de 362x362 objetos (unos 131.000) 
+// en el plano Y=0, con cuatro mallas sencillas, y giros y colores pseudo-aleatorios
+
+void CrearLote()
+{
+    using namespace glm ;
+    if ( lote != nullptr )
+        return ;
+    ZONA_TRAZA( "CrearLote" );
+    lote = new LoteIndirecto();
 
-    assert( glGetError() == GL_NO_ERROR );
+    for( DescrVAO * malla : { GenerarIcoesfera( 2 ), GenerarToro( 12, 6 ), GenerarCilindro( 8, 1 ), GenerarEsferaUV( 10, 5 ) } )
+    {
+        lote->agregarMalla( *malla );
+        delete malla ;
+    }
+
+    constexpr int lado = 362 ;
+    for( int i = 0 ; i < lado ; i++ )
+        for( int j = 0 ; j < lado ; j++ )
+        {
+            const unsigned h      = unsigned( i*lado + j )*2654435761u ;
+            const float    angulo = float( h >> 8 & 0xFF )*( 6.2832f/256.0f );
+            const vec3     color  = { 0.4f + 0.6f*float( h >> 16 & 0xFF )/255.0f, 
+                                      0.4f + 0.6f*float( h >> 24 )/255.0f, 0.7f };
+            const mat4     modelo = translate( vec3{ float( i - lado/2 ), 0.0f, float( j - lado/2 ) } )
+                                  * rotate( angulo, vec3{ 0.0f, 1.0f, 0.0f } ) * scale( vec3{ 0.35f } );
+            lote->agregarObjeto( h % 4, modelo, color );
+        }
 }
+// ---------------------------------------------------------------------------------------------
+// (hilo de visualización) deja de visualizar una escena que no se puede visualizar: la desactiva
+// en las variables globales y pide al hilo de eventos que la desactive en 'entrada' (si no, el 
+// siguiente estado publicado la volvería a activar)
 
+void RechazarEscena( bool & escena, const unsigned bit )
+{
+    escena = false ;
+    escenas_rechazadas.fetch_or( bit );
+    glfwPostEmptyEvent(); // (despierta al hilo de eventos si está esperando)
+}
 // ---------------------------------------------------------------------------------------------
-// función que se encarga de visualizar el contenido en la ventana
+// visualiza el lote de objetos con la cámara orbital (si el contexto lo permite)
 
-void VisualizarFrame( )
+void DibujarLote( const int ancho, const int alto )
+{
+    using namespace std ;
+    if ( ! LoteIndirecto::soportado() )
+    {
+        cout << "El recortado en la GPU requiere OpenGL 4.3 (compute shaders y 'multi draw indirect')." << endl ;
+        RechazarEscena( escena_lote, rechazada_lote );
+        return ;
+    }
+    CrearLote();
+    cauce->fijarMatrizProyeccion( camara_mallas.matrizProyeccion( float(ancho)/float(alto) ) );
+    cauce->fijarMatrizVista( camara_mallas.matrizVista() );
+    lote->visualizar( *cauce );
+}
+// ---------------------------------------------------------------------------------------------
+// visualiza la nube de puntos con la cámara orbital (la abre al visualizarla la primera vez),
+// escalada para que ocupe el cubo [-3,3]^3
+
+void DibujarNube( const int ancho, const int alto )
+{
+    using namespace std ;
+    using namespace glm ;
+    if ( nube == nullptr && ! carpeta_nube.empty() )
+        nube = NubePuntos::abrir( carpeta_nube, (unsigned long)( presupuesto_puntos*1e6 ) );
+    if ( nube == nullptr )
+    {
+        cout << "No hay nube de puntos que visualizar (opción '--nube <carpeta>', que se construye con '--construir-nube')." << endl ;
+        carpeta_nube.clear(); // (no se vuelve a intentar abrir)
+        RechazarEscena( escena_nube, rechazada_nube );
+        return ;
+    }
+    cauce->fijarMatrizProyeccion( camara_mallas.matrizProyeccion( float(ancho)/float(alto) ) );
+    cauce->fijarMatrizVista( camara_mallas.matrizVista() );
+    cauce->fijarUsarColorPlano( false );
+    cauce->fijarIluminacion( false );
+    cauce->pushMM();
+        cauce->compMM( scale( vec3( 3.0f )) * nube->matrizNormalizacion() );
+        nube->visualizar( *cauce, alto );
+    cauce->popMM();
+}
+// ---------------------------------------------------------------------------------------------
+// crea la serie temporal (solo la primera vez): las muestras de un sensor simulado (varias
+// oscilaciones, una deriva lenta, ruido y picos aislados), generadas en varios hilos
+
+void CrearSerie()
+{
+    using namespace std ;
+    if ( serie != nullptr )
+        return ;
+    ZONA_TRAZA( "CrearSerie" );
+    const auto    inicio = chrono::steady_clock::now();
+    vector<float> muestras( std::max( 2ul, (unsigned long)( muestras_serie*1e6 )) );
+    ParaleloPara( muestras.size(), [&muestras]( const unsigned long primera, const unsigned long fin )
+    {
+        constexpr double dos_pi = 6.283185307179586 ;
+        const double     n      = double( muestras.size() );
+        for( unsigned long i = primera ; i < fin ; i++ )
+        {
+            const double   t     = double( i )/n ;
+            const unsigned h     = unsigned( i )*2654435761u ,
+                           h2    = ( h ^ ( h >> 15 ))*2246822519u ;
+            const double   ruido = double( h >> 16 )/65535.0 - 0.5 ,
+                           pico  = ( h2 >> 20 ) == 0 ? 1.5 : 0.0 ;  // (uno de cada 4096)
+            muestras[i] = float( 0.6*sin( dos_pi*3.0*t ) + 0.25*sin( dos_pi*200.0*t ) + 0.1*sin( dos_pi*double( i )/50.0 )
+                               + 0.3*t + 0.15*ruido + pico );
+        }
+    });
+    serie = new SerieTemporal( std::move( muestras ));
+
+    const double ms = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+    cout << "Serie temporal: " << serie->leerNumMuestras() << " muestras (" << fixed << setprecision(1)
+         << double( serie->leerNumMuestras()*sizeof(float) )/( 1024.0*1024.0 ) << " MiB) y pirámide de "
+         << serie->leerNumNiveles() << " niveles (" << double( serie->leerBytesPiramide() )/( 1024.0*1024.0 )
+         << " MiB), creadas en " << ms << " ms." << defaultfloat << endl ;
+}
+// ---------------------------------------------------------------------------------------------
+// visualiza el rango visible de la serie temporal como una polilínea decimada, con unos dos
+// vértices por columna de pixels (el rango visible tiene al menos unas pocas muestras)
+
+void DibujarSerie( const int ancho )
+{
+    CrearSerie();
+    const double ultima = double( serie->leerNumMuestras() - 1 ),
+                 tam    = std::max( std::min( ultima, 8.0 ), serie_ancho*ultima ),
+                 inicio = std::clamp( serie_centro*ultima - 0.5*tam, 0.0, ultima - tam );
+    cauce->fijarUsarColorPlano( false ); // (el VAO no tiene colores, se usa el color del cauce)
+    cauce->fijarIluminacion( false );
+    cauce->pushColor();
+        cauce->fijarColor( { 0.1f, 0.3f, 0.7f } );
+        serie->visualizar( *cauce, inicio, inicio + tam, ancho );
+    cauce->popColor();
+}
+
+// ---------------------------------------------------------------------------------------------
+// crea y sube a la GPU los recursos de las escenas antes del primer frame visible, y calienta el
+// driver dibujándolos con cada programa y estado (las mallas y el lote, que son grandes, solo si
+// su escena es la inicial; si no, se preparan al crearlos)
+
+void PrepararRecursos()
+{
+    if ( ! precargar )
+        return ;
+    ZONA_TRAZA( "PrepararRecursos" );
+
+#ifdef __GLIBC__
+    // fijar los umbrales de 'malloc': el driver (p.ej. 'llvmpipe') reserva y libera bloques grandes en
+    // cada dibujo, y con los umbrales dinámicos de glibc (que dependen del orden de las primeras 
+    // reservas) esos bloques pueden devolverse al SO y volver a pedirse en cada frame (fallos de página)
+    mallopt( M_MMAP_THRESHOLD, 32 << 20 );
+    mallopt( M_TRIM_THRESHOLD, 128 << 20 );
+#endif
+
+    CrearTriangulo_NoInd();
+    CrearTriangulo_Ind();
+    CrearTriangulo_glm();
+    CrearCuadro();
+    CrearTexturaAjedrez();
+    precarga.registrar( vao_no_ind, GL_TRIANGLES );
+    precarga.registrar( vao_ind,    GL_TRIANGLES );
+    precarga.registrar( vao_glm,    GL_TRIANGLES );
+    precarga.registrar( vao_cuadro, GL_TRIANGLES, textura_ajedrez );
+
+    if ( escena_mallas )
+        CrearMallas();
+    if ( escena_lote && LoteIndirecto::soportado() )
+    {
+        CrearLote();
+        lote->preparar( *cauce );
+    }
+    if ( escena_serie )
+        CrearSerie();
+    precarga.precargar( *cauce );
+}
+
+// ---------------------------------------------------------------------------------------------
+// función que dibuja la escena en el framebuffer activo (la ventana o uno offscreen), sin presentarla
+
+void DibujarEscena( const int ancho, const int alto )
 {
     using namespace std ;
     using namespace glm ;
+    ZONA_TRAZA( "DibujarEscena" );
 
     // comprobar y limpiar variable interna de error
-    assert( glGetError() == GL_NO_ERROR );
+    CError();
+
+    // liberar la memoria temporal del frame anterior
+    asignador_frame.reiniciar();
 
     // usar (acrivar) el objeto programa (no es necesario hacerlo en 
     // cada frame si solo hay uno de estos objetos, pero se incluye 
     // para hacer explícito que el objeto programa debe estar activado)
     cauce->activar();
 
-    // establece la zona visible (toda la ventana)
-    glViewport( 0, 0, ancho_actual, alto_actual );
+    // establece la zona visible (todo el framebuffer), el cauce necesita su tamaño para las aristas
+    cauce->fijarViewport( ancho, alto );
 
     // fija la matriz de transformación de posiciones de los shaders 
     // (la hace igual a la matriz identidad)
     cauce->resetMM();
 
-    // fija la matriz de proyeccion (la hace igual a la matriz identidad)
+    // fija las matrices de proyeccion y de vista (las hace iguales a la matriz identidad),
+    // se envían una vez por frame al UBO de datos por frame
     cauce->fijarMatrizProyeccion( glm::mat4(1.0) );
+    cauce->fijarMatrizVista( glm::mat4(1.0) );
 
-    // limpiar la ventana
+    // limpiar la ventana (en negro al visualizar el 'overdraw', para que se vea la mezcla aditiva)
+    if ( cola_opacos->visualizar_overdraw )
+        glClearColor( 0.0, 0.0, 0.0, 0.0 );
+    else
+        glClearColor( 1.0, 1.0, 1.0, 0.0 );
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
-    // habilitar EPO por Z-buffer (test de profundidad)
-    glDisable( GL_DEPTH_TEST );
+    // vaciar la cola de objetos opacos, se llena en las funciones 'DibujarTriangulo_...' o 'DibujarMallas'
+    cola_opacos->vaciar();
+
+    if ( escena_mallas )
+    {
+        DibujarMallas( ancho, alto );
+        cola_opacos->visualizar( *cauce );
+        CError();
+        return ;
+    }
+    if ( escena_lote )
+    {
+        DibujarLote( ancho, alto );
+        CError();
+        if ( escena_lote ) // (si se ha rechazado, se dibujan los triángulos)
+            return ;
+    }
+    if ( escena_nube )
+    {
+        DibujarNube( ancho, alto );
+        CError();
+        if ( escena_nube ) // (si se ha rechazado, se dibujan los triángulos)
+            return ;
+    }
+    if ( escena_serie )
+    {
+        DibujarSerie( ancho );
+        CError();
+        return ;
+    }
+    if ( escena_texturas )
+    {
+        DibujarTexturas();
+        cola_opacos->visualizar( *cauce );
+        CError();
+        return ;
+    }
 
     // Dibujar un triángulo, es una secuncia de vértice no indexada.
     DibujarTriangulo_NoInd();
@@ -217,18 +951,178 @@ void VisualizarFrame( )
         DibujarTriangulo_Ind();     // indexado
     cauce->popMM();
 
-    // dibujar un triángulo usando vectores de GLM
-    DibujarTriangulo_glm() ;
+    // dibujar un triángulo usando vectores de GLM (desplazado hacia el observador, para que
+    // quede delante del primer triángulo, que está a la misma profundidad)
+    cauce->pushMM();
+        cauce->compMM( translate( vec3{ 0.0f, 0.0f, -0.2f } ));
+        DibujarTriangulo_glm() ;
+    cauce->popMM();
+
+    // visualizar los objetos opacos, con test de profundidad (EPO por Z-buffer)
+    cola_opacos->visualizar( *cauce );
 
     // comprobar y limpiar variable interna de error
-    assert( glGetError() == GL_NO_ERROR );
+    CError();
+}
+
+// ---------------------------------------------------------------------------------------------
+// función que se encarga de visualizar el contenido en la ventana
+
+void VisualizarFrame( )
+{
+    using namespace std ;
+    ZONA_TRAZA( "frame" );
+    InicioFrameTraza(); // (instante de inicio del frame en la GPU)
+    const auto inicio = chrono::steady_clock::now();
+
+    // subir a la GPU parte de las texturas pendientes, sin superar el presupuesto por frame
+    cargador_texturas->procesarSubidas( presupuesto_texturas_ms );
+
+    // con resolución dinámica, visualizar en el framebuffer offscreen (a la escala actual) y ampliar
+    // la imagen a la ventana
+    if ( resolucion_dinamica != nullptr )
+    {
+        resolucion_dinamica->iniciarFrame( ancho_actual, alto_actual );
+        DibujarEscena( resolucion_dinamica->leerAncho(), resolucion_dinamica->leerAlto() );
+        resolucion_dinamica->terminarFrame();
+    }
+    else
+        DibujarEscena( ancho_actual, alto_actual );
+
+    // si se está capturando, iniciar la copia del frame (antes de presentarlo)
+    if ( captura != nullptr )
+        captura->capturar( ancho_actual, alto_actual );
 
     // esperar a que termine 'glDrawArrays' y entonces presentar el framebuffer actualizado
-    glfwSwapBuffers( ventana_glfw );
+    FinFrameTraza();
+    {
+        ZONA_TRAZA( "glfwSwapBuffers" );
+        glfwSwapBuffers( ventana_glfw );
+    }
 
+    // registrar el tiempo del frame, e informar del tiempo hasta el primer frame visible
+    const auto   fin = chrono::steady_clock::now();
+    const double ms  = chrono::duration<double,milli>( fin - inicio ).count();
+    if ( resolucion_dinamica != nullptr )
+        resolucion_dinamica->registrarTiempoCpu( ms );
+    if ( ms > peor_frame_ms )
+    {
+        peor_frame_ms = ms ;
+        peor_frame    = num_frames ;
+    }
+    if ( num_frames == 0 )
+        cout << "Primer frame visible a los " << fixed << setprecision(1) 
+             << chrono::duration<double,milli>( fin - instante_inicio ).count() << " ms del inicio del programa"
+             << " (el frame ha tardado " << ms << " ms)." << defaultfloat << endl ;
+    num_frames++ ;
 }
 
 
+// ---------------------------------------------------------------------------------------------
+// inicia o termina la captura de frames (en la carpeta 'capturas')
+
+void ActivarDesactivarCaptura()
+{
+    if ( captura == nullptr )
+        captura = new CapturaFrames( "capturas", formato_captura );
+    else
+    {
+        delete captura ; // (espera a que se escriban los frames pendientes)
+        captura = nullptr ;
+    }
+    redibujar_ventana = true ;
+}
+// ---------------------------------------------------------------------------------------------
+// devuelve el estado de la entrada que corresponde a las variables globales actuales (se usa al
+// inicio, antes de crear el hilo de visualización, como estado inicial en los dos hilos)
+
+EstadoEntrada LeerEstadoGlobales()
+{
+    EstadoEntrada e ;
+    e.ancho                    = ancho_actual ;
+    e.alto                     = alto_actual ;
+    e.terminar                 = terminar_programa ;
+    e.escena_mallas            = escena_mallas ;
+    e.escena_texturas          = escena_texturas ;
+    e.escena_lote              = escena_lote ;
+    e.escena_nube              = escena_nube ;
+    e.escena_serie             = escena_serie ;
+    e.soldar_mallas            = soldar_mallas ;
+    e.tiras_mallas             = tiras_mallas ;
+    e.iluminar_mallas          = iluminar_mallas ;
+    e.nivel_mallas             = nivel_mallas ;
+    e.camara                   = camara_mallas ;
+    e.prepasada_profundidad    = cola_opacos->prepasada_profundidad ;
+    e.ordenar                  = cola_opacos->ordenar ;
+    e.visualizar_overdraw      = cola_opacos->visualizar_overdraw ;
+    e.usar_cache_transformados = cola_opacos->usar_cache_transformados ;
+    return e ;
+}
+// ---------------------------------------------------------------------------------------------
+// (hilo de eventos) publica el estado actual de la entrada para el hilo de visualización
+
+void PublicarEntrada()
+{
+    // desactivar las escenas que ha rechazado el hilo de visualización
+    const unsigned rechazadas = escenas_rechazadas.exchange( 0 );
+    if ( rechazadas & rechazada_lote )
+        entrada.escena_lote = false ;
+    if ( rechazadas & rechazada_nube )
+        entrada.escena_nube = false ;
+
+    buffer_entrada.escritura() = entrada ;
+    buffer_entrada.publicar();
+}
+// ---------------------------------------------------------------------------------------------
+// (hilo de visualización) si el hilo de eventos ha publicado un estado de la entrada nuevo, lo
+// aplica a las variables globales y ejecuta las acciones pedidas (crear o eliminar mallas,
+// iniciar o terminar la captura, seleccionar), y pide redibujar la ventana
+
+void AplicarEntrada()
+{
+    if ( ! buffer_entrada.actualizar() )
+        return ;
+    const EstadoEntrada & e = buffer_entrada.lectura();
+
+    if ( e.nivel_mallas != nivel_mallas || e.soldar_mallas != soldar_mallas || e.tiras_mallas != tiras_mallas )
+        EliminarMallas(); // (se vuelven a crear con el nuevo nivel, soldadas o en tiras al visualizarlas)
+
+    ancho_actual      = e.ancho ;
+    alto_actual       = e.alto ;
+    terminar_programa = e.terminar ;
+    escena_mallas     = e.escena_mallas ;
+    escena_texturas   = e.escena_texturas ;
+    escena_lote       = e.escena_lote ;
+    escena_nube       = e.escena_nube ;
+    escena_serie      = e.escena_serie ;
+    serie_centro      = e.serie_centro ;
+    serie_ancho       = e.serie_ancho ;
+    soldar_mallas     = e.soldar_mallas ;
+    tiras_mallas      = e.tiras_mallas ;
+    iluminar_mallas   = e.iluminar_mallas ;
+    nivel_mallas      = e.nivel_mallas ;
+    camara_mallas     = e.camara ;
+    cola_opacos->prepasada_profundidad    = e.prepasada_profundidad ;
+    cola_opacos->ordenar                  = e.ordenar ;
+    cola_opacos->visualizar_overdraw      = e.visualizar_overdraw ;
+    cola_opacos->usar_cache_transformados = e.usar_cache_transformados ;
+
+    // los cambios de captura pedidos desde el último estado aplicado (se pueden haber perdido
+    // estados intermedios, pero no los contadores)
+    for( unsigned long i = entrada_aplicada.num_cambios_captura ; i < e.num_cambios_captura ; i++ )
+        ActivarDesactivarCaptura();
+
+    // selección pedida (si todavía no se ha visualizado ningún frame con las mallas, se crean antes)
+    if ( e.num_selecciones != entrada_aplicada.num_selecciones && escena_mallas )
+    {
+        CrearMallas();
+        SeleccionarMalla( e.seleccion_x, e.seleccion_y, e.seleccion_ancho, e.seleccion_alto );
+    }
+
+    entrada_aplicada  = e ;
+    redibujar_ventana = true ;
+}
+
 // ---------------------------------------------------------------------------------------------
 // función que se invoca cada vez que cambia el número de pixels del framebuffer
 // (cada vez que se redimensiona la ventana)
@@ -237,9 +1131,19 @@ void FGE_CambioTamano( GLFWwindow* ventana, int nuevo_ancho, int nuevo_alto )
 {
     using namespace std ;
     //cout << "FGE cambio tamaño, nuevas dimensiones: " << nuevo_ancho << " x " << nuevo_alto << "." << endl ;
-    ancho_actual      = nuevo_ancho ;
-    alto_actual       = nuevo_alto ;
-    redibujar_ventana = true ; // fuerza a redibujar la ventana
+    entrada.ancho = nuevo_ancho ;
+    entrada.alto  = nuevo_alto ;
+    PublicarEntrada(); // fuerza a redibujar la ventana
+}
+// ---------------------------------------------------------------------------------------------
+// (hilo de eventos) desplaza la vista de la serie temporal una fracción de su ancho, y multiplica
+// su ancho por un factor, sin salir de la serie
+
+void MoverVistaSerie( const double desplazamiento, const double factor )
+{
+    entrada.serie_ancho  = std::clamp( entrada.serie_ancho*factor, 1e-8, 1.0 );
+    entrada.serie_centro = std::clamp( entrada.serie_centro + desplazamiento*entrada.serie_ancho,
+                                       0.5*entrada.serie_ancho, 1.0 - 0.5*entrada.serie_ancho );
 }
 // ---------------------------------------------------------------------------------------------
 // función que se invocará cada vez que se pulse o levante una tecla.
@@ -250,15 +1154,166 @@ void FGE_PulsarLevantarTecla( GLFWwindow* ventana, int key, int scancode, int ac
     //cout << "FGE pulsar levantar tecla, número de tecla == " << key << "." << endl ;
     // si se pulsa la tecla 'ESC', acabar el programa
     if ( key == GLFW_KEY_ESCAPE )
-        terminar_programa = true ;
+    {
+        entrada.terminar = true ;
+        PublicarEntrada();
+    }
+
+    if ( action != GLFW_PRESS )
+        return ;
+
+    // teclas para las opciones de la cola de objetos opacos
+    switch( key )
+    {
+        case GLFW_KEY_P :
+            entrada.prepasada_profundidad = ! entrada.prepasada_profundidad ;
+            cout << "Pasada previa de profundidad: " << (entrada.prepasada_profundidad ? "sí" : "no") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_O :
+            entrada.ordenar = ! entrada.ordenar ;
+            cout << "Ordenar de delante hacia atrás: " << (entrada.ordenar ? "sí" : "no") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_V :
+            entrada.visualizar_overdraw = ! entrada.visualizar_overdraw ;
+            cout << "Visualizar overdraw: " << (entrada.visualizar_overdraw ? "sí" : "no") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_X :
+            entrada.usar_cache_transformados = ! entrada.usar_cache_transformados ;
+            cout << "Cache de vértices transformados: " << (entrada.usar_cache_transformados ? "sí" : "no") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_C :
+            entrada.num_cambios_captura++ ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_M :
+            entrada.escena_mallas   = ! entrada.escena_mallas ;
+            entrada.escena_texturas = false ;
+            entrada.escena_lote     = false ;
+            entrada.escena_nube     = false ;
+            entrada.escena_serie    = false ;
+            cout << "Escena: " << (entrada.escena_mallas ? "mallas procedurales" : "triángulos") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_T :
+            entrada.escena_texturas = ! entrada.escena_texturas ;
+            entrada.escena_mallas   = false ;
+            entrada.escena_lote     = false ;
+            entrada.escena_nube     = false ;
+            entrada.escena_serie    = false ;
+            cout << "Escena: " << (entrada.escena_texturas ? "texturas" : "triángulos") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_I :
+            entrada.escena_lote     = ! entrada.escena_lote ;
+            entrada.escena_mallas   = false ;
+            entrada.escena_texturas = false ;
+            entrada.escena_nube     = false ;
+            entrada.escena_serie    = false ;
+            cout << "Escena: " << (entrada.escena_lote ? "lote de objetos recortado en la GPU" : "triángulos") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_N :
+            entrada.escena_nube     = ! entrada.escena_nube ;
+            entrada.escena_mallas   = false ;
+            entrada.escena_texturas = false ;
+            entrada.escena_lote     = false ;
+            entrada.escena_serie    = false ;
+            cout << "Escena: " << (entrada.escena_nube ? "nube de puntos" : "triángulos") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_S :
+            entrada.escena_serie    = ! entrada.escena_serie ;
+            entrada.escena_mallas   = false ;
+            entrada.escena_texturas = false ;
+            entrada.escena_lote     = false ;
+            entrada.escena_nube     = false ;
+            cout << "Escena: " << (entrada.escena_serie ? "serie temporal" : "triángulos") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_W :
+            entrada.soldar_mallas = ! entrada.soldar_mallas ;
+            cout << "Soldar vértices de las mallas: " << (entrada.soldar_mallas ? "sí" : "no") << endl ;
+            PublicarEntrada(); // (el hilo de visualización elimina las mallas, y se vuelven a crear)
+            break ;
+        case GLFW_KEY_R :
+            entrada.tiras_mallas = ! entrada.tiras_mallas ;
+            cout << "Mallas como tiras de triángulos: " << (entrada.tiras_mallas ? "sí" : "no") << endl ;
+            PublicarEntrada(); // (igual que al soldar)
+            break ;
+        case GLFW_KEY_L :
+            entrada.iluminar_mallas = ! entrada.iluminar_mallas ;
+            cout << "Iluminar las mallas: " << (entrada.iluminar_mallas ? "sí" : "no") << endl ;
+            PublicarEntrada();
+            break ;
+        case GLFW_KEY_EQUAL :
+        case GLFW_KEY_KP_ADD :
+        case GLFW_KEY_MINUS :
+        case GLFW_KEY_KP_SUBTRACT :
+        {
+            const bool     mas         = ( key == GLFW_KEY_EQUAL || key == GLFW_KEY_KP_ADD );
+            const unsigned nivel       = entrada.nivel_mallas ,
+                           nuevo_nivel = mas ? std::min( 7u, nivel+1 ) : ( nivel > 0 ? nivel-1 : 0 );
+            if ( entrada.escena_mallas && nuevo_nivel != nivel )
+            {
+                entrada.nivel_mallas = nuevo_nivel ;
+                PublicarEntrada();
+            }
+            break ;
+        }
+        default :
+            break ;
+    }
+
+    // teclas de la vista de la serie temporal (desplazar y ampliar o reducir el rango visible)
+    if ( entrada.escena_serie )
+    {
+        switch( key )
+        {
+            case GLFW_KEY_LEFT      : MoverVistaSerie( -0.1, 1.0 ); break ;
+            case GLFW_KEY_RIGHT     : MoverVistaSerie( +0.1, 1.0 ); break ;
+            case GLFW_KEY_PAGE_UP   : MoverVistaSerie( 0.0, 0.8 ); break ;
+            case GLFW_KEY_PAGE_DOWN : MoverVistaSerie( 0.0, 1.0/0.8 ); break ;
+            default :
+                return ;
+        }
+        PublicarEntrada();
+        return ;
+    }
+
+    // teclas de la cámara orbital (solo en las escenas de mallas, del lote y de la nube)
+    if ( ! entrada.escena_mallas && ! entrada.escena_lote && ! entrada.escena_nube )
+        return ;
+    switch( key )
+    {
+        case GLFW_KEY_LEFT      : entrada.camara.rotar( -5.0f,  0.0f ); break ;
+        case GLFW_KEY_RIGHT     : entrada.camara.rotar( +5.0f,  0.0f ); break ;
+        case GLFW_KEY_UP        : entrada.camara.rotar(  0.0f, +5.0f ); break ;
+        case GLFW_KEY_DOWN      : entrada.camara.rotar(  0.0f, -5.0f ); break ;
+        case GLFW_KEY_PAGE_UP   : entrada.camara.acercar( 0.9f ); break ;
+        case GLFW_KEY_PAGE_DOWN : entrada.camara.acercar( 1.0f/0.9f ); break ;
+        default :
+            return ;
+    }
+    PublicarEntrada();
 }
 // ---------------------------------------------------------------------------------------------
 // función que se invocará cada vez que se pulse o levante un botón del ratón
 
 void FGE_PulsarLevantarBotonRaton( GLFWwindow* ventana, int button, int action, int mods )
 {
-    // nada, por ahora
-
+    // en la escena de mallas, al pulsar el botón izquierdo se selecciona la malla bajo el puntero
+    // (la selección la hace el hilo de visualización, que tiene las mallas)
+    if ( entrada.escena_mallas && button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS )
+    {
+        glfwGetCursorPos( ventana, &entrada.seleccion_x, &entrada.seleccion_y );
+        glfwGetWindowSize( ventana, &entrada.seleccion_ancho, &entrada.seleccion_alto );
+        entrada.num_selecciones++ ;
+        PublicarEntrada();
+    }
 }
 // ---------------------------------------------------------------------------------------------
 // función que se invocará cada vez que cambie la posición del puntero
@@ -272,7 +1327,18 @@ void FGE_MovimientoRaton( GLFWwindow* ventana, double xpos, double ypos )
 
 void FGE_Scroll( GLFWwindow* ventana, double xoffset, double yoffset )
 {
-    // nada, por ahora
+    // en las escenas de mallas, del lote y de la nube, acercar o alejar la cámara, y en la de la
+    // serie temporal, ampliar o reducir el rango visible
+    if ( ( entrada.escena_mallas || entrada.escena_lote || entrada.escena_nube ) && yoffset != 0.0 )
+    {
+        entrada.camara.acercar( yoffset > 0.0 ? 0.9f : 1.0f/0.9f );
+        PublicarEntrada();
+    }
+    else if ( entrada.escena_serie && yoffset != 0.0 )
+    {
+        MoverVistaSerie( 0.0, yoffset > 0.0 ? 0.8 : 1.0/0.8 );
+        PublicarEntrada();
+    }
 }
 // ---------------------------------------------------------------------------------------------
 // función que se invocará cuando se produzca un error de GLFW
@@ -291,6 +1357,7 @@ void ErrorGLFW ( int error, const char * description )
 
 void InicializaGLFW( int argc, char * argv[] )
 {
+    ZONA_TRAZA( "InicializaGLFW" );
     using namespace std ;
 
     // intentar inicializar, terminar si no se puede
@@ -307,10 +1374,17 @@ void InicializaGLFW( int argc, char * argv[] )
    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 3 ); 
    glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE ); // indica que tambien debe funcionar si se usa con un driver con version superior a la 3.3
    glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE ); // indica que no es compatible hacia atrás con versiones previas a la 3.3
+#if NIVEL_COMPROBACION_GL == 1
+   glfwWindowHint( GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE ); // contexto con salida de depuración (mensajes de error del driver)
+#endif
 
     // especificar que función se llamará ante un error de GLFW
     glfwSetErrorCallback( ErrorGLFW );
 
+    // en la prueba de regresión se visualiza offscreen, la ventana no se muestra
+   if ( ! opciones_regresion.carpeta.empty() )
+      glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+
     // crear la ventana (var. global ventana_glfw), activar el rendering context
     ventana_glfw = glfwCreateWindow( 512, 512, "IG ejemplo mínimo (OpenGL 3+)", nullptr, nullptr );
     glfwMakeContextCurrent( ventana_glfw ); // necesario para OpenGL
@@ -332,6 +1406,7 @@ void InicializaGLFW( int argc, char * argv[] )
 
 void InicializaGLEW()
 {
+    ZONA_TRAZA( "InicializaGLEW" );
 #ifndef __APPLE__
     using namespace std ;
     GLenum codigoError = glewInit();
@@ -351,9 +1426,10 @@ void InicializaGLEW()
 
 void InicializaOpenGL()
 {
+    ZONA_TRAZA( "InicializaOpenGL" );
     using namespace std ;
     
-    assert( glGetError() == GL_NO_ERROR );
+    CError();
 
     cout  << "Datos de versión e implementación de OpenGL" << endl
          << "    Implementación de : " << glGetString(GL_VENDOR)  << endl
@@ -363,42 +1439,395 @@ void InicializaOpenGL()
 
     
     InicializaGLEW(); // En linux y windows, fija punteros a funciones de OpenGL version 2.0 o superiores
-    
-    
-    assert( glGetError() == GL_NO_ERROR );
+    InicializarComprobacionGL(); // según NIVEL_COMPROBACION_GL, activa la salida de depuración de OpenGL
+    InicializarCreacionVAOs( permitir_dsa ); // usar DSA para crear VBOs y VAOs, si está disponible
+    if ( memoria_gpu_mib > 0.0 )
+    {
+        gestor_residencia = new GestorResidencia( std::max( GLsizeiptr(1), GLsizeiptr( memoria_gpu_mib*1024.0*1024.0 )) );
+        FijarGestorResidencia( gestor_residencia );
+    }
+
+    CError();
     
     glClearColor( 1.0, 1.0, 1.0, 0.0 ); // color para 'glClear' (blanco, 100% opaco)
     glDisable( GL_CULL_FACE );          // dibujar todos los triángulos independientemente de su orientación
     cauce = new Cauce() ;            // crear el objeto programa (variable global 'cauce')
-    
+    cola_opacos = new ColaOpacos() ; // crear la cola de objetos opacos (variable global 'cola_opacos')
+    cargador_texturas = new CargadorTexturas() ; // crear el cargador de texturas y pedir las de la carpeta
+    CargarTexturas();
+    if ( objetivo_frame_ms > 0.0 )
+        resolucion_dinamica = new ResolucionDinamica( objetivo_frame_ms, escala_resolucion_min, escala_resolucion_max );
+
+    if ( capturar_al_inicio )
+        ActivarDesactivarCaptura();
+
     assert( cauce != nullptr );
-    assert( glGetError() == GL_NO_ERROR );
+    CError();
 }
 // ---------------------------------------------------------------------------------------------
+// termina la captura (si hay alguna en curso) y libera el lote, la nube de puntos, la serie
+// temporal, la resolución dinámica (tras informar de su escala) y el cargador de texturas,
+// mientras el contexto sigue activo
 
-void BucleEventosGLFW()
+void LiberarRecursos()
+{
+    using namespace std ;
+    if ( captura != nullptr )
+        ActivarDesactivarCaptura();
+    delete lote ;
+    lote = nullptr ;
+    if ( nube != nullptr )
+        cout << "Nube de puntos: " << nube->numNodosCargados() << " nodos leídos de " << nube->numNodos() << " (" 
+             << fixed << setprecision(1) << double( nube->bytesLeidos() )/( 1024.0*1024.0 ) << " MiB), " 
+             << nube->numExpulsiones() << " expulsiones, " << nube->numPuntosDibujados() << " puntos en " 
+             << nube->numNodosDibujados() << " nodos en el último frame." << defaultfloat << endl ;
+    delete nube ;
+    nube = nullptr ;
+    if ( serie != nullptr )
+        cout << "Serie temporal: " << serie->leerNumVertices() << " vértices en el último frame, " 
+             << serie->leerNumDecimaciones() << " decimaciones." << endl ;
+    delete serie ;
+    serie = nullptr ;
+    if ( resolucion_dinamica != nullptr )
+        cout << "Resolución dinámica: escala final " << fixed << setprecision(2) << resolucion_dinamica->leerEscala() 
+             << ", tiempo estimado de la GPU a escala 1: " << setprecision(1) << resolucion_dinamica->leerCosteMs() 
+             << " ms por frame (objetivo " << objetivo_frame_ms << " ms)." << defaultfloat << endl ;
+    delete resolucion_dinamica ;
+    resolucion_dinamica = nullptr ;
+    if ( gestor_residencia != nullptr )
+        cout << "Residencia de VAOs: " << gestor_residencia->numAciertos() << " aciertos, " 
+             << gestor_residencia->numFallos() << " fallos (" << fixed << setprecision(1) 
+             << double( gestor_residencia->bytesSubidos() )/( 1024.0*1024.0 ) << " MiB subidos), " 
+             << gestor_residencia->numExpulsiones() << " expulsiones, máximo residente " 
+             << double( gestor_residencia->leerMaximoResidentes() )/( 1024.0*1024.0 ) << " MiB (presupuesto " 
+             << double( gestor_residencia->leerPresupuesto() )/( 1024.0*1024.0 ) << " MiB)." << defaultfloat << endl ;
+    FijarGestorResidencia( nullptr );
+    delete gestor_residencia ;
+    gestor_residencia = nullptr ;
+    delete textura_ajedrez ;
+    delete cargador_texturas ;
+    textura_ajedrez   = nullptr ;
+    cargador_texturas = nullptr ;
+}
+// ---------------------------------------------------------------------------------------------
+// devuelve el número de recursos que se están leyendo y todavía no se pueden visualizar
+// (texturas y nodos de la nube de puntos)
+
+unsigned NumPendientes()
+{
+    return cargador_texturas->numPendientes() + ( nube != nullptr ? nube->numPendientes() : 0u );
+}
+// ---------------------------------------------------------------------------------------------
+// bucle del hilo de visualización, que tiene el contexto OpenGL: aplica los estados de la entrada
+// que publica el hilo de eventos y visualiza un frame cuando cambian, hasta que hay que terminar
+// (entonces libera los recursos y deja el contexto libre para el hilo principal)
+
+void BucleVisualizacion()
 {
-    while ( ! terminar_programa )
-    {   
+    using namespace std ;
+    glfwMakeContextCurrent( ventana_glfw );
+    if ( ! archivo_traza.empty() )
+        NombrarHiloTraza( "visualización" );
+
+    while ( true )
+    {
+        AplicarEntrada();
+        if ( terminar_programa )
+            break ;
         if ( redibujar_ventana )
-        {   
+        {
             VisualizarFrame();
             redibujar_ventana = false; // (evita que se redibuje continuamente)
         }
+        // mientras se captura o hay texturas o nodos de la nube por subir se visualizan frames
+        // continuamente, sin esperar a que cambie la entrada
+        if ( captura != nullptr || NumPendientes() > 0 )
+            redibujar_ventana = true ;
+        else
+            buffer_entrada.esperar();
+    }
+    cout << "Frames visualizados: " << num_frames << ", el peor ha tardado " << fixed << setprecision(1) 
+         << peor_frame_ms << " ms (frame " << peor_frame << ")." << defaultfloat << endl ;
+    LiberarRecursos();
+    glfwMakeContextCurrent( nullptr );
+}
+// ---------------------------------------------------------------------------------------------
+// bucle del hilo de eventos (el hilo principal, como exige GLFW): crea el hilo de visualización,
+// y espera eventos y llama a las FGE (que publican el estado de la entrada) hasta que hay que 
+// terminar. Así un frame lento no retrasa los eventos, ni muchos eventos seguidos (p.ej. al 
+// redimensionar la ventana) retrasan los frames. Al volver, el contexto está activo en este hilo.
+
+void BucleEventosGLFW()
+{
+    glfwMakeContextCurrent( nullptr ); // (el contexto solo puede estar activo en un hilo)
+    std::thread hilo_visualizacion( BucleVisualizacion );
+
+    while ( ! entrada.terminar )
+    {
         glfwWaitEvents(); // esperar evento y llamar FGE (si hay alguna)
+        if ( escenas_rechazadas != 0 )
+            PublicarEntrada(); // (desactiva en la entrada las escenas rechazadas)
+        if ( ! entrada.terminar && glfwWindowShouldClose( ventana_glfw ) )
+        {
+            entrada.terminar = true ;
+            PublicarEntrada();
+        }
+    }
+    hilo_visualizacion.join();
+    glfwMakeContextCurrent( ventana_glfw );
+}
+// ---------------------------------------------------------------------------------------------
+// visualiza 'frames_benchmark' frames seguidos (tras unos de calentamiento, y tras subir todas
+// las texturas) e informa del tiempo por frame y de las reservas de memoria dinámica en los 
+// frames medidos, devuelve false si en algún frame medido se ha reservado memoria
+
+bool EjecutarBenchmark()
+{
+    using namespace std ;
+    using namespace std::chrono ;
+
+    unsigned                frames_calentamiento = 0 , 
+                            frames_estables      = 0 , // frames de calentamiento seguidos sin texturas ni nodos pendientes
+                            medidos              = 0 ;
+    ContadoresAsignaciones  total ;
+    unsigned                frames_con_asignaciones = 0 ;
+    double                  ms_total = 0.0, ms_maximo = 0.0 ;
+
+    while( medidos < frames_benchmark && ! terminar_programa )
+    {
+        const ContadoresAsignaciones antes  = LeerContadoresAsignaciones();
+        const auto                   inicio = steady_clock::now();
+
+        VisualizarFrame();
+        glFinish();
+        glfwPollEvents();
+        if ( escenas_rechazadas != 0 )
+            PublicarEntrada();
+        AplicarEntrada(); // (en el benchmark no hay hilo de visualización, se aplica aquí)
+
+        const double                 ms      = duration<double,milli>( steady_clock::now() - inicio ).count();
+        const ContadoresAsignaciones reservas = LeerContadoresAsignaciones() - antes ;
+
+        // calentamiento: hasta tener varios frames seguidos sin texturas ni nodos pendientes (en los primeros
+        // frames se crean VAOs, cachés, etc. y crecen las tablas que se reutilizan)
+        if ( frames_estables < frames_calentamiento_benchmark )
+        {
+            frames_calentamiento++ ;
+            frames_estables = ( NumPendientes() > 0 ) ? 0 : frames_estables+1 ;
+            continue ;
+        }
+        medidos++ ;
+        ms_total  += ms ;
+        ms_maximo  = std::max( ms_maximo, ms );
+        total.num_asignaciones += reservas.num_asignaciones ;
+        total.bytes            += reservas.bytes ;
+        if ( reservas.num_asignaciones > 0 )
+            frames_con_asignaciones++ ;
         terminar_programa = terminar_programa || glfwWindowShouldClose( ventana_glfw );
     }
+
+    cout << "Benchmark: " << medidos << " frames medidos (tras " << frames_calentamiento 
+         << " de calentamiento), " << fixed << setprecision(3) << ms_total/std::max( 1u, medidos ) 
+         << " ms por frame de media, " << ms_maximo << " ms como máximo." << defaultfloat << endl 
+         << "Benchmark: reservas de memoria dinámica en los frames medidos: " << total.num_asignaciones 
+         << " (" << total.bytes << " bytes, en " << frames_con_asignaciones << " frames). Memoria de frame: " 
+         << asignador_frame.leerPico() << " bytes como máximo, de " << asignador_frame.leerCapacidad() << "." << endl ;
+    if ( total.num_asignaciones > 0 )
+        cout << "Benchmark: error, se ha reservado memoria dinámica tras el calentamiento." << endl ;
+
+    LiberarRecursos();
+    return total.num_asignaciones == 0 ;
+}
+// ---------------------------------------------------------------------------------------------
+// ejecuta la prueba de regresión con las escenas registradas (cada una es la escena del 
+// programa con unas opciones de la cola de opacos), devuelve el número de fallos
+
+unsigned PruebaRegresion()
+{
+    const auto opciones_cola = []( const bool prepasada, const bool ordenar, const bool mallas = false,
+                                   const bool tiras = false )
+    {
+        return [=]()
+        {
+            if ( tiras != tiras_mallas )
+                EliminarMallas();
+            tiras_mallas                       = tiras ;
+            escena_mallas                      = mallas ;
+            nivel_mallas                       = 4 ;
+            camara_mallas                      = CamaraOrbital( 9.0f ) ;
+            cola_opacos->prepasada_profundidad = prepasada ;
+            cola_opacos->ordenar               = ordenar ;
+            cola_opacos->visualizar_overdraw   = false ;
+        };
+    };
+    const std::vector<EscenaRegresion> escenas =
+    {
+        { "basica",      opciones_cola( false, true  ) },
+        { "prepasada",   opciones_cola( true,  true  ) },
+        { "sin-ordenar", opciones_cola( false, false ) },
+        { "mallas",      opciones_cola( false, true, true ) },
+        { "tiras",       opciones_cola( false, true, true, true ) },
+    };
+    return EjecutarRegresion( opciones_regresion, escenas, DibujarEscena );
+}
+// ---------------------------------------------------------------------------------------------
+// procesa los argumentos de la línea de órdenes:
+//    --capturar    : capturar frames desde el inicio (hasta pulsar 'C' o terminar)
+//    --captura-raw : escribir las capturas en un flujo de frames RGB sin cabecera, en lugar de PPM
+//    --regresion <carpeta>     : ejecutar la prueba de regresión (sin ventana) y terminar, 
+//                                con código de salida distinto de 0 si alguna escena falla (o no tiene referencias)
+//    --actualizar-referencias  : en la prueba de regresión, escribir las imágenes y tiempos de referencia
+//    --sin-dsa     : crear los VBOs y VAOs enlazándolos para editarlos, aunque haya DSA
+//    --texturas <carpeta>      : cargar (de forma asíncrona) los archivos PPM de la carpeta (tecla 'T' para verlas)
+//    --escena <nombre>         : escena inicial ('triangulos', 'mallas', 'texturas', 'lote', 'nube' o 'serie')
+//    --benchmark <frames>      : visualizar y medir los frames indicados (sin esperar eventos) y terminar, con
+//                                código de salida distinto de 0 si algún frame medido reserva memoria dinámica
+//    --sin-precarga            : no preparar los recursos antes del primer frame (se crean al dibujarlos)
+//    --traza <archivo>         : grabar una traza de tiempos (CPU y GPU) desde el inicio y escribirla al terminar,
+//                                en formato JSON de 'Chrome tracing' (se puede abrir con Perfetto)
+//    --resolucion-dinamica <ms>     : visualizar a menor resolución y ampliar a la ventana, ajustando la escala
+//                                     para que el tiempo de la GPU por frame se acerque al indicado
+//    --escala-resolucion <min> <max> : límites de la escala de la resolución dinámica (por defecto 0.5 y 1)
+//    --cache-mallas <carpeta>  : leer las mallas procedurales comprimidas de la carpeta, o guardarlas en ella
+//                                al crearlas (un archivo '.mcm' por malla, nivel y soldadura)
+//    --memoria-gpu <MiB>       : presupuesto de memoria de la GPU para los VAOs, expulsando los usados hace más
+//                                tiempo (se vuelven a crear al dibujarlos, con los datos de la memoria de la aplicación)
+//    --nube <carpeta>          : visualizar el octree de puntos de la carpeta (tecla 'N'), leyendo del disco
+//                                solo los nodos que se ven
+//    --presupuesto-puntos <millones>      : máximo de puntos de la nube dibujados por frame (por defecto 3)
+//    --generar-nube <archivo> <puntos>    : escribir una nube de puntos sintética (registros 'PuntoNube') y terminar
+//    --construir-nube <archivo> <carpeta> : construir el octree de una nube de puntos en la carpeta y terminar
+//    --muestras-serie <millones>          : número de muestras de la serie temporal (tecla 'S', por defecto 16)
+
+void ProcesarArgumentos( int argc, char * argv[] )
+{
+    using namespace std ;
+    for( int i = 1 ; i < argc ; i++ )
+    {
+        const string arg = argv[i] ;
+        if ( arg == "--capturar" )
+            capturar_al_inicio = true ;
+        else if ( arg == "--captura-raw" )
+            formato_captura = FormatoCaptura::raw ;
+        else if ( arg == "--regresion" && i+1 < argc )
+            opciones_regresion.carpeta = argv[++i] ;
+        else if ( arg == "--actualizar-referencias" )
+            opciones_regresion.actualizar = true ;
+        else if ( arg == "--sin-dsa" )
+            permitir_dsa = false ;
+        else if ( arg == "--texturas" && i+1 < argc )
+            carpeta_texturas = argv[++i] ;
+        else if ( arg == "--escena" && i+1 < argc )
+        {
+            const string escena = argv[++i] ;
+            escena_mallas   = ( escena == "mallas" );
+            escena_texturas = ( escena == "texturas" );
+            escena_lote     = ( escena == "lote" );
+            escena_nube     = ( escena == "nube" );
+            escena_serie    = ( escena == "serie" );
+            if ( ! escena_mallas && ! escena_texturas && ! escena_lote && ! escena_nube && ! escena_serie 
+                 && escena != "triangulos" )
+                cout << "Escena '" << escena << "' no reconocida (se usa 'triangulos')." << endl ;
+        }
+        else if ( arg == "--benchmark" && i+1 < argc )
+            frames_benchmark = std::max( 1, atoi( argv[++i] ));
+        else if ( arg == "--sin-precarga" )
+            precargar = false ;
+        else if ( arg == "--traza" && i+1 < argc )
+            archivo_traza = argv[++i] ;
+        else if ( arg == "--resolucion-dinamica" && i+1 < argc )
+            objetivo_frame_ms = std::max( 0.0, atof( argv[++i] ));
+        else if ( arg == "--escala-resolucion" && i+2 < argc )
+        {
+            escala_resolucion_min = std::clamp( float( atof( argv[i+1] )), 0.1f, 1.0f );
+            escala_resolucion_max = std::clamp( float( atof( argv[i+2] )), escala_resolucion_min, 1.0f );
+            i += 2 ;
+        }
+        else if ( arg == "--cache-mallas" && i+1 < argc )
+            carpeta_mallas = argv[++i] ;
+        else if ( arg == "--memoria-gpu" && i+1 < argc )
+            memoria_gpu_mib = std::max( 0.0, atof( argv[++i] ));
+        else if ( arg == "--nube" && i+1 < argc )
+            carpeta_nube = argv[++i] ;
+        else if ( arg == "--presupuesto-puntos" && i+1 < argc )
+            presupuesto_puntos = std::max( 0.01, atof( argv[++i] ));
+        else if ( arg == "--generar-nube" && i+2 < argc )
+        {
+            archivo_generar_nube = argv[i+1] ;
+            puntos_generar_nube  = std::max( 1l, atol( argv[i+2] ));
+            i += 2 ;
+        }
+        else if ( arg == "--muestras-serie" && i+1 < argc )
+            muestras_serie = std::max( 1e-6, atof( argv[++i] ));
+        else if ( arg == "--construir-nube" && i+2 < argc )
+        {
+            archivo_construir_nube = argv[i+1] ;
+            carpeta_construir_nube = argv[i+2] ;
+            i += 2 ;
+        }
+        else
+            cout << "Argumento '" << arg << "' no reconocido (se ignora)." << endl ;
+    }
+}
+// ---------------------------------------------------------------------------------------------
+// escribe la traza, si se ha pedido (antes de terminar GLFW, necesita el contexto)
+
+void EscribirTrazaPedida()
+{
+    if ( ! archivo_traza.empty() )
+        EscribirTraza( archivo_traza );
 }
 // ---------------------------------------------------------------------------------------------
 
 int main( int argc, char *argv[] )
 {
     using namespace std ;
+    instante_inicio = chrono::steady_clock::now();
     cout << "Programa mínimo de OpenGL 3.3 o superior" << endl ;
 
+    ProcesarArgumentos( argc, argv ); // Lee las opciones de la línea de órdenes
+
+    // herramientas de las nubes de puntos (no necesitan ventana ni OpenGL)
+    if ( ! archivo_generar_nube.empty() || ! archivo_construir_nube.empty() )
+    {
+        bool correcto = true ;
+        if ( ! archivo_generar_nube.empty() )
+            correcto = GenerarNubeSintetica( archivo_generar_nube, puntos_generar_nube );
+        if ( correcto && ! archivo_construir_nube.empty() )
+            correcto = ConstruirOctreePuntos( archivo_construir_nube, carpeta_construir_nube );
+        return correcto ? 0 : 1 ;
+    }
+
+    if ( ! archivo_traza.empty() )    // empezar a grabar la traza (incluye la inicialización)
+    {
+        IniciarTraza();
+        NombrarHiloTraza( "principal" );
+    }
     InicializaGLFW( argc, argv ); // Crea una ventana, fija funciones gestoras de eventos
     InicializaOpenGL() ;          // Compila vertex y fragment shaders. Enlaza y activa programa. Inicializa GLEW.
-    BucleEventosGLFW() ;          // Esperar eventos y procesarlos hasta que 'terminar_programa == true'
+    PrepararRecursos() ;          // Crea los VAOs de las escenas y calienta el driver (opción '--sin-precarga')
+    entrada = entrada_aplicada = LeerEstadoGlobales(); // estado inicial de la entrada en los dos hilos
+
+    // en modo de prueba de regresión, no se procesan eventos
+    if ( ! opciones_regresion.carpeta.empty() )
+    {
+        const unsigned num_fallos = PruebaRegresion();
+        EscribirTrazaPedida();
+        glfwTerminate();
+        return num_fallos == 0 ? 0 : 1 ;
+    }
+
+    // en modo benchmark, se visualizan frames seguidos sin esperar eventos
+    if ( frames_benchmark > 0 )
+    {
+        const bool sin_asignaciones = EjecutarBenchmark();
+        EscribirTrazaPedida();
+        glfwTerminate();
+        return sin_asignaciones ? 0 : 1 ;
+    }
+
+    BucleEventosGLFW() ;          // Esperar eventos y procesarlos (y visualizar en otro hilo) hasta terminar
+    EscribirTrazaPedida();        // Escribir la traza (opción '--traza')
     glfwTerminate();              // Terminar GLFW (cierra la ventana)
 
     cout << "Programa terminado normalmente." << endl ;
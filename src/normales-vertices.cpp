@@ -0,0 +1,212 @@
+// Cálculo de las normales de los vértices de una malla indexada (en paralelo)
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "normales-vertices.h"
+#include "cauce.h"
+#include "paralelo.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+constexpr unsigned long tam_bloque_caras     = 256 ;     // triángulos por bloque al calcular sus normales
+constexpr unsigned long min_vertices_por_hilo = 1 << 14 ; // mínimo número de vértices por dueño
+
+// ------------------------------------------------------------------------------------------------------
+// Normales de los triángulos [t0,t1) (sin normalizar, su longitud es el doble del área), en tablas
+// separadas por componentes. Las coordenadas de cada bloque se copian antes en tablas separadas,
+// así el bucle de los productos vectoriales no tiene accesos indirectos y se puede vectorizar.
+
+template< class T >
+static void NormalesCaras( const T * indices, const float * posiciones, const unsigned long t0,
+                           const unsigned long t1, float * nx, float * ny, float * nz )
+{
+   float b[3][tam_bloque_caras], c[3][tam_bloque_caras] ;
+
+   for( unsigned long t_bloque = t0 ; t_bloque < t1 ; t_bloque += tam_bloque_caras )
+   {
+      const unsigned long n = std::min( tam_bloque_caras, t1 - t_bloque );
+      for( unsigned long i = 0 ; i < n ; i++ )
+      {
+         const T * tri = indices + 3*( t_bloque + i );
+         const float * p0 = posiciones + 3ul*tri[0] ,
+                     * p1 = posiciones + 3ul*tri[1] ,
+                     * p2 = posiciones + 3ul*tri[2] ;
+         for( unsigned e = 0 ; e < 3 ; e++ )
+         {
+            b[e][i] = p1[e] - p0[e] ; // aristas desde el primer vértice
+            c[e][i] = p2[e] - p0[e] ;
+         }
+      }
+      float * const bx = nx + t_bloque , * const by = ny + t_bloque , * const bz = nz + t_bloque ;
+      for( unsigned long i = 0 ; i < n ; i++ )
+      {
+         bx[i] = b[1][i]*c[2][i] - b[2][i]*c[1][i] ;
+         by[i] = b[2][i]*c[0][i] - b[0][i]*c[2][i] ;
+         bz[i] = b[0][i]*c[1][i] - b[1][i]*c[0][i] ;
+      }
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+// normaliza las normales de los vértices [v0,v1) (las nulas pasan a ser (0,0,1))
+
+static void NormalizarNormales( float * normales, const unsigned long v0, const unsigned long v1 )
+{
+   for( unsigned long v = v0 ; v < v1 ; v++ )
+   {
+      float * n = normales + 3*v ;
+      const float l2 = n[0]*n[0] + n[1]*n[1] + n[2]*n[2] ;
+      if ( l2 > 0.0f )
+      {
+         const float f = 1.0f/std::sqrt( l2 );
+         n[0] *= f ;  n[1] *= f ;  n[2] *= f ;
+      }
+      else
+      {
+         n[0] = 0.0f ;  n[1] = 0.0f ;  n[2] = 1.0f ;
+      }
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+// calcula las normales de los vértices en 'normales' (3 floats por vértice), con índices de tipo 'T'
+
+template< class T >
+static void CalcularNormalesIndices( const T * indices, const unsigned long num_tris, const float * posiciones,
+                                     const unsigned long num_verts, float * normales, const unsigned num_duenos )
+{
+   // normales de los triángulos
+   std::vector<float> nx( num_tris ), ny( num_tris ), nz( num_tris );
+   ParaleloPara( num_tris, [&]( const unsigned long t0, const unsigned long t1 )
+   {
+      NormalesCaras( indices, posiciones, t0, t1, nx.data(), ny.data(), nz.data() );
+   }, 4*tam_bloque_caras );
+
+   // con un solo dueño, acumular directamente
+   if ( num_duenos == 1 )
+   {
+      std::fill( normales, normales + 3*num_verts, 0.0f );
+      for( unsigned long t = 0 ; t < num_tris ; t++ )
+         for( unsigned k = 0 ; k < 3 ; k++ )
+         {
+            float * n = normales + 3ul*indices[3*t+k] ;
+            n[0] += nx[t] ;  n[1] += ny[t] ;  n[2] += nz[t] ;
+         }
+      NormalizarNormales( normales, 0, num_verts );
+      return ;
+   }
+
+   // repartir las esquinas de los triángulos (3*t+k) entre los dueños de sus vértices: cada
+   // bloque de triángulos cuenta sus esquinas por dueño, y después las escribe en la zona de
+   // cada dueño (las de un dueño quedan seguidas, en el orden de los triángulos)
+   const unsigned long verts_por_dueno = ( num_verts + num_duenos - 1 )/num_duenos ,
+                       num_bloques     = num_duenos ,
+                       tris_por_bloque = ( num_tris + num_bloques - 1 )/num_bloques ;
+   std::vector<unsigned long> cuentas( num_bloques*num_duenos, 0 ); // [bloque*num_duenos + dueño]
+   std::vector<unsigned long> inicio_dueno( num_duenos+1, 0 );
+   std::vector<uint32_t>      esquinas( 3*num_tris );
+
+   ParaleloPara( num_bloques, [&]( const unsigned long b0, const unsigned long b1 )
+   {
+      for( unsigned long b = b0 ; b < b1 ; b++ )
+      {
+         unsigned long * cuenta = cuentas.data() + b*num_duenos ;
+         const unsigned long e1 = 3*std::min( num_tris, ( b+1 )*tris_por_bloque );
+         for( unsigned long e = 3*std::min( num_tris, b*tris_por_bloque ) ; e < e1 ; e++ )
+            cuenta[ indices[e]/verts_por_dueno ]++ ;
+      }
+   }, 1 );
+
+   // (las cuentas pasan a ser las posiciones de inicio de cada bloque en la zona de cada dueño)
+   unsigned long total = 0 ;
+   for( unsigned d = 0 ; d < num_duenos ; d++ )
+   {
+      inicio_dueno[d] = total ;
+      for( unsigned long b = 0 ; b < num_bloques ; b++ )
+      {
+         const unsigned long c = cuentas[ b*num_duenos + d ] ;
+         cuentas[ b*num_duenos + d ] = total ;
+         total += c ;
+      }
+   }
+   inicio_dueno[num_duenos] = total ;
+   assert( total == 3*num_tris );
+
+   ParaleloPara( num_bloques, [&]( const unsigned long b0, const unsigned long b1 )
+   {
+      for( unsigned long b = b0 ; b < b1 ; b++ )
+      {
+         unsigned long * posicion = cuentas.data() + b*num_duenos ;
+         const unsigned long e1 = 3*std::min( num_tris, ( b+1 )*tris_por_bloque );
+         for( unsigned long e = 3*std::min( num_tris, b*tris_por_bloque ) ; e < e1 ; e++ )
+            esquinas[ posicion[ indices[e]/verts_por_dueno ]++ ] = uint32_t( e );
+      }
+   }, 1 );
+
+   // cada dueño acumula y normaliza las normales de sus vértices
+   ParaleloPara( num_duenos, [&]( const unsigned long d0, const unsigned long d1 )
+   {
+      for( unsigned long d = d0 ; d < d1 ; d++ )
+      {
+         const unsigned long v0 = std::min( num_verts, d*verts_por_dueno ),
+                             v1 = std::min( num_verts, v0 + verts_por_dueno );
+         std::fill( normales + 3*v0, normales + 3*v1, 0.0f );
+         for( unsigned long i = inicio_dueno[d] ; i < inicio_dueno[d+1] ; i++ )
+         {
+            const uint32_t e = esquinas[i], t = e/3 ;
+            float * n = normales + 3ul*indices[e] ;
+            n[0] += nx[t] ;  n[1] += ny[t] ;  n[2] += nz[t] ;
+         }
+         NormalizarNormales( normales, v0, v1 );
+      }
+   }, 1 );
+}
+// ------------------------------------------------------------------------------------------------------
+
+DescrVBOAtribs * CalcularNormales( const DescrVAO & vao )
+{
+   using namespace std ;
+   ZONA_TRAZA( "CalcularNormales" );
+   const auto inicio = chrono::steady_clock::now();
+
+   const DescrVBOAtribs * dvbo_pos  = vao.leerDescrAtrib( Cauce::ind_atrib_posiciones );
+   const DescrVBOInds   * dvbo_inds = vao.leerDescrIndices();
+   assert( dvbo_pos->leerType() == GL_FLOAT && dvbo_pos->leerSize() == 3 );
+   assert( dvbo_pos->leerDatos() != nullptr );
+   assert( dvbo_inds != nullptr && dvbo_inds->leerIndices() != nullptr && ! dvbo_inds->usaReinicio() );
+   assert( dvbo_inds->leerCount() % 3 == 0 );
+
+   const unsigned long num_verts  = vao.leerNumVertices(),
+                       num_tris   = dvbo_inds->leerCount()/3 ;
+   const unsigned      num_duenos = unsigned( std::min<unsigned long>( NumHilosParalelo(),
+                                              std::max( 1ul, num_verts/min_vertices_por_hilo ) ));
+   assert( 3*num_tris <= UINT32_MAX );
+
+   DescrVBOAtribs * dvbo_nor   = new DescrVBOAtribs( Cauce::ind_atrib_normales, GL_FLOAT, 3, num_verts );
+   const float    * posiciones = (const float *) dvbo_pos->leerDatos();
+   float          * normales   = (float *) dvbo_nor->leerPunteroDatos();
+
+   switch( dvbo_inds->leerType() )
+   {
+      case GL_UNSIGNED_BYTE :
+         CalcularNormalesIndices( (const GLubyte *) dvbo_inds->leerIndices(), num_tris, posiciones, num_verts, normales, num_duenos );
+         break ;
+      case GL_UNSIGNED_SHORT :
+         CalcularNormalesIndices( (const GLushort *) dvbo_inds->leerIndices(), num_tris, posiciones, num_verts, normales, num_duenos );
+         break ;
+      default :
+         CalcularNormalesIndices( (const GLuint *) dvbo_inds->leerIndices(), num_tris, posiciones, num_verts, normales, num_duenos );
+         break ;
+   }
+
+   const double ms = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+   cout << "Normales calculadas: " << num_verts << " vértices, " << num_tris << " triángulos ("
+        << fixed << setprecision(1) << ms << " ms, " << num_duenos << " hilos)." << defaultfloat << endl ;
+   return dvbo_nor ;
+}
+// ------------------------------------------------------------------------------------------------------
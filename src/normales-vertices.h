@@ -0,0 +1,33 @@
+// Cálculo de las normales de los vértices de una malla indexada (en paralelo)
+
+#ifndef NORMALES_VERTICES_H
+#define NORMALES_VERTICES_H
+
+#include "glincludes.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+// Calcula la normal de cada vértice de un VAO indexado de triángulos (modo GL_TRIANGLES), como
+// la suma de las normales de los triángulos adyacentes ponderadas por su área (el producto
+// vectorial de dos aristas, sin normalizar), normalizada. Los vértices sin triángulos con área
+// tienen la normal (0,0,1). Es adecuado para mallas importadas sin normales: las caras con
+// vértices repetidos en las aristas (costuras) quedan con normales distintas a cada lado (ver
+// 'SoldarVertices').
+//
+// Las normales de los triángulos se calculan por bloques (las coordenadas se copian en tablas
+// separadas por componentes, para que el compilador vectorice los productos vectoriales). La
+// acumulación se reparte por vértices: cada hilo es el dueño de un rango de vértices y suma las
+// normales de las esquinas de triángulos que caen en su rango (antes se reparten las esquinas
+// por dueño), así que ningún hilo escribe en la misma normal que otro y no hacen falta
+// operaciones atómicas. Informa en 'cout' del tiempo empleado.
+//
+// Las tablas de posiciones (GL_FLOAT, 3 componentes) y de índices (sin reinicios de primitiva)
+// deben estar en la memoria de la aplicación.
+//
+// @param vao (const DescrVAO &) VAO con los triángulos
+// @return (DescrVBOAtribs *) tabla de normales (atributo 'Cauce::ind_atrib_normales', GL_FLOAT,
+//                            3 componentes), para añadir al VAO antes de crearlo en la GPU
+//
+DescrVBOAtribs * CalcularNormales( const DescrVAO & vao );
+
+#endif
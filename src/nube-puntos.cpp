@@ -0,0 +1,399 @@
+// Visualización de nubes de puntos fuera de memoria: nodos del octree elegidos por su error en
+// pantalla con un presupuesto de puntos, leídos del disco en hilos auxiliares
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "nube-puntos.h"
+#include "errores-gl.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+NubePuntos * NubePuntos::abrir( const std::string & carpeta, const unsigned long presupuesto_puntos,
+                                const unsigned num_hilos )
+{
+   using namespace std ;
+   using namespace glm ;
+   namespace fs = std::filesystem ;
+   ZONA_TRAZA( "NubePuntos::abrir" );
+   assert( 0 < presupuesto_puntos && 0 < num_hilos );
+
+   // jerarquía (cabecera y nodos), comprobando que es coherente con el archivo de puntos
+   CabeceraOctree          cabecera ;
+   vector<NodoOctreeDisco> en_disco ;
+   const string            archivo_puntos = carpeta + "/puntos.bin" ;
+   error_code              error ;
+   const uint64_t          tam_puntos = fs::file_size( archivo_puntos, error );
+   ifstream                archivo( carpeta + "/jerarquia.bin", ios::binary );
+   archivo.read( (char *) &cabecera, sizeof( cabecera ));
+   const CabeceraOctree    correcta ;
+   bool valido = archivo && ! error && std::equal( cabecera.magia, cabecera.magia + 4, correcta.magia ) &&
+                 0 < cabecera.num_nodos && 0 < cabecera.max_puntos_nodo && 0 < cabecera.tam_rejilla && 0.0f < cabecera.lado ;
+   if ( valido )
+   {
+      en_disco.resize( cabecera.num_nodos );
+      valido = bool( archivo.read( (char *) en_disco.data(), streamsize( en_disco.size()*sizeof( NodoOctreeDisco ) )));
+   }
+   for( size_t i = 0 ; valido && i < en_disco.size() ; i++ )
+   {
+      const NodoOctreeDisco & n = en_disco[i] ;
+      valido = n.nivel < 32 && n.num_puntos <= cabecera.max_puntos_nodo &&
+               n.desplazamiento + BytesNodoOctree( n.num_puntos ) <= tam_puntos ;
+      for( const int32_t h : n.hijos )
+         valido = valido && ( h == -1 || ( size_t( h ) > i && size_t( h ) < en_disco.size() ));
+   }
+   if ( ! valido )
+   {
+      cout << "No se ha podido leer el octree de puntos de la carpeta '" << carpeta << "'." << endl ;
+      return nullptr ;
+   }
+
+   NubePuntos * nube = new NubePuntos();
+   nube->cabecera           = cabecera ;
+   nube->archivo_puntos     = archivo_puntos ;
+   nube->presupuesto_puntos = presupuesto_puntos ;
+   nube->nodos.resize( en_disco.size() );
+   for( size_t i = 0 ; i < en_disco.size() ; i++ )
+   {
+      const NodoOctreeDisco & d = en_disco[i] ;
+      Nodo &                  n = nube->nodos[i] ;
+      n.lado           = cabecera.lado/float( 1ull << d.nivel );
+      n.minimo         = vec3( cabecera.minimo[0], cabecera.minimo[1], cabecera.minimo[2] )
+                       + vec3( float( d.x ), float( d.y ), float( d.z ))*n.lado ;
+      n.num_puntos     = d.num_puntos ;
+      n.desplazamiento = d.desplazamiento ;
+      std::copy( d.hijos, d.hijos + 8, n.hijos );
+   }
+
+   // ranuras del tamaño del mayor nodo: las suficientes para el presupuesto con nodos llenos, y
+   // más para los nodos con menos puntos (se crean al necesitarlas)
+   const unsigned long max_puntos = cabecera.max_puntos_nodo ;
+   nube->desplazamiento_colores = GLsizeiptr( ( 6*max_puntos + 3 ) & ~3ul );
+   nube->bytes_ranura           = nube->desplazamiento_colores + GLsizeiptr( 4*max_puntos );
+   nube->max_ranuras            = unsigned( 2*( ( presupuesto_puntos + max_puntos - 1 )/max_puntos ) + 64 );
+
+   // tablas que se reutilizan (así los frames no reservan memoria)
+   nube->ranuras.reserve( nube->max_ranuras );
+   nube->cola_recorrido.reserve( nube->nodos.size() );
+   nube->nodos_dibujados.reserve( nube->max_ranuras );
+   nube->nodos_pedidos.reserve( nube->max_ranuras );
+   nube->peticiones.reserve( nube->max_ranuras );
+   nube->lecturas.resize( 2*num_hilos + 2 );
+   for( unsigned i = 0 ; i < nube->lecturas.size() ; i++ )
+   {
+      nube->lecturas[i].datos.resize( BytesNodoOctree( max_puntos ));
+      nube->lecturas_libres.push_back( i );
+   }
+   nube->lecturas_hechas.reserve( nube->lecturas.size() );
+
+   for( unsigned i = 0 ; i < num_hilos ; i++ )
+      nube->hilos.emplace_back( &NubePuntos::leer, nube );
+
+   cout << "Nube de puntos abierta: " << cabecera.num_puntos << " puntos en " << cabecera.num_nodos << " nodos, "
+        << "presupuesto de " << presupuesto_puntos << " puntos por frame (hasta " << nube->max_ranuras
+        << " nodos en la GPU)." << endl ;
+   return nube ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void NubePuntos::leer()
+{
+   NombrarHiloTraza( "lectura de nodos" );
+   std::ifstream archivo( archivo_puntos, std::ios::binary );
+
+   std::unique_lock<std::mutex> bloqueo( cerrojo );
+   while ( true )
+   {
+      cond_peticiones.wait( bloqueo, [this]()
+      {
+         return terminar || ( sig_peticion < peticiones.size() && ! lecturas_libres.empty() );
+      });
+      if ( terminar )
+         return ;
+      const int      nodo = peticiones[ sig_peticion++ ] ;
+      const unsigned l    = lecturas_libres.back() ;
+      lecturas_libres.pop_back();
+      bloqueo.unlock();
+
+      // (el desplazamiento y el número de puntos de los nodos no cambian, se leen sin el cerrojo)
+      {
+         ZONA_TRAZA( "NubePuntos::leer" );
+         Lectura & lectura = lecturas[l] ;
+         archivo.seekg( std::streamoff( nodos[nodo].desplazamiento ));
+         archivo.read( (char *) lectura.datos.data(), std::streamsize( BytesNodoOctree( nodos[nodo].num_puntos )));
+         lectura.nodo  = nodo ;
+         lectura.error = ! archivo ;
+         archivo.clear();
+      }
+
+      bloqueo.lock();
+      lecturas_hechas.push_back( l );
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+
+int NubePuntos::obtenerRanura()
+{
+   for( unsigned r = 0 ; r < ranuras.size() ; r++ )
+      if ( ranuras[r].nodo < 0 )
+         return int( r );
+
+   // crear una ranura nueva, si quedan
+   if ( ranuras.size() < max_ranuras )
+   {
+      CError();
+      Ranura r ;
+      glGenVertexArrays( 1, &r.vao ); assert( 0 < r.vao );
+      glGenBuffers( 1, &r.vbo ); assert( 0 < r.vbo );
+      glBindVertexArray( r.vao );
+      glBindBuffer( GL_ARRAY_BUFFER, r.vbo );
+      glBufferData( GL_ARRAY_BUFFER, bytes_ranura, nullptr, GL_DYNAMIC_DRAW );
+      glVertexAttribPointer( Cauce::ind_atrib_posiciones, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0, nullptr );
+      glVertexAttribPointer( Cauce::ind_atrib_colores, 3, GL_UNSIGNED_BYTE, GL_TRUE, 4, (void *) desplazamiento_colores );
+      glEnableVertexAttribArray( Cauce::ind_atrib_posiciones );
+      glEnableVertexAttribArray( Cauce::ind_atrib_colores );
+      glBindVertexArray( 0 );
+      glBindBuffer( GL_ARRAY_BUFFER, 0 );
+      CError();
+      ranuras.push_back( r );
+      return int( ranuras.size() - 1 );
+   }
+
+   // si no, quitar de la GPU el nodo dibujado hace más frames (nunca uno de este frame)
+   int mejor = -1 ;
+   for( unsigned r = 0 ; r < ranuras.size() ; r++ )
+      if ( ranuras[r].ultimo_frame < frame && ( mejor < 0 || ranuras[r].ultimo_frame < ranuras[mejor].ultimo_frame ))
+         mejor = int( r );
+   if ( mejor >= 0 )
+   {
+      Nodo & expulsado = nodos[ ranuras[mejor].nodo ] ;
+      expulsado.ranura = -1 ;
+      expulsado.estado = EstadoNodo::en_disco ;
+      ranuras[mejor].nodo = -1 ;
+      num_expulsiones++ ;
+   }
+   return mejor ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void NubePuntos::subirLeidos()
+{
+   using namespace std::chrono ;
+   ZONA_TRAZA( "NubePuntos::subirLeidos" );
+   const auto inicio = steady_clock::now();
+
+   while ( true )
+   {
+      unsigned l ;
+      {
+         std::lock_guard<std::mutex> bloqueo( cerrojo );
+         if ( lecturas_hechas.empty() )
+            return ;
+         l = lecturas_hechas.front() ;
+         lecturas_hechas.erase( lecturas_hechas.begin() );
+      }
+
+      const Lectura & lectura = lecturas[l] ;
+      Nodo &          nodo    = nodos[ lectura.nodo ] ;
+      assert( nodo.estado == EstadoNodo::pedido );
+      const int       r       = lectura.error ? -1 : obtenerRanura() ;
+      if ( lectura.error )
+      {
+         std::cout << "No se ha podido leer el nodo " << lectura.nodo << " de la nube de puntos." << std::endl ;
+         nodo.estado = EstadoNodo::error ;
+      }
+      else if ( r < 0 ) // (no hay ranuras, se volverá a pedir si sigue haciendo falta)
+         nodo.estado = EstadoNodo::en_disco ;
+      else
+      {
+         CError();
+         const uint64_t bytes = BytesNodoOctree( nodo.num_puntos );
+         glBindBuffer( GL_ARRAY_BUFFER, ranuras[r].vbo );
+         glBufferSubData( GL_ARRAY_BUFFER, 0, GLsizeiptr( 6*nodo.num_puntos ), lectura.datos.data() );
+         glBufferSubData( GL_ARRAY_BUFFER, desplazamiento_colores, GLsizeiptr( 4*nodo.num_puntos ),
+                          lectura.datos.data() + ( bytes - 4*nodo.num_puntos ));
+         glBindBuffer( GL_ARRAY_BUFFER, 0 );
+         CError();
+         ranuras[r].nodo         = lectura.nodo ;
+         ranuras[r].ultimo_frame = frame ;
+         nodo.ranura  = r ;
+         nodo.estado  = EstadoNodo::en_gpu ;
+         num_cargados++ ;
+         bytes_leidos += bytes ;
+      }
+
+      // devolver la lectura a los hilos
+      {
+         std::lock_guard<std::mutex> bloqueo( cerrojo );
+         lecturas_libres.push_back( l );
+      }
+      cond_peticiones.notify_one();
+
+      if ( duration<double,std::milli>( steady_clock::now() - inicio ).count() >= presupuesto_subidas_ms )
+         return ;
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+
+void NubePuntos::recorrer( const Cauce & cauce, const int alto )
+{
+   using namespace glm ;
+   ZONA_TRAZA( "NubePuntos::recorrer" );
+
+   // planos del view-frustum y posición de la cámara, en coordenadas de la nube
+   const mat4 vista_modelado = cauce.leerMatrizVista() * cauce.leerMM() ,
+              m              = cauce.leerMatrizProyeccion() * vista_modelado ;
+   vec4 planos[6] ;
+   for( int i = 0 ; i < 3 ; i++ )
+   {
+      planos[2*i]   = row( m, 3 ) + row( m, i );
+      planos[2*i+1] = row( m, 3 ) - row( m, i );
+   }
+   const vec4  c4     = inverse( vista_modelado ) * vec4( 0.0f, 0.0f, 0.0f, 1.0f );
+   const vec3  camara = vec3( c4.x, c4.y, c4.z )/c4.w ;
+
+   // pixels que ocupa una longitud de 1 a distancia 1 de la cámara (la escala de la nube se
+   // cancela: la separación y la distancia se miden en sus coordenadas)
+   const float escala     = cauce.leerMatrizProyeccion()[1][1]*0.5f*float( alto ),
+               distan_min = 1e-4f*cabecera.lado ;
+   const auto  separacion = [&]( const Nodo & n )
+   {
+      const vec3  centro = n.minimo + vec3( 0.5f*n.lado );
+      const float d      = std::max( distan_min, length( centro - camara ) - 0.8661f*n.lado );
+      return n.lado/float( cabecera.tam_rejilla )*escala/d ;
+   };
+   const auto visible = [&]( const Nodo & n )
+   {
+      for( const vec4 & p : planos )
+      {
+         const vec3 esquina = n.minimo + n.lado*vec3( p.x > 0.0f, p.y > 0.0f, p.z > 0.0f );
+         if ( p.x*esquina.x + p.y*esquina.y + p.z*esquina.z + p.w < 0.0f )
+            return false ;
+      }
+      return true ;
+   };
+
+   // recorrido de mayor a menor separación en pantalla
+   cola_recorrido.clear();
+   nodos_dibujados.clear();
+   nodos_pedidos.clear();
+   puntos_dibujados = 0 ;
+   unsigned long puntos_elegidos = 0 ;
+   cola_recorrido.push_back( { separacion( nodos[0] ), 0 } );
+   while ( ! cola_recorrido.empty() )
+   {
+      std::pop_heap( cola_recorrido.begin(), cola_recorrido.end() );
+      const auto [sep, i] = cola_recorrido.back() ;
+      cola_recorrido.pop_back();
+      const Nodo & n = nodos[i] ;
+      if ( ! visible( n ))
+         continue ;
+      if ( puntos_elegidos + n.num_puntos > presupuesto_puntos ||
+           nodos_dibujados.size() + nodos_pedidos.size() >= max_ranuras )
+         break ;
+      puntos_elegidos += n.num_puntos ;
+
+      if ( n.estado == EstadoNodo::en_gpu )
+      {
+         nodos_dibujados.push_back( i );
+         ranuras[n.ranura].ultimo_frame = frame ;
+         puntos_dibujados += n.num_puntos ;
+         if ( sep > error_maximo_pixels )
+            for( const int32_t h : n.hijos )
+               if ( h >= 0 )
+               {
+                  cola_recorrido.push_back( { separacion( nodos[h] ), h } );
+                  std::push_heap( cola_recorrido.begin(), cola_recorrido.end() );
+               }
+      }
+      else if ( n.estado != EstadoNodo::error )
+         nodos_pedidos.push_back( i );
+   }
+   num_pendientes = unsigned( nodos_pedidos.size() );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void NubePuntos::pedir()
+{
+   {
+      std::lock_guard<std::mutex> bloqueo( cerrojo );
+
+      // las peticiones que no ha tomado ningún hilo se olvidan (se vuelven a pedir si siguen en la lista)
+      for( size_t k = sig_peticion ; k < peticiones.size() ; k++ )
+         nodos[ peticiones[k] ].estado = EstadoNodo::en_disco ;
+      peticiones.clear();
+      sig_peticion = 0 ;
+      for( const int i : nodos_pedidos )
+         if ( nodos[i].estado == EstadoNodo::en_disco )
+         {
+            nodos[i].estado = EstadoNodo::pedido ;
+            peticiones.push_back( i );
+         }
+   }
+   cond_peticiones.notify_all();
+}
+// ------------------------------------------------------------------------------------------------------
+
+void NubePuntos::visualizar( Cauce & cauce, const int alto )
+{
+   using namespace glm ;
+   ZONA_TRAZA( "NubePuntos::visualizar" );
+   CError();
+   frame++ ;
+
+   subirLeidos();
+   recorrer( cauce, alto );
+   pedir();
+
+   // dibujar los nodos en la GPU, cada uno con la matriz que lleva [0,1]^3 a su cubo
+   glEnable( GL_DEPTH_TEST );
+   glDepthFunc( GL_LESS );
+   glDepthMask( GL_TRUE );
+   glPointSize( tam_punto );
+   const mat4 modelado = cauce.leerMM() ;
+   for( const int i : nodos_dibujados )
+   {
+      const Nodo & n = nodos[i] ;
+      cauce.fijarMM( modelado * translate( n.minimo ) * scale( vec3( n.lado )) );
+      glBindVertexArray( ranuras[n.ranura].vao );
+      glDrawArrays( GL_POINTS, 0, GLsizei( n.num_puntos ));
+   }
+   glBindVertexArray( 0 );
+   glPointSize( 1.0f );
+   cauce.fijarMM( modelado );
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
+
+glm::mat4 NubePuntos::matrizNormalizacion() const
+{
+   using namespace glm ;
+   const vec3 centro = vec3( cabecera.minimo[0], cabecera.minimo[1], cabecera.minimo[2] ) + vec3( 0.5f*cabecera.lado );
+   return scale( vec3( 2.0f/cabecera.lado )) * translate( -centro );
+}
+// ------------------------------------------------------------------------------------------------------
+
+NubePuntos::~NubePuntos()
+{
+   {
+      std::lock_guard<std::mutex> bloqueo( cerrojo );
+      terminar = true ;
+   }
+   cond_peticiones.notify_all();
+   for( std::thread & h : hilos )
+      h.join();
+
+   CError();
+   for( Ranura & r : ranuras )
+   {
+      glDeleteVertexArrays( 1, &r.vao );
+      glDeleteBuffers( 1, &r.vbo );
+   }
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,160 @@
+// Visualización de nubes de puntos fuera de memoria: nodos del octree elegidos por su error en
+// pantalla con un presupuesto de puntos, leídos del disco en hilos auxiliares
+
+#ifndef NUBE_PUNTOS_H
+#define NUBE_PUNTOS_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "glincludes.h"
+#include "cauce.h"
+#include "octree-puntos.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Visualiza un octree escrito con 'ConstruirOctreePuntos', sea cual sea su tamaño: solo está en
+// memoria la jerarquía de nodos, y en la GPU los nodos que se están viendo.
+//
+// En cada frame se recorre el octree de mayor a menor separación entre puntos en pantalla (la
+// separación de un nodo, el lado de su cubo dividido por su rejilla, proyectada a la distancia de
+// la cámara), descartando los nodos fuera del 'view-frustum', hasta que la separación es menor
+// que 'error_maximo_pixels' o se agota el presupuesto de puntos. Los nodos elegidos que no están
+// en la GPU se piden a los hilos de lectura (en el orden del recorrido) y no se baja por debajo
+// de ellos; mientras llegan, se ven sus antecesores (que son una versión menos densa de la nube).
+//
+// Cada nodo leído se sube a una ranura de un conjunto de VBOs del mismo tamaño (el del mayor
+// nodo), cada uno con su VAO, que se crean al necesitarlos y se reutilizan: si no hay ranuras
+// libres, se usa la que hace más frames que no se dibuja. Así, en los frames no se crean ni
+// destruyen buffers, y la memoria de la GPU está acotada. Los puntos se dibujan con el cauce
+// (GL_POINTS), con sus posiciones cuantizadas como atributos normalizados (GL_UNSIGNED_SHORT)
+// y la matriz de cada nodo llevando [0,1]^3 a su cubo.
+//
+class NubePuntos
+{
+   public:
+
+   // abre el octree de una carpeta (lee su jerarquía) y lanza los hilos de lectura (no crea
+   // nada en la GPU hasta visualizar), devuelve nulo si no se puede leer
+   //
+   // @param carpeta            (string)        carpeta con 'jerarquia.bin' y 'puntos.bin'
+   // @param presupuesto_puntos (unsigned long) máximo número de puntos dibujados en un frame
+   // @param num_hilos          (unsigned)      número de hilos de lectura (>0)
+   //
+   static NubePuntos * abrir( const std::string & carpeta, const unsigned long presupuesto_puntos = 3000000,
+                              const unsigned num_hilos = 2 );
+
+   // sube a la GPU los nodos leídos (sin superar 'presupuesto_subidas_ms', al menos uno si hay),
+   // elige los nodos a dibujar con las matrices actuales del cauce, pide los que faltan y dibuja
+   // los que están en la GPU. Se debe llamar una vez por frame.
+   //
+   // @param cauce (Cauce &) cauce con las matrices de proyección, vista y modelado (la nube está en sus coordenadas)
+   // @param alto  (int)     alto del viewport en pixels
+   //
+   void visualizar( Cauce & cauce, const int alto );
+
+   // devuelve la matriz que lleva el cubo de la nube al cubo [-1,1]^3
+   glm::mat4 matrizNormalizacion() const ;
+
+   // número de nodos elegidos en el último frame que todavía no están en la GPU
+   inline unsigned numPendientes() const { return num_pendientes ; }
+
+   // estadísticas: nodos leídos y subidos, bytes leídos, nodos quitados de la GPU para
+   // reutilizar sus ranuras, y puntos y nodos dibujados en el último frame
+   inline unsigned long numNodosCargados()   const { return num_cargados ; }
+   inline unsigned long bytesLeidos()        const { return bytes_leidos ; }
+   inline unsigned long numExpulsiones()     const { return num_expulsiones ; }
+   inline unsigned long numPuntosDibujados() const { return puntos_dibujados ; }
+   inline unsigned long numNodosDibujados()  const { return nodos_dibujados.size() ; }
+   inline unsigned long numNodos()           const { return nodos.size() ; }
+   inline uint64_t      numPuntos()          const { return cabecera.num_puntos ; }
+
+   // termina los hilos y libera los VBOs y VAOs
+   ~NubePuntos();
+
+   float  error_maximo_pixels    = 1.0f ; // separación máxima entre puntos en pantalla (en pixels)
+   float  tam_punto              = 2.0f ; // tamaño de los puntos (en pixels)
+   double presupuesto_subidas_ms = 2.0 ;  // tiempo máximo por frame para subir nodos a la GPU
+
+   private: // ---------------------------
+
+   enum class EstadoNodo : uint8_t { en_disco, pedido, en_gpu, error } ;
+
+   struct Nodo
+   {
+      glm::vec3  minimo ;           // esquina mínima del cubo (en coordenadas de la nube)
+      float      lado ;
+      uint32_t   num_puntos ;
+      uint64_t   desplazamiento ;   // posición de sus puntos en 'puntos.bin'
+      int32_t    hijos[8] ;
+      int        ranura = -1 ;      // ranura con sus puntos (si está en la GPU)
+      EstadoNodo estado = EstadoNodo::en_disco ; // (solo lo cambia el hilo de OpenGL)
+   } ;
+
+   // VBO (con su VAO) en el que se sube un nodo: posiciones al principio y colores en 'desplazamiento_colores'
+   struct Ranura
+   {
+      GLuint        vao = 0, vbo = 0 ;
+      int           nodo = -1 ;          // nodo que tiene (-1 si ninguno)
+      unsigned long ultimo_frame = 0 ;   // último frame en el que se ha dibujado (o se ha subido su nodo)
+   } ;
+
+   // bloque de puntos leído por un hilo
+   struct Lectura
+   {
+      int                        nodo  = -1 ;
+      bool                       error = false ;
+      std::vector<unsigned char> datos ;
+   } ;
+
+   NubePuntos() = default ;
+
+   // función que ejecuta cada hilo de lectura
+   void leer();
+
+   // sube a la GPU los nodos leídos, hasta agotar el presupuesto de tiempo
+   void subirLeidos();
+
+   // devuelve una ranura libre o la usada hace más frames (no en este), o -1 si no hay
+   int obtenerRanura();
+
+   // elige los nodos a dibujar ('nodos_dibujados') y los que faltan ('nodos_pedidos')
+   void recorrer( const Cauce & cauce, const int alto );
+
+   // sustituye las peticiones a los hilos por 'nodos_pedidos'
+   void pedir();
+
+   CabeceraOctree        cabecera ;
+   std::string           archivo_puntos ;
+   std::vector<Nodo>     nodos ;
+   std::vector<Ranura>   ranuras ;
+   unsigned              max_ranuras = 0 ;
+   GLsizeiptr            bytes_ranura = 0 ,
+                         desplazamiento_colores = 0 ;
+   unsigned long         presupuesto_puntos = 0 ;
+   unsigned long         frame = 0 ;
+
+   // tablas del recorrido (se reutilizan en cada frame, no se reserva memoria)
+   std::vector<std::pair<float,int>> cola_recorrido ; // montículo de nodos por visitar (separación en pixels, nodo)
+   std::vector<int>      nodos_dibujados ;
+   std::vector<int>      nodos_pedidos ;
+   unsigned long         puntos_dibujados = 0 ;
+   unsigned              num_pendientes   = 0 ;
+
+   unsigned long         num_cargados = 0, bytes_leidos = 0, num_expulsiones = 0 ;
+
+   // estado compartido con los hilos (protegido por 'cerrojo')
+   std::mutex               cerrojo ;
+   std::condition_variable  cond_peticiones ; // hay peticiones y lecturas libres, o hay que terminar
+   std::vector<int>         peticiones ;      // nodos a leer, en orden de prioridad
+   size_t                   sig_peticion = 0 ; // primera petición que todavía no ha tomado ningún hilo
+   std::vector<Lectura>     lecturas ;
+   std::vector<unsigned>    lecturas_libres ;  // índices en 'lecturas'
+   std::vector<unsigned>    lecturas_hechas ;  // índices en 'lecturas', en el orden en que se han terminado
+   bool                     terminar = false ;
+   std::vector<std::thread> hilos ;
+} ;
+
+#endif
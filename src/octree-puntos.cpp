@@ -0,0 +1,552 @@
+// Octree de nubes de puntos para visualizarlas fuera de memoria: formato en disco y construcción
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "octree-puntos.h"
+#include "traza.h"
+
+static_assert( sizeof( PuntoNube ) == 16 && sizeof( CabeceraOctree ) == 40 && sizeof( NodoOctreeDisco ) == 64,
+               "los registros se escriben tal cual en los archivos" );
+
+// ------------------------------------------------------------------------------------------------------
+
+constexpr unsigned long puntos_por_bloque = 1ul << 16 ; // puntos que se leen o escriben de una vez
+
+// ------------------------------------------------------------------------------------------------------
+// llama a 'f( p )' con cada punto de un archivo de puntos, leyéndolo por bloques (en 'bloque'),
+// devuelve false si no se puede leer o su tamaño no es un múltiplo del de un punto
+
+template< class Funcion >
+static bool RecorrerArchivo( const std::string & nombre, std::vector<PuntoNube> & bloque, const Funcion & f )
+{
+   std::ifstream archivo( nombre, std::ios::binary );
+   if ( ! archivo )
+      return false ;
+   bloque.resize( puntos_por_bloque );
+   while ( true )
+   {
+      archivo.read( (char *) bloque.data(), std::streamsize( puntos_por_bloque*sizeof( PuntoNube ) ));
+      const std::streamsize bytes = archivo.gcount();
+      if ( bytes % sizeof( PuntoNube ) != 0 )
+         return false ;
+      for( size_t i = 0 ; i < size_t( bytes )/sizeof( PuntoNube ) ; i++ )
+         f( bloque[i] );
+      if ( ! archivo )
+         return archivo.eof() ;
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+// archivo de puntos que se escribe por bloques (se crea al escribir el primer punto)
+
+struct ArchivoPuntos
+{
+   std::string            nombre ;
+   std::ofstream          archivo ;
+   std::vector<PuntoNube> bloque ;
+   unsigned long          num_puntos = 0 ;
+   bool                   error      = false ;
+
+   void agregar( const PuntoNube & p )
+   {
+      if ( bloque.empty() )
+         bloque.reserve( puntos_por_bloque );
+      bloque.push_back( p );
+      num_puntos++ ;
+      if ( bloque.size() == puntos_por_bloque )
+         vaciar();
+   }
+   void vaciar()
+   {
+      if ( bloque.empty() )
+         return ;
+      if ( ! archivo.is_open() )
+         archivo.open( nombre, std::ios::binary );
+      archivo.write( (const char *) bloque.data(), std::streamsize( bloque.size()*sizeof( PuntoNube ) ));
+      error = error || ! archivo ;
+      bloque.clear();
+   }
+   void cerrar()
+   {
+      vaciar();
+      if ( archivo.is_open() )
+         archivo.close();
+      std::vector<PuntoNube>().swap( bloque );
+   }
+} ;
+// ------------------------------------------------------------------------------------------------------
+// cubo de un nodo
+
+struct CuboOctree
+{
+   glm::vec3 minimo = { 0.0f, 0.0f, 0.0f };
+   float     lado   = 1.0f ;
+
+   // octante del cubo en el que está un punto (el índice del hijo que lo contiene)
+   inline unsigned octante( const PuntoNube & p ) const
+   {
+      const float m = 0.5f*lado ;
+      return unsigned( p.x >= minimo.x + m ) | unsigned( p.y >= minimo.y + m ) << 1 | unsigned( p.z >= minimo.z + m ) << 2 ;
+   }
+} ;
+// ------------------------------------------------------------------------------------------------------
+// número pseudo-aleatorio de un punto (a partir de sus bytes): ordena los puntos de una celda o
+// de un nodo de forma uniforme, aunque el archivo esté ordenado (p.ej. por pasadas del escáner)
+
+static inline uint64_t HashPunto( const PuntoNube & p )
+{
+   uint64_t a, b ;
+   std::memcpy( &a, &p, 8 );
+   std::memcpy( &b, (const char *) &p + 8, 8 );
+   uint64_t h = a*0x9E3779B97F4A7C15ull ^ b ;
+   h ^= h >> 31 ;  h *= 0xBF58476D1CE4E5B9ull ;
+   h ^= h >> 29 ;  h *= 0x94D049BB133111EBull ;
+   return h ^ ( h >> 32 );
+}
+
+// ------------------------------------------------------------------------------------------------------
+// Muestreo de los puntos de un nodo con una rejilla: en cada celda se elige el punto con menor
+// 'HashPunto' y, si hay más celdas ocupadas que 'max_puntos_nodo', se quedan las de menor hash
+// (una muestra aleatoria uniforme de las celdas). Se hace en dos recorridos de los puntos del
+// nodo: 'considerar' cada punto, y después 'tomar' indica si un punto es uno de los elegidos
+// (así los puntos no tienen que estar en memoria, se pueden leer dos veces de un archivo).
+
+class MuestreoRejilla
+{
+   public:
+
+   MuestreoRejilla( const unsigned p_tam_rejilla )
+   :  n( p_tam_rejilla ), celdas( size_t( n )*n*n, -1 )
+   {
+      assert( 0 < n && n <= 256 );
+   }
+
+   // empieza el muestreo de un nodo
+   void iniciar( const CuboOctree & p_cubo )
+   {
+      assert( candidatos.empty() );
+      cubo = p_cubo ;
+   }
+
+   // (primer recorrido) tiene en cuenta un punto del nodo
+   void considerar( const PuntoNube & p )
+   {
+      const uint32_t celda = celdaPunto( p );
+      const uint64_t hash  = HashPunto( p );
+      int32_t &      c     = celdas[celda] ;
+      if ( c < 0 )
+      {
+         c = int32_t( candidatos.size() );
+         candidatos.push_back( { hash, celda, false } );
+      }
+      else if ( hash < candidatos[c].hash )
+         candidatos[c].hash = hash ;
+   }
+
+   // (entre los dos recorridos) limita el número de puntos elegidos
+   void limitar( const size_t max_puntos )
+   {
+      if ( candidatos.size() <= max_puntos )
+         return ;
+      std::nth_element( candidatos.begin(), candidatos.begin() + max_puntos, candidatos.end(),
+                        []( const Candidato & a, const Candidato & b ) { return a.hash < b.hash ; } );
+      for( size_t i = max_puntos ; i < candidatos.size() ; i++ )
+         celdas[ candidatos[i].celda ] = -1 ;
+      candidatos.resize( max_puntos );
+      for( size_t i = 0 ; i < max_puntos ; i++ )
+         celdas[ candidatos[i].celda ] = int32_t( i );
+   }
+
+   // (segundo recorrido) devuelve true si el punto es el elegido de su celda (solo una vez)
+   bool tomar( const PuntoNube & p )
+   {
+      const int32_t c = celdas[ celdaPunto( p ) ] ;
+      if ( c < 0 || candidatos[c].tomado || candidatos[c].hash != HashPunto( p ) )
+         return false ;
+      candidatos[c].tomado = true ;
+      return true ;
+   }
+
+   // termina el muestreo del nodo (deja la rejilla vacía para el siguiente)
+   void terminar()
+   {
+      for( const Candidato & k : candidatos )
+         celdas[ k.celda ] = -1 ;
+      candidatos.clear();
+   }
+
+   private:
+
+   struct Candidato
+   {
+      uint64_t hash ;   // menor hash de los puntos de la celda
+      uint32_t celda ;
+      bool     tomado ; // true cuando el segundo recorrido ha encontrado el punto
+   } ;
+
+   inline uint32_t celdaPunto( const PuntoNube & p ) const
+   {
+      const float f = float( n )/cubo.lado ;
+      const auto  c = [&]( const float v, const float m )
+      {
+         return uint32_t( std::clamp( int( ( v - m )*f ), 0, int( n ) - 1 ));
+      };
+      return ( c( p.z, cubo.minimo.z )*n + c( p.y, cubo.minimo.y ) )*n + c( p.x, cubo.minimo.x );
+   }
+
+   const unsigned         n ;          // celdas por lado de la rejilla
+   CuboOctree             cubo ;
+   std::vector<int32_t>   celdas ;     // índice en 'candidatos' del punto elegido en cada celda (-1 si ninguno)
+   std::vector<Candidato> candidatos ; // celdas ocupadas
+} ;
+
+// ------------------------------------------------------------------------------------------------------
+// Construcción del octree: los nodos se crean en profundidad, y el bloque de puntos de cada uno se
+// escribe en 'puntos.bin' en cuanto se elige su muestra (antes de construir sus hijos)
+
+class ConstructorOctree
+{
+   public:
+
+   ConstructorOctree( const std::string & p_carpeta, const OpcionesOctree & p_opciones, const CuboOctree & p_raiz )
+   :  opciones( p_opciones ), carpeta( p_carpeta ), raiz( p_raiz ), muestreo( p_opciones.tam_rejilla )
+   {
+      archivo_puntos.open( carpeta + "/puntos.bin", std::ios::binary );
+      error = ! archivo_puntos ;
+      nodos.push_back( NodoOctreeDisco() );
+   }
+
+   // construye el subárbol del nodo 'nodo' con los puntos de un archivo (que se elimina al
+   // terminar de leerlo si es temporal)
+   void construirArchivo( const std::string & nombre, const int nodo, const unsigned long num_puntos, const bool temporal );
+
+   // construye el subárbol del nodo 'nodo' con los puntos de un vector (que se vacía)
+   void construirMemoria( const int nodo, std::vector<PuntoNube> & puntos );
+
+   // escribe 'jerarquia.bin', devuelve true si no ha habido errores
+   bool terminar( const uint64_t num_puntos );
+
+   const OpcionesOctree &       opciones ;
+   std::string                  carpeta ;
+   CuboOctree                   raiz ;
+   MuestreoRejilla              muestreo ;
+   std::ofstream                archivo_puntos ;
+   std::vector<NodoOctreeDisco> nodos ;
+   std::vector<PuntoNube>       bloque ;           // bloque de lectura de los archivos
+   std::vector<unsigned char>   bytes_nodo ;       // bloque de puntos del nodo que se escribe
+   uint64_t                     bytes_escritos   = 0 ;
+   unsigned long                num_reparticiones = 0 , // nodos repartidos en disco
+                                num_descartados  = 0 ;  // puntos que sobran en nodos del nivel máximo
+   unsigned                     max_nivel        = 0 ;
+   bool                         error            = false ;
+
+   private:
+
+   // cubo de un nodo
+   CuboOctree cuboNodo( const NodoOctreeDisco & n ) const
+   {
+      const float lado = raiz.lado/float( 1u << n.nivel );
+      return { raiz.minimo + glm::vec3( float( n.x ), float( n.y ), float( n.z ))*lado, lado };
+   }
+
+   // añade el hijo 'i' de un nodo, devuelve su índice
+   int agregarHijo( const int nodo, const unsigned i )
+   {
+      NodoOctreeDisco h ;
+      h.nivel = nodos[nodo].nivel + 1 ;
+      h.x     = 2*nodos[nodo].x + ( i & 1 );
+      h.y     = 2*nodos[nodo].y + ( i >> 1 & 1 );
+      h.z     = 2*nodos[nodo].z + ( i >> 2 & 1 );
+      max_nivel = std::max( max_nivel, unsigned( h.nivel ));
+      nodos.push_back( h );
+      nodos[nodo].hijos[i] = int32_t( nodos.size() - 1 );
+      return int( nodos.size() - 1 );
+   }
+
+   // escribe el bloque de puntos de un nodo en 'puntos.bin'
+   void escribirNodo( const int nodo, const PuntoNube * puntos, const size_t num_puntos );
+} ;
+// ------------------------------------------------------------------------------------------------------
+
+void ConstructorOctree::escribirNodo( const int nodo, const PuntoNube * puntos, const size_t num_puntos )
+{
+   assert( num_puntos <= opciones.max_puntos_nodo );
+   const CuboOctree cubo  = cuboNodo( nodos[nodo] );
+   const uint64_t   bytes = BytesNodoOctree( num_puntos );
+   bytes_nodo.assign( bytes, 0 );
+
+   // posiciones cuantizadas en el cubo del nodo, y colores (tras el relleno)
+   uint16_t *      pos = (uint16_t *) bytes_nodo.data();
+   unsigned char * col = bytes_nodo.data() + ( bytes - 4*num_puntos );
+   const float     f   = 65535.0f/cubo.lado ;
+   const auto      q   = [&]( const float v, const float m )
+   {
+      return uint16_t( std::clamp( std::lround( ( v - m )*f ), 0l, 65535l ));
+   };
+   for( size_t i = 0 ; i < num_puntos ; i++ )
+   {
+      const PuntoNube & p = puntos[i] ;
+      pos[3*i]   = q( p.x, cubo.minimo.x );
+      pos[3*i+1] = q( p.y, cubo.minimo.y );
+      pos[3*i+2] = q( p.z, cubo.minimo.z );
+      std::memcpy( col + 4*i, &p.r, 4 );
+   }
+   nodos[nodo].num_puntos     = uint32_t( num_puntos );
+   nodos[nodo].desplazamiento = bytes_escritos ;
+   archivo_puntos.write( (const char *) bytes_nodo.data(), std::streamsize( bytes ));
+   bytes_escritos += bytes ;
+   error = error || ! archivo_puntos ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void ConstructorOctree::construirMemoria( const int nodo, std::vector<PuntoNube> & puntos )
+{
+   // hoja: todos los puntos caben en el nodo (en el nivel máximo, se descartan los que sobran)
+   if ( puntos.size() <= opciones.max_puntos_nodo || nodos[nodo].nivel >= opciones.max_nivel )
+   {
+      const size_t n = std::min<size_t>( puntos.size(), opciones.max_puntos_nodo );
+      num_descartados += puntos.size() - n ;
+      escribirNodo( nodo, puntos.data(), n );
+      std::vector<PuntoNube>().swap( puntos );
+      return ;
+   }
+
+   // muestra del nodo, y el resto de puntos repartidos entre los hijos
+   const CuboOctree cubo = cuboNodo( nodos[nodo] );
+   muestreo.iniciar( cubo );
+   for( const PuntoNube & p : puntos )
+      muestreo.considerar( p );
+   muestreo.limitar( opciones.max_puntos_nodo );
+
+   std::vector<PuntoNube> seleccionados, hijos[8] ;
+   for( const PuntoNube & p : puntos )
+      if ( muestreo.tomar( p ) )
+         seleccionados.push_back( p );
+      else
+         hijos[ cubo.octante( p ) ].push_back( p );
+   muestreo.terminar();
+   std::vector<PuntoNube>().swap( puntos );
+
+   escribirNodo( nodo, seleccionados.data(), seleccionados.size() );
+   for( unsigned i = 0 ; i < 8 ; i++ )
+      if ( ! hijos[i].empty() )
+         construirMemoria( agregarHijo( nodo, i ), hijos[i] );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void ConstructorOctree::construirArchivo( const std::string & nombre, const int nodo, const unsigned long num_puntos,
+                                          const bool temporal )
+{
+   namespace fs = std::filesystem ;
+   if ( error )
+      return ;
+
+   // si el subárbol cabe en memoria, leer los puntos y construirlo en memoria
+   if ( num_puntos <= opciones.max_puntos_memoria || nodos[nodo].nivel >= opciones.max_nivel )
+   {
+      std::vector<PuntoNube> puntos ;
+      puntos.reserve( num_puntos );
+      error = ! RecorrerArchivo( nombre, bloque, [&]( const PuntoNube & p ) { puntos.push_back( p ); } );
+      if ( temporal )
+         fs::remove( nombre );
+      if ( ! error )
+         construirMemoria( nodo, puntos );
+      return ;
+   }
+
+   // si no, primer recorrido del archivo: muestra del nodo
+   num_reparticiones++ ;
+   const CuboOctree cubo = cuboNodo( nodos[nodo] );
+   muestreo.iniciar( cubo );
+   error = ! RecorrerArchivo( nombre, bloque, [&]( const PuntoNube & p ) { muestreo.considerar( p ); } );
+   muestreo.limitar( opciones.max_puntos_nodo );
+
+   // segundo recorrido: los puntos que no están en la muestra, a un archivo temporal por cada hijo
+   std::vector<PuntoNube> seleccionados ;
+   ArchivoPuntos          hijos[8] ;
+   for( unsigned i = 0 ; i < 8 ; i++ )
+      hijos[i].nombre = carpeta + "/temporal-" + std::to_string( nodo ) + "-" + std::to_string( i ) + ".bin" ;
+   if ( ! error )
+      error = ! RecorrerArchivo( nombre, bloque, [&]( const PuntoNube & p )
+      {
+         if ( muestreo.tomar( p ) )
+            seleccionados.push_back( p );
+         else
+            hijos[ cubo.octante( p ) ].agregar( p );
+      });
+   muestreo.terminar();
+   for( ArchivoPuntos & h : hijos )
+   {
+      h.cerrar();
+      error = error || h.error ;
+   }
+   if ( temporal )
+      fs::remove( nombre );
+
+   escribirNodo( nodo, seleccionados.data(), seleccionados.size() );
+   std::vector<PuntoNube>().swap( seleccionados );
+   for( unsigned i = 0 ; i < 8 ; i++ )
+      if ( hijos[i].num_puntos > 0 )
+      {
+         if ( ! error )
+            construirArchivo( hijos[i].nombre, agregarHijo( nodo, i ), hijos[i].num_puntos, true );
+         else
+            fs::remove( hijos[i].nombre );
+      }
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool ConstructorOctree::terminar( const uint64_t num_puntos )
+{
+   archivo_puntos.close();
+   error = error || ! archivo_puntos ;
+
+   CabeceraOctree cabecera ;
+   cabecera.num_nodos       = uint32_t( nodos.size() );
+   cabecera.max_puntos_nodo = opciones.max_puntos_nodo ;
+   cabecera.tam_rejilla     = opciones.tam_rejilla ;
+   cabecera.minimo[0]       = raiz.minimo.x ;
+   cabecera.minimo[1]       = raiz.minimo.y ;
+   cabecera.minimo[2]       = raiz.minimo.z ;
+   cabecera.lado            = raiz.lado ;
+   cabecera.num_puntos      = num_puntos ;
+
+   std::ofstream archivo( carpeta + "/jerarquia.bin", std::ios::binary );
+   archivo.write( (const char *) &cabecera, sizeof( cabecera ));
+   archivo.write( (const char *) nodos.data(), std::streamsize( nodos.size()*sizeof( NodoOctreeDisco ) ));
+   return ! error && archivo ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+bool ConstruirOctreePuntos( const std::string & archivo, const std::string & carpeta, const OpcionesOctree & opciones )
+{
+   using namespace std ;
+   using namespace glm ;
+   ZONA_TRAZA( "ConstruirOctreePuntos" );
+   assert( 0 < opciones.max_puntos_nodo && opciones.max_puntos_nodo <= opciones.max_puntos_memoria );
+   const auto inicio = chrono::steady_clock::now();
+
+   // caja englobante de los puntos (primer recorrido del archivo de entrada)
+   vector<PuntoNube> bloque ;
+   vec3              minimo = vec3( +INFINITY ), maximo = vec3( -INFINITY );
+   uint64_t          num_puntos = 0 ;
+   const bool        leido = RecorrerArchivo( archivo, bloque, [&]( const PuntoNube & p )
+   {
+      minimo = min( minimo, vec3( p.x, p.y, p.z ));
+      maximo = max( maximo, vec3( p.x, p.y, p.z ));
+      num_puntos++ ;
+   });
+   if ( ! leido || num_puntos == 0 )
+   {
+      cout << "No se ha podido leer el archivo de puntos '" << archivo << "' (o está vacío)." << endl ;
+      return false ;
+   }
+
+   // cubo de la raíz, centrado en la caja (y un poco mayor, así ningún punto queda en su cara máxima)
+   const vec3 tam  = maximo - minimo ;
+   const float lado = std::max( 1e-6f, std::max( tam.x, std::max( tam.y, tam.z )))*1.0001f ;
+   std::filesystem::create_directories( carpeta );
+   ConstructorOctree constructor( carpeta, opciones, { 0.5f*( minimo + maximo ) - vec3( 0.5f*lado ), lado } );
+   constructor.construirArchivo( archivo, 0, num_puntos, false );
+   const bool correcto = constructor.terminar( num_puntos );
+
+   const double s = chrono::duration<double>( chrono::steady_clock::now() - inicio ).count();
+   if ( ! correcto )
+   {
+      cout << "No se ha podido escribir el octree en la carpeta '" << carpeta << "'." << endl ;
+      return false ;
+   }
+   cout << "Octree construido: " << num_puntos << " puntos, " << constructor.nodos.size() << " nodos, "
+        << constructor.max_nivel + 1 << " niveles, " << constructor.num_reparticiones << " nodos repartidos en disco, "
+        << fixed << setprecision(1) << double( constructor.bytes_escritos )/( 1024.0*1024.0 ) << " MiB ("
+        << s << " s)." << defaultfloat << endl ;
+   if ( constructor.num_descartados > 0 )
+      cout << "Octree: " << constructor.num_descartados << " puntos descartados en nodos del nivel máximo." << endl ;
+   return true ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+// escaneo sintético: altura del terreno en (x,z) (en metros, en un cuadrado de 1 km de lado),
+// con edificios de tejado plano en algunas celdas de una cuadrícula de 60 metros
+
+static inline uint32_t HashEntero( uint32_t h )
+{
+   h ^= h >> 16 ;  h *= 0x7feb352du ;
+   h ^= h >> 15 ;  h *= 0x846ca68bu ;
+   return h ^ ( h >> 16 );
+}
+
+static float AlturaTerreno( const float x, const float z, bool & edificio )
+{
+   const float suelo = 40.0f*std::sin( x*0.006f )*std::cos( z*0.004f ) + 12.0f*std::sin( x*0.031f + z*0.017f )
+                     + 3.0f*std::sin( x*0.13f )*std::sin( z*0.11f );
+   const int   cx = int( std::floor( x/60.0f )), cz = int( std::floor( z/60.0f ));
+   const float fx = x/60.0f - float( cx ), fz = z/60.0f - float( cz );
+   edificio = HashEntero( uint32_t( cx*7919 + cz*104729 )) % 5 == 0 && 0.2f < fx && fx < 0.8f && 0.2f < fz && fz < 0.8f ;
+   return edificio ? suelo + 12.0f + float( HashEntero( uint32_t( cx*31 + cz*17 )) % 20 ) : suelo ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool GenerarNubeSintetica( const std::string & archivo, const unsigned long num_puntos, const unsigned semilla )
+{
+   using namespace std ;
+   ZONA_TRAZA( "GenerarNubeSintetica" );
+   assert( 0 < num_puntos );
+   const auto inicio = chrono::steady_clock::now();
+
+   // franjas paralelas al eje X, recorridas en líneas de escaneo a lo ancho de la franja
+   constexpr float tam_terreno = 1000.0f , ancho_franja = 100.0f ;
+   constexpr unsigned num_franjas = unsigned( tam_terreno/ancho_franja );
+   const unsigned long por_linea = std::max( 1ul, (unsigned long) std::sqrt( double( num_puntos )/( num_franjas*tam_terreno/ancho_franja )) );
+   const unsigned long num_lineas = ( num_puntos + por_linea - 1 )/por_linea ,
+                       lineas_franja = ( num_lineas + num_franjas - 1 )/num_franjas ;
+
+   ArchivoPuntos salida ;
+   salida.nombre = archivo ;
+   uint32_t estado = HashEntero( semilla + 1 );
+   const auto aleatorio = [&]() { estado = HashEntero( estado + 0x9e3779b9u ); return float( estado >> 8 )/float( 1u << 24 ); };
+
+   for( unsigned long l = 0 ; l < num_lineas ; l++ )
+   {
+      const unsigned long franja = l/lineas_franja ;
+      const float         x      = tam_terreno*float( l % lineas_franja )/float( lineas_franja );
+      for( unsigned long j = 0 ; j < por_linea && salida.num_puntos < num_puntos ; j++ )
+      {
+         bool        edificio ;
+         const float px = x + 0.5f*tam_terreno/float( lineas_franja )*aleatorio(),
+                     pz = ancho_franja*( float( franja ) + ( float( j ) + aleatorio() )/float( por_linea )),
+                     py = AlturaTerreno( px, pz, edificio ) + 0.05f*aleatorio(),
+                     h  = std::clamp( ( py + 55.0f )/110.0f, 0.0f, 1.0f ),
+                     v  = 0.85f + 0.15f*aleatorio(); // (variación de la reflectancia)
+
+         // colores: tejados rojizos, y el terreno verde en las zonas bajas, marrón en las medias y blanco en las altas
+         glm::vec3 color ;
+         if ( edificio )
+            color = { 0.7f, 0.3f, 0.25f };
+         else if ( h < 0.55f )
+            color = glm::mix( glm::vec3( 0.2f, 0.55f, 0.15f ), glm::vec3( 0.45f, 0.35f, 0.2f ), std::clamp( ( h - 0.3f )/0.25f, 0.0f, 1.0f ));
+         else
+            color = glm::mix( glm::vec3( 0.45f, 0.35f, 0.2f ), glm::vec3( 0.95f ), std::clamp( ( h - 0.55f )/0.15f, 0.0f, 1.0f ));
+         salida.agregar( { px, py, pz, uint8_t( 255.0f*v*color.r ), uint8_t( 255.0f*v*color.g ), uint8_t( 255.0f*v*color.b ), 255 } );
+      }
+   }
+   salida.cerrar();
+   if ( salida.error || salida.num_puntos != num_puntos )
+   {
+      cout << "No se ha podido escribir el archivo de puntos '" << archivo << "'." << endl ;
+      return false ;
+   }
+   cout << "Nube sintética escrita en '" << archivo << "': " << num_puntos << " puntos ("
+        << fixed << setprecision(1) << chrono::duration<double>( chrono::steady_clock::now() - inicio ).count()
+        << " s)." << defaultfloat << endl ;
+   return true ;
+}
+// ------------------------------------------------------------------------------------------------------
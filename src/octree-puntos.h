@@ -0,0 +1,99 @@
+// Octree de nubes de puntos para visualizarlas fuera de memoria: formato en disco y construcción
+
+#ifndef OCTREE_PUNTOS_H
+#define OCTREE_PUNTOS_H
+
+#include <cstdint>
+#include <string>
+#include "glincludes.h"
+
+// --------------------------------------------------------------------------------------------
+// Archivo de entrada: registros 'PuntoNube' seguidos (16 bytes cada uno, sin cabecera), con las
+// coordenadas de cada punto y su color RGBA (el formato binario más sencillo al que se puede
+// convertir un escaneo LiDAR, p.ej. desde LAS).
+
+struct PuntoNube
+{
+   float   x, y, z ;
+   uint8_t r, g, b, a ;
+} ;
+
+// --------------------------------------------------------------------------------------------
+// Octree en disco: una carpeta con dos archivos (todos los enteros en 'little endian'):
+//
+//   - 'jerarquia.bin': una 'CabeceraOctree' y un 'NodoOctreeDisco' por nodo (la raíz es el 0).
+//     Es pequeño (64 bytes por nodo) y se lee entero al abrir la nube.
+//   - 'puntos.bin': los puntos de cada nodo seguidos, en bloques que se leen con una sola
+//     lectura: las posiciones cuantizadas a 16 bits dentro del cubo del nodo (3 'uint16_t' por
+//     punto), relleno hasta un múltiplo de 4 bytes, y los colores RGBA (4 bytes por punto).
+//
+// Cada punto está en un único nodo. Un nodo interior tiene una muestra uniforme de los puntos de
+// su cubo (como mucho uno por celda de una rejilla de 'tam_rejilla'^3 celdas, y no más de
+// 'max_puntos_nodo'), y el resto se reparte entre sus hijos: un nodo junto con sus antecesores
+// es una versión de la nube con una separación entre puntos de aproximadamente el lado de su
+// cubo dividido por 'tam_rejilla' (el nivel de detalle que se elige al visualizar).
+
+struct CabeceraOctree
+{
+   char     magia[4]        = { 'N', 'U', 'B', '1' } ;
+   uint32_t num_nodos       = 0 ;
+   uint32_t max_puntos_nodo = 0 ;   // máximo número de puntos de un nodo
+   uint32_t tam_rejilla     = 0 ;   // celdas por lado de la rejilla de muestreo de cada nodo
+   float    minimo[3]       = { 0.0f, 0.0f, 0.0f } ; // esquina mínima del cubo de la raíz
+   float    lado            = 0.0f ; // lado del cubo de la raíz
+   uint64_t num_puntos      = 0 ;   // número total de puntos
+} ;
+
+struct NodoOctreeDisco
+{
+   uint32_t nivel          = 0 ;    // nivel en el árbol (la raíz tiene nivel 0)
+   uint32_t x = 0, y = 0, z = 0 ;   // posición del cubo del nodo entre los de su nivel (en [0,2^nivel))
+   uint32_t num_puntos     = 0 ;
+   int32_t  hijos[8]       = { -1, -1, -1, -1, -1, -1, -1, -1 } ; // índices de los hijos (-1 si no hay), el
+                                    // hijo 'i' ocupa el octante (i&1, (i>>1)&1, (i>>2)&1) del cubo
+   uint32_t reservado      = 0 ;
+   uint64_t desplazamiento = 0 ;    // posición del bloque de puntos del nodo en 'puntos.bin'
+} ;
+
+// número de bytes del bloque de puntos de un nodo con 'n' puntos en 'puntos.bin'
+inline uint64_t BytesNodoOctree( const uint64_t n )
+{
+   return ( ( 6*n + 3 ) & ~uint64_t(3) ) + 4*n ;
+}
+
+// Opciones de la construcción del octree
+//
+struct OpcionesOctree
+{
+   unsigned      max_puntos_nodo    = 16384 ;   // máximo número de puntos de un nodo
+   unsigned      tam_rejilla        = 64 ;      // celdas por lado de la rejilla de muestreo
+   unsigned long max_puntos_memoria = 1ul << 23 ; // los subárboles con más puntos se reparten en disco
+   unsigned      max_nivel          = 20 ;      // nivel máximo de los nodos (en él se descartan los puntos que sobran)
+} ;
+
+// --------------------------------------------------------------------------------------------
+// Construye el octree de una nube de puntos de cualquier tamaño, usando una cantidad de memoria
+// limitada: un nodo con más de 'max_puntos_memoria' puntos en su cubo se procesa leyendo dos
+// veces su archivo (una para elegir la muestra del nodo y otra para escribir los demás puntos en
+// un archivo temporal por cada hijo), y los subárboles que caben en memoria se construyen en
+// ella. Informa en 'cout' del resultado.
+//
+// @param archivo (string)                 archivo de puntos de entrada (registros 'PuntoNube')
+// @param carpeta (string)                 carpeta donde escribir el octree (se crea si no existe)
+// @param opciones (const OpcionesOctree &) opciones de la construcción
+// @return (bool) true si se ha construido sin errores
+//
+bool ConstruirOctreePuntos( const std::string & archivo, const std::string & carpeta,
+                            const OpcionesOctree & opciones = {} );
+
+// Escribe un archivo de puntos de entrada con un escaneo sintético de un terreno con edificios
+// (por pasadas en franjas, como un escaneo aéreo), sin tenerlo entero en memoria
+//
+// @param archivo    (string)        archivo a escribir
+// @param num_puntos (unsigned long) número de puntos (>0)
+// @param semilla    (unsigned)      semilla de los números pseudo-aleatorios
+// @return (bool) true si se ha escrito sin errores
+//
+bool GenerarNubeSintetica( const std::string & archivo, const unsigned long num_puntos, const unsigned semilla = 0 );
+
+#endif
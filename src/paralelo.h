@@ -0,0 +1,49 @@
+// Utilidades para repartir bucles entre varios hilos
+
+#ifndef PARALELO_H
+#define PARALELO_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------------------------------------------
+
+// Devuelve el número de hilos a usar en los bucles paralelos (al menos 1)
+//
+inline unsigned NumHilosParalelo()
+{
+   return std::max( 1u, std::thread::hardware_concurrency() );
+}
+
+// Ejecuta 'f( inicio, fin )' sobre bloques consecutivos que cubren el rango [0,n), repartidos
+// entre varios hilos (el hilo que llama procesa el primer bloque). Si 'n' es pequeño se usan 
+// menos hilos, de forma que cada uno procese al menos 'min_por_hilo' elementos. Vuelve 
+// cuando todos los bloques están procesados.
+//
+// @param n            (unsigned long) número de elementos del rango
+// @param f            (función)       función (o lambda) con parámetros (unsigned long, unsigned long)
+// @param min_por_hilo (unsigned long) mínimo número de elementos por hilo (>0)
+//
+template< class Funcion >
+void ParaleloPara( const unsigned long n, const Funcion & f, const unsigned long min_por_hilo = 4096 )
+{
+   const unsigned long max_hilos = std::max( 1ul, n / std::max( 1ul, min_por_hilo ) ),
+                       num_hilos = std::min( (unsigned long) NumHilosParalelo(), max_hilos ),
+                       tam_bloque = ( n + num_hilos - 1 ) / num_hilos ;
+
+   std::vector<std::thread> hilos ;
+   hilos.reserve( num_hilos-1 );
+   for( unsigned long h = 1 ; h < num_hilos ; h++ )
+   {
+      const unsigned long inicio = std::min( n, h*tam_bloque ),
+                          fin    = std::min( n, inicio + tam_bloque );
+      if ( inicio < fin )
+         hilos.emplace_back( [&f,inicio,fin]() { f( inicio, fin ); } );
+   }
+   f( 0, std::min( n, tam_bloque ) );
+   for( std::thread & h : hilos )
+      h.join();
+}
+
+#endif
@@ -0,0 +1,56 @@
+// Pila de capacidad fija (sin memoria dinámica)
+
+#ifndef PILA_FIJA_H
+#define PILA_FIJA_H
+
+#include <array>
+#include <cassert>
+
+// --------------------------------------------------------------------------------------------
+
+// Pila con capacidad máxima fija 'N', guardada dentro del propio objeto: apilar y desapilar
+// nunca reservan memoria dinámica (a diferencia de 'std::vector::push_back'), así que se puede
+// usar en el código que se ejecuta en cada frame. Superar la capacidad es un error (assert).
+//
+template< class T, unsigned N >
+class PilaFija
+{
+   public:
+
+   // añade una copia de 'valor' en el tope de la pila (no puede estar llena)
+   inline void push( const T & valor )
+   {
+      assert( num_elementos < N );
+      elementos[ num_elementos++ ] = valor ;
+   }
+
+   // quita el elemento del tope de la pila y lo devuelve (no puede estar vacía)
+   inline T pop()
+   {
+      assert( 0 < num_elementos );
+      return elementos[ --num_elementos ] ;
+   }
+
+   // elemento del tope de la pila (no puede estar vacía)
+   inline const T & tope() const
+   {
+      assert( 0 < num_elementos );
+      return elementos[ num_elementos-1 ] ;
+   }
+
+   // vacía la pila
+   inline void vaciar() { num_elementos = 0 ; }
+
+   // número de elementos apilados
+   inline unsigned size() const { return num_elementos ; }
+
+   // máximo número de elementos
+   static constexpr unsigned capacidad = N ;
+
+   private: // ---------------------------
+
+   std::array<T,N> elementos ;
+   unsigned        num_elementos = 0 ;
+} ;
+
+#endif
@@ -0,0 +1,111 @@
+// Precarga de recursos: creación de VAOs y calentamiento de programas antes del primer frame
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include "precarga-recursos.h"
+#include "errores-gl.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+void PrecargaRecursos::registrar( DescrVAO * vao, const GLenum modo, Textura * textura )
+{
+   assert( vao != nullptr );
+   for( const Entrada & e : entradas )
+      if ( e.vao == vao && e.modo == modo && e.textura == textura )
+         return ;
+   entradas.push_back( { vao, modo, textura, false } );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void PrecargaRecursos::quitar( DescrVAO * vao )
+{
+   entradas.erase( std::remove_if( entradas.begin(), entradas.end(), 
+                                   [vao]( const Entrada & e ) { return e.vao == vao ; } ), 
+                   entradas.end() );
+}
+// ------------------------------------------------------------------------------------------------------
+
+double PrecargaRecursos::precargar( Cauce & cauce )
+{
+   using namespace std ;
+   ZONA_TRAZA( "PrecargaRecursos::precargar" );
+   CError();
+   const auto inicio = chrono::steady_clock::now();
+
+   // 1. crear los VAOs (y subir sus VBOs) que no están creados
+   unsigned num_creados = 0 ;
+   for( Entrada & e : entradas )
+      if ( ! e.vao->creado() )
+      {
+         e.vao->preparar();
+         num_creados++ ;
+      }
+
+   // 2. dibujar cada VAO nuevo con cada combinación de programa y estado de la cola de opacos
+   Textura * const textura_previa          = cauce.leerTextura();
+   const bool      usar_color_plano_previo = cauce.leerUsarColorPlano();
+   unsigned        num_dibujos             = 0 ;
+
+   cauce.activar();
+   glEnable( GL_SCISSOR_TEST ); // (no se escribe ningún pixel)
+   glScissor( 0, 0, 0, 0 );
+   glEnable( GL_DEPTH_TEST );
+   glDepthFunc( GL_LESS );
+   for( Entrada & e : entradas )
+   {
+      if ( e.calentado )
+         continue ;
+      const bool triangulos = e.modo == GL_TRIANGLES || e.modo == GL_TRIANGLE_STRIP || e.modo == GL_TRIANGLE_FAN ;
+      cauce.fijarTextura( e.textura );
+      cauce.fijarUsarColorPlano( false );
+
+      // relleno, y relleno con aristas superpuestas
+      cauce.fijarDibujarAristas( false );
+      e.vao->draw( e.modo );
+      if ( triangulos )
+      {
+         cauce.fijarDibujarAristas( true );
+         e.vao->draw( e.modo );
+         cauce.fijarDibujarAristas( false );
+         num_dibujos++ ;
+      }
+
+      // pasada previa (solo profundidad) y pasada de color con test GL_LEQUAL
+      glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+      e.vao->draw( e.modo );
+      glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+      glDepthMask( GL_FALSE );
+      glDepthFunc( GL_LEQUAL );
+      e.vao->draw( e.modo );
+      glDepthMask( GL_TRUE );
+      glDepthFunc( GL_LESS );
+
+      // 'overdraw': mezcla aditiva con el uniform de visualización del 'overdraw'
+      glEnable( GL_BLEND );
+      glBlendFunc( GL_ONE, GL_ONE );
+      cauce.fijarVisualizarOverdraw( true );
+      e.vao->draw( e.modo );
+      cauce.fijarVisualizarOverdraw( false );
+      glDisable( GL_BLEND );
+
+      num_dibujos += 4 ;
+      e.calentado = true ;
+   }
+
+   // restaurar el estado del cauce y esperar a que el driver y la GPU terminen
+   glDisable( GL_SCISSOR_TEST );
+   cauce.fijarTextura( textura_previa );
+   cauce.fijarUsarColorPlano( usar_color_plano_previo );
+   glFinish();
+   CError();
+
+   const double ms = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+   if ( num_creados > 0 || num_dibujos > 0 )
+      cout << "Precarga: " << num_creados << " VAOs creados, " << num_dibujos << " dibujos de calentamiento ("
+           << fixed << setprecision(1) << ms << " ms)." << defaultfloat << endl ;
+   return ms ;
+}
+// ------------------------------------------------------------------------------------------------------
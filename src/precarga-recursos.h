@@ -0,0 +1,61 @@
+// Precarga de recursos: creación de VAOs y calentamiento de programas antes del primer frame
+
+#ifndef PRECARGA_RECURSOS_H
+#define PRECARGA_RECURSOS_H
+
+#include <vector>
+#include "glincludes.h"
+#include "cauce.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Registro de los VAOs que se van a visualizar, para crearlos en la GPU y 'calentar' el driver
+// antes del primer frame visible: si no, cada VAO se crea (y sus datos se suben a la GPU) en
+// su primer 'draw', y el driver termina de compilar cada programa y combinación de estado la
+// primera vez que se usa, así que el primer frame (y cada frame que muestra un objeto nuevo)
+// tarda mucho más que los demás.
+//
+// 'precargar' crea los VAOs registrados pendientes y dibuja cada uno con cada combinación de
+// programa y estado que usa la cola de opacos (relleno, aristas superpuestas, pasada previa sin
+// color y visualización del 'overdraw'), con un rectángulo de recorte ('scissor') vacío, así que
+// los dibujos de calentamiento no modifican el framebuffer y se puede llamar en cualquier momento
+// (normalmente antes del primer frame, y al crear objetos nuevos).
+//
+class PrecargaRecursos
+{
+   public:
+
+   // registra un VAO (si ya está registrado, no hace nada)
+   //
+   // @param vao     (DescrVAO *) VAO (no nulo, no es propiedad del registro)
+   // @param modo    (GLenum)     modo de visualización con el que se dibujará
+   // @param textura (Textura *)  textura con la que se dibujará (puede ser nula)
+   //
+   void registrar( DescrVAO * vao, const GLenum modo, Textura * textura = nullptr );
+
+   // quita un VAO del registro (se debe llamar antes de destruirlo)
+   void quitar( DescrVAO * vao );
+
+   // crea los VAOs registrados que no están creados y dibuja los de calentamiento (solo los 
+   // registrados desde la anterior llamada), espera a que la GPU termine
+   //
+   // @param cauce (Cauce &) cauce con el que se dibuja (deja su estado como estaba)
+   // @return (double) tiempo empleado en milisegundos
+   //
+   double precargar( Cauce & cauce );
+
+   private: // ---------------------------
+
+   struct Entrada
+   {
+      DescrVAO * vao ;
+      GLenum     modo ;
+      Textura *  textura ;
+      bool       calentado ; // true si ya se ha dibujado para calentar
+   } ;
+
+   std::vector<Entrada> entradas ;
+} ;
+
+#endif
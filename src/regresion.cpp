@@ -0,0 +1,171 @@
+// Pruebas de regresión: imágenes de referencia y presupuestos de tiempo por frame
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "regresion.h"
+#include "fbo-offscreen.h"
+#include "imagenes.h"
+#include "errores-gl.h"
+
+// ------------------------------------------------------------------------------------------------------
+// lee y escribe el archivo de presupuestos de tiempo: una línea por escena con su nombre y 
+// el tiempo por frame en milisegundos (las líneas que empiezan por '#' son comentarios)
+
+static std::map<std::string,double> LeerPresupuestos( const std::string & nombre_archivo )
+{
+   std::map<std::string,double> presupuestos ;
+   std::ifstream                archivo( nombre_archivo );
+   std::string                  linea ;
+
+   while( std::getline( archivo, linea ) )
+   {
+      if ( linea.empty() || linea[0] == '#' )
+         continue ;
+      std::istringstream is( linea );
+      std::string nombre ;
+      double      ms ;
+      if ( is >> nombre >> ms )
+         presupuestos[nombre] = ms ;
+   }
+   return presupuestos ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+static void EscribirPresupuestos( const std::string & nombre_archivo, 
+                                  const std::map<std::string,double> & presupuestos )
+{
+   std::ofstream archivo( nombre_archivo );
+   archivo << "# presupuestos de tiempo por frame (ms), escritos por '--regresion'" << std::endl ;
+   for( const auto & [nombre, ms] : presupuestos )
+      archivo << nombre << " " << std::fixed << std::setprecision(3) << ms << std::endl ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+unsigned EjecutarRegresion( const OpcionesRegresion & opciones, const std::vector<EscenaRegresion> & escenas,
+                            const std::function<void(int,int)> & dibujar )
+{
+   using namespace std ;
+   assert( 0 < opciones.frames_medidos );
+   CError();
+
+   std::filesystem::create_directories( opciones.carpeta );
+   const string nombre_presupuestos = opciones.carpeta + "/tiempos.txt" ;
+
+   map<string,double>   presupuestos = LeerPresupuestos( nombre_presupuestos );
+   bool                 presupuestos_cambiados = false ,
+                        faltan_referencias     = false ;
+   unsigned             num_fallos = 0 ;
+   FramebufferOffscreen fbo( opciones.ancho, opciones.alto );
+   Imagen               obtenida, referencia ;
+   vector<double>       tiempos ;
+
+   cout << "Prueba de regresión: " << escenas.size() << " escenas, referencias en '" << opciones.carpeta << "'"
+        << ( opciones.actualizar ? " (se actualizan)" : "" ) << "." << endl ;
+
+   fbo.activar();
+   for( const EscenaRegresion & escena : escenas )
+   {
+      escena.preparar();
+
+      // visualizar y medir (cada frame espera a la GPU, para medir el tiempo completo)
+      tiempos.clear();
+      for( unsigned i = 0 ; i < opciones.frames_calentamiento + opciones.frames_medidos ; i++ )
+      {
+         const auto inicio = chrono::steady_clock::now();
+         dibujar( opciones.ancho, opciones.alto );
+         glFinish();
+         const double ms = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+         if ( i >= opciones.frames_calentamiento )
+            tiempos.push_back( ms );
+      }
+      std::nth_element( tiempos.begin(), tiempos.begin() + tiempos.size()/2, tiempos.end() );
+      const double mediana = tiempos[tiempos.size()/2] ;
+      fbo.leerImagen( obtenida );
+
+      // comparar la imagen con la referencia (o crear la referencia)
+      const string nombre_ref = opciones.carpeta + "/" + escena.nombre + ".ppm" ;
+      bool         imagen_ok  = true ;
+      string       info_imagen ;
+
+      if ( opciones.actualizar )
+      {
+         EscribirPPM( nombre_ref, obtenida );
+         info_imagen = "referencia escrita" ;
+      }
+      else if ( ! LeerPPM( nombre_ref, referencia ) )
+      {
+         imagen_ok          = false ;
+         faltan_referencias = true ;
+         info_imagen        = "no hay imagen de referencia" ;
+      }
+      else if ( referencia.ancho != obtenida.ancho || referencia.alto != obtenida.alto )
+      {
+         imagen_ok   = false ;
+         info_imagen = "tamaño distinto al de la referencia" ;
+      }
+      else
+      {
+         const ComparacionImagenes comp = CompararImagenes( obtenida, referencia, opciones.tolerancia_canal );
+         const double fraccion = double( comp.num_distintos ) / ( double(obtenida.ancho)*obtenida.alto );
+         imagen_ok   = fraccion <= opciones.max_fraccion_distintos ;
+         info_imagen = to_string( comp.num_distintos ) + " pixels distintos, diferencia máxima " 
+                       + to_string( comp.max_diferencia );
+      }
+
+      // comparar el tiempo con el presupuesto (o fijar el presupuesto)
+      bool   tiempo_ok = true ;
+      string info_tiempo ;
+      auto   it = presupuestos.find( escena.nombre );
+      ostringstream os ;
+      os << fixed << setprecision(3) << mediana << " ms" ;
+
+      if ( opciones.actualizar )
+      {
+         presupuestos[escena.nombre] = mediana ;
+         presupuestos_cambiados      = true ;
+         os << " (presupuesto fijado)" ;
+      }
+      else if ( it == presupuestos.end() )
+      {
+         tiempo_ok          = false ;
+         faltan_referencias = true ;
+         os << " (no hay presupuesto)" ;
+      }
+      else 
+      {
+         const double limite = it->second * ( 1.0 + opciones.umbral_tiempo ) + opciones.margen_tiempo_ms ;
+         tiempo_ok = mediana <= limite ;
+         os << " (presupuesto " << it->second << " ms, límite " << limite << " ms)" ;
+      }
+      info_tiempo = os.str();
+
+      const bool ok = imagen_ok && tiempo_ok ;
+      if ( ! ok )
+         num_fallos++ ;
+      cout << "   " << ( ok ? "[ OK ]   " : "[FALLO]  " ) << setw(14) << left << escena.nombre << right
+           << " imagen: " << ( imagen_ok ? "" : "FALLO, " ) << info_imagen
+           << " -- tiempo: " << ( tiempo_ok ? "" : "FALLO, " ) << info_tiempo << endl ;
+
+      // guardar la imagen obtenida junto a la referencia, para poder compararlas
+      if ( ! imagen_ok )
+         EscribirPPM( opciones.carpeta + "/" + escena.nombre + "-obtenida.ppm", obtenida );
+   }
+   fbo.desactivar();
+
+   if ( presupuestos_cambiados )
+      EscribirPresupuestos( nombre_presupuestos, presupuestos );
+
+   cout << "Prueba de regresión terminada: " << ( escenas.size() - num_fallos ) << " de " << escenas.size() 
+        << " escenas correctas." << endl ;
+   if ( faltan_referencias )
+      cout << "Faltan referencias en '" << opciones.carpeta << "': se crean con '--actualizar-referencias'." << endl ;
+   CError();
+   return num_fallos ;
+}
+// ------------------------------------------------------------------------------------------------------
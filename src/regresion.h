@@ -0,0 +1,51 @@
+// Pruebas de regresión: imágenes de referencia y presupuestos de tiempo por frame
+
+#ifndef REGRESION_H
+#define REGRESION_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+// --------------------------------------------------------------------------------------------
+
+// Escena de la prueba de regresión: un nombre (que da nombre a la imagen de referencia
+// '<nombre>.ppm') y una función que fija las opciones de visualización de la escena
+//
+struct EscenaRegresion
+{
+   std::string           nombre ;
+   std::function<void()> preparar ;
+} ;
+
+// Opciones de la prueba de regresión
+//
+struct OpcionesRegresion
+{
+   std::string carpeta ;                       // carpeta con las referencias ('<escena>.ppm' y 'tiempos.txt')
+   unsigned    ancho = 512, alto = 512 ;       // tamaño del framebuffer offscreen
+   unsigned    frames_calentamiento = 5 ;      // frames que se visualizan antes de medir tiempos
+   unsigned    frames_medidos       = 31 ;     // frames medidos (se usa la mediana)
+   unsigned    tolerancia_canal     = 2 ;      // máxima diferencia admitida en un canal de un pixel
+   double      max_fraccion_distintos = 0.001 ; // máxima fracción de pixels distintos admitida
+   double      umbral_tiempo        = 0.25 ;   // máximo aumento relativo admitido sobre el presupuesto
+   double      margen_tiempo_ms     = 0.5 ;    // aumento absoluto admitido además del relativo (ruido de medida
+                                               // en escenas de muy poco tiempo por frame)
+   bool        actualizar           = false ;  // reescribir las referencias en lugar de comparar
+} ;
+
+// Visualiza cada escena en un framebuffer offscreen, la compara con su imagen de referencia 
+// y compara la mediana del tiempo por frame (con 'glFinish') con su presupuesto. Una escena sin
+// imagen de referencia o sin presupuesto falla (no se crean al compararlas); con 'actualizar' se
+// escriben las de todas las escenas. Informa en 'cout' del resultado de cada escena.
+//
+// @param opciones (OpcionesRegresion)         opciones de la prueba
+// @param escenas  (vector<EscenaRegresion>)   escenas a probar
+// @param dibujar  (function<void(int,int)>)   dibuja un frame con el viewport del tamaño dado
+//                                             (sin presentarlo), en el framebuffer activo
+// @return (unsigned) número de escenas que no superan la prueba (0 si todo es correcto)
+//
+unsigned EjecutarRegresion( const OpcionesRegresion & opciones, const std::vector<EscenaRegresion> & escenas,
+                            const std::function<void(int,int)> & dibujar );
+
+#endif
@@ -0,0 +1,119 @@
+// Resolución dinámica: visualizar a menor resolución que la ventana para no superar un tiempo por frame
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "resolucion-dinamica.h"
+#include "errores-gl.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+ResolucionDinamica::ResolucionDinamica( const double p_objetivo_ms, const float p_escala_min, const float p_escala_max )
+:  objetivo_ms( p_objetivo_ms ),
+   escala_min( p_escala_min ),
+   escala_max( p_escala_max ),
+   escala( p_escala_max )
+{
+   assert( 0.0 < objetivo_ms );
+   assert( 0.0f < escala_min && escala_min <= escala_max && escala_max <= 1.0f );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ResolucionDinamica::ajustarEscala( const double ms, const float escala_frame )
+{
+   constexpr double suavizado  = 0.25 ;  // peso de la nueva medición en el coste estimado
+   constexpr float  histeresis = 0.02f ; // diferencia mínima con la escala ideal para cambiarla
+
+   // tiempo que habría tardado el frame a escala 1 (proporcional al número de pixels)
+   const double coste = ms / double( escala_frame*escala_frame );
+   coste_ms = ( coste_ms < 0.0 ) ? coste : ( 1.0-suavizado )*coste_ms + suavizado*coste ;
+
+   // acercarse a la escala con la que el tiempo sería el objetivo (a medio camino, para no oscilar)
+   const float ideal = std::clamp( float( std::sqrt( objetivo_ms / std::max( coste_ms, 1e-6 ) ) ), escala_min, escala_max );
+   if ( std::fabs( ideal - escala ) > histeresis )
+      escala = std::clamp( escala + 0.5f*( ideal - escala ), escala_min, escala_max );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ResolucionDinamica::iniciarFrame( const int p_ancho_ventana, const int p_alto_ventana )
+{
+   CError();
+   if ( mediciones[0].consulta == 0 )
+      for( Medicion & m : mediciones )
+         glGenQueries( 1, &m.consulta );
+
+   // leer las mediciones ya disponibles, de la más antigua a la más reciente (si una no está
+   // disponible, las posteriores tampoco)
+   for( unsigned i = 0 ; i < num_consultas ; i++ )
+   {
+      Medicion & m = mediciones[ ( num_frame + i ) % num_consultas ] ;
+      if ( ! m.pendiente )
+         continue ;
+      GLint disponible = 0 ;
+      glGetQueryObjectiv( m.consulta, GL_QUERY_RESULT_AVAILABLE, &disponible );
+      if ( ! disponible )
+         break ;
+      GLuint64 ns = 0 ;
+      glGetQueryObjectui64v( m.consulta, GL_QUERY_RESULT, &ns );
+      m.pendiente = false ;
+      ajustarEscala( std::max( double( ns )*1e-6, m.cpu_ms ), m.escala );
+   }
+
+   // (re)crear el framebuffer con el tamaño de la ventana a la escala máxima
+   const int ancho = std::max( 1, p_ancho_ventana ),
+             alto  = std::max( 1, p_alto_ventana );
+   if ( fbo == nullptr || ancho != ancho_ventana || alto != alto_ventana )
+   {
+      delete fbo ;
+      ancho_ventana = ancho ;
+      alto_ventana  = alto ;
+      fbo = new FramebufferOffscreen( unsigned( std::ceil( escala_max*float( ancho ) ) ),
+                                      unsigned( std::ceil( escala_max*float( alto ) ) ) );
+   }
+   ancho_zona = std::clamp( int( std::lround( escala*float( ancho ) ) ), 1, int( fbo->leerAncho() ) );
+   alto_zona  = std::clamp( int( std::lround( escala*float( alto  ) ) ), 1, int( fbo->leerAlto()  ) );
+
+   // activar el framebuffer e iniciar la medición (si la consulta de este frame del anillo no se
+   // ha podido leer, la GPU va más de 'num_consultas' frames por detrás, y se descarta)
+   Medicion & m = mediciones[ num_frame % num_consultas ] ;
+   m.escala    = escala ;
+   m.cpu_ms    = 0.0 ;
+   m.pendiente = false ;
+   fbo->activar();
+   glBeginQuery( GL_TIME_ELAPSED, m.consulta );
+   CError();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ResolucionDinamica::terminarFrame()
+{
+   assert( fbo != nullptr );
+   glEndQuery( GL_TIME_ELAPSED );
+   mediciones[ num_frame % num_consultas ].pendiente = true ;
+   num_frame++ ;
+   fbo->copiarEnVentana( ancho_zona, alto_zona, ancho_ventana, alto_ventana );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void ResolucionDinamica::registrarTiempoCpu( const double ms )
+{
+   if ( num_frame > 0 )
+      mediciones[ ( num_frame-1 ) % num_consultas ].cpu_ms = ms ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+ResolucionDinamica::~ResolucionDinamica()
+{
+   CError();
+   delete fbo ;
+   if ( mediciones[0].consulta != 0 )
+      for( Medicion & m : mediciones )
+         glDeleteQueries( 1, &m.consulta );
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+// Resolución dinámica: visualizar a menor resolución que la ventana para no superar un tiempo por frame
+
+#ifndef RESOLUCION_DINAMICA_H
+#define RESOLUCION_DINAMICA_H
+
+#include <array>
+#include "glincludes.h"
+#include "fbo-offscreen.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Visualiza los frames en un framebuffer offscreen, en una zona de tamaño igual al de la
+// ventana multiplicado por una escala, y después la amplía a la ventana (con filtro bilineal).
+// El tiempo de la GPU de cada frame se mide con consultas GL_TIME_ELAPSED en un anillo de
+// varios frames (se leen cuando ya están disponibles, sin esperar a la GPU), y la escala se
+// ajusta para que el tiempo del frame se acerque al objetivo, dentro de unos límites. Como
+// tiempo del frame se usa el mayor entre el de la GPU y el de la CPU (con rasterización por
+// software, p.ej. 'llvmpipe', la rasterización se hace en la CPU al presentar el frame, y las
+// consultas no la miden).
+//
+// Se supone que el tiempo es proporcional al número de pixels (al cuadrado de la escala): con
+// cada medición se estima el tiempo que tardaría el frame a escala 1, y se suaviza entre frames.
+// La ampliación cuesta lo mismo que dibujar un rectángulo texturado del tamaño de la ventana,
+// así que solo compensa si la escena cuesta bastante más por pixel.
+//
+class ResolucionDinamica
+{
+   public:
+
+   // crea el objeto (el framebuffer y las consultas se crean en el primer frame)
+   //
+   // @param p_objetivo_ms  (double) tiempo objetivo de la GPU por frame, en milisegundos (>0)
+   // @param p_escala_min   (float)  escala mínima (en (0,1])
+   // @param p_escala_max   (float)  escala máxima (en [escala_min,1]), es la escala inicial
+   //
+   ResolucionDinamica( const double p_objetivo_ms, const float p_escala_min, const float p_escala_max );
+
+   // lee las mediciones de los frames anteriores que ya están disponibles y ajusta la escala,
+   // (re)crea el framebuffer si ha cambiado el tamaño de la ventana, lo activa e inicia la
+   // medición del frame (requiere un contexto OpenGL activo)
+   //
+   // @param ancho_ventana, alto_ventana (int) tamaño del framebuffer de la ventana, en pixels
+   //
+   void iniciarFrame( const int ancho_ventana, const int alto_ventana );
+
+   // termina la medición del frame y amplía la imagen a la ventana (el framebuffer por defecto
+   // queda activo)
+   void terminarFrame();
+
+   // registra el tiempo de la CPU del último frame terminado, incluyendo la presentación
+   // @param ms (double) tiempo en milisegundos
+   //
+   void registrarTiempoCpu( const double ms );
+
+   // tamaño de la zona donde hay que visualizar el frame actual (entre 'iniciarFrame' y 'terminarFrame')
+   inline int leerAncho() const { return ancho_zona ; }
+   inline int leerAlto()  const { return alto_zona ; }
+
+   // escala actual, y tiempo estimado de la GPU por frame a escala 1 (negativo si aún no hay mediciones)
+   inline float  leerEscala() const { return escala ; }
+   inline double leerCosteMs() const { return coste_ms ; }
+
+   // libera el framebuffer y las consultas
+   ~ResolucionDinamica();
+
+   private: // ---------------------------
+
+   // ajusta la escala con el tiempo medido en un frame visualizado con la escala 'escala_frame'
+   void ajustarEscala( const double ms, const float escala_frame );
+
+   static constexpr unsigned num_consultas = 4 ; // frames en el anillo de consultas
+
+   // entrada del anillo de consultas
+   struct Medicion
+   {
+      GLuint consulta  = 0 ;
+      float  escala    = 1.0f ;  // escala con la que se ha visualizado el frame medido
+      double cpu_ms    = 0.0 ;   // tiempo de la CPU del frame (si se ha registrado)
+      bool   pendiente = false ; // true si la consulta no se ha leído todavía
+   } ;
+
+   const double  objetivo_ms ;
+   const float   escala_min ,
+                 escala_max ;
+   float         escala ;
+   double        coste_ms      = -1.0 ; // tiempo estimado a escala 1 (suavizado)
+   int           ancho_ventana = 0 ,
+                 alto_ventana  = 0 ,
+                 ancho_zona    = 0 ,
+                 alto_zona     = 0 ;
+   FramebufferOffscreen *           fbo = nullptr ; // tamaño de la ventana por la escala máxima
+   std::array<Medicion,num_consultas> mediciones ;
+   unsigned long                    num_frame = 0 ;
+} ;
+
+#endif
@@ -0,0 +1,185 @@
+// Series temporales muy grandes: pirámide de mínimos y máximos y polilínea decimada por columnas de pixels
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "serie-temporal.h"
+#include "paralelo.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+SerieTemporal::SerieTemporal( std::vector<float> && p_muestras )
+:  muestras( std::move( p_muestras ))
+{
+   using namespace glm ;
+   ZONA_TRAZA( "SerieTemporal" );
+   assert( 2 <= muestras.size() );
+
+   // niveles de la pirámide, hasta el que tiene un solo bloque (los bloques incompletos del final
+   // no se guardan: las muestras que quedan fuera se recorren sueltas)
+   for( unsigned long num = muestras.size() >> log_bloque ; num > 0 ; num /= 2 )
+      niveles.emplace_back( num );
+
+   // nivel 0 con las muestras, y cada nivel con el anterior
+   if ( ! niveles.empty() )
+      ParaleloPara( niveles[0].size(), [this]( const unsigned long inicio, const unsigned long fin )
+      {
+         constexpr unsigned long tam_bloque = 1ul << log_bloque ;
+         for( unsigned long i = inicio ; i < fin ; i++ )
+         {
+            const float * m = muestras.data() + ( i << log_bloque );
+            vec2 r = { m[0], m[0] };
+            for( unsigned long j = 1 ; j < tam_bloque ; j++ )
+               r = { std::min( r.x, m[j] ), std::max( r.y, m[j] ) };
+            niveles[0][i] = r ;
+         }
+      }, 1ul << 15 );
+   for( size_t k = 1 ; k < niveles.size() ; k++ )
+   {
+      const std::vector<vec2> & anterior = niveles[k-1] ;
+      std::vector<vec2> &       nivel    = niveles[k] ;
+      ParaleloPara( nivel.size(), [&]( const unsigned long inicio, const unsigned long fin )
+      {
+         for( unsigned long i = inicio ; i < fin ; i++ )
+            nivel[i] = { std::min( anterior[2*i].x, anterior[2*i+1].x ), std::max( anterior[2*i].y, anterior[2*i+1].y ) };
+      }, 1ul << 16 );
+   }
+   min_max = minMax( 0, muestras.size() );
+}
+// ------------------------------------------------------------------------------------------------------
+
+glm::vec2 SerieTemporal::minMax( const unsigned long inicio, const unsigned long fin ) const
+{
+   assert( inicio < fin && fin <= muestras.size() );
+   constexpr unsigned long tam_bloque = 1ul << log_bloque ;
+
+   glm::vec2     r = { muestras[inicio], muestras[inicio] };
+   unsigned long i = inicio ;
+   const auto    agregar = [&r]( const float minimo, const float maximo )
+   {
+      r.x = std::min( r.x, minimo );
+      r.y = std::max( r.y, maximo );
+   };
+
+   // muestras sueltas hasta el primer bloque del nivel 0
+   for( const unsigned long alineado = std::min( fin, ( i + tam_bloque - 1 ) & ~( tam_bloque - 1 )) ; i < alineado ; i++ )
+      agregar( muestras[i], muestras[i] );
+
+   // bloques alineados: se sube de nivel mientras el bloque del nivel siguiente empieza en 'i' y
+   // cabe en el rango, y se baja cuando el bloque del nivel actual ya no cabe
+   size_t k = 0 ;
+   while ( i + tam_bloque <= fin )
+   {
+      while ( k+1 < niveles.size() && ( i & (( tam_bloque << (k+1) ) - 1 )) == 0 && i + ( tam_bloque << (k+1) ) <= fin )
+         k++ ;
+      while ( i + ( tam_bloque << k ) > fin )
+         k-- ;
+      const glm::vec2 & b = niveles[k][ i >> ( log_bloque + k ) ] ;
+      agregar( b.x, b.y );
+      i += tam_bloque << k ;
+   }
+
+   // muestras sueltas tras el último bloque
+   for( ; i < fin ; i++ )
+      agregar( muestras[i], muestras[i] );
+   return r ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+unsigned long SerieTemporal::decimar( const double inicio, const double fin, const unsigned ancho,
+                                      glm::vec2 * vertices ) const
+{
+   using namespace glm ;
+   assert( inicio < fin && 0 < ancho && vertices != nullptr );
+   const double        tam_rango = fin - inicio ,
+                       ultima    = double( muestras.size() - 1 );
+   unsigned long       num       = 0 ;
+
+   // pocas muestras por columna: las del rango (y la anterior y la siguiente, para llegar a los bordes)
+   if ( tam_rango <= 2.0*ancho )
+   {
+      const unsigned long primera = (unsigned long) std::clamp( std::floor( inicio ), 0.0, ultima ),
+                          final   = (unsigned long) std::clamp( std::ceil( fin ), 0.0, ultima );
+      for( unsigned long i = primera ; i <= final ; i++ )
+         vertices[num++] = { float( double( i ) - inicio ), muestras[i] };
+      return num ;
+   }
+
+   // si no, el mínimo y el máximo de cada columna (las muestras [floor(t0),floor(t1)) de su
+   // intervalo [t0,t1)), primero el más cercano al último vértice, así los segmentos entre
+   // columnas son cortos
+   const double por_columna = tam_rango/double( ancho ),
+                tam        = double( muestras.size() );
+   for( unsigned c = 0 ; c < ancho ; c++ )
+   {
+      const double        t0 = inicio + double( c )*por_columna ;
+      const unsigned long a  = (unsigned long) std::clamp( std::floor( t0 ), 0.0, tam ),
+                          b  = (unsigned long) std::clamp( std::floor( t0 + por_columna ), 0.0, tam );
+      if ( b <= a )
+         continue ;
+      const vec2  mm          = minMax( a, b );
+      const float x           = float( ( double( c ) + 0.5 )*por_columna );
+      const bool  max_primero = num > 0 && std::abs( vertices[num-1].y - mm.y ) < std::abs( vertices[num-1].y - mm.x );
+      vertices[num++] = { x, max_primero ? mm.y : mm.x };
+      vertices[num++] = { x, max_primero ? mm.x : mm.y };
+   }
+   return num ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void SerieTemporal::visualizar( Cauce & cauce, const double inicio, const double fin, const int ancho )
+{
+   using namespace glm ;
+   ZONA_TRAZA( "SerieTemporal::visualizar" );
+   assert( inicio < fin && 0 < ancho );
+
+   // (re)crear el VAO si no tiene capacidad para el ancho (los vértices se escriben al decimar)
+   if ( vao == nullptr || capacidad < maxVertices( unsigned( ancho )) )
+   {
+      delete vao ;
+      capacidad = maxVertices( unsigned( ancho ));
+      DescrVBOAtribs * posiciones = new DescrVBOAtribs( Cauce::ind_atrib_posiciones, GL_FLOAT, 2, GLsizei( capacidad ));
+      std::fill_n( (vec2 *) posiciones->leerPunteroDatos(), capacidad, vec2( 0.0f, 0.0f ));
+      vao       = new DescrVAO( Cauce::num_atribs, posiciones );
+      ancho_vao = 0 ;
+   }
+
+   // decimar solo si ha cambiado la vista (se envían a la GPU los vértices de la capacidad, que
+   // dependen del ancho, no de las muestras)
+   if ( inicio != inicio_vao || fin != fin_vao || unsigned( ancho ) != ancho_vao )
+   {
+      ZONA_TRAZA( "SerieTemporal::decimar" );
+      vec2 * vertices = (vec2 *) vao->modificarAtrib( Cauce::ind_atrib_posiciones, 0, capacidad );
+      num_vertices = decimar( inicio, fin, unsigned( ancho ), vertices );
+      inicio_vao   = inicio ;
+      fin_vao      = fin ;
+      ancho_vao    = unsigned( ancho );
+      num_decimaciones++ ;
+   }
+
+   // x en [0,fin-inicio] a [-1,1], y entre el mínimo y el máximo a [-0.9,0.9]
+   const float alto_valores = std::max( 1e-20f, min_max.y - min_max.x );
+   cauce.pushMM();
+      cauce.compMM( translate( vec3( -1.0f, -0.9f, 0.0f ))
+                  * scale( vec3( float( 2.0/( fin - inicio )), 1.8f/alto_valores, 1.0f ))
+                  * translate( vec3( 0.0f, -min_max.x, 0.0f )) );
+      vao->draw( GL_LINE_STRIP, GLsizei( num_vertices ));
+   cauce.popMM();
+}
+// ------------------------------------------------------------------------------------------------------
+
+unsigned long SerieTemporal::leerBytesPiramide() const
+{
+   unsigned long bytes = 0 ;
+   for( const std::vector<glm::vec2> & nivel : niveles )
+      bytes += nivel.size()*sizeof( glm::vec2 );
+   return bytes ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+SerieTemporal::~SerieTemporal()
+{
+   delete vao ;
+}
+// ------------------------------------------------------------------------------------------------------
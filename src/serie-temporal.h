@@ -0,0 +1,98 @@
+// Series temporales muy grandes: pirámide de mínimos y máximos y polilínea decimada por columnas de pixels
+
+#ifndef SERIE_TEMPORAL_H
+#define SERIE_TEMPORAL_H
+
+#include <vector>
+#include "glincludes.h"
+#include "cauce.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Serie de muestras equiespaciadas (el tiempo de cada una es su índice) que se visualiza como una
+// polilínea (GL_LINE_STRIP) sin dibujar todas sus muestras: para un rango visible y un ancho en
+// pixels, si hay más de dos muestras por columna de pixels se dibujan, en cada columna, un
+// vértice en el mínimo y otro en el máximo de sus muestras (los pixels que cubriría la polilínea
+// completa), y si no, las muestras del rango. Así la polilínea tiene como mucho unos dos
+// vértices por columna, sea cual sea el número de muestras visibles.
+//
+// Los mínimos y máximos salen de una pirámide que se construye al crear la serie: el nivel 0 tiene
+// el mínimo y el máximo de cada bloque de 8 muestras, y cada nivel los de los pares de bloques
+// del anterior (ocupa la mitad que las muestras). El rango de una columna se descompone en bloques
+// alineados de la pirámide (como mucho dos por nivel, y algunas muestras sueltas en los extremos),
+// así que decimar cuesta O(pixels) (por el logaritmo de las muestras por columna), no O(muestras).
+//
+class SerieTemporal
+{
+   public:
+
+   // crea la serie y construye su pirámide (en varios hilos)
+   //
+   // @param p_muestras (vector<float> &&) muestras de la serie (se toman, sin copiarlas; al menos 2)
+   //
+   SerieTemporal( std::vector<float> && p_muestras );
+
+   // devuelve el mínimo (en x) y el máximo (en y) de las muestras [inicio,fin)
+   //
+   // @param inicio, fin (unsigned long) rango de muestras (inicio < fin <= número de muestras)
+   //
+   glm::vec2 minMax( const unsigned long inicio, const unsigned long fin ) const ;
+
+   // escribe la polilínea decimada del rango [inicio,fin] de la serie para 'ancho' columnas de
+   // pixels: vértices (x,y) con 'x' el tiempo relativo a 'inicio' (en muestras, así conserva
+   // la precisión en series largas) e 'y' el valor
+   //
+   // @param inicio, fin (double)   rango visible de la serie, en muestras (inicio < fin)
+   // @param ancho       (unsigned) número de columnas de pixels (>0)
+   // @param vertices    (vec2 *)   tabla donde escribir (al menos 'maxVertices( ancho )' vértices)
+   // @return (unsigned long) número de vértices escritos
+   //
+   unsigned long decimar( const double inicio, const double fin, const unsigned ancho, glm::vec2 * vertices ) const ;
+
+   // máximo número de vértices que escribe 'decimar' para un ancho
+   static inline unsigned long maxVertices( const unsigned ancho ) { return 2ul*ancho + 4 ; }
+
+   // dibuja el rango [inicio,fin] de la serie en todo el ancho del viewport (con las matrices de
+   // proyección y vista identidad), con los valores entre el mínimo y el máximo de la serie en
+   // [-0.9,0.9]. Solo vuelve a decimar si ha cambiado el rango o el ancho.
+   //
+   // @param cauce       (Cauce &) cauce con el que dibujar (usa su color y su matriz de modelado)
+   // @param inicio, fin (double)  rango visible de la serie, en muestras (inicio < fin)
+   // @param ancho       (int)     ancho del viewport en pixels (>0)
+   //
+   void visualizar( Cauce & cauce, const double inicio, const double fin, const int ancho );
+
+   // número de muestras, número de niveles y bytes de la pirámide, y mínimo y máximo de la serie
+   inline unsigned long leerNumMuestras() const { return muestras.size() ; }
+   inline unsigned      leerNumNiveles()  const { return unsigned( niveles.size() ) ; }
+   unsigned long        leerBytesPiramide() const ;
+   inline glm::vec2     leerMinMax()      const { return min_max ; }
+
+   // número de vértices dibujados en el último frame, y veces que se ha decimado
+   inline unsigned long leerNumVertices()     const { return num_vertices ; }
+   inline unsigned long leerNumDecimaciones() const { return num_decimaciones ; }
+
+   // libera el VAO
+   ~SerieTemporal();
+
+   private: // ---------------------------
+
+   static constexpr unsigned log_bloque = 3 ; // logaritmo en base 2 del tamaño de los bloques del nivel 0
+
+   std::vector<float>                   muestras ;
+   std::vector<std::vector<glm::vec2>>  niveles ;   // pirámide: mínimo y máximo de cada bloque de cada nivel
+   glm::vec2                            min_max ;   // mínimo y máximo de toda la serie
+
+   // VAO con la polilínea decimada (con capacidad para 'capacidad' vértices, se vuelve a crear
+   // si el ancho necesita más) y rango y ancho con los que se ha decimado
+   DescrVAO *    vao          = nullptr ;
+   unsigned long capacidad    = 0 ,
+                 num_vertices = 0 ,
+                 num_decimaciones = 0 ;
+   double        inicio_vao   = 0.0 ,
+                 fin_vao      = 0.0 ;
+   unsigned      ancho_vao    = 0 ;
+} ;
+
+#endif
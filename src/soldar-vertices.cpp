@@ -0,0 +1,269 @@
+// Soldadura de vértices: construcción de un VAO indexado sin vértices repetidos
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+#include "soldar-vertices.h"
+#include "paralelo.h"
+#include "traza.h"
+
+// ------------------------------------------------------------------------------------------------------
+// Número de fragmentos en los que se reparte la tabla de vértices únicos (potencia de 2): cada
+// fragmento contiene los vértices cuyo hash tiene en los bits altos el número del fragmento, y
+// cada fragmento lo procesa un único hilo, sin necesidad de sincronización.
+
+constexpr unsigned bits_fragmentos = 6 ,
+                   num_fragmentos  = 1u << bits_fragmentos ;
+
+// ------------------------------------------------------------------------------------------------------
+// Acceso a los valores de todas las tablas de atributos de un VAO, vistos como una secuencia de
+// componentes enteras de 64 bits por vértice (cuantizadas o con el patrón de bits del valor).
+
+class ClavesVertices
+{
+   public:
+
+   ClavesVertices( const DescrVAO & vao, const float p_epsilon ) ;
+
+   // hash de todas las componentes del vértice 'v'
+   uint64_t hash( const unsigned long v ) const ;
+
+   // true si los vértices 'a' y 'b' tienen las mismas componentes
+   bool iguales( const unsigned long a, const unsigned long b ) const ;
+
+   private:
+
+   struct Tabla
+   {
+      const unsigned char * datos ;    // datos de la tabla
+      GLenum                type ;     // GL_FLOAT o GL_DOUBLE
+      unsigned              size ;     // valores por tupla
+      unsigned long         bytes ;    // bytes por tupla
+      bool                  cuantizar ; // true para las posiciones si 'epsilon' > 0
+   } ;
+
+   // componente 'c' del vértice 'v' en la tabla 't'
+   uint64_t componente( const Tabla & t, const unsigned long v, const unsigned c ) const ;
+
+   std::vector<Tabla> tablas ;
+   double             inv_epsilon = 0.0 ;
+} ;
+
+// ------------------------------------------------------------------------------------------------------
+
+ClavesVertices::ClavesVertices( const DescrVAO & vao, const float p_epsilon )
+{
+   assert( 0.0f <= p_epsilon );
+   if ( p_epsilon > 0.0f )
+      inv_epsilon = 1.0/double(p_epsilon) ;
+
+   for( unsigned i = 0 ; i < vao.leerNumAtribs() ; i++ )
+   {
+      if ( ! vao.tieneAtrib( i ) )
+         continue ;
+      const DescrVBOAtribs * dvbo = vao.leerDescrAtrib( i );
+      assert( dvbo->leerType() == GL_FLOAT || dvbo->leerType() == GL_DOUBLE );
+      assert( dvbo->leerDatos() != nullptr );
+
+      const unsigned long tam = ( dvbo->leerType() == GL_FLOAT ) ? sizeof(float) : sizeof(double) ;
+      tablas.push_back( { (const unsigned char *) dvbo->leerDatos(), dvbo->leerType(),
+                          (unsigned) dvbo->leerSize(), tam*dvbo->leerSize(),
+                          i == 0 && p_epsilon > 0.0f } );
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+
+inline uint64_t ClavesVertices::componente( const Tabla & t, const unsigned long v, const unsigned c ) const
+{
+   const unsigned char * p = t.datos + v*t.bytes ;
+   double valor ;
+   if ( t.type == GL_FLOAT )
+   {
+      float f ;
+      std::memcpy( &f, p + c*sizeof(float), sizeof(float) );
+      if ( ! t.cuantizar )
+      {
+         uint32_t bits ;
+         f = ( f == 0.0f ) ? 0.0f : f ; // -0.0 igual a 0.0
+         std::memcpy( &bits, &f, sizeof(f) );
+         return bits ;
+      }
+      valor = f ;
+   }
+   else
+   {
+      std::memcpy( &valor, p + c*sizeof(double), sizeof(double) );
+      if ( ! t.cuantizar )
+      {
+         uint64_t bits ;
+         valor = ( valor == 0.0 ) ? 0.0 : valor ;
+         std::memcpy( &bits, &valor, sizeof(valor) );
+         return bits ;
+      }
+   }
+   return (uint64_t) std::llround( valor*inv_epsilon );
+}
+// ------------------------------------------------------------------------------------------------------
+
+uint64_t ClavesVertices::hash( const unsigned long v ) const
+{
+   uint64_t h = 0x9E3779B97F4A7C15ull ;
+   for( const Tabla & t : tablas )
+      for( unsigned c = 0 ; c < t.size ; c++ )
+      {
+         h = ( h ^ componente( t, v, c ) ) * 0xFF51AFD7ED558CCDull ;
+         h ^= h >> 32 ;
+      }
+   // mezcla final (de 'MurmurHash3'), para que los bits altos dependan de todos los valores
+   h ^= h >> 33 ;  h *= 0xC4CEB9FE1A85EC53ull ;  h ^= h >> 33 ;
+   return h ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool ClavesVertices::iguales( const unsigned long a, const unsigned long b ) const
+{
+   for( const Tabla & t : tablas )
+      for( unsigned c = 0 ; c < t.size ; c++ )
+         if ( componente( t, a, c ) != componente( t, b, c ) )
+            return false ;
+   return true ;
+}
+// ------------------------------------------------------------------------------------------------------
+// Lee el índice 'i' de una tabla de índices (o devuelve 'i' si no hay tabla)
+
+static inline GLuint LeerIndice( const DescrVBOInds * dvbo_ind, const unsigned long i )
+{
+   return ( dvbo_ind != nullptr ) ? dvbo_ind->leerIndice( i ) : GLuint( i ) ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * SoldarVertices( const DescrVAO & vao, const float epsilon, EstadisticasSoldadura * estadisticas )
+{
+   using namespace std ;
+   ZONA_TRAZA( "SoldarVertices" );
+   const auto inicio = chrono::steady_clock::now();
+
+   const unsigned long    n = vao.leerNumVertices() ;
+   const ClavesVertices   claves( vao, epsilon );
+   assert( 0 < n && n < 0xFFFFFFFFul );
+
+   // 1. calcular el hash de cada vértice (en paralelo)
+   vector<uint64_t> hashes( n );
+   ParaleloPara( n, [&]( const unsigned long v0, const unsigned long v1 )
+   {
+      for( unsigned long v = v0 ; v < v1 ; v++ )
+         hashes[v] = claves.hash( v );
+   } );
+
+   // 2. buscar el representante de cada vértice (la primera aparición de sus valores): cada
+   //    hilo recorre los vértices en orden y procesa solo los de sus fragmentos
+   vector<GLuint> representante( n );
+   ParaleloPara( num_fragmentos, [&]( const unsigned long f0, const unsigned long f1 )
+   {
+      unordered_multimap<uint64_t,GLuint> unicos ;
+      unicos.reserve( 2*n*(f1-f0)/num_fragmentos + 16 );
+      for( unsigned long v = 0 ; v < n ; v++ )
+      {
+         const unsigned long f = hashes[v] >> ( 64 - bits_fragmentos );
+         if ( f < f0 || f1 <= f )
+            continue ;
+         GLuint rep = GLuint( v );
+         const auto rango = unicos.equal_range( hashes[v] );
+         for( auto it = rango.first ; it != rango.second ; ++it )
+            if ( claves.iguales( it->second, v ) )
+            {
+               rep = it->second ;
+               break ;
+            }
+         if ( rep == v )
+            unicos.emplace( hashes[v], rep );
+         representante[v] = rep ;
+      }
+   }, 1 );
+
+   // 3. numerar los vértices únicos en orden (secuencial: el representante siempre es anterior)
+   vector<GLuint> nuevo_indice( n ), original ;
+   original.reserve( n );
+   for( unsigned long v = 0 ; v < n ; v++ )
+   {
+      if ( representante[v] == v )
+      {
+         nuevo_indice[v] = GLuint( original.size() );
+         original.push_back( GLuint( v ) );
+      }
+      else
+         nuevo_indice[v] = nuevo_indice[ representante[v] ];
+   }
+   const unsigned long m = original.size() ;
+
+   // 4. copiar las tuplas de los vértices únicos en las tablas nuevas (en paralelo)
+   DescrVAO * resultado = nullptr ;
+   for( unsigned i = 0 ; i < vao.leerNumAtribs() ; i++ )
+   {
+      if ( ! vao.tieneAtrib( i ) )
+         continue ;
+      const DescrVBOAtribs * dvbo  = vao.leerDescrAtrib( i );
+      DescrVBOAtribs *       nuevo = new DescrVBOAtribs( i, dvbo->leerType(), dvbo->leerSize(), m );
+
+      const unsigned long   bytes   = dvbo->leerSize()*( dvbo->leerType() == GL_FLOAT ? sizeof(float) : sizeof(double) );
+      const unsigned char * origen  = (const unsigned char *) dvbo->leerDatos();
+      unsigned char *       destino = (unsigned char *) nuevo->leerPunteroDatos();
+      ParaleloPara( m, [&]( const unsigned long u0, const unsigned long u1 )
+      {
+         for( unsigned long u = u0 ; u < u1 ; u++ )
+            std::memcpy( destino + u*bytes, origen + original[u]*bytes, bytes );
+      } );
+
+      if ( resultado == nullptr )
+         resultado = new DescrVAO( vao.leerNumAtribs(), nuevo );
+      else
+         resultado->agregar( nuevo );
+   }
+
+   // 5. traducir los índices originales (o la secuencia 0..n-1 si no es indexado)
+   const DescrVBOInds * dvbo_ind  = vao.leerDescrIndices();
+   const unsigned long  num_inds  = ( dvbo_ind != nullptr ) ? dvbo_ind->leerCount() : n ;
+   DescrVBOInds *       nuevo_ind = new DescrVBOInds( GL_UNSIGNED_INT, num_inds );
+   GLuint *             inds      = (GLuint *) nuevo_ind->leerPunteroIndices();
+   constexpr GLuint     reinicio  = 0xFFFFFFFFu ;
+
+   ParaleloPara( num_inds, [&]( const unsigned long i0, const unsigned long i1 )
+   {
+      for( unsigned long i = i0 ; i < i1 ; i++ )
+      {
+         if ( dvbo_ind == nullptr )
+            inds[i] = nuevo_indice[i] ;
+         else
+         {
+            const GLuint ind = LeerIndice( dvbo_ind, i );
+            if ( dvbo_ind->usaReinicio() && ind == dvbo_ind->leerIndiceReinicio() )
+               inds[i] = reinicio ;
+            else
+            {
+               assert( ind < n );
+               inds[i] = nuevo_indice[ind] ;
+            }
+         }
+      }
+   } );
+   if ( dvbo_ind != nullptr && dvbo_ind->usaReinicio() )
+      nuevo_ind->fijarIndiceReinicio( reinicio );
+   resultado->agregar( nuevo_ind );
+
+   // informar del resultado
+   EstadisticasSoldadura estad ;
+   estad.num_vertices_entrada = n ;
+   estad.num_vertices_salida  = m ;
+   estad.num_indices          = num_inds ;
+   estad.ms                   = chrono::duration<double,milli>( chrono::steady_clock::now() - inicio ).count();
+   if ( estadisticas != nullptr )
+      *estadisticas = estad ;
+
+   cout << "Soldadura de vértices: " << n << " -> " << m << " vértices (ratio " << fixed << setprecision(2)
+        << estad.ratio() << ":1, " << setprecision(1) << 100.0*(1.0 - double(m)/double(n))
+        << "% menos), " << num_inds << " índices (" << estad.ms << " ms, " << NumHilosParalelo()
+        << " hilos)." << defaultfloat << endl ;
+   return resultado ;
+}
@@ -0,0 +1,47 @@
+// Soldadura de vértices: construcción de un VAO indexado sin vértices repetidos
+
+#ifndef SOLDAR_VERTICES_H
+#define SOLDAR_VERTICES_H
+
+#include "glincludes.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+// Estadísticas de una soldadura de vértices
+
+struct EstadisticasSoldadura
+{
+   unsigned long num_vertices_entrada = 0 , // vértices del VAO original
+                 num_vertices_salida  = 0 , // vértices distintos (los del VAO soldado)
+                 num_indices          = 0 ; // índices del VAO soldado
+   double        ms                   = 0.0 ; // tiempo empleado, en milisegundos
+
+   // ratio de compresión de las tablas de atributos (entrada/salida)
+   inline double ratio() const 
+   { return num_vertices_salida > 0 ? double(num_vertices_entrada)/double(num_vertices_salida) : 1.0 ; }
+} ;
+
+// --------------------------------------------------------------------------------------------
+// Crea un VAO indexado nuevo a partir de otro VAO (indexado o no, por ejemplo una 'sopa' de 
+// triángulos), de forma que dos vértices con los mismos valores en todas sus tablas de atributos
+// se unen en uno solo. Cada vértice del resultado es la primera aparición en 'vao' de su grupo,
+// y los vértices conservan el orden relativo de la entrada. El VAO original no se modifica 
+// (sus tablas deben seguir en la memoria de la aplicación).
+//
+// Si 'epsilon' es mayor que cero, las coordenadas de las posiciones se comparan cuantizadas a 
+// una rejilla de lado 'epsilon' (se unen los vértices que caen en la misma celda, aunque dos 
+// vértices a menos de 'epsilon' en celdas vecinas no se unen). El resto de atributos se comparan 
+// siempre de forma exacta (0.0 y -0.0 se consideran iguales).
+//
+// El cálculo de claves y la búsqueda de duplicados se reparten entre varios hilos, y se 
+// informa en 'cout' del ratio de compresión obtenido.
+//
+// @param vao         (const DescrVAO &)        VAO de entrada
+// @param epsilon     (float)                   lado de la rejilla para las posiciones (0 = exacto)
+// @param estadisticas (EstadisticasSoldadura *) si no es nulo, se escriben ahí las estadísticas
+// @return (DescrVAO *) VAO nuevo indexado con GL_UNSIGNED_INT (el llamador lo debe destruir)
+//
+DescrVAO * SoldarVertices( const DescrVAO & vao, const float epsilon = 0.0f, 
+                           EstadisticasSoldadura * estadisticas = nullptr );
+
+#endif
@@ -0,0 +1,74 @@
+// Texturas 2D (RGBA8 con mipmaps)
+
+#include <vector>
+#include "textura.h"
+#include "errores-gl.h"
+
+// ------------------------------------------------------------------------------------------------------
+
+Textura::Textura( const std::string & p_nombre )
+:  nombre( p_nombre )
+{
+}
+// ------------------------------------------------------------------------------------------------------
+
+Textura::Textura( const std::string & p_nombre, const Imagen & imagen )
+:  nombre( p_nombre )
+{
+   assert( 0 < imagen.ancho && 0 < imagen.alto );
+   crear( imagen.ancho, imagen.alto );
+
+   // OpenGL espera la fila inferior primero: se invierten las filas al pasar a RGBA
+   std::vector<unsigned char> rgba( 4ul*ancho*alto );
+   for( unsigned y = 0 ; y < alto ; y++ )
+   {
+      const unsigned char * org = imagen.fila( alto-1-y );
+      unsigned char *       dst = rgba.data() + 4ul*ancho*y ;
+      for( unsigned x = 0 ; x < ancho ; x++ )
+      {
+         dst[4*x+0] = org[3*x+0] ;  dst[4*x+1] = org[3*x+1] ;
+         dst[4*x+2] = org[3*x+2] ;  dst[4*x+3] = 255 ;
+      }
+   }
+   glBindTexture( GL_TEXTURE_2D, id );
+   glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, ancho, alto, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data() );
+   terminar();
+}
+// ------------------------------------------------------------------------------------------------------
+
+void Textura::crear( const unsigned p_ancho, const unsigned p_alto )
+{
+   assert( id == 0 );
+   assert( 0 < p_ancho && 0 < p_alto );
+   CError();
+
+   ancho = p_ancho ;
+   alto  = p_alto ;
+   glGenTextures( 1, &id ); assert( 0 < id );
+   glBindTexture( GL_TEXTURE_2D, id );
+   glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, ancho, alto, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+   glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+   glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+   glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+   glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
+
+void Textura::terminar()
+{
+   assert( 0 < id && ! es_lista );
+   CError();
+   glBindTexture( GL_TEXTURE_2D, id );
+   glGenerateMipmap( GL_TEXTURE_2D );
+   glBindTexture( GL_TEXTURE_2D, 0 );
+   es_lista = true ;
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
+
+Textura::~Textura()
+{
+   if ( id != 0 )
+      glDeleteTextures( 1, &id );
+}
@@ -0,0 +1,64 @@
+// Texturas 2D (RGBA8 con mipmaps)
+
+#ifndef TEXTURA_H
+#define TEXTURA_H
+
+#include <string>
+#include "glincludes.h"
+#include "imagenes.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Textura 2D RGBA8 con mipmaps generados en la GPU y filtrado trilineal. Se puede crear a 
+// partir de una imagen en memoria (se sube en la llamada), o vacía y sin lista (la rellena 
+// poco a poco un 'CargadorTexturas'). Mientras no está lista, el cauce dibuja sin textura.
+//
+class Textura
+{
+   public:
+
+   // crea una textura sin lista (sin objeto textura de OpenGL, la crea el cargador)
+   // @param p_nombre (string) nombre de la textura (para los mensajes)
+   //
+   Textura( const std::string & p_nombre );
+
+   // crea la textura y sube la imagen en esta llamada, genera los mipmaps (requiere contexto OpenGL)
+   // @param p_nombre (string) nombre de la textura (para los mensajes)
+   // @param imagen   (Imagen) imagen RGB (la fila 0 es la superior, se ve arriba con la coord. T=1)
+   //
+   Textura( const std::string & p_nombre, const Imagen & imagen );
+
+   // true si la textura se puede usar para visualizar (todos los niveles están subidos)
+   inline bool lista() const { return es_lista ; }
+
+   // devuelve el nombre del objeto textura de OpenGL (0 si todavía no se ha creado)
+   inline GLuint leerId() const { return id ; }
+
+   // devuelve el nombre de la textura
+   inline const std::string & leerNombre() const { return nombre ; }
+
+   // devuelve el tamaño del nivel 0 en pixels
+   inline unsigned leerAncho() const { return ancho ; }
+   inline unsigned leerAlto() const { return alto ; }
+
+   // libera el objeto textura de OpenGL (si se ha creado)
+   ~Textura();
+
+   private: // ---------------------------
+
+   friend class CargadorTexturas ;
+
+   // crea el objeto textura con el nivel 0 sin inicializar, y fija los parámetros de filtrado
+   void crear( const unsigned p_ancho, const unsigned p_alto );
+
+   // genera los mipmaps a partir del nivel 0 y deja la textura lista
+   void terminar();
+
+   std::string nombre ;
+   GLuint      id       = 0 ;
+   unsigned    ancho    = 0 ,
+               alto     = 0 ;
+   bool        es_lista = false ;
+} ;
+
+#endif
@@ -0,0 +1,228 @@
+// Conversión de tablas de triángulos en tiras de triángulos con reinicio de primitiva
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include "tiras-triangulos.h"
+
+// ------------------------------------------------------------------------------------------------------
+// arista orientada (a->b) de un triángulo, codificada en un entero de 64 bits, con el
+// triángulo al que pertenece
+
+struct AristaTri
+{
+   uint64_t clave ;     // (a << 32) | b
+   unsigned triangulo ; // índice del triángulo que tiene la arista a->b
+} ;
+
+inline uint64_t ClaveArista( const unsigned a, const unsigned b )
+{
+   return ( uint64_t(a) << 32 ) | uint64_t(b) ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+// Clase auxiliar con la tabla de aristas orientadas y el estado de la conversión
+
+class GeneradorTiras
+{
+   public:
+
+   GeneradorTiras( const std::vector<glm::uvec3> & p_triangulos ) ;
+
+   // genera las tiras, añadiéndolas a 'salida' separadas por 'ind_reinicio'
+   void generar( const unsigned ind_reinicio, std::vector<unsigned> & salida, unsigned long & num_tiras );
+
+   private:
+
+   const std::vector<glm::uvec3> & triangulos ;
+   std::vector<AristaTri>          aristas ; // aristas orientadas, ordenadas por clave
+   std::vector<bool>               usado ;   // true para los triángulos ya incluidos en alguna tira
+   std::vector<unsigned>           marca ;   // marca de los triángulos incluidos en la tira de prueba actual
+   unsigned                        marca_actual = 0 ;
+
+   // busca un triángulo no usado (y no marcado) con la arista a->b, devuelve su tercer vértice en 'w'
+   bool buscarVecino( const unsigned a, const unsigned b, unsigned & tri, unsigned & w ) const ;
+
+   // construye la tira que empieza en el triángulo 't', con su rotación 'rot' (0,1 o 2),
+   // dejando los triángulos en 'tris' y los índices en 'tira' (no marca los triángulos como usados)
+   void construirTira( const unsigned t, const unsigned rot, std::vector<unsigned> & tira,
+                       std::vector<unsigned> & tris ) ;
+} ;
+
+// ------------------------------------------------------------------------------------------------------
+
+GeneradorTiras::GeneradorTiras( const std::vector<glm::uvec3> & p_triangulos )
+:  triangulos( p_triangulos )
+{
+   const unsigned n = triangulos.size() ;
+
+   aristas.reserve( 3*n );
+   for( unsigned t = 0 ; t < n ; t++ )
+      for( unsigned i = 0 ; i < 3 ; i++ )
+         aristas.push_back( { ClaveArista( triangulos[t][i], triangulos[t][(i+1)%3] ), t } );
+
+   std::sort( aristas.begin(), aristas.end(), []( const AristaTri & x, const AristaTri & y )
+              {  return x.clave < y.clave || ( x.clave == y.clave && x.triangulo < y.triangulo ) ; } );
+
+   usado.resize( n, false );
+   marca.resize( n, 0 );
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+bool GeneradorTiras::buscarVecino( const unsigned a, const unsigned b, unsigned & tri, unsigned & w ) const
+{
+   const uint64_t clave = ClaveArista( a, b );
+   auto it = std::lower_bound( aristas.begin(), aristas.end(), clave,
+                               []( const AristaTri & x, const uint64_t c ) { return x.clave < c ; } );
+
+   for( ; it != aristas.end() && it->clave == clave ; ++it )
+   {
+      const unsigned t = it->triangulo ;
+      if ( usado[t] || marca[t] == marca_actual )
+         continue ;
+      const glm::uvec3 & v = triangulos[t] ;
+      for( unsigned i = 0 ; i < 3 ; i++ )
+         if ( v[i] == a && v[(i+1)%3] == b )
+         {
+            tri = t ;
+            w   = v[(i+2)%3] ;
+            return true ;
+         }
+   }
+   return false ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+// La tira s0,s1,s2,... produce los triángulos (s[k],s[k+1],s[k+2]) para 'k' par y
+// (s[k+1],s[k],s[k+2]) para 'k' impar. En ambos casos el triángulo 'k' tiene la arista
+// orientada x->y (con x,y los dos primeros vértices) y el nuevo vértice s[k+2].
+
+void GeneradorTiras::construirTira( const unsigned t, const unsigned rot, std::vector<unsigned> & tira,
+                                    std::vector<unsigned> & tris )
+{
+   marca_actual++ ;
+   tira.clear();
+   tris.clear();
+
+   const glm::uvec3 & v = triangulos[t] ;
+   tira.push_back( v[rot] );
+   tira.push_back( v[(rot+1)%3] );
+   tira.push_back( v[(rot+2)%3] );
+   tris.push_back( t );
+   marca[t] = marca_actual ;
+
+   for( unsigned k = 1 ; ; k++ )
+   {
+      const unsigned x = ( k % 2 == 0 ) ? tira[k]   : tira[k+1],
+                     y = ( k % 2 == 0 ) ? tira[k+1] : tira[k] ;
+      unsigned tri, w ;
+      if ( ! buscarVecino( x, y, tri, w ) )
+         break ;
+      tira.push_back( w );
+      tris.push_back( tri );
+      marca[tri] = marca_actual ;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void GeneradorTiras::generar( const unsigned ind_reinicio, std::vector<unsigned> & salida,
+                              unsigned long & num_tiras )
+{
+   std::vector<unsigned> tira, tris, mejor_tira, mejor_tris ;
+   num_tiras = 0 ;
+
+   for( unsigned t = 0 ; t < triangulos.size() ; t++ )
+   {
+      if ( usado[t] )
+         continue ;
+
+      // probar las tres rotaciones del triángulo inicial, y quedarse con la tira más larga
+      mejor_tira.clear();
+      for( unsigned rot = 0 ; rot < 3 ; rot++ )
+      {
+         construirTira( t, rot, tira, tris );
+         if ( tira.size() > mejor_tira.size() )
+         {
+            std::swap( tira, mejor_tira );
+            std::swap( tris, mejor_tris );
+         }
+      }
+
+      for( const unsigned u : mejor_tris )
+         usado[u] = true ;
+
+      if ( num_tiras > 0 )
+         salida.push_back( ind_reinicio );
+      salida.insert( salida.end(), mejor_tira.begin(), mejor_tira.end() );
+      num_tiras++ ;
+   }
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+std::vector<unsigned> GenerarTirasTriangulos( const std::vector<glm::uvec3> & triangulos,
+                                              const unsigned ind_reinicio,
+                                              EstadisticasTiras * estadisticas )
+{
+   std::vector<unsigned> salida ;
+   unsigned long         num_tiras = 0 ;
+
+   GeneradorTiras generador( triangulos );
+   generador.generar( ind_reinicio, salida, num_tiras );
+
+   if ( estadisticas != nullptr )
+   {
+      estadisticas->num_triangulos    = triangulos.size() ;
+      estadisticas->num_tiras         = num_tiras ;
+      estadisticas->num_indices_lista = 3*triangulos.size() ;
+      estadisticas->num_indices_tiras = salida.size() ;
+   }
+   return salida ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+DescrVBOInds * CrearVBOIndsTiras( const std::vector<glm::uvec3> & triangulos )
+{
+   using namespace std ;
+   constexpr unsigned ind_reinicio = 0xFFFFFFFFu ; // mayor valor representable con GL_UNSIGNED_INT
+
+   EstadisticasTiras     estad ;
+   std::vector<unsigned> tiras = GenerarTirasTriangulos( triangulos, ind_reinicio, &estad );
+
+   cout << "Tiras de triángulos: " << estad.num_triangulos << " triángulos en " << estad.num_tiras << " tiras, "
+        << estad.num_indices_tiras << " índices en lugar de " << estad.num_indices_lista << " ("
+        << fixed << setprecision(1) << 100.0*estad.num_indices_tiras/estad.num_indices_lista
+        << "%)." << defaultfloat << endl ;
+
+   DescrVBOInds * dvbo_tiras = new DescrVBOInds( tiras );
+   dvbo_tiras->fijarIndiceReinicio( ind_reinicio );
+   return dvbo_tiras ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+DescrVAO * CrearVAOTiras( const DescrVAO & vao )
+{
+   const DescrVBOInds * indices = vao.leerDescrIndices();
+   assert( indices != nullptr && ! indices->usaReinicio() && indices->leerCount() % 3 == 0 );
+
+   std::vector<glm::uvec3> triangulos( indices->leerCount()/3 );
+   for( unsigned long i = 0 ; i < triangulos.size() ; i++ )
+      triangulos[i] = { indices->leerIndice( 3*i ), indices->leerIndice( 3*i+1 ), indices->leerIndice( 3*i+2 ) };
+
+   // copiar las tablas de atributos (la de posiciones es la primera)
+   const auto copiar = []( const DescrVBOAtribs & d )
+   {
+      return new DescrVBOAtribs( d.leerIndex(), d.leerType(), unsigned( d.leerSize() ), 
+                                 (unsigned long) d.leerCount(), d.leerDatos() );
+   };
+   DescrVAO * tiras = new DescrVAO( vao.leerNumAtribs(), copiar( *vao.leerDescrAtrib( 0 )) );
+   for( unsigned i = 1 ; i < vao.leerNumAtribs() ; i++ )
+      if ( vao.tieneAtrib( i ) )
+         tiras->agregar( copiar( *vao.leerDescrAtrib( i )) );
+   tiras->agregar( CrearVBOIndsTiras( triangulos ));
+   return tiras ;
+}
+// ------------------------------------------------------------------------------------------------------
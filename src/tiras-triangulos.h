@@ -0,0 +1,53 @@
+#ifndef TIRAS_TRIANGULOS_H
+#define TIRAS_TRIANGULOS_H
+
+#include <vector>
+#include "glincludes.h"
+#include "vaos-vbos.h"
+
+// --------------------------------------------------------------------------------------------
+
+// Estadísticas obtenidas al convertir una tabla de triángulos en tiras
+//
+struct EstadisticasTiras
+{
+   unsigned long num_triangulos     = 0 ; // número de triángulos de la tabla original
+   unsigned long num_tiras          = 0 ; // número de tiras generadas
+   unsigned long num_indices_lista  = 0 ; // número de índices como lista de triángulos (=3*num_triangulos)
+   unsigned long num_indices_tiras  = 0 ; // número de índices en las tiras (incluyendo los de reinicio)
+} ;
+
+// --------------------------------------------------------------------------------------------
+
+// Convierte una tabla de triángulos (orientados de forma coherente) en una secuencia de tiras
+// (para GL_TRIANGLE_STRIP), separadas por el índice de reinicio de primitiva. Las tiras
+// conservan la orientación de los triángulos originales.
+//
+// @param triangulos   (vector<uvec3>)       tabla de triángulos (solo se lee)
+// @param ind_reinicio (unsigned)            índice que separa las tiras (no puede aparecer en 'triangulos')
+// @param estadisticas (EstadisticasTiras *) si no es nulo, se escriben ahí las estadísticas
+// @return (vector<unsigned>) tabla de índices de las tiras
+//
+std::vector<unsigned> GenerarTirasTriangulos( const std::vector<glm::uvec3> & triangulos,
+                                              const unsigned ind_reinicio,
+                                              EstadisticasTiras * estadisticas = nullptr );
+
+// Crea un descriptor de VBO de índices con las tiras de triángulos de una tabla de triángulos,
+// con el índice de reinicio fijado, e informa (en 'cout') de la reducción del número de índices.
+// El VAO que lo use se debe dibujar con GL_TRIANGLE_STRIP.
+//
+// @param triangulos (vector<uvec3>) tabla de triángulos (solo se lee)
+// @return (DescrVBOInds *) nuevo descriptor de VBO de índices
+//
+DescrVBOInds * CrearVBOIndsTiras( const std::vector<glm::uvec3> & triangulos );
+
+// Crea un VAO con las mismas tablas de atributos que un VAO indexado de triángulos (copiadas) y
+// sus triángulos como tiras (con 'CrearVBOIndsTiras', que informa de la reducción de índices).
+// El nuevo VAO se debe dibujar con GL_TRIANGLE_STRIP.
+//
+// @param vao (const DescrVAO &) VAO indexado para GL_TRIANGLES (solo se lee)
+// @return (DescrVAO *) nuevo VAO, con las tiras
+//
+DescrVAO * CrearVAOTiras( const DescrVAO & vao );
+
+#endif
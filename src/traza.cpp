@@ -0,0 +1,258 @@
+// Traza de tiempos de ejecución (zonas de código en la CPU y frames en la GPU), exportable
+// al formato JSON de 'Chrome tracing' (se puede ver en 'chrome://tracing' o en Perfetto)
+
+#include <iostream>
+#include "traza.h"
+
+#if TRAZA_ACTIVADA
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "glincludes.h"
+
+// ------------------------------------------------------------------------------------------------------
+// Evento de la traza: zona con nombre, con instantes de inicio y fin en nanosegundos
+
+struct EventoTraza
+{
+   const char * nombre ;
+   uint64_t     inicio_ns ,
+                fin_ns ;
+   long         frame ;    // número de frame (solo eventos de la GPU, -1 en los demás)
+} ;
+
+// Buffer de eventos de un hilo (o de la GPU)
+
+struct BufferTraza
+{
+   unsigned                 id ;                 // identificador del hilo en la traza ('tid')
+   const char *             nombre_hilo = nullptr ;
+   std::vector<EventoTraza> eventos ;            // (capacidad reservada al crearlo, no crece)
+   unsigned long            descartados = 0 ;    // eventos que no han cabido
+} ;
+
+constexpr std::size_t capacidad_buffer = 1 << 16 ; // máximo número de eventos por hilo
+constexpr unsigned    num_frames_gpu   = 4 ;       // frames en el anillo de consultas GL_TIMESTAMP
+
+// Frame del anillo de consultas de la GPU
+struct FrameGPU
+{
+   GLuint consultas[2] = { 0, 0 } ; // instantes de inicio y fin
+   long   numero       = 0 ;
+   bool   pendiente    = false ;    // true si tiene consultas por leer
+} ;
+
+static std::atomic<bool>                         activa { false } ;
+static uint64_t                                  origen_ns = 0 ;   // instante de 'IniciarTraza'
+static std::mutex                                cerrojo_buffers ; // protege 'buffers' (solo al crear un buffer)
+static std::vector<std::unique_ptr<BufferTraza>> buffers ;         // buffers de todos los hilos (sobreviven a los hilos)
+static thread_local BufferTraza *                buffer_hilo = nullptr ;
+
+static BufferTraza                               buffer_gpu ;        // eventos de la GPU ('tid' 0)
+static std::array<FrameGPU,num_frames_gpu>       frames_gpu ;
+static long                                      num_frame_gpu = 0 ;
+static int64_t                                   desplazamiento_gpu_ns = 0 ; // instante CPU - instante GPU
+static bool                                      calibrada_gpu = false ;
+
+// ------------------------------------------------------------------------------------------------------
+// Instante actual en nanosegundos (reloj monótono)
+
+static inline uint64_t InstanteNs()
+{
+   using namespace std::chrono ;
+   return uint64_t( duration_cast<nanoseconds>( steady_clock::now().time_since_epoch() ).count() );
+}
+// ------------------------------------------------------------------------------------------------------
+// Buffer del hilo que llama (lo crea la primera vez)
+
+static BufferTraza & BufferHilo()
+{
+   if ( buffer_hilo == nullptr )
+   {
+      std::unique_ptr<BufferTraza> nuevo = std::make_unique<BufferTraza>();
+      nuevo->eventos.reserve( capacidad_buffer );
+      std::lock_guard<std::mutex> bloqueo( cerrojo_buffers );
+      nuevo->id   = unsigned( buffers.size() + 1 );
+      buffer_hilo = nuevo.get();
+      buffers.push_back( std::move( nuevo ) );
+   }
+   return *buffer_hilo ;
+}
+// ------------------------------------------------------------------------------------------------------
+// Añade un evento a un buffer (si cabe)
+
+static inline void Agregar( BufferTraza & buffer, const EventoTraza & evento )
+{
+   if ( buffer.eventos.size() < capacidad_buffer )
+      buffer.eventos.push_back( evento );
+   else
+      buffer.descartados++ ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+ZonaTraza::ZonaTraza( const char * p_nombre )
+{
+   nombre    = p_nombre ;
+   inicio_ns = activa.load( std::memory_order_relaxed ) ? InstanteNs() : 0 ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+ZonaTraza::~ZonaTraza()
+{
+   if ( inicio_ns != 0 && activa.load( std::memory_order_relaxed ) )
+      Agregar( BufferHilo(), { nombre, inicio_ns, InstanteNs(), -1 } );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void IniciarTraza()
+{
+   origen_ns = InstanteNs();
+   buffer_gpu.id          = 0 ;
+   buffer_gpu.nombre_hilo = "GPU" ;
+   buffer_gpu.eventos.reserve( capacidad_buffer );
+   activa = true ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void NombrarHiloTraza( const char * nombre )
+{
+   BufferHilo().nombre_hilo = nombre ;
+}
+// ------------------------------------------------------------------------------------------------------
+// Lee las consultas de un frame del anillo y añade su evento (espera a la GPU si no están listas)
+
+static void LeerFrameGPU( FrameGPU & f )
+{
+   GLuint64 inicio = 0, fin = 0 ;
+   glGetQueryObjectui64v( f.consultas[0], GL_QUERY_RESULT, &inicio );
+   glGetQueryObjectui64v( f.consultas[1], GL_QUERY_RESULT, &fin );
+   f.pendiente = false ;
+   Agregar( buffer_gpu, { "frame (GPU)", uint64_t( int64_t( inicio ) + desplazamiento_gpu_ns ),
+                          uint64_t( int64_t( fin ) + desplazamiento_gpu_ns ), f.numero } );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void InicioFrameTraza()
+{
+   if ( ! activa )
+      return ;
+   if ( ! calibrada_gpu )
+   {
+      // relacionar el reloj de la GPU con el de la CPU (leyendo ambos a la vez)
+      GLint64 instante_gpu = 0 ;
+      glGetInteger64v( GL_TIMESTAMP, &instante_gpu );
+      desplazamiento_gpu_ns = int64_t( InstanteNs() ) - int64_t( instante_gpu );
+      for( FrameGPU & f : frames_gpu )
+         glGenQueries( 2, f.consultas );
+      calibrada_gpu = true ;
+   }
+   FrameGPU & f = frames_gpu[ num_frame_gpu % num_frames_gpu ] ;
+   if ( f.pendiente ) // (del frame 'num_frames_gpu' anterior, normalmente ya está terminado)
+      LeerFrameGPU( f );
+   f.numero = num_frame_gpu ;
+   glQueryCounter( f.consultas[0], GL_TIMESTAMP );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void FinFrameTraza()
+{
+   if ( ! activa || ! calibrada_gpu )
+      return ;
+   FrameGPU & f = frames_gpu[ num_frame_gpu % num_frames_gpu ] ;
+   glQueryCounter( f.consultas[1], GL_TIMESTAMP );
+   f.pendiente = true ;
+   num_frame_gpu++ ;
+}
+// ------------------------------------------------------------------------------------------------------
+// Escribe en el flujo los eventos de un buffer (con el nombre del hilo como metadato)
+
+static void EscribirBuffer( std::ostream & salida, const BufferTraza & buffer, bool & primero )
+{
+   const auto separador = [&]() { salida << ( primero ? "\n" : ",\n" ); primero = false ; };
+   if ( buffer.nombre_hilo != nullptr )
+   {
+      separador();
+      salida << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.id 
+             << ",\"args\":{\"name\":\"" << buffer.nombre_hilo << "\"}}" ;
+   }
+   for( const EventoTraza & e : buffer.eventos )
+   {
+      if ( e.inicio_ns < origen_ns )
+         continue ;
+      separador();
+      salida << "{\"name\":\"" << e.nombre << "\",\"cat\":\"" << ( buffer.id == 0 ? "gpu" : "cpu" )
+             << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.id
+             << ",\"ts\":"  << double( e.inicio_ns - origen_ns )*1e-3 
+             << ",\"dur\":" << double( e.fin_ns - e.inicio_ns )*1e-3 ;
+      if ( e.frame >= 0 )
+         salida << ",\"args\":{\"frame\":" << e.frame << "}" ;
+      salida << "}" ;
+   }
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool EscribirTraza( const std::string & archivo )
+{
+   using namespace std ;
+   if ( ! activa )
+      return false ;
+   activa = false ;
+
+   // leer los frames de la GPU pendientes y eliminar las consultas
+   if ( calibrada_gpu )
+   {
+      for( unsigned i = 0 ; i < num_frames_gpu ; i++ )
+      {
+         FrameGPU & f = frames_gpu[ ( num_frame_gpu + i ) % num_frames_gpu ] ;
+         if ( f.pendiente )
+            LeerFrameGPU( f );
+         glDeleteQueries( 2, f.consultas );
+      }
+      calibrada_gpu = false ;
+   }
+
+   ofstream salida( archivo );
+   if ( ! salida )
+   {
+      cout << "No se puede escribir la traza en '" << archivo << "'." << endl ;
+      return false ;
+   }
+   salida << fixed << setprecision(3) << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" ;
+
+   bool          primero     = true ;
+   unsigned long num_eventos = buffer_gpu.eventos.size(),
+                 descartados = buffer_gpu.descartados ;
+   EscribirBuffer( salida, buffer_gpu, primero );
+   lock_guard<mutex> bloqueo( cerrojo_buffers );
+   for( const unique_ptr<BufferTraza> & b : buffers )
+   {
+      EscribirBuffer( salida, *b, primero );
+      num_eventos += b->eventos.size() ;
+      descartados += b->descartados ;
+   }
+   salida << "\n]}\n" ;
+
+   cout << "Traza escrita en '" << archivo << "': " << num_eventos << " eventos de " << buffers.size() 
+        << " hilos y la GPU (" << num_frame_gpu << " frames)" ;
+   if ( descartados > 0 )
+      cout << ", " << descartados << " eventos descartados (buffers llenos)" ;
+   cout << "." << endl ;
+   return bool( salida );
+}
+// ------------------------------------------------------------------------------------------------------
+
+#else // ---------------------------- traza eliminada
+
+bool EscribirTraza( const std::string & archivo )
+{
+   std::cout << "La traza no se ha compilado (TRAZA_ACTIVADA es 0), no se escribe '" << archivo << "'." << std::endl ;
+   return false ;
+}
+
+#endif
@@ -0,0 +1,89 @@
+// Traza de tiempos de ejecución (zonas de código en la CPU y frames en la GPU), exportable
+// al formato JSON de 'Chrome tracing' (se puede ver en 'chrome://tracing' o en Perfetto)
+
+#ifndef TRAZA_H
+#define TRAZA_H
+
+#include <cstdint>
+#include <string>
+
+// --------------------------------------------------------------------------------------------
+// La traza se puede eliminar en tiempo de compilación con -DTRAZA_ACTIVADA=0: entonces las
+// zonas no generan código y las funciones no hacen nada. Por defecto está compilada, pero no
+// graba nada hasta que se llama a 'IniciarTraza'.
+
+#ifndef TRAZA_ACTIVADA
+#define TRAZA_ACTIVADA 1
+#endif
+
+// --------------------------------------------------------------------------------------------
+// Zona de código con nombre: mide el tiempo desde su declaración hasta el final del bloque
+// que la contiene. Las zonas anidadas aparecen anidadas en la traza. El nombre debe ser una 
+// cadena literal (solo se guarda el puntero).
+//
+//    void CrearMallas()
+//    {
+//       ZONA_TRAZA( "CrearMallas" );
+//       ....
+
+#if TRAZA_ACTIVADA
+
+#define ZONA_TRAZA_CONCAT2( a, b ) a##b
+#define ZONA_TRAZA_CONCAT( a, b )  ZONA_TRAZA_CONCAT2( a, b )
+#define ZONA_TRAZA( nombre )       ZonaTraza ZONA_TRAZA_CONCAT( zona_traza_, __LINE__ )( nombre )
+
+// objeto que registra una zona al destruirse (usar la macro 'ZONA_TRAZA')
+//
+class ZonaTraza
+{
+   public:
+   explicit ZonaTraza( const char * p_nombre ) ;
+   ~ZonaTraza() ;
+   ZonaTraza( const ZonaTraza & ) = delete ;
+   ZonaTraza & operator = ( const ZonaTraza & ) = delete ;
+
+   private:
+   const char * nombre ;
+   uint64_t     inicio_ns ; // 0 si la traza no estaba activa al crear la zona
+} ;
+
+// Activa la grabación de la traza (las zonas anteriores no se graban). Cada hilo graba en su
+// propio buffer, de capacidad fija (los eventos que no caben se descartan y se cuentan), así 
+// que grabar no necesita sincronización ni reserva memoria tras el primer evento del hilo.
+//
+void IniciarTraza() ;
+
+// Da nombre al hilo que llama en la traza (el nombre debe ser una cadena literal)
+//
+void NombrarHiloTraza( const char * nombre ) ;
+
+// Marca el inicio y el fin de un frame en la GPU (con consultas GL_TIMESTAMP, en un anillo de
+// varios frames para no esperar a la GPU). Los tiempos de la GPU se pasan a la escala de la CPU
+// y aparecen en la traza como un hilo 'GPU', con el número de frame. Requiere un contexto
+// OpenGL activo, no hacen nada si la traza no está activa.
+//
+void InicioFrameTraza() ;
+void FinFrameTraza() ;
+
+// Escribe la traza grabada en un archivo JSON y termina la grabación (requiere el contexto
+// OpenGL, para leer las consultas pendientes y eliminarlas). Se debe llamar cuando ningún
+// otro hilo está grabando.
+//
+// @param archivo (string) nombre del archivo
+// @return (bool) true si se ha podido escribir
+//
+bool EscribirTraza( const std::string & archivo ) ;
+
+#else // ---------------------------- traza eliminada
+
+#define ZONA_TRAZA( nombre )
+
+inline void IniciarTraza() { }
+inline void NombrarHiloTraza( const char * ) { }
+inline void InicioFrameTraza() { }
+inline void FinFrameTraza() { }
+bool EscribirTraza( const std::string & archivo ) ;
+
+#endif
+
+#endif
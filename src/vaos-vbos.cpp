@@ -1,10 +1,144 @@
 
+#include <algorithm>
+#include <atomic>
 #include "vaos-vbos.h"
+#include "gestor-residencia.h"
+#include "traza.h"
     
 constexpr GLsizei stride = 0 ;
 constexpr void *  offset = 0 ;
 constexpr GLint   first  = 0 ;
 
+// true si los VBOs y VAOs se crean con DSA (lo fija 'InicializarCreacionVAOs')
+static bool usar_dsa = false ;
+
+// gestor de residencia de los VAOs (lo fija 'FijarGestorResidencia', nulo si no hay)
+static GestorResidencia * gestor_residencia = nullptr ;
+
+// última versión asignada a un VAO (los VAOs se pueden crear en varios hilos)
+static std::atomic<std::uint64_t> ultima_version { 0 } ;
+
+// devuelve una versión nueva, distinta de todas las asignadas antes a cualquier VAO
+static std::uint64_t NuevaVersion()
+{
+   return ++ultima_version ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+void InicializarCreacionVAOs( const bool permitir_dsa )
+{
+   using namespace std ;
+#ifndef __APPLE__
+   // 'glNamedBufferStorage' requiere además almacenamiento inmutable (OpenGL 4.4 o la extensión)
+   usar_dsa = permitir_dsa && 
+              ( GLEW_VERSION_4_5 || ( GLEW_ARB_direct_state_access && GLEW_ARB_buffer_storage ));
+#else
+   usar_dsa = false ;
+#endif
+   cout << "Creación de VBOs y VAOs: " 
+        << ( usar_dsa ? "acceso directo al estado (DSA)." : "enlazar para editar (OpenGL 3.3)." ) << endl ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+bool UsandoDSA()
+{
+   return usar_dsa ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void FijarGestorResidencia( GestorResidencia * gestor )
+{
+   gestor_residencia = gestor ;
+}
+
+// ------------------------------------------------------------------------------------------------------
+// envía a un VBO ya creado los rangos de bytes modificados de su tabla en la memoria de la aplicación
+// (sin DSA se usa el 'target' GL_COPY_WRITE_BUFFER, que no cambia el estado de ningún VAO)
+
+static void EnviarRangos( const GLuint buffer, const void * datos, RangosModificados & modificados )
+{
+   assert( 0 < buffer );
+   assert( datos != nullptr );
+   CError();
+   const unsigned char * bytes = (const unsigned char *) datos ;
+#ifndef __APPLE__
+   if ( usar_dsa )
+   {
+      for( const auto & r : modificados.fusionar() )
+         glNamedBufferSubData( buffer, r.first, r.second - r.first, bytes + r.first );
+   }
+   else
+#endif
+   {
+      glBindBuffer( GL_COPY_WRITE_BUFFER, buffer );
+      for( const auto & r : modificados.fusionar() )
+         glBufferSubData( GL_COPY_WRITE_BUFFER, r.first, r.second - r.first, bytes + r.first );
+      glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+   }
+   modificados.vaciar();
+   CError();
+}
+
+// ******************************************************************************************************
+// Clase RangosModificados
+// ------------------------------------------------------------------------------------------------------
+
+void RangosModificados::registrar( const GLsizeiptr inicio, const GLsizeiptr fin )
+{
+   assert( 0 <= inicio && inicio < fin );
+
+   // ampliar el último rango si este es contiguo o se solapa con él
+   if ( ! rangos.empty() )
+   {
+      auto & ultimo = rangos.back() ;
+      if ( inicio <= ultimo.second && ultimo.first <= fin )
+      {
+         ultimo.first  = std::min( ultimo.first, inicio );
+         ultimo.second = std::max( ultimo.second, fin );
+         return ;
+      }
+   }
+
+   // si no caben más, unirlos (primero los cercanos, si no basta, todos en uno)
+   if ( rangos.size() >= max_rangos )
+   {
+      unir( hueco_minimo );
+      if ( rangos.size() >= max_rangos )
+      {
+         rangos.front().second = rangos.back().second ;
+         rangos.resize( 1 );
+      }
+   }
+   if ( rangos.capacity() == 0 )
+      rangos.reserve( max_rangos );
+   rangos.push_back( { inicio, fin } );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void RangosModificados::unir( const GLsizeiptr hueco )
+{
+   if ( rangos.size() < 2 )
+      return ;
+   std::sort( rangos.begin(), rangos.end() );
+   size_t n = 0 ; // número de rangos ya unidos (el último es rangos[n-1])
+   for( size_t i = 0 ; i < rangos.size() ; i++ )
+   {
+      if ( n > 0 && rangos[i].first <= rangos[n-1].second + hueco )
+         rangos[n-1].second = std::max( rangos[n-1].second, rangos[i].second );
+      else
+         rangos[n++] = rangos[i] ;
+   }
+   rangos.resize( n );
+}
+// ------------------------------------------------------------------------------------------------------
+
+const std::vector<std::pair<GLsizeiptr,GLsizeiptr>> & RangosModificados::fusionar()
+{
+   unir( hueco_minimo );
+   return rangos ;
+}
+
 // ------------------------------------------------------------------------------------------------------
 // devuelve el tamaño en bytes de un valor a partir de entero asociado con el tipo del valor en OpenGL
 
@@ -44,7 +178,8 @@ constexpr inline void check_indices_type( const GLenum type )
 constexpr void check_mode( const GLenum mode )
 {
    assert( mode == GL_TRIANGLES  || mode == GL_LINES || mode == GL_POINTS || 
-           mode == GL_LINE_STRIP || mode == GL_LINE_LOOP  );  
+           mode == GL_LINE_STRIP || mode == GL_LINE_LOOP || 
+           mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN );  
 }
 
 // ******************************************************************************************************
@@ -96,6 +231,24 @@ DescrVBOAtribs::DescrVBOAtribs( const unsigned p_index, const std::vector<glm::v
    comprobar();
 }
 
+// ----------------------------------------------------------------------------
+
+DescrVBOAtribs::DescrVBOAtribs( const unsigned p_index, const GLenum p_type, const unsigned p_size, 
+                                const unsigned long p_count )
+{
+   index    = p_index ;
+   type     = p_type ;
+   size     = p_size ;
+   count    = p_count ;
+   tot_size = size*count*size_in_bytes( type );
+   assert( 0 < tot_size );
+
+   // reservar la memoria sin inicializarla (la escribe la aplicación)
+   own_data = new unsigned char [tot_size] ;
+   data     = own_data ;
+   comprobar();
+}
+
 // --------------------------------------------------------------------------------------
 
 void DescrVBOAtribs::copiarDatos()
@@ -133,8 +286,9 @@ void DescrVBOAtribs::crearVBO()
    assert( buffer == 0 );  
    comprobar();
 
-   // generar un nuevo identificador de VBO 
+   // generar un nuevo identificador de VBO (se envía la tabla completa, los rangos modificados sobran)
    glGenBuffers( 1, &buffer ); assert( 0 < buffer );
+   modificados.vaciar();
 
    // fija este buffer como buffer 'activo' actualmente en el 'target' GL_ARRAY_BUFFER
    glBindBuffer( GL_ARRAY_BUFFER, buffer ); 
@@ -156,19 +310,59 @@ void DescrVBOAtribs::crearVBO()
 }
 // ------------------------------------------------------------------------------------------------------
 
-DescrVBOAtribs::~DescrVBOAtribs()
+void DescrVBOAtribs::crearVBODSA( const GLuint vao ) 
+{
+   CError();
+   assert( buffer == 0 );  
+   assert( 0 < vao );
+   comprobar();
+#ifndef __APPLE__
+   // crear el VBO con almacenamiento inmutable, inicializado con los datos de la aplicación (que
+   // después se pueden modificar por rangos con 'glNamedBufferSubData')
+   glCreateBuffers( 1, &buffer ); assert( 0 < buffer );
+   glNamedBufferStorage( buffer, tot_size, data, GL_DYNAMIC_STORAGE_BIT );
+   modificados.vaciar();
+
+   // formato del atributo, punto de enlace de buffer (el mismo índice) y VBO en ese punto
+   glVertexArrayAttribFormat( vao, index, size, type, GL_FALSE, 0 );
+   glVertexArrayAttribBinding( vao, index, index );
+   glVertexArrayVertexBuffer( vao, index, buffer, 0, size*size_in_bytes( type ) );
+
+   // por defecto, habilita el uso de esta tabla de atributos
+   glEnableVertexArrayAttrib( vao, index );
+#else
+   assert( false ); // no se usa DSA en macOS
+#endif
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
+
+void DescrVBOAtribs::actualizarVBO()
+{
+   assert( buffer != 0 );
+   if ( modificados.hay() )
+      EnviarRangos( buffer, data, modificados );
+}
+// ------------------------------------------------------------------------------------------------------
+
+void DescrVBOAtribs::liberarVBO()
 {
-   delete [] (unsigned char *) own_data ;
-   own_data = nullptr ; // probablemente innecesario
-   
    if ( buffer != 0 )
    {
       CError();
       glDeleteBuffers( 1, &buffer );
       CError();
-      buffer = 0 ; // probablemente innecesario
+      buffer = 0 ;
    }
+}
+// ------------------------------------------------------------------------------------------------------
 
+DescrVBOAtribs::~DescrVBOAtribs()
+{
+   delete [] (unsigned char *) own_data ;
+   own_data = nullptr ; // probablemente innecesario
+   
+   liberarVBO();
 }
 
 // ******************************************************************************************************
@@ -214,6 +408,20 @@ DescrVBOInds::DescrVBOInds( const std::vector<glm::uvec3> & src_vec )
 }
 // ------------------------------------------------------------------------------------------------------
 
+DescrVBOInds::DescrVBOInds( const GLenum p_type, const GLsizei p_count )
+{
+   type     = p_type ;
+   count    = p_count ;
+   tot_size = count*size_in_bytes( type ) ;
+   assert( 0 < tot_size );
+
+   // reservar la memoria sin inicializarla (la escribe la aplicación)
+   own_indices = new unsigned char [tot_size] ;
+   indices     = own_indices ;
+   comprobar();
+}
+// ------------------------------------------------------------------------------------------------------
+
 void DescrVBOInds::copyIndices()
 {
    assert( indices != nullptr );     // 'indices' debe apuntar a los indices originales
@@ -238,6 +446,16 @@ void DescrVBOInds::comprobar() const
 }
 // ------------------------------------------------------------------------------------------------------
 
+void DescrVBOInds::fijarIndiceReinicio( const GLuint p_ind_reinicio )
+{
+   assert( buffer == 0 ); // solo se puede fijar antes de crear el VBO
+   assert( (GLuint64)p_ind_reinicio < ((GLuint64)1 << (8*size_in_bytes( type ))) ); // debe ser representable en 'type'
+
+   usar_reinicio = true ;
+   ind_reinicio  = p_ind_reinicio ;
+}
+// ------------------------------------------------------------------------------------------------------
+
 void DescrVBOInds::crearVBO( )
 {
    // comprobar precondiciones:
@@ -247,6 +465,7 @@ void DescrVBOInds::crearVBO( )
 
    // crear el VBO y enviar los índices a la GPU 
    glGenBuffers( 1, &buffer ); assert( 0 < buffer );
+   modificados.vaciar();
    
    // activar ('bind') el buffer en el 'target' GL_ELEMENT_ARRAY_BUFFER
    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, buffer ); 
@@ -259,19 +478,51 @@ void DescrVBOInds::crearVBO( )
 }
 // ---------------------------------------------------------------------------------------------
 
-DescrVBOInds::~DescrVBOInds()
+void DescrVBOInds::crearVBODSA( const GLuint vao )
 {
-   delete [] (unsigned char *) own_indices ;
-   own_indices = nullptr ; // probablemente innecesario
+   CError();
+   assert( buffer == 0 );
+   assert( 0 < vao );
+   comprobar();
+#ifndef __APPLE__
+   glCreateBuffers( 1, &buffer ); assert( 0 < buffer );
+   glNamedBufferStorage( buffer, tot_size, indices, GL_DYNAMIC_STORAGE_BIT );
+   modificados.vaciar();
+   glVertexArrayElementBuffer( vao, buffer );
+#else
+   assert( false ); // no se usa DSA en macOS
+#endif
+   CError();
+}
+// ---------------------------------------------------------------------------------------------
+
+void DescrVBOInds::actualizarVBO()
+{
+   assert( buffer != 0 );
+   if ( modificados.hay() )
+      EnviarRangos( buffer, indices, modificados );
+}
+// ---------------------------------------------------------------------------------------------
 
+void DescrVBOInds::liberarVBO()
+{
    if ( buffer != 0 )
    {
       CError();
       glDeleteBuffers( 1, &buffer );
       CError();
-      buffer = 0 ; // probablemente innecesario
+      buffer = 0 ;
    }
 }
+// ---------------------------------------------------------------------------------------------
+
+DescrVBOInds::~DescrVBOInds()
+{
+   delete [] (unsigned char *) own_indices ;
+   own_indices = nullptr ; // probablemente innecesario
+
+   liberarVBO();
+}
 
 // ******************************************************************************************************
 // Clase DescrVAO
@@ -298,6 +549,7 @@ DescrVAO::DescrVAO( const unsigned p_num_atribs, DescrVBOAtribs * vbo_posiciones
 
    // registrar el número de vértices en la tabla de posiciones
    count = vbo_posiciones->leerCount() ;
+   version = NuevaVersion() ;
 
    // clonar el descriptor de VBO de posiciones y apuntarlo desde este objeto
    dvbo_atributo[0] = vbo_posiciones ;  
@@ -328,6 +580,7 @@ void DescrVAO::agregar( DescrVBOAtribs * p_dvbo_atributo )
 
    // registrar el descriptor de VBO en la tabla de descriptores de VBOs de atributos
    dvbo_atributo[index] = p_dvbo_atributo ;
+   version = NuevaVersion() ;
 }
 // ----------------------------------------------------------------------------
 
@@ -337,24 +590,47 @@ void DescrVAO::agregar( DescrVBOInds * p_dvbo_indices )
    assert( p_dvbo_indices != nullptr ); // no permite añadir atributos si el VAO ya esá alojado en la GPU
    p_dvbo_indices->comprobar();
 
-   // registrar el número de índices (3 por tupla) y el tipo
-   idxs_count = p_dvbo_indices->leerCount() ;
-   idxs_type  = p_dvbo_indices->leerType() ;
+   // registrar el número de índices (3 por tupla), el tipo y el índice de reinicio (si hay)
+   idxs_count    = p_dvbo_indices->leerCount() ;
+   idxs_type     = p_dvbo_indices->leerType() ;
+   usar_reinicio = p_dvbo_indices->usaReinicio() ;
+   ind_reinicio  = p_dvbo_indices->leerIndiceReinicio() ;
 
    // crear el descriptor VBO y referenciarlo desde este objeto 
    dvbo_indices = p_dvbo_indices ;
+   version = NuevaVersion() ;
 }
 // ------------------------------------------------------------------------------------------------------
 
 // Crea el VAO en la GPU (solo se puede llamar una vez), deja el VAO activado como VAO actual.
 // Crea y activa el VBO de posiciones y todos los VBOs de atributos que se hayan añadido.
 // Si se ha añadido una tabla de índices, crea y activa el VBO de índices.
+// Con DSA, el VAO y los VBOs se crean y configuran sin enlazarlos (el VAO no queda activado).
 //
 void DescrVAO::crearVAO()
 {
+   ZONA_TRAZA( "DescrVAO::crearVAO" );
    CError();
    assert( array == 0 ); // asegurarnos que únicamente se invoca una vez para este descriptor
 
+#ifndef __APPLE__
+   if ( usar_dsa )
+   {
+      glCreateVertexArrays( 1, &array ); assert( array > 0 );
+      for( unsigned i = 0 ; i < num_atribs ; i++ )
+         if ( dvbo_atributo[i] != nullptr )
+         {
+            dvbo_atributo[i]->crearVBODSA( array );
+            if ( ! atrib_habilitado[i] )
+               glDisableVertexArrayAttrib( array, i );
+         }
+      if ( dvbo_indices != nullptr )
+         dvbo_indices->crearVBODSA( array );
+      CError();
+      return ;
+   }
+#endif
+
    // crear el VBO (queda 'binded')
    glGenVertexArrays( 1, &array ); assert( array > 0 );
    glBindVertexArray( array );
@@ -391,10 +667,21 @@ void DescrVAO::habilitarAtrib( const unsigned index, const bool habilitar )
    assert( index < num_atribs ); // al índice debe estar en su rango
    assert( dvbo_atributo[index] != nullptr ); // no tiene sentido usarlo para un atributo para el cual no hay tabla
 
-   // registrar el nuevo valor del flag
+   // registrar el nuevo valor del flag (cambian los vértices que produce el VAO)
    atrib_habilitado[index] = habilitar ;
-   
+   version = NuevaVersion() ;
+
    // si el VAO ya se ha enviado a la GPU, actualizar estado del VAO en OpenGL
+#ifndef __APPLE__
+   if ( array != 0 && usar_dsa ) // con DSA, sin enlazar el VAO
+   {
+      if ( habilitar ) 
+         glEnableVertexArrayAttrib( array, index );
+      else 
+         glDisableVertexArrayAttrib( array, index );
+   }
+   else
+#endif
    if ( array != 0 )
    {
       CError();
@@ -412,29 +699,160 @@ void DescrVAO::habilitarAtrib( const unsigned index, const bool habilitar )
 }
 // ------------------------------------------------------------------------------------------------------
 
+void * DescrVAO::modificarAtrib( const unsigned index, const unsigned long primera, const unsigned long num )
+{
+   assert( tieneAtrib( index ));
+   assert( 0 < num && primera + num <= (unsigned long) count );
+
+   DescrVBOAtribs * dvbo = dvbo_atributo[index] ;
+   const GLsizeiptr bytes_tupla = dvbo->size*size_in_bytes( dvbo->type );
+   assert( dvbo->own_data != nullptr );
+
+   if ( dvbo->buffer != 0 ) // (si no está creado, al crearlo se envía la tabla completa)
+   {
+      dvbo->modificados.registrar( primera*bytes_tupla, ( primera + num )*bytes_tupla );
+      hay_modificaciones = true ;
+   }
+   version = NuevaVersion() ; // (cambian los vértices que produce el VAO)
+   return (unsigned char *) dvbo->own_data + primera*bytes_tupla ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void * DescrVAO::modificarIndices( const unsigned long primero, const unsigned long num )
+{
+   assert( dvbo_indices != nullptr );
+   assert( 0 < num && primero + num <= (unsigned long) idxs_count );
+
+   const GLsizeiptr bytes_indice = size_in_bytes( idxs_type );
+   assert( dvbo_indices->own_indices != nullptr );
+
+   if ( dvbo_indices->buffer != 0 )
+   {
+      dvbo_indices->modificados.registrar( primero*bytes_indice, ( primero + num )*bytes_indice );
+      hay_modificaciones = true ;
+   }
+   version = NuevaVersion() ;
+   return (unsigned char *) dvbo_indices->own_indices + primero*bytes_indice ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+// Envía a los VBOs (ya creados) los rangos modificados de sus tablas
+//
+void DescrVAO::actualizarVBOs()
+{
+   ZONA_TRAZA( "DescrVAO::actualizarVBOs" );
+   assert( array != 0 );
+   for( unsigned i = 0 ; i < num_atribs ; i++ )
+      if ( dvbo_atributo[i] != nullptr )
+         dvbo_atributo[i]->actualizarVBO();
+   if ( dvbo_indices != nullptr )
+      dvbo_indices->actualizarVBO();
+   hay_modificaciones = false ;
+}
+// ------------------------------------------------------------------------------------------------------
+
+void DescrVAO::preparar()
+{
+   if ( gestor_residencia != nullptr )
+      gestor_residencia->usar( *this ); // (puede liberar otros VAOs para hacer sitio a este)
+   if ( array != 0 )
+   {
+      if ( hay_modificaciones )
+         actualizarVBOs();
+      return ;
+   }
+   crearVAO();
+   hay_modificaciones = false ;
+   glBindVertexArray( 0 );
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
+
+void DescrVAO::liberarGPU()
+{
+   if ( gestor != nullptr )
+      gestor->olvidar( *this );
+   if ( array == 0 )
+      return ;
+   CError();
+   for( unsigned i = 0 ; i < num_atribs ; i++ )
+      if ( dvbo_atributo[i] != nullptr )
+         dvbo_atributo[i]->liberarVBO();
+   if ( dvbo_indices != nullptr )
+      dvbo_indices->liberarVBO();
+   glDeleteVertexArrays( 1, &array );
+   array = 0 ;
+   CError();
+}
+// ------------------------------------------------------------------------------------------------------
+
+GLsizeiptr DescrVAO::leerTamano() const
+{
+   GLsizeiptr tamano = ( dvbo_indices != nullptr ) ? dvbo_indices->leerTamano() : 0 ;
+   for( unsigned i = 0 ; i < num_atribs ; i++ )
+      if ( dvbo_atributo[i] != nullptr )
+         tamano += dvbo_atributo[i]->leerTamano() ;
+   return tamano ;
+}
+// ------------------------------------------------------------------------------------------------------
+
 // Visualiza los vértices de este VAO, usando un modo determinado
 //
-// @param mode (GLenum) modo de visualización (GL_TRIANGLES, GL_LINES, GL_POINTS,  GL_LINE_STRIP o GL_LINE_LOOP)
+// @param mode (GLenum) modo de visualización (GL_TRIANGLES, GL_LINES, GL_POINTS,  GL_LINE_STRIP, GL_LINE_LOOP, 
+//                     GL_TRIANGLE_STRIP o GL_TRIANGLE_FAN)
 //
 void DescrVAO::draw( const GLenum mode )
+{
+   draw( mode, dvbo_indices != nullptr ? idxs_count : count );
+}
+// ------------------------------------------------------------------------------------------------------
+
+// Visualiza los primeros 'num' vértices (o índices) de este VAO, usando un modo determinado
+//
+// @param mode (GLenum)  modo de visualización
+// @param num  (GLsizei) número de vértices, o de índices si la secuencia es indexada
+//
+void DescrVAO::draw( const GLenum mode, const GLsizei num )
 {
    CError();
+   assert( 0 <= num && num <= ( dvbo_indices != nullptr ? idxs_count : count ));
    assert( dvbo_atributo[0] != nullptr ); // asegurarnos que hay una tabla de coordenadas de posición.
    check_mode( mode );                // comprobar que el modo es el correcto.
+
+   // registrar el uso en el gestor de residencia (puede liberar otros VAOs para hacer sitio a este)
+   if ( gestor_residencia != nullptr )
+      gestor_residencia->usar( *this );
    
-   // si el VAO no está creado, crearlo y dejarlo 'binded', si ya está creado, solo se hace 'bind'
+   // si el VAO no está creado, crearlo y dejarlo 'binded' (con DSA hay que hacer 'bind' después 
+   // de crearlo), si ya está creado, enviar los rangos modificados (si hay) y hacer 'bind'
    if ( array == 0 )
+   {
       crearVAO();
+      hay_modificaciones = false ;
+      if ( usar_dsa )
+         glBindVertexArray( array );
+   }
    else 
+   {
+      if ( hay_modificaciones )
+         actualizarVBOs();
       glBindVertexArray( array );
+   }
       
    CError();
 
    // dibujar
-   if ( dvbo_indices != nullptr ) // es una secuencia indexada
-      glDrawElements( mode, idxs_count, idxs_type, offset );
+   if ( dvbo_indices != nullptr && usar_reinicio ) // es una secuencia indexada, con reinicios de primitiva
+   {
+      glEnable( GL_PRIMITIVE_RESTART );
+      glPrimitiveRestartIndex( ind_reinicio );
+      glDrawElements( mode, num, idxs_type, offset );
+      glDisable( GL_PRIMITIVE_RESTART );
+   }
+   else if ( dvbo_indices != nullptr ) // es una secuencia indexada
+      glDrawElements( mode, num, idxs_type, offset );
    else // no es una secuencia indexada
-      glDrawArrays( mode, first, count );
+      glDrawArrays( mode, first, num );
 
    CError();
    glBindVertexArray( 0 );
@@ -448,7 +866,10 @@ void DescrVAO::draw( const GLenum mode )
 //
 DescrVAO::~DescrVAO()
 {
-   for( unsigned i = 1 ; i < num_atribs ; i++ )
+   if ( gestor != nullptr )
+      gestor->olvidar( *this );
+
+   for( unsigned i = 0 ; i < num_atribs ; i++ )
    {  
       delete dvbo_atributo[i] ;
       dvbo_atributo[i] = nullptr ; 
@@ -1,10 +1,77 @@
 #ifndef VBOS_VAOS_H
 #define VBOS_VAOS_H
 
+#include <cstdint>
 #include <vector>
 #include "glincludes.h"
+#include "errores-gl.h"
+
+// --------------------------------------------------------------------------------------------
+// Modo de creación de los VBOs y VAOs en la GPU, se elige una vez en tiempo de ejecución:
+//
+//   - enlazar para editar (OpenGL 3.3): 'glGenBuffers' + 'glBindBuffer' + 'glBufferData', y
+//     'glVertexAttribPointer' con el VAO y el VBO enlazados.
+//   - acceso directo al estado (DSA, OpenGL 4.5 o GL_ARB_direct_state_access): 'glCreateBuffers'
+//     + 'glNamedBufferStorage' (almacenamiento inmutable) y el formato de cada atributo separado 
+//     del buffer del que lee ('glVertexArrayAttribFormat' + 'glVertexArrayVertexBuffer'), sin 
+//     cambiar los objetos enlazados.
+
+// Elige el modo de creación de los VBOs y VAOs, se debe llamar tras inicializar GLEW y antes
+// de crear ningún VAO. Se usa DSA si se permite y el contexto lo soporta (nunca en macOS).
+//
+// @param permitir_dsa (bool) false para usar siempre el modo 'enlazar para editar'
+//
+void InicializarCreacionVAOs( const bool permitir_dsa = true );
+
+// Devuelve true si los VBOs y VAOs se crean con DSA
+//
+bool UsandoDSA();
+
+class GestorResidencia ;
+
+// Fija el gestor de residencia que controla la memoria de la GPU ocupada por los VAOs (los VAOs
+// se registran en él al dibujarlos o prepararlos), o ninguno (nulo, por defecto).
+//
+// @param gestor (GestorResidencia *) gestor a usar (o nulo)
+//
+void FijarGestorResidencia( GestorResidencia * gestor );
+
+// --------------------------------------------------------------------------------------------
+
+// Rangos de bytes de una tabla modificados en la memoria de la aplicación y pendientes de enviar
+// a su VBO. Un rango contiguo o solapado con el último registrado lo amplía (las modificaciones
+// suelen ser secuenciales). Antes de enviarlos se ordenan y se unen los separados por menos de
+// 'hueco_minimo' bytes (una llamada más cuesta más que copiar unos pocos bytes de más), y si se
+// llega a 'max_rangos' se unen antes de añadir otro, así que el vector no crece sin límite.
+//
+class RangosModificados
+{
+   public:
+
+   // registra el rango de bytes [inicio,fin) como modificado
+   void registrar( const GLsizeiptr inicio, const GLsizeiptr fin );
+
+   // ordena y une los rangos (también los separados por huecos menores que 'hueco_minimo'), y
+   // devuelve la lista resultante
+   const std::vector<std::pair<GLsizeiptr,GLsizeiptr>> & fusionar();
+
+   // true si hay algún rango registrado
+   inline bool hay() const { return ! rangos.empty() ; }
+
+   // olvida los rangos (conserva la memoria del vector)
+   inline void vaciar() { rangos.clear(); }
+
+   static constexpr GLsizeiptr hueco_minimo = 1024 ;
+   static constexpr size_t     max_rangos   = 64 ;
+
+   private:
+
+   // une los rangos solapados o separados por menos de 'hueco' bytes (los deja ordenados)
+   void unir( const GLsizeiptr hueco );
+
+   std::vector<std::pair<GLsizeiptr,GLsizeiptr>> rangos ;
+} ;
 
-#define CError()  assert( glGetError() == GL_NO_ERROR );
 // --------------------------------------------------------------------------------------------
 
 // Guarda los datos y metadatos de un VBO con una tabla de atributos de vértice
@@ -24,12 +91,22 @@ class DescrVBOAtribs
    
    const void * data     = nullptr ; // datos originales en la CPU (null antes de saberlos, no null después)
    void *       own_data = nullptr ; // si no nulo, tiene copia de los datos (propiedad de este objeto).
+
+   RangosModificados modificados ; // rangos de 'own_data' modificados después de crear el VBO
    
    // Hace una copia de los datos de la tabla en una zona de memoria propiedad de esta 
    // instancia (copia los datos originales en 'data' en 'own_data', solo una vez).
    // 
    void copiarDatos() ; 
 
+   // Elimina el VBO en la GPU (si está creado), conserva los datos en la memoria de la aplicación
+   // para poder crearlo otra vez
+   //
+   void liberarVBO() ;
+
+   // Envía al VBO (ya creado) los rangos modificados de la tabla, y los olvida
+   void actualizarVBO() ;
+
    friend class DescrVAO ;
 
    public:
@@ -67,6 +144,17 @@ class DescrVBOAtribs
    //
    DescrVBOAtribs( const unsigned p_index, const std::vector<glm::vec2> & src_vec );
 
+   // Crea un descriptor de VBO de atributos con memoria propia sin inicializar, para que la 
+   // aplicación escriba los datos directamente (con 'leerPunteroDatos') antes de crear el VBO.
+   // 
+   // @param p_index (unsigned) índice del atributo 
+   // @param p_type  (GLenum)   tipo de los datos (GL_FLOAT o GL_DOUBLE)
+   // @param p_size  (unsigned) tamaño de las tuplas o vectores (2, 3 o 4)
+   // @param p_count (unsigned) número de tuplas (>0)
+   // 
+   DescrVBOAtribs( const unsigned p_index, const GLenum p_type, const unsigned p_size, 
+                   const unsigned long p_count ); 
+
    // Comprueba que los descriptores de la tabla de datos son correctos, aborta si no
    //
    void comprobar() const;
@@ -79,11 +167,28 @@ class DescrVBOAtribs
    //
    void crearVBO() ; 
 
+   // Igual que 'crearVBO', pero con DSA: crea el VBO con almacenamiento inmutable y fija en el
+   // VAO el formato del atributo y el VBO del que lee (usa como punto de enlace de buffer el 
+   // índice del atributo), sin enlazar el VAO ni el VBO
+   //
+   // @param vao (GLuint) nombre del VAO (ya creado con 'glCreateVertexArrays')
+   //
+   void crearVBODSA( const GLuint vao ) ;
+
    // Devuelve true solo si el VBO ya ha sido creado en la GPU
    inline bool creado() const { return buffer != 0; } 
 
    // Devuelve el valor de 'count' para este descriptor
-   inline GLsizei leerCount() { return count ; }
+   inline GLsizei leerCount() const { return count ; }
+
+   // Devuelve el tipo de los valores (GL_FLOAT o GL_DOUBLE)
+   inline GLenum leerType() const { return type ; }
+
+   // Devuelve el número de valores por tupla
+   inline GLint leerSize() const { return size ; }
+
+   // Devuelve un puntero (de solo lectura) a los datos en la memoria de la aplicación
+   inline const void * leerDatos() const { return data ; }
 
    // Devuelve el índice de este VBO
    inline GLuint leerIndex() const { return index; }
@@ -91,6 +196,13 @@ class DescrVBOAtribs
    // Devuelve el número de vértices
    inline GLuint getCount() const { return count; }
 
+   // Devuelve el tamaño de la tabla en bytes (el que ocupa el VBO en la GPU)
+   inline GLsizeiptr leerTamano() const { return tot_size ; }
+
+   // Devuelve un puntero a la memoria propia con los datos, para escribirlos antes de crear 
+   // el VBO (después de crearlo ya no se envían a la GPU)
+   inline void * leerPunteroDatos() { assert( buffer == 0 ); return own_data ; }
+
    // Libera la memoria ocupada por el VBO, tanto en la memoria de la aplicación, como 
    // en la memoria del buffer en la GPU (si ya se ha creado)
    //
@@ -110,15 +222,29 @@ class DescrVBOInds
    GLenum       type     = 0 ; // tipo de los valores (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)
    GLsizei      count    = 0 ; // número de índices en la tabla (>0)
    GLsizeiptr   tot_size = 0 ; // tamaño completo de la tabla en bytes (=count*sizeof(c-type))
+   bool         usar_reinicio = false ; // true si la tabla tiene índices de reinicio de primitiva
+   GLuint       ind_reinicio  = 0 ;     // valor del índice de reinicio de primitiva (si 'usar_reinicio')
    
    const void * indices     = nullptr ; // datos originales en la CPU (null antes de saberlos, no null después)
    void *       own_indices = nullptr ; // si no nulo, tiene copia de los datos (propiedad de este objeto).
+
+   RangosModificados modificados ; // rangos de 'own_indices' modificados después de crear el VBO
    
    // Inicializa 'own_indices' con una copia de los datos en 'indices', y apunta 
    // 'indices' a 'own_indices'
    //
    void copyIndices() ; 
 
+   // Elimina el VBO en la GPU (si está creado), conserva los índices en la memoria de la aplicación
+   // para poder crearlo otra vez
+   //
+   void liberarVBO() ;
+
+   // Envía al VBO (ya creado) los rangos modificados de la tabla, y los olvida
+   void actualizarVBO() ;
+
+   friend class DescrVAO ;
+
    public:
 
    // impide usar constructor por defecto (sin parámetros)
@@ -148,6 +274,14 @@ class DescrVBOInds
    // 
    DescrVBOInds( const std::vector<glm::uvec3> & src_vec );
 
+   // Crea un descriptor de VBO de índices con memoria propia sin inicializar, para que la 
+   // aplicación escriba los índices directamente (con 'leerPunteroIndices') antes de crear el VBO.
+   // 
+   // @param p_type  (GLEnum)   tipo de los datos (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT o GL_UNSIGNED_INT)
+   // @param p_count (unsigned) número de índices (>0)
+   //
+   DescrVBOInds( const GLenum p_type, const GLsizei p_count ); 
+
 
    // Comprueba que los metadatos son correctos, aborta si no
    void comprobar() const ;
@@ -156,10 +290,46 @@ class DescrVBOInds
    inline bool creado() const { return buffer != 0; }
 
    // Devuelve el valor de 'count' para este descriptor
-   inline GLsizei leerCount() { return count ; }
+   inline GLsizei leerCount() const { return count ; }
 
    // Devuelve el valor de 'type' para este descriptor
-   inline GLenum leerType() { return type ; }
+   inline GLenum leerType() const { return type ; }
+
+   // Devuelve un puntero (de solo lectura) a los índices en la memoria de la aplicación
+   inline const void * leerIndices() const { return indices ; }
+
+   // Devuelve el tamaño de la tabla en bytes (el que ocupa el VBO en la GPU)
+   inline GLsizeiptr leerTamano() const { return tot_size ; }
+
+   // Devuelve el índice 'i' de la tabla (como GLuint, sea cual sea su tipo)
+   inline GLuint leerIndice( const unsigned long i ) const
+   {
+      assert( i < (unsigned long) count );
+      switch( type )
+      {
+         case GL_UNSIGNED_BYTE  : return ((const GLubyte  *) indices)[i] ;
+         case GL_UNSIGNED_SHORT : return ((const GLushort *) indices)[i] ;
+         default                : return ((const GLuint   *) indices)[i] ;
+      }
+   }
+
+   // Devuelve un puntero a la memoria propia con los índices, para escribirlos antes de crear 
+   // el VBO (después de crearlo ya no se envían a la GPU)
+   inline void * leerPunteroIndices() { assert( buffer == 0 ); return own_indices ; }
+
+   // Indica que la tabla contiene índices de reinicio de primitiva (GL_PRIMITIVE_RESTART), con el
+   // valor dado (típicamente el mayor valor representable en el tipo de los índices). Se debe 
+   // llamar antes de añadir la tabla a un VAO.
+   //
+   // @param p_ind_reinicio (GLuint) valor del índice de reinicio (debe ser representable en 'type')
+   //
+   void fijarIndiceReinicio( const GLuint p_ind_reinicio );
+
+   // Devuelve true si la tabla usa índices de reinicio de primitiva
+   inline bool usaReinicio() const { return usar_reinicio ; }
+
+   // Devuelve el valor del índice de reinicio de primitiva (solo si 'usaReinicio()')
+   inline GLuint leerIndiceReinicio() const { return ind_reinicio ; }
 
    // Crear y activar el VBO de índices, es decir:
    //   1. Crea el VBO y envía la tabla de índices a la GPU (únicamente la primera vez)
@@ -167,6 +337,13 @@ class DescrVBOInds
    //
    void crearVBO( );
 
+   // Igual que 'crearVBO', pero con DSA: crea el VBO con almacenamiento inmutable y lo fija
+   // como buffer de índices del VAO, sin enlazar el VAO ni el VBO
+   //
+   // @param vao (GLuint) nombre del VAO (ya creado con 'glCreateVertexArrays')
+   //
+   void crearVBODSA( const GLuint vao );
+
    // destruye un VAO (libera memoria dinámica de la aplic. y elimina VAO en la GPU)
    ~DescrVBOInds();
 
@@ -195,6 +372,10 @@ class DescrVAO
    // si hay índices, tiene el tipo de los índices 
    GLenum idxs_type ;
 
+   // si hay índices con reinicio de primitiva, es true, y 'ind_reinicio' tiene el índice de reinicio
+   bool   usar_reinicio = false ;
+   GLuint ind_reinicio  = 0 ;
+
    // si la secuencia es indexada, VBO de attrs, en otro caso
    DescrVBOInds * dvbo_indices   = nullptr ; 
    
@@ -204,6 +385,24 @@ class DescrVAO
    // array que indica si cada tabla de atributos está habilitada o deshabilitada
    std::vector<bool> atrib_habilitado ;
 
+   // versión de los datos de los vértices: se toma de un contador global al crear el VAO y al
+   // cambiar sus vértices, así no se repite entre VAOs (aunque uno ocupe la dirección de otro ya destruido)
+   std::uint64_t version = 0 ;
+
+   // true si alguna tabla tiene rangos modificados que todavía no se han enviado a su VBO
+   bool hay_modificaciones = false ;
+
+   // gestor de residencia en el que está registrado como residente (nulo si no lo está), y VAOs
+   // anterior y siguiente en su lista de residentes (ordenada del más al menos recientemente usado)
+   GestorResidencia * gestor        = nullptr ;
+   DescrVAO *         lru_anterior  = nullptr ,
+            *         lru_siguiente = nullptr ;
+
+   friend class GestorResidencia ;
+
+   // envía a los VBOs (ya creados) los rangos modificados de sus tablas
+   void actualizarVBOs();
+
    void check( const unsigned index ); // comprueba precondiciones antes de añadir tabla de atribs
 
    public:    
@@ -223,6 +422,22 @@ class DescrVAO
    //
    void crearVAO();
 
+   // Crea el VAO y sus VBOs en la GPU si todavía no están creados (sin dejar el VAO enlazado),
+   // para no hacerlo en el primer 'draw' (que es donde se crean si no se llama a este método)
+   //
+   void preparar();
+
+   // devuelve true solo si el VAO ya ha sido creado en la GPU
+   inline bool creado() const { return array != 0 ; }
+
+   // Elimina el VAO y sus VBOs en la GPU, si están creados, y conserva los datos en la memoria de
+   // la aplicación: el siguiente 'draw' (o 'preparar') los vuelve a crear
+   //
+   void liberarGPU();
+
+   // devuelve el número de bytes que ocupan los VBOs del VAO en la GPU (al crearlos)
+   GLsizeiptr leerTamano() const ;
+
    // Añade un descriptor de VBO de atributos 
    //
    // @param index (unsigned) índice del atributo (no puede ser 0, la tabla de posiciones se da en el constructor)
@@ -238,9 +453,58 @@ class DescrVAO
    // habilita/deshabilita una tabla de atributos (index no puede ser 0)
    void habilitarAtrib( const unsigned index, const bool habilitar );
 
+   // devuelve true solo si este VAO tiene una tabla de atributos con índice 'index'
+   inline bool tieneAtrib( const unsigned index ) const 
+   { return index < num_atribs && dvbo_atributo[index] != nullptr ; }
+
+   // devuelve el número de atributos que puede tener este VAO
+   inline GLuint leerNumAtribs() const { return num_atribs ; }
+
+   // devuelve el número de vértices (tuplas en cada tabla de atributos)
+   inline GLsizei leerNumVertices() const { return count ; }
+
+   // devuelve el descriptor de la tabla de atributos 'index' (nulo si no la tiene)
+   inline const DescrVBOAtribs * leerDescrAtrib( const unsigned index ) const 
+   { assert( index < num_atribs ); return dvbo_atributo[index] ; }
+
+   // devuelve el descriptor de la tabla de índices (nulo si la secuencia no es indexada)
+   inline const DescrVBOInds * leerDescrIndices() const { return dvbo_indices ; }
+
+   // Devuelve un puntero a las tuplas [primera,primera+num) de la tabla de atributos 'index' en
+   // la memoria de la aplicación, para modificarlas, y registra ese rango como modificado: antes
+   // del siguiente 'draw' se envían a la GPU solo los rangos modificados, no la tabla completa (si
+   // el VAO no está creado en la GPU, se envía todo al crearlo).
+   //
+   // @param index   (unsigned)      índice del atributo (el VAO debe tener esa tabla)
+   // @param primera (unsigned long) primera tupla a modificar
+   // @param num     (unsigned long) número de tuplas (>0, primera+num <= número de vértices)
+   // @return (void *) puntero a la primera tupla (válido mientras exista el VAO)
+   //
+   void * modificarAtrib( const unsigned index, const unsigned long primera, const unsigned long num );
+
+   // Igual que 'modificarAtrib', para los índices [primero,primero+num) de la tabla de índices
+   //
+   // @param primero (unsigned long) primer índice a modificar
+   // @param num     (unsigned long) número de índices (>0, primero+num <= número de índices)
+   // @return (void *) puntero al primer índice (del tipo de la tabla)
+   //
+   void * modificarIndices( const unsigned long primero, const unsigned long num );
+
+   // devuelve un número que cambia cada vez que cambian los vértices que produce el VAO, y que
+   // no se repite en otros VAOs (para invalidar copias en cache de sus vértices transformados)
+   inline std::uint64_t leerVersion() const { return version ; }
+
    // ....
    void draw( const GLenum mode ) ;
 
+   // Igual que 'draw( mode )', pero dibuja solo los primeros 'num' vértices (o índices, si la
+   // secuencia es indexada), p.ej. en tablas de tamaño fijo que se rellenan en parte
+   //
+   // @param mode (GLenum)  modo de visualización
+   // @param num  (GLsizei) número de vértices o índices (no mayor que el número que hay)
+   //
+   void draw( const GLenum mode, const GLsizei num ) ;
+
    // ....
    ~DescrVAO();
 } ;